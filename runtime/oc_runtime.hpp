@@ -0,0 +1,432 @@
+//
+// Open Controls - Real-Time Executor
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+
+namespace oc::runtime {
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Rates
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Rate of an OC element's "frequency" entry: "1 kHz", "1kHz", "500 Hz", "2.5 MHz" or a bare number of Hz
+    [[nodiscard]] inline auto parse_frequency(std::string_view text) -> std::optional<double> {
+        while (!text.empty() && (text.front() == ' ' || text.front() == ':')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == ';')) text.remove_suffix(1);
+        double value = 0.0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc{} || value <= 0.0) return std::nullopt;
+
+        std::string_view unit(end, static_cast<std::size_t>(text.data() + text.size() - end));
+        while (!unit.empty() && unit.front() == ' ') unit.remove_prefix(1);
+        if (unit.empty() || unit == "Hz" || unit == "hz") return value;
+        if (unit == "kHz" || unit == "khz") return value * 1e3;
+        if (unit == "MHz" || unit == "mhz") return value * 1e6;
+        return std::nullopt;
+    }
+
+    // Rate of a generated element: its update integrates over cfg.dt, so it runs once per dt
+    template <typename Config>
+    [[nodiscard]] auto frequency_of(const Config& cfg) -> double {
+        return 1.0 / static_cast<double>(cfg.dt);
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Statistics
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Histogram of durations in nanoseconds: exact below 8 ns, then four buckets per power of two, so
+    // a bucket's bounds are within 25% of each other. Fixed size; written by one thread, read by any.
+    class histogram {
+    public:
+        static constexpr int buckets = 252;
+
+        void add(std::uint64_t ns) {
+            auto& bucket = counts_[bucket_of(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sum_.store(sum_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > max_.load(std::memory_order_relaxed)) max_.store(ns, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] auto count() const -> std::uint64_t { return count_.load(std::memory_order_relaxed); }
+        [[nodiscard]] auto max() const -> std::uint64_t { return max_.load(std::memory_order_relaxed); }
+        [[nodiscard]] auto mean() const -> double {
+            auto n = count();
+            return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+        }
+
+        // Upper bound of the bucket holding the q-th quantile, capped at the largest value seen
+        [[nodiscard]] auto percentile(double q) const -> std::uint64_t {
+            auto n = count();
+            if (n == 0) return 0;
+            auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(n - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (int b = 0; b < buckets; ++b) {
+                seen += counts_[b].load(std::memory_order_relaxed);
+                if (seen >= rank) return std::min(upper_bound(b), max());
+            }
+            return max();
+        }
+
+        [[nodiscard]] auto bucket_count(int b) const -> std::uint64_t { return counts_[b].load(std::memory_order_relaxed); }
+
+        [[nodiscard]] static constexpr auto bucket_of(std::uint64_t ns) -> int {
+            if (ns < 8) return static_cast<int>(ns);
+            int msb = static_cast<int>(std::bit_width(ns)) - 1;
+            return 4 * (msb - 1) + static_cast<int>((ns >> (msb - 2)) & 3);
+        }
+        [[nodiscard]] static constexpr auto lower_bound(int b) -> std::uint64_t {
+            if (b < 8) return static_cast<std::uint64_t>(b);
+            int msb = b / 4 + 1;
+            return static_cast<std::uint64_t>(4 + b % 4) << (msb - 2);
+        }
+        [[nodiscard]] static constexpr auto upper_bound(int b) -> std::uint64_t {
+            return b + 1 < buckets ? lower_bound(b + 1) - 1 : ~std::uint64_t{0};
+        }
+
+    private:
+        std::atomic<std::uint64_t> counts_[buckets] = {};
+        std::atomic<std::uint64_t> count_{0};
+        std::atomic<std::uint64_t> sum_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+
+    struct task_stats {
+        std::atomic<std::uint64_t> releases{0};  // steps run
+        std::atomic<std::uint64_t> overruns{0};  // steps that finished after the next release
+        std::atomic<std::uint64_t> missed{0};    // releases skipped because an overrun ran past them
+        histogram execution;                     // time in the step
+        histogram jitter;                        // start of the step minus its release
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Executor
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    struct executor_options {
+        int priority = 80;                       // SCHED_FIFO priority of the worker threads, where allowed
+        bool lock_memory = true;                 // mlockall the process before the threads start
+        std::chrono::milliseconds start_delay{10};  // first release, after start(), shared by all tasks
+    };
+
+    // Runs a set of steps, each at its own rate, on threads pinned to cores. Tasks on the same core
+    // share one thread and run rate-monotonically: at each release the due tasks run shortest period
+    // first. Every release is an absolute time on the monotonic clock, epoch + k * period, so periods
+    // do not drift. A step that finishes after its next release is an overrun; releases it ran past
+    // are skipped and counted as missed rather than run back to back. Everything the threads touch is
+    // allocated by add() and start(); the loop itself does not allocate.
+    class executor {
+    public:
+        explicit executor(executor_options options = {}) : options_(options) {}
+        executor(const executor&) = delete;
+        auto operator=(const executor&) -> executor& = delete;
+        ~executor() { stop(); }
+
+        // Run step at hz on the thread pinned to core, or on an unpinned thread of its own for core < 0.
+        // Tasks can only be added before start(). Returns the task's index.
+        auto add(std::string name, double hz, int core, std::function<void()> step) -> std::size_t {
+            auto t = std::make_unique<task>();
+            t->name = std::move(name);
+            t->period_ns = std::max<std::int64_t>(1, static_cast<std::int64_t>(1e9 / hz + 0.5));
+            t->core = core;
+            t->step = std::move(step);
+            tasks_.push_back(std::move(t));
+            return tasks_.size() - 1;
+        }
+
+        void start() {
+            if (!threads_.empty() || tasks_.empty()) return;
+            stop_.store(false);
+#if defined(__linux__)
+            memory_locked_ = options_.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#endif
+            realtime_.store(true);
+
+            // One thread per core; tasks without a core get a thread each
+            std::vector<std::vector<task*>> groups;
+            std::vector<int> cores;
+            for (auto& t : tasks_) {
+                auto it = t->core >= 0 ? std::ranges::find(cores, t->core) : cores.end();
+                if (it == cores.end()) {
+                    cores.push_back(t->core);
+                    groups.emplace_back();
+                    it = cores.end() - 1;
+                }
+                groups[static_cast<std::size_t>(it - cores.begin())].push_back(t.get());
+            }
+            for (auto& group : groups) {
+                std::ranges::stable_sort(group, {}, &task::period_ns);
+            }
+
+            epoch_ = clock::now() + options_.start_delay;
+            for (std::size_t g = 0; g < groups.size(); ++g) {
+                threads_.emplace_back([this, group = std::move(groups[g]), core = cores[g]] { run(group, core); });
+            }
+        }
+
+        void stop() {
+            stop_.store(true);
+            for (auto& thread : threads_) thread.join();
+            threads_.clear();
+        }
+
+        [[nodiscard]] auto size() const -> std::size_t { return tasks_.size(); }
+        [[nodiscard]] auto name(std::size_t i) const -> const std::string& { return tasks_[i]->name; }
+        [[nodiscard]] auto frequency(std::size_t i) const -> double { return 1e9 / static_cast<double>(tasks_[i]->period_ns); }
+        [[nodiscard]] auto core(std::size_t i) const -> int { return tasks_[i]->core; }
+        [[nodiscard]] auto stats(std::size_t i) const -> const task_stats& { return tasks_[i]->stats; }
+
+        // Whether every worker thread got SCHED_FIFO, and whether the process memory is locked
+        [[nodiscard]] auto realtime() const -> bool { return realtime_.load() && !threads_.empty(); }
+        [[nodiscard]] auto memory_locked() const -> bool { return memory_locked_; }
+
+        // One line per task: rate, core, steps, overruns and missed releases, then the 50th and 99th
+        // percentile and the largest execution time and release jitter, in microseconds
+        [[nodiscard]] auto summary() const -> std::string {
+            auto us = [](std::uint64_t ns) {
+                char buffer[32];
+                auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(ns) / 1e3,
+                                               std::chars_format::fixed, 1);
+                return std::string(buffer, end);
+            };
+            auto pad = [](std::string text, std::size_t width) {
+                if (text.size() < width) text.insert(0, width - text.size(), ' ');
+                return text;
+            };
+            std::size_t width = 4;
+            for (const auto& t : tasks_) width = std::max(width, t->name.size());
+
+            std::string out = std::string(width, ' ') + "        Hz core      steps  overrun   missed   exec p50/p99/max us     jitter p50/p99/max us\n";
+            for (const auto& t : tasks_) {
+                const auto& s = t->stats;
+                auto hz = std::to_string(static_cast<long long>(1e9 / static_cast<double>(t->period_ns) + 0.5));
+                auto name = t->name + std::string(width - t->name.size(), ' ');
+                out += name + pad(hz, 10) + pad(t->core >= 0 ? std::to_string(t->core) : "-", 5) +
+                       pad(std::to_string(s.releases.load()), 11) + pad(std::to_string(s.overruns.load()), 9) +
+                       pad(std::to_string(s.missed.load()), 9) + "  " +
+                       pad(us(s.execution.percentile(0.5)) + "/" + us(s.execution.percentile(0.99)) + "/" + us(s.execution.max()), 22) +
+                       "  " + pad(us(s.jitter.percentile(0.5)) + "/" + us(s.jitter.percentile(0.99)) + "/" + us(s.jitter.max()), 24) + "\n";
+            }
+            if (!realtime()) out += "(not SCHED_FIFO: no permission for priority " + std::to_string(options_.priority) + ")\n";
+            if (options_.lock_memory && !memory_locked_) out += "(memory not locked)\n";
+            return out;
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct task {
+            std::string name;
+            std::int64_t period_ns = 0;
+            int core = -1;
+            std::function<void()> step;
+            task_stats stats;
+            clock::time_point next;
+        };
+
+        // A clock duration in nanoseconds, whatever the clock's tick
+        [[nodiscard]] static auto nanoseconds(clock::duration d) -> std::int64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        }
+
+        // Touch the stack the steps will use, so the first releases do not fault it in
+        [[gnu::noinline]] static void prefault_stack() {
+            volatile unsigned char frame[64 * 1024];
+            for (std::size_t i = 0; i < sizeof(frame); i += 4096) frame[i] = 0;
+        }
+
+        void configure_thread([[maybe_unused]] int core) {
+#if defined(__linux__)
+            if (core >= 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(core, &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+            sched_param param{};
+            param.sched_priority = options_.priority;
+            if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) realtime_.store(false);
+#else
+            realtime_.store(false);
+#endif
+            prefault_stack();
+        }
+
+        // Sleep until an absolute time, waking at least every 50 ms to notice stop()
+        auto sleep_until(clock::time_point until) -> bool {
+            while (!stop_.load(std::memory_order_relaxed)) {
+                auto now = clock::now();
+                if (now >= until) return true;
+                auto wake = std::min(until, now + std::chrono::milliseconds(50));
+#if defined(__linux__)
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+                timespec ts{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+#else
+                std::this_thread::sleep_until(wake);
+#endif
+            }
+            return false;
+        }
+
+        void run(const std::vector<task*>& group, int core) {
+            configure_thread(core);
+            for (auto* t : group) t->next = epoch_;
+
+            while (true) {
+                auto release = group.front()->next;
+                for (auto* t : group) release = std::min(release, t->next);
+                if (!sleep_until(release)) return;
+
+                for (auto* t : group) {
+                    auto start = clock::now();
+                    if (t->next > start) continue;
+                    t->step();
+                    auto end = clock::now();
+
+                    auto& s = t->stats;
+                    s.releases.store(s.releases.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    s.execution.add(static_cast<std::uint64_t>(nanoseconds(end - start)));
+                    s.jitter.add(static_cast<std::uint64_t>(nanoseconds(start - t->next)));
+
+                    t->next += std::chrono::nanoseconds(t->period_ns);
+                    if (end > t->next) {
+                        s.overruns.store(s.overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        auto behind = nanoseconds(end - t->next) / t->period_ns + 1;
+                        t->next += std::chrono::nanoseconds(behind * t->period_ns);
+                        s.missed.store(s.missed.load(std::memory_order_relaxed) + static_cast<std::uint64_t>(behind),
+                                       std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        executor_options options_;
+        std::vector<std::unique_ptr<task>> tasks_;
+        std::vector<std::thread> threads_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> realtime_{true};
+        bool memory_locked_ = false;
+        clock::time_point epoch_;
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Configuration
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    struct no_derived {};
+
+    // The config a running element reads, swapped in by other threads without stopping it. Three
+    // snapshots rotate between the publisher, the running step and a middle slot that is handed
+    // over with one atomic exchange: publish() fills its own snapshot and exchanges it into the
+    // middle, and acquire(), called by the step at its start, exchanges its snapshot for the middle
+    // one only when a newer one is there. Neither side waits on the other, the step never sees a
+    // snapshot being written, and every copy, every call to prepare and every allocation or free in
+    // Derived happens on the publishing thread. Publishers are serialized by a mutex the step never
+    // takes. Derived holds data worked out from a config, such as filter coefficients, built by
+    // prepare next to the config it belongs to.
+    template <typename Config, typename Derived = no_derived>
+    class config_holder {
+    public:
+        struct snapshot {
+            Config config{};
+            Derived derived{};
+            std::uint64_t version = 0;  // 1 for the initial config, then one more per publish()
+        };
+
+        using prepare_fn = std::function<void(const Config&, Derived&)>;
+
+        explicit config_holder(const Config& initial = {}, prepare_fn prepare = {})
+            : prepare_(std::move(prepare)), latest_(initial) {
+            for (auto& slot : slots_) fill(slot, initial, 1);
+        }
+        config_holder(const config_holder&) = delete;
+        auto operator=(const config_holder&) -> config_holder& = delete;
+
+        // Publisher side, from any thread but the running step's
+
+        void publish(const Config& cfg) {
+            std::lock_guard lock(publish_mutex_);
+            latest_ = cfg;
+            fill(slots_[back_], cfg, ++version_);
+            back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index;
+        }
+
+        // Publish the latest config with some fields changed
+        template <typename Edit>
+        void modify(Edit&& edit) {
+            std::lock_guard lock(publish_mutex_);
+            edit(latest_);
+            fill(slots_[back_], latest_, ++version_);
+            back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index;
+        }
+
+        [[nodiscard]] auto latest() const -> Config {
+            std::lock_guard lock(publish_mutex_);
+            return latest_;
+        }
+
+        // Step side, from one thread only: take the newest published snapshot at a step boundary.
+        // The reference stays valid and unchanged until the next acquire().
+        [[nodiscard]] auto acquire() -> const snapshot& {
+            if (middle_.load(std::memory_order_relaxed) & fresh) {
+                front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index;
+            }
+            return slots_[front_];
+        }
+
+        // The snapshot the last acquire() returned
+        [[nodiscard]] auto current() const -> const snapshot& { return slots_[front_]; }
+
+    private:
+        static constexpr unsigned index = 3;
+        static constexpr unsigned fresh = 4;
+
+        void fill(snapshot& slot, const Config& cfg, std::uint64_t version) {
+            slot.config = cfg;
+            if (prepare_) prepare_(slot.config, slot.derived);
+            slot.version = version;
+        }
+
+        snapshot slots_[3];
+        unsigned front_ = 0;                  // owned by the step
+        std::atomic<unsigned> middle_{1};     // index of the handed-over snapshot, | fresh when unread
+        unsigned back_ = 2;                   // owned by the publisher
+        prepare_fn prepare_;
+        mutable std::mutex publish_mutex_;
+        Config latest_;
+        std::uint64_t version_ = 1;
+    };
+
+} // namespace oc::runtime
@@ -0,0 +1,531 @@
+//
+// Open Controls - Generated Code Regression Checks
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Compares generated code with its references:
+// - the dc voltage regulator's _update_n with a loop of its _update
+// - its other variants with the plain _update, to rounding
+// - the systems of systems.hpp with their hand-computed responses
+// - the simulator with the generated _update on the same systems
+// - the pipelines with _update, lagged by their latency
+// - the parallel runners with _update, exactly
+// - the AD variants' derivatives with central differences of _update
+// Built against generated.hpp as tests/generate.cpp writes it.
+//
+// Usage: check_generated <model.mdl>
+//
+
+#include "../tools/libmdl/oc_sim.hpp"
+#include "../tools/libmdl/oc_tool.hpp"
+#include "systems.hpp"
+#include "generated.hpp"
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+    int failures = 0;
+
+    void report(bool passed, const std::string& name, const std::string& detail) {
+        std::printf("%-4s %-44s %s\n", passed ? "ok" : "FAIL", name.c_str(), detail.c_str());
+        if (!passed) ++failures;
+    }
+
+    auto number(double value) -> std::string {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3g", value);
+        return buffer;
+    }
+
+    // Difference relative to max(1, |reference|)
+    auto relative(double value, double reference) -> double {
+        return std::abs(value - reference) / std::max(1.0, std::abs(reference));
+    }
+
+    // Largest relative difference between two traces
+    auto worst(const std::vector<float>& trace, const std::vector<float>& reference) -> double {
+        double result = 0.0;
+        for (std::size_t k = 0; k < trace.size() && k < reference.size(); ++k) {
+            result = std::max(result, relative(trace[k], reference[k]));
+        }
+        return result;
+    }
+
+    constexpr int steps = 20000;
+
+    namespace regulator {
+
+        // The calibration the checks run with, for the fields a variant still reads at run time
+        template <typename Config>
+        auto config() -> Config {
+            Config cfg{};
+            if constexpr (requires { cfg.kpFast; }) {
+                cfg.kpFast = 2.5f;
+                cfg.kpSlow = 0.5f;
+                cfg.pLimitExternalMinimum = 0.25f;
+                cfg.pRequestMax = 10.0f;
+                cfg.pRequestMin = -10.0f;
+            }
+            cfg.dt = 1e-4f;
+            return cfg;
+        }
+
+        template <typename Input>
+        auto input(int k) -> Input {
+            auto t = static_cast<float>(k);
+            return {.external_Plimit = 20.0f, .p_pv = 0.3f * std::sin(t * 0.01f), .v_ref = 1.0f,
+                    .v_cap = 0.9f + 0.05f * std::sin(t * 0.003f), .line_freq = 50.0f};
+        }
+
+        // P_request of one variant's _update over a run from rest
+        template <typename Input, typename Config, typename State, typename Output>
+        auto trace(void (*update)(const Input&, const Config&, State&, Output&)) -> std::vector<float> {
+            auto cfg = config<Config>();
+            State state{};
+            Output out{};
+            std::vector<float> result;
+            for (int k = 0; k < steps; ++k) {
+                update(input<Input>(k), cfg, state, out);
+                result.push_back(static_cast<float>(out.P_request));
+            }
+            return result;
+        }
+
+        // _update_n in calls of 1, 4, 13, ... steps, across window boundaries
+        void update_n_matches_update() {
+            using namespace plain;
+            std::vector<dc_voltage_regulator_input> in;
+            for (int k = 0; k < steps; ++k) in.push_back(input<dc_voltage_regulator_input>(k));
+            std::vector<dc_voltage_regulator_output> out(in.size());
+            auto cfg = config<dc_voltage_regulator_config>();
+            dc_voltage_regulator_state state{};
+            std::size_t done = 0;
+            for (std::size_t n = 1; done < in.size(); n = 3 * n + 1) {
+                n = std::min(n, in.size() - done);
+                dc_voltage_regulator_update_n(std::span(in).subspan(done), std::span(out).subspan(done), n, cfg, state);
+                done += n;
+            }
+
+            auto reference = trace(&dc_voltage_regulator_update);
+            int mismatched = 0;
+            for (std::size_t k = 0; k < out.size(); ++k) {
+                if (out[k].P_request != reference[k]) ++mismatched;
+            }
+            report(mismatched == 0, "dc_voltage_regulator: _update_n == _update", std::to_string(mismatched) + " mismatched steps");
+        }
+
+        // A variant against the plain _update, to within `tolerance`
+        void variant_matches_plain(const std::string& name, const std::vector<float>& variant, double tolerance) {
+            auto diff = worst(variant, trace(&plain::dc_voltage_regulator_update));
+            report(diff <= tolerance, "dc_voltage_regulator: " + name + " == plain", "max relative diff " + number(diff));
+        }
+
+        void simulator_matches_update(const oc::mdl::model& model) {
+            using namespace plain;
+            auto cfg = config<dc_voltage_regulator_config>();
+            oc::sim::sim_options options;
+            options.calibration = {{"kpFast", cfg.kpFast}, {"kpSlow", cfg.kpSlow}, {"pLimitExternalMinimum", cfg.pLimitExternalMinimum},
+                                   {"pRequestMax", cfg.pRequestMax}, {"pRequestMin", cfg.pRequestMin}, {"dt", cfg.dt}};
+            const auto* blk = oc::tool::find_subsystem(model, "dc voltage regulator");
+            oc::sim::simulator sim(model, *model.get_system(blk->subsystem_ref), options);
+            auto index = [&](std::string_view name) { return *oc::tool::port_index(sim.inputs(), name); };
+
+            dc_voltage_regulator_state state{};
+            dc_voltage_regulator_output out{};
+            double diff = 0.0;
+            for (int k = 0; k < steps; ++k) {
+                auto in = input<dc_voltage_regulator_input>(k);
+                sim.set_input(index("external_Plimit"), in.external_Plimit);
+                sim.set_input(index("p_pv"), in.p_pv);
+                sim.set_input(index("v_ref"), in.v_ref);
+                sim.set_input(index("v_cap"), in.v_cap);
+                sim.set_input(index("line_freq"), in.line_freq);
+                sim.step();
+                dc_voltage_regulator_update(in, cfg, state, out);
+                diff = std::max(diff, relative(sim.output(0), out.P_request));
+            }
+            report(diff < 1e-5, "dc_voltage_regulator: sim == _update", "max relative diff " + number(diff));
+        }
+
+        void pipeline_lags_update() {
+            using namespace plain;
+            auto cfg = config<dc_voltage_regulator_config>();
+            dc_voltage_regulator_pipeline pipeline(cfg);
+            dc_voltage_regulator_output piped{};
+            auto serial = trace(&dc_voltage_regulator_update);
+            int mismatched = 0;
+            for (int k = 0; k < steps; ++k) {
+                pipeline.step(input<dc_voltage_regulator_input>(k), piped);
+                if (k >= dc_voltage_regulator_pipeline::latency && piped.P_request != serial[k - dc_voltage_regulator_pipeline::latency]) ++mismatched;
+            }
+            report(mismatched == 0, "dc_voltage_regulator: pipeline == _update",
+                   std::to_string(mismatched) + " mismatched steps, latency " + std::to_string(dc_voltage_regulator_pipeline::latency));
+        }
+
+        void parallel_matches_update() {
+            using namespace plain;
+            auto cfg = config<dc_voltage_regulator_config>();
+            dc_voltage_regulator_parallel parallel;
+            dc_voltage_regulator_state state{};
+            dc_voltage_regulator_output split{};
+            auto serial = trace(&dc_voltage_regulator_update);
+            int mismatched = 0;
+            for (int k = 0; k < steps; ++k) {
+                parallel.step(input<dc_voltage_regulator_input>(k), cfg, state, split);
+                if (split.P_request != serial[k]) ++mismatched;
+            }
+            report(mismatched == 0, "dc_voltage_regulator: parallel == _update", std::to_string(mismatched) + " mismatched steps");
+        }
+
+        // dP_request/dkpFast and dP_request/dv_cap after a run, against central differences of whole runs
+        void derivatives_match_differences() {
+            using namespace plain;
+            namespace ad = dc_voltage_regulator_ad;
+            constexpr int run = 2000;
+            auto final_output = [&](float dk, float dv) {
+                auto cfg = config<dc_voltage_regulator_config>();
+                cfg.kpFast += dk;
+                dc_voltage_regulator_state state{};
+                dc_voltage_regulator_output out{};
+                for (int k = 0; k < run; ++k) {
+                    auto in = input<dc_voltage_regulator_input>(k);
+                    in.v_cap += dv;
+                    dc_voltage_regulator_update(in, cfg, state, out);
+                }
+                return static_cast<double>(out.P_request);
+            };
+
+            auto plain = config<dc_voltage_regulator_config>();
+            ad::dc_voltage_regulator_config cfg{.kpFast = plain.kpFast, .kpSlow = plain.kpSlow, .pLimitExternalMinimum = plain.pLimitExternalMinimum,
+                                                .pRequestMax = plain.pRequestMax, .pRequestMin = plain.pRequestMin, .dt = plain.dt};
+            ad::dc_voltage_regulator_state state{};
+            ad::dc_voltage_regulator_output out{};
+            for (int k = 0; k < run; ++k) {
+                auto p = input<dc_voltage_regulator_input>(k);
+                ad::dc_voltage_regulator_input in{.external_Plimit = p.external_Plimit, .p_pv = p.p_pv, .v_ref = p.v_ref, .v_cap = p.v_cap, .line_freq = p.line_freq};
+                ad::seed(cfg, in);
+                ad::dc_voltage_regulator_update(in, cfg, state, out);
+            }
+
+            constexpr float h = 1e-2f;
+            double by_gain = (final_output(h, 0.0f) - final_output(-h, 0.0f)) / (2.0 * h);
+            double by_input = (final_output(0.0f, h) - final_output(0.0f, -h)) / (2.0 * h);
+            double diff = std::max(relative(out.P_request.d[0], by_gain), relative(out.P_request.d[1], by_input));
+            report(diff < 1e-2, "dc_voltage_regulator: AD == differences",
+                   "d/dkpFast " + number(out.P_request.d[0]) + " vs " + number(by_gain) +
+                   ", d/dv_cap " + number(out.P_request.d[1]) + " vs " + number(by_input));
+        }
+
+    } // namespace regulator
+
+    // k^2 scale and (k + 1)^-0.5 with scale bound to 0.5 and k = 3 from the config
+    void power_binds_pow() {
+        using namespace regress;
+        power_output out{};
+        power_update({.u = 2.0f}, {.k = 3.0f}, out);
+        report(out.y == 9.0f && std::abs(out.z - 1.0f) < 1e-6f, "power: a^b as std::pow",
+               "y " + number(out.y) + " (9), z " + number(out.z) + " (1)");
+    }
+
+    namespace buses {
+        using namespace regress;
+
+        auto input(int k) -> buses_input {
+            auto t = static_cast<float>(k);
+            return {.cmd = {.level = std::sin(t * 0.01f), .rate = 0.5f * std::cos(t * 0.02f)}, .u = 0.1f * t};
+        }
+
+        // Each field of the bus outport, and y, from the inputs; status.total reads the component's
+        // UnitDelay after its update, one step ahead
+        void update_matches_hand() {
+            buses_state state{};
+            buses_output out{};
+            double diff = 0.0;
+            for (int k = 0; k < 200; ++k) {
+                auto in = input(k);
+                buses_update(in, {}, state, out);
+                diff = std::max({diff, relative(out.status.total, in.cmd.level + in.u), relative(out.status.inner.level, in.cmd.level),
+                                 relative(out.status.inner.u, in.u), relative(out.y, std::exp(std::sin(in.cmd.rate)))});
+            }
+            report(diff < 1e-6, "buses: _update == hand", "max relative diff " + number(diff));
+        }
+
+        // _update_n gathers cmd.rate per leaf; in two calls, the first ending inside a window
+        void update_n_matches_update() {
+            std::vector<buses_input> in;
+            for (int k = 0; k < 200; ++k) in.push_back(input(k));
+            std::vector<buses_output> batched(in.size());
+            buses_state state{};
+            buses_update_n(in, batched, 77, {}, state);
+            buses_update_n(std::span(in).subspan(77), std::span(batched).subspan(77), in.size() - 77, {}, state);
+
+            buses_state serial_state{};
+            buses_output out{};
+            int mismatched = 0;
+            for (std::size_t k = 0; k < in.size(); ++k) {
+                buses_update(in[k], {}, serial_state, out);
+                const auto& b = batched[k];
+                if (b.status.total != out.status.total || b.status.inner.level != out.status.inner.level ||
+                    b.status.inner.u != out.status.inner.u || b.y != out.y) ++mismatched;
+            }
+            report(mismatched == 0, "buses: _update_n == _update", std::to_string(mismatched) + " mismatched steps");
+        }
+
+        // The simulator lowers the same buses: cmd and status are one port per leaf
+        void simulator_matches_update() {
+            oc::mdl::model model;
+            auto system = oc::regress::buses(model);
+            oc::sim::simulator sim(model, system.system());
+            auto index = [&](std::string_view name) { return *oc::tool::port_index(sim.inputs(), name); };
+            auto output = [&](std::string_view name) { return sim.output(*oc::tool::port_index(sim.outputs(), name)); };
+
+            buses_state state{};
+            buses_output out{};
+            double diff = 0.0;
+            for (int k = 0; k < 200; ++k) {
+                auto in = input(k);
+                sim.set_input(index("cmd.level"), in.cmd.level);
+                sim.set_input(index("cmd.rate"), in.cmd.rate);
+                sim.set_input(index("u"), in.u);
+                sim.step();
+                buses_update(in, {}, state, out);
+                diff = std::max({diff, relative(output("status.total"), out.status.total), relative(output("status.inner.level"), out.status.inner.level),
+                                 relative(output("status.inner.u"), out.status.inner.u), relative(output("y"), out.y)});
+            }
+            report(diff < 1e-6 && sim.outputs().size() == 4, "buses: sim == _update",
+                   std::to_string(sim.outputs().size()) + " outputs, max relative diff " + number(diff));
+        }
+    } // namespace buses
+
+    // The cascade's region folds three TransferFcns with poles close to 1 at dt = 1e-4; its double rows
+    // keep it with the per-block code, where float coefficients drifted by several percent
+    void state_space_cascade_matches_per_block() {
+        regress::cascade_state per_block{};
+        state_space::cascade_state region{};
+        regress::cascade_output blocks_out{};
+        state_space::cascade_output region_out{};
+        double diff = 0.0;
+        for (int k = 0; k < steps; ++k) {
+            float u = k < steps / 2 ? 1.0f : -0.5f;
+            regress::cascade_update({.u = u}, per_block, blocks_out);
+            state_space::cascade_update({.u = u}, region, region_out);
+            diff = std::max(diff, relative(region_out.y, blocks_out.y));
+        }
+        report(diff < 1e-2, "cascade: state space == per block", "max relative diff " + number(diff));
+    }
+
+    // One of each discrete block against its difference equation. An outport fed straight from a
+    // state block reads it after the step's update, one step ahead, as it reads a UnitDelay; so
+    // do the references for the Delay and the strictly proper DiscreteTransferFcn
+    void discrete_matches_recursion() {
+        using namespace regress;
+        discrete_state state{};
+        discrete_output out{};
+        double history[5] = {};                          // u[k-4] .. u[k]
+        double filtered = 0.0, lagged = 0.0, x1 = 0.0, x2 = 0.0;
+        double diff = 0.0;
+        for (int k = 0; k < 200; ++k) {
+            double u = std::sin(k * 0.1) + (k % 7 == 0 ? 1.0 : 0.0);
+            std::copy(history + 1, history + 5, history);
+            history[4] = u;
+            filtered = 0.2 * u + 0.3 * history[3] + 0.5 * filtered;
+            lagged = 0.9 * lagged + u;
+            double y4 = x1 + x2 + 0.2 * u;
+            double next1 = 0.5 * x1 + 0.1 * x2 + u;
+            x2 = 0.8 * x2 + 0.5 * u;
+            x1 = next1;
+            discrete_update({.u = static_cast<float>(u)}, state, out);
+            diff = std::max({diff, relative(out.y1, history[0]), relative(out.y2, filtered), relative(out.y3, lagged),
+                             relative(out.y4, y4)});
+        }
+        report(diff < 1e-5, "discrete: _update == difference equations", "max relative diff " + number(diff));
+    }
+
+    // A loop closed only through a strictly proper filter, y[k] = 0.3 y[k-1] + 0.5 g[k-1] with
+    // g = 2 (r - y); the outport y reads the filter one step ahead
+    void filter_loop_matches_recursion() {
+        using namespace regress;
+        filter_loop_state state{};
+        filter_loop_output out{};
+        double y = 0.0, diff = 0.0;
+        for (int k = 0; k < 200; ++k) {
+            float r = k < 100 ? 1.0f : -0.5f;
+            filter_loop_update({.r = r}, state, out);
+            double e = r - y;
+            y = 0.3 * y + 0.5 * (2.0 * e);
+            diff = std::max({diff, relative(out.y, y), relative(out.e, e)});
+        }
+        report(diff < 1e-6, "filter_loop: _update == recursion", "max relative diff " + number(diff));
+    }
+
+    // Any system of systems.hpp with one scalar inport, in the simulator and in its generated _update
+    template <typename Input, typename State, typename Output>
+    void simulator_matches(const std::string& name, const oc::regress::builder& system,
+                           void (*update)(const Input&, State&, Output&), float (*signal)(int), auto... outputs) {
+        oc::mdl::model model;
+        oc::sim::simulator sim(model, system.system());
+        State state{};
+        Output out{};
+        double diff = 0.0;
+        for (int k = 0; k < 200; ++k) {
+            float u = signal(k);
+            sim.set_input(0, u);
+            sim.step();
+            update({u}, state, out);
+            std::size_t o = 0;
+            ((diff = std::max(diff, relative(sim.output(o++), out.*outputs))), ...);
+        }
+        report(diff < 1e-6, name + ": sim == _update", "max relative diff " + number(diff));
+    }
+
+    namespace wide {
+        using namespace regress;
+
+        const wide_config cfg{.gain = 0.5f, .dt = 0.001f};
+
+        auto input(int k) -> wide_input {
+            auto t = static_cast<float>(k);
+            return {.u1 = 0.1f + 0.4f * std::sin(t * 0.002f), .u2 = 0.2f + 0.4f * std::sin(t * 0.004f),
+                    .u3 = 0.3f + 0.4f * std::sin(t * 0.006f), .u4 = 0.4f + 0.4f * std::sin(t * 0.008f)};
+        }
+
+        void simulator_matches_update() {
+            oc::mdl::model model;
+            auto system = oc::regress::wide();
+            oc::sim::sim_options options;
+            options.calibration = {{"gain", cfg.gain}, {"dt", cfg.dt}};
+            oc::sim::simulator sim(model, system.system(), options);
+            wide_state state{};
+            wide_output out{};
+            double diff = 0.0;
+            for (int k = 0; k < steps; ++k) {
+                auto in = input(k);
+                const float values[] = {in.u1, in.u2, in.u3, in.u4};
+                for (std::size_t i = 0; i < 4; ++i) sim.set_input(i, values[i]);
+                sim.step();
+                wide_update(in, cfg, state, out);
+                diff = std::max(diff, relative(sim.output(0), out.y));
+            }
+            report(diff < 1e-5, "wide: sim == _update", "max relative diff " + number(diff));
+        }
+
+        void pipeline_lags_update() {
+            wide_pipeline pipeline(cfg);
+            wide_state state{};
+            wide_output serial{}, piped{};
+            std::deque<float> expected;
+            int mismatched = 0;
+            for (int k = 0; k < steps; ++k) {
+                wide_update(input(k), cfg, state, serial);
+                pipeline.step(input(k), piped);
+                expected.push_back(serial.y);
+                if (k < wide_pipeline::latency) continue;
+                if (piped.y != expected.front()) ++mismatched;
+                expected.pop_front();
+            }
+            report(mismatched == 0, "wide: pipeline == _update",
+                   std::to_string(mismatched) + " mismatched steps, latency " + std::to_string(wide_pipeline::latency));
+        }
+
+        void parallel_matches_update() {
+            wide_parallel parallel;
+            wide_state serial_state{}, parallel_state{};
+            wide_output serial{}, split{};
+            int mismatched = 0;
+            for (int k = 0; k < steps; ++k) {
+                wide_update(input(k), cfg, serial_state, serial);
+                parallel.step(input(k), cfg, parallel_state, split);
+                if (split.y != serial.y) ++mismatched;
+            }
+            report(mismatched == 0 && wide_parallel::partitions >= 2, "wide: parallel == _update",
+                   std::to_string(mismatched) + " mismatched steps on " + std::to_string(wide_parallel::partitions) + " partitions");
+        }
+
+        void derivatives_match_differences() {
+            namespace ad = wide_ad;
+            constexpr int run = 2000;
+            auto final_output = [&](float d1, float d3) {
+                wide_state state{};
+                wide_output out{};
+                for (int k = 0; k < run; ++k) {
+                    auto in = input(k);
+                    in.u1 += d1;
+                    in.u3 += d3;
+                    wide_update(in, cfg, state, out);
+                }
+                return static_cast<double>(out.y);
+            };
+
+            ad::wide_config config{.gain = cfg.gain, .dt = cfg.dt};
+            ad::wide_state state{};
+            ad::wide_output out{};
+            for (int k = 0; k < run; ++k) {
+                auto p = input(k);
+                ad::wide_input in{.u1 = p.u1, .u2 = p.u2, .u3 = p.u3, .u4 = p.u4};
+                ad::seed(config, in);
+                ad::wide_update(in, config, state, out);
+            }
+
+            constexpr float h = 1e-2f;
+            double by_u1 = (final_output(h, 0.0f) - final_output(-h, 0.0f)) / (2.0 * h);
+            double by_u3 = (final_output(0.0f, h) - final_output(0.0f, -h)) / (2.0 * h);
+            double diff = std::max(relative(out.y.d[0], by_u1), relative(out.y.d[1], by_u3));
+            report(diff < 1e-2, "wide: AD == differences",
+                   "d/du1 " + number(out.y.d[0]) + " vs " + number(by_u1) + ", d/du3 " + number(out.y.d[1]) + " vs " + number(by_u3));
+        }
+    } // namespace wide
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <model.mdl>\n", argv[0]);
+        return 2;
+    }
+    oc::mdl::parser parser;
+    if (!parser.load(argv[1])) {
+        std::fprintf(stderr, "Error: cannot load %s\n", argv[1]);
+        return 2;
+    }
+
+    regulator::update_n_matches_update();
+    regulator::variant_matches_plain("specialized", regulator::trace(&specialized::dc_voltage_regulator_update), 1e-5);
+    power_binds_pow();
+    regulator::variant_matches_plain("typed", regulator::trace(&typed::dc_voltage_regulator_update), 0.0);
+    buses::update_matches_hand();
+    buses::update_n_matches_update();
+    regulator::variant_matches_plain("state space", regulator::trace(&state_space::dc_voltage_regulator_update), 1e-3);
+    state_space_cascade_matches_per_block();
+    regulator::variant_matches_plain("fused", regulator::trace(&fused::dc_voltage_regulator_update), 1e-5);
+    regulator::variant_matches_plain("scheduled", regulator::trace(&scheduled::dc_voltage_regulator_update), 0.0);
+    regulator::variant_matches_plain("banked", regulator::trace(&banked::dc_voltage_regulator_update), 1e-5);
+    discrete_matches_recursion();
+    filter_loop_matches_recursion();
+    regulator::variant_matches_plain("ranged", regulator::trace(&ranged::dc_voltage_regulator_update), 0.0);
+    regulator::simulator_matches_update(parser.get_model());
+    buses::simulator_matches_update();
+    simulator_matches("discrete", oc::regress::discrete(), &regress::discrete_update,
+                      [](int k) { return static_cast<float>(std::sin(k * 0.1) + (k % 7 == 0 ? 1.0 : 0.0)); },
+                      &regress::discrete_output::y1, &regress::discrete_output::y2, &regress::discrete_output::y3,
+                      &regress::discrete_output::y4);
+    simulator_matches("filter_loop", oc::regress::filter_loop(), &regress::filter_loop_update,
+                      [](int k) { return k < 100 ? 1.0f : -0.5f; }, &regress::filter_loop_output::y, &regress::filter_loop_output::e);
+    regulator::pipeline_lags_update();
+    wide::simulator_matches_update();
+    wide::pipeline_lags_update();
+    regulator::parallel_matches_update();
+    wide::parallel_matches_update();
+    regulator::derivatives_match_differences();
+    wide::derivatives_match_differences();
+    return failures;
+}
@@ -0,0 +1,146 @@
+//
+// Open Controls - Runtime Regression Checks
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Checks runtime/oc_runtime.hpp:
+// - the histogram's buckets tile the durations and hold what add() put in them
+// - the executor counts every step, overrun and missed release of a step that sleeps
+// - config_holder hands a running step whole snapshots, in publish order
+//
+// Usage: check_runtime
+//
+
+#include "../runtime/oc_runtime.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+    int failures = 0;
+
+    void report(bool passed, const std::string& name, const std::string& detail) {
+        std::printf("%-4s %-44s %s\n", passed ? "ok" : "FAIL", name.c_str(), detail.c_str());
+        if (!passed) ++failures;
+    }
+
+    // Every bucket starts one past the end of the one before, holds its own bounds, and is within
+    // 25% of its lower bound; percentile() answers with the bucket of the value added
+    void histogram_buckets_tile() {
+        using oc::runtime::histogram;
+        int bad = 0;
+        for (int b = 0; b < histogram::buckets; ++b) {
+            auto lo = histogram::lower_bound(b), hi = histogram::upper_bound(b);
+            if (lo > hi || histogram::bucket_of(lo) != b || histogram::bucket_of(hi) != b) ++bad;
+            if (b > 0 && histogram::upper_bound(b - 1) + 1 != lo) ++bad;
+            if (b >= 8 && b + 1 < histogram::buckets && (hi - lo + 1) * 4 > lo) ++bad;
+        }
+        if (histogram::lower_bound(0) != 0 || histogram::upper_bound(histogram::buckets - 1) != ~std::uint64_t{0}) ++bad;
+
+        histogram h;
+        for (std::uint64_t ns : {3, 1000, 1000, 1000, 250000}) h.add(ns);
+        auto median = h.percentile(0.5);
+        bool holds = histogram::bucket_of(median) == histogram::bucket_of(1000) && h.percentile(1.0) == 250000 &&
+                     h.count() == 5 && h.max() == 250000 && h.bucket_count(histogram::bucket_of(1000)) == 3;
+        report(bad == 0 && holds, "histogram buckets tile the durations",
+               std::to_string(bad) + " bad buckets, median " + std::to_string(median) + " ns");
+    }
+
+    // A 1 kHz step that sleeps 2.5 ms on every 25th call: each of those ends past its next release
+    // and at least 1.5 ms into it, so it is an overrun that skips two or more releases. Every release
+    // from the epoch to stop() is either run or missed.
+    void executor_counts_overruns() {
+        using namespace oc::runtime;
+        using clock = std::chrono::steady_clock;
+        executor_options options;
+        options.lock_memory = false;
+        executor exec(options);
+        std::atomic<std::uint64_t> calls{0}, sleeps{0};
+        exec.add("sleepy", 1000.0, -1, [&] {
+            if (calls.fetch_add(1) % 25 == 24) {
+                sleeps.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::microseconds(2500));
+            }
+        });
+
+        auto started = clock::now();
+        exec.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(410));
+        exec.stop();
+        auto stopped = clock::now();
+
+        const auto& s = exec.stats(0);
+        auto releases = s.releases.load(), overruns = s.overruns.load(), missed = s.missed.load();
+        auto periods = std::chrono::duration<double, std::milli>(stopped - started - options.start_delay).count();
+        auto accounted = static_cast<double>(releases + missed);
+        bool passed = releases == calls.load() && s.execution.count() == releases && sleeps.load() > 0 &&
+                      overruns >= sleeps.load() && missed >= 2 * sleeps.load() && s.execution.max() >= 2500000 &&
+                      accounted > 0.9 * periods && accounted < periods + 2.0;
+        report(passed, "executor counts overruns and missed releases",
+               std::to_string(releases) + " releases, " + std::to_string(overruns) + " overruns, " +
+               std::to_string(missed) + " missed of " + std::to_string(static_cast<long long>(periods)) + " periods");
+    }
+
+    struct gains {
+        std::uint64_t a = 0;
+        std::uint64_t b = 0;
+    };
+
+    // Worked out from a config: sized by it, so publishes allocate and free
+    struct table {
+        std::vector<std::uint64_t> entries;
+    };
+
+    // A publisher thread modifies the config in a loop while a step thread acquires it. Each modify
+    // sets both fields to its own count, so a snapshot is whole when a == b == version - 1 and every
+    // derived entry equals a; versions must never go backwards, and the last acquire sees the last
+    // publish.
+    void config_swaps_whole_snapshots() {
+        using namespace oc::runtime;
+        constexpr std::uint64_t publishes = 200000;
+        config_holder<gains, table> holder({}, [](const gains& cfg, table& derived) {
+            derived.entries.assign(cfg.a % 7 + 1, cfg.a);
+        });
+
+        std::atomic<bool> done{false};
+        std::thread publisher([&] {
+            for (std::uint64_t n = 1; n <= publishes; ++n) {
+                holder.modify([n](gains& cfg) { cfg.a = n; cfg.b = n; });
+                if (n % 64 == 0) std::this_thread::yield();
+            }
+            done.store(true);
+        });
+
+        std::uint64_t torn = 0, backwards = 0, seen = 0, last = 0;
+        auto check = [&](const auto& snap) {
+            bool whole = snap.config.a == snap.config.b && snap.version == snap.config.a + 1 &&
+                         snap.derived.entries.size() == snap.config.a % 7 + 1;
+            for (auto entry : snap.derived.entries) whole = whole && entry == snap.config.a;
+            if (!whole) ++torn;
+            if (snap.version < last) ++backwards;
+            if (snap.version != last) ++seen;
+            last = snap.version;
+        };
+        while (!done.load()) check(holder.acquire());
+        publisher.join();
+        check(holder.acquire());
+
+        report(torn == 0 && backwards == 0 && last == publishes + 1, "config_holder swaps whole snapshots",
+               std::to_string(seen) + " versions seen, " + std::to_string(torn) + " torn, " +
+               std::to_string(backwards) + " out of order, last " + std::to_string(last));
+    }
+
+} // namespace
+
+int main() {
+    histogram_buckets_tile();
+    executor_counts_overruns();
+    config_swaps_whole_snapshots();
+    return failures;
+}
@@ -0,0 +1,270 @@
+//
+// Open Controls - Simulator Regression Checks
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Compares the simulator with independent references:
+// - a loop closed only through a strictly proper filter with the filter's recursion
+// - co-simulation with two standalone simulators, also where a controller
+//   passes feedback straight through
+// - the variable-step solver with closed-form responses
+// - frequency response composed from the linear path with a simulated sweep
+// - linearization with the symbolic linear path
+//
+// Usage: check_sim <model.mdl>
+//
+
+#include "../tools/libmdl/oc_freq.hpp"
+#include "../tools/libmdl/oc_linearize.hpp"
+#include "../tools/libmdl/oc_sim.hpp"
+#include "../tools/libmdl/oc_tool.hpp"
+#include "systems.hpp"
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+    int failures = 0;
+
+    void report(bool passed, const std::string& name, const std::string& detail) {
+        std::printf("%-4s %-44s %s\n", passed ? "ok" : "FAIL", name.c_str(), detail.c_str());
+        if (!passed) ++failures;
+    }
+
+    auto number(double value) -> std::string {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3g", value);
+        return buffer;
+    }
+
+    // A loop closed only through a strictly proper DiscreteFilter runs, with no algebraic loop, and
+    // follows the filter's recursion by hand
+    void filter_breaks_loop() {
+        using namespace oc;
+        mdl::model model;
+        auto loop = regress::filter_loop();
+        sim::simulator sim(model, loop.system());
+
+        double worst = 0.0, y = 0.0;
+        for (int k = 0; k < 200; ++k) {
+            float r = k < 100 ? 1.0f : -0.5f;
+            sim.set_input(0, r);
+            sim.step();
+            double e = r - y;
+            y = 0.3 * y + 0.5 * (2.0 * e);
+            worst = std::max({worst, std::abs(sim.output(0) - y), std::abs(sim.output(1) - e)});
+        }
+        report(sim.warnings().empty() && worst < 1e-6, "strictly proper filter breaks a loop",
+               std::to_string(sim.warnings().size()) + " warnings, max |diff| " + number(worst));
+    }
+
+    const std::map<std::string, double> regulator_cal = {
+        {"kpFast", 2.5}, {"kpSlow", 0.5}, {"pLimitExternalMinimum", 0.25},
+        {"pRequestMax", 10}, {"pRequestMin", -10}, {"dt", 1e-4},
+    };
+
+    // dc voltage regulator against currentSource_A, its v_cap fed from the plant's i_ref, run once as
+    // a co-simulation and once as two simulators wired by copy; every outport must agree exactly
+    void cosim_matches_standalone(const oc::mdl::model& model, std::uint32_t ratio) {
+        using namespace oc;
+        const auto* controller = model.get_system(tool::find_subsystem(model, "dc voltage regulator")->subsystem_ref);
+        const auto* plant = model.get_system(tool::find_subsystem(model, "currentSource_A")->subsystem_ref);
+
+        sim::sim_options controller_options;
+        controller_options.calibration = regulator_cal;
+        sim::cosim_options options;
+        options.controller = controller_options;
+        options.ratio = ratio;
+        options.connections = {{"v_cap", "i_ref"}};
+        sim::cosimulator cosim(model, *controller, model, *plant, options);
+
+        sim::simulator regulator(model, *controller, controller_options);
+        sim::sim_options plant_options;
+        plant_options.dt = regulator.dt() / ratio;
+        sim::simulator source(model, *plant, plant_options);
+
+        auto cosim_input = [&](std::string_view name) {
+            for (const auto& port : cosim.inputs()) {
+                if (port.name == "controller/" + std::string(name)) return port.slot;
+            }
+            return std::uint32_t{0};
+        };
+        auto input = [&](std::string_view name) { return *tool::port_index(regulator.inputs(), name); };
+
+        double worst = 0.0;
+        for (int k = 0; k < 20000; ++k) {
+            const std::pair<std::string_view, float> held[] = {
+                {"v_ref", 1.0f}, {"p_pv", 0.3f * std::sin(static_cast<float>(k) * 0.01f)},
+                {"external_Plimit", 20.0f}, {"line_freq", 50.0f},
+            };
+            for (auto [name, value] : held) {
+                cosim.set(cosim_input(name), value);
+                regulator.set_input(input(name), value);
+            }
+            regulator.set_input(input("v_cap"), source.output(0));
+            regulator.step();
+            source.set_input(0, regulator.output(0));
+            for (std::uint32_t r = 0; r < ratio; ++r) source.step();
+            cosim.step();
+
+            for (std::size_t o = 0; o < cosim.outputs().size(); ++o) {
+                float expected = o == 0 ? regulator.output(0) : source.output(o - 1);
+                worst = std::max(worst, static_cast<double>(std::abs(expected - cosim.signal(cosim.outputs()[o].slot))));
+            }
+        }
+        report(worst == 0.0 && cosim.connections() == 2, "cosim == standalone, ratio " + std::to_string(ratio),
+               "max |diff| " + number(worst) + ", " + std::to_string(cosim.connections()) + " connections");
+    }
+
+    // A controller outport wired straight from an inport the plant feeds back: the plant must read the
+    // value the controller sent on each of its steps, as with two simulators wired by copy
+    void cosim_passes_feedback_through(std::uint32_t ratio) {
+        using namespace oc;
+        mdl::model model;
+        auto controller = regress::pass_through();
+        auto plant = regress::accumulator();
+        sim::cosim_options options;
+        options.ratio = ratio;
+        sim::cosimulator cosim(model, controller.system(), model, plant.system(), options);
+        sim::simulator relay(model, controller.system());
+        sim::simulator counter(model, plant.system());
+
+        double worst = 0.0;
+        for (int k = 0; k < 100; ++k) {
+            cosim.set(cosim.inputs()[0].slot, 50.0f);
+            relay.set_input(1, 50.0f);
+            relay.set_input(0, counter.output(0));
+            relay.step();
+            counter.set_input(0, relay.output(0));
+            for (std::uint32_t r = 0; r < ratio; ++r) counter.step();
+            cosim.step();
+
+            const float expected[] = {relay.output(0), relay.output(1), counter.output(0)};
+            for (std::size_t o = 0; o < cosim.outputs().size(); ++o) {
+                worst = std::max(worst, static_cast<double>(std::abs(expected[o] - cosim.signal(cosim.outputs()[o].slot))));
+            }
+        }
+        report(worst == 0.0 && cosim.connections() == 2 && counter.output(0) == 100.0f,
+               "cosim feeds a pass-through back, ratio " + std::to_string(ratio),
+               "max |diff| " + number(worst) + ", plant output " + number(cosim.signal(cosim.outputs()[2].slot)) + " after 100 steps");
+    }
+
+    // ode45 at tight tolerances against the closed-form step responses; a fixed step is no reference
+    // here, as Tustin coefficients of a fine step lose too much to single precision
+    void ode45_matches_closed_form() {
+        using namespace oc;
+        mdl::model model;
+        auto plant = regress::continuous_plant();
+        sim::sim_options options;
+        options.dt = 0.001;
+        options.solver = sim::solver_kind::ode45;
+        options.rel_tol = 1e-7;
+        options.abs_tol = 1e-9;
+        sim::simulator ode(model, plant.system(), options);
+        ode.set_input(0, 1.0f);
+
+        // 400 / (s^2 + 4 s + 400), and x'' = 1 - 3 x', from rest
+        auto expected_y = [](double t) {
+            double zeta = 0.1, wn = 20.0, wd = wn * std::sqrt(1.0 - zeta * zeta);
+            return 1.0 - std::exp(-zeta * wn * t) * (std::cos(wd * t) + zeta / std::sqrt(1.0 - zeta * zeta) * std::sin(wd * t));
+        };
+        auto expected_x = [](double t) { return t / 3.0 - (1.0 - std::exp(-3.0 * t)) / 9.0; };
+
+        double worst = 0.0;
+        for (double t : {0.05, 0.2, 0.5, 1.0}) {
+            while (ode.solver_step(t)) {}
+            worst = std::max({worst, std::abs(ode.output(0) - expected_y(t)), std::abs(ode.output(1) - expected_x(t))});
+        }
+        report(worst < 1e-5, "ode45 == closed-form responses", "max |diff| " + number(worst) + ", " +
+               std::to_string(ode.stats().steps) + " solver steps");
+    }
+
+    // H(z) composed from the linear path against a simulated sweep with coherent sampling
+    void frequency_response_matches_sweep() {
+        using namespace oc;
+        mdl::model model;
+        auto loop = regress::linear_loop();
+        sim::sim_options options;
+        options.dt = 0.001;
+        sim::simulator sim(model, loop.system(), options);
+
+        double worst = 0.0;
+        auto tf = freq::compose(sim.linear_path(0, sim.output_slot(0)));
+        std::vector<float> operating{0.0f};
+        for (double hz : {2.0, 20.0, 120.0}) {
+            auto measured = freq::measure(sim, operating, 0, sim.output_slot(0), hz,
+                                          {.amplitude = 0.01, .periods = 10, .settle_periods = 40, .settle_time = 3});
+            auto h = freq::evaluate(tf, sim.dt(), measured.hz);
+            worst = std::max(worst, std::abs(h - measured.response) / std::abs(h));
+        }
+        report(worst < 1e-3, "H(z) == simulated sweep", "worst relative error " + number(worst));
+    }
+
+    // A, B, C, D by central differences against the linear path traced through the instruction
+    // stream, compared as transfer functions on the unit circle
+    void linearize_matches_linear_path() {
+        using namespace oc;
+        mdl::model model;
+        auto loop = regress::linear_loop();
+        sim::sim_options options;
+        options.dt = 0.001;
+        sim::simulator sim(model, loop.system(), options);
+        sim.set_input(0, 0.3f);
+        for (int k = 0; k < 1237; ++k) sim.step();
+
+        std::vector<std::uint32_t> outputs{sim.output_slot(0), sim.output_slot(1)};
+        auto jac = lin::linearize(sim, outputs, {.delta = 0.1, .lanes = 8, .threads = 2});
+        auto n = jac.states.size();
+
+        double worst = 0.0;
+        for (std::size_t out = 0; out < outputs.size(); ++out) {
+            sim::linear_model model_of_jacobian;
+            model_of_jacobian.states = n;
+            model_of_jacobian.a = jac.a;
+            for (std::size_t r = 0; r < n; ++r) {
+                model_of_jacobian.b.push_back(jac.b[r]);
+                model_of_jacobian.c.push_back(jac.c[out * n + r]);
+            }
+            model_of_jacobian.d = jac.d[out];
+            auto numeric = freq::compose(model_of_jacobian);
+            auto symbolic = freq::compose(sim.linear_path(0, outputs[out]));
+            for (double hz : {0.5, 10.0, 150.0}) {
+                auto h = freq::evaluate(numeric, sim.dt(), hz);
+                auto reference = freq::evaluate(symbolic, sim.dt(), hz);
+                worst = std::max(worst, std::abs(h - reference) / std::abs(reference));
+            }
+        }
+        report(worst < 2e-3, "linearize == linear_path (delta 0.1)", "worst relative error " + number(worst));
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <model.mdl>\n", argv[0]);
+        return 2;
+    }
+    oc::mdl::parser parser;
+    if (!parser.load(argv[1])) {
+        std::fprintf(stderr, "Error: cannot load %s\n", argv[1]);
+        return 2;
+    }
+    const auto& model = parser.get_model();
+
+    filter_breaks_loop();
+    cosim_matches_standalone(model, 1);
+    cosim_matches_standalone(model, 4);
+    cosim_passes_feedback_through(1);
+    cosim_passes_feedback_through(4);
+    ode45_matches_closed_form();
+    frequency_response_matches_sweep();
+    linearize_matches_linear_path();
+    return failures;
+}
@@ -0,0 +1,123 @@
+//
+// Open Controls - Generated Code for the Regression Checks
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Writes generated.hpp for check_generated: the dc voltage regulator of the
+// example model once per generator variant, each in a namespace of its own,
+// and the regression systems of systems.hpp in namespace regress.
+//
+// Usage: generate <model.mdl> <header dir>
+//
+
+#include "../tools/libmdl/oc_codegen.hpp"
+#include "systems.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <model.mdl> <header dir>\n", argv[0]);
+        return 2;
+    }
+    oc::mdl::parser parser;
+    if (!parser.load(argv[1])) {
+        std::fprintf(stderr, "Error: cannot load %s\n", argv[1]);
+        return 2;
+    }
+    const auto& model = parser.get_model();
+    const oc::mdl::system* element = nullptr;
+    for (const auto& blk : model.root_system()->subsystems()) {
+        if (blk.name == "dc voltage regulator") element = model.get_system(blk.subsystem_ref);
+    }
+    if (!element) {
+        std::fprintf(stderr, "Error: no dc voltage regulator in %s\n", argv[1]);
+        return 2;
+    }
+    auto regulator = *element;
+    regulator.name = "dc voltage regulator";
+
+    std::ofstream out(std::string(argv[2]) + "/generated.hpp");
+    out << "#pragma once\n\n"
+        << "#include <algorithm>\n#include <array>\n#include <atomic>\n#include <cmath>\n"
+        << "#include <cstddef>\n#include <cstdint>\n#include <span>\n#include <thread>\n"
+        << "#if defined(__linux__)\n#include <pthread.h>\n#endif\n\n";
+
+    oc::codegen::generator gen;
+    auto emit = [&](const oc::mdl::model& owner, const oc::mdl::system& system, const std::string& library,
+                    const oc::codegen::generator_options& options) {
+        gen.set_model(&owner);
+        gen.set_options(options);
+        out << gen.generate(system, library);
+    };
+
+    oc::codegen::generator_options plain;
+    plain.update_n = true;
+    plain.pipeline = 2;
+    plain.parallel = 2;
+    plain.derivatives = {"kpFast", "v_cap"};
+    emit(model, regulator, "plain", plain);
+
+    oc::codegen::generator_options specialized;
+    specialized.calibration = {{"kpFast", 2.5}, {"kpSlow", 0.5}, {"pLimitExternalMinimum", 0.25},
+                               {"pRequestMax", 10}, {"pRequestMin", -10}, {"dt", 1e-4}};
+    emit(model, regulator, "specialized", specialized);
+
+    oc::codegen::generator_options typed;
+    typed.typed = true;
+    emit(model, regulator, "typed", typed);
+
+    // Linear regions need dt bound
+    oc::codegen::generator_options state_space;
+    state_space.calibration = {{"dt", 1e-4}};
+    state_space.state_space = true;
+    emit(model, regulator, "state_space", state_space);
+
+    oc::codegen::generator_options fused;
+    fused.fuse = true;
+    emit(model, regulator, "fused", fused);
+
+    oc::codegen::generator_options scheduled;
+    scheduled.schedule = true;
+    emit(model, regulator, "scheduled", scheduled);
+
+    oc::codegen::generator_options banked;
+    banked.bank = true;
+    emit(model, regulator, "banked", banked);
+
+    // Wide enough for the inputs and config check_generated runs with
+    oc::codegen::generator_options ranged;
+    ranged.range_analysis = true;
+    ranged.ranges = oc::codegen::parse_ranges("v_ref: [0.5, 1.5]\nv_cap: [0.5, 1.5]\np_pv: [-1, 1]\n"
+                                              "line_freq: [45, 55]\nexternal_Plimit: [0, 50]\n"
+                                              "kpFast: [0, 10]\nkpSlow: [0, 10]\npLimitExternalMinimum: [0, 1]\n");
+    emit(model, regulator, "ranged", ranged);
+
+    oc::mdl::model systems;
+    oc::codegen::generator_options power;
+    power.calibration = {{"scale", 0.5}};
+    emit(systems, oc::regress::power().system(), "regress", power);
+    oc::codegen::generator_options windowed;
+    windowed.update_n = true;
+    auto buses = oc::regress::buses(systems);
+    emit(systems, buses.system(), "regress", windowed);
+    oc::codegen::generator_options per_block;
+    per_block.calibration = state_space.calibration;
+    emit(systems, oc::regress::cascade().system(), "regress", per_block);
+    emit(systems, oc::regress::cascade().system(), "state_space", state_space);
+    emit(systems, oc::regress::discrete().system(), "regress", {});
+    emit(systems, oc::regress::filter_loop().system(), "regress", {});
+
+    oc::codegen::generator_options wide;
+    wide.pipeline = 2;
+    wide.parallel = 2;
+    wide.derivatives = {"u1", "u3"};
+    emit(systems, oc::regress::wide().system(), "regress", wide);
+    return out ? 0 : 1;
+}
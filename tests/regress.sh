@@ -0,0 +1,165 @@
+#!/usr/bin/env bash
+#
+# Open Controls - Regression Runs
+# Copyright (C) 2026 Daher Alfawares
+#
+# Runs the tools on the example model and checks what their documentation
+# promises:
+# - bad option values are usage errors
+# - the native and tiered traces equal the interpreter's
+# - a resumed run equals the tail of the uninterrupted one
+# - sweep results do not depend on the thread count
+# - traces survive the CSV/.oct round trip
+# - mdl_tune recovers known gains, whatever the thread count
+# check_generated and check_sim compare the generated code and the simulator
+# with independent references.
+# check_runtime runs the real-time executor and its config swap.
+# Prints one line per check and exits with the number of failed checks.
+#
+# Usage: tests/regress.sh [bin dir]   (make regress builds the tools first)
+#
+
+set -u
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BIN=$(cd "${1:-$ROOT/bin}" && pwd)
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++23 -Wall -Wextra -Wpedantic -O2}
+MODEL=$ROOT/models/controls_module_lib.mdl
+ELEMENT="dc voltage regulator"
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 2
+
+failures=0
+
+check() {
+    local name=$1
+    shift
+    if "$@" >/dev/null 2>"$WORK/error.log"; then
+        printf '%-4s %s\n' ok "$name"
+    else
+        printf '%-4s %s\n' FAIL "$name"
+        sed 's/^/       /' "$WORK/error.log" | head -5
+        failures=$((failures + 1))
+    fi
+}
+
+# A command that has to stop at a bad option value
+rejects() {
+    "$@" 2>&1 >/dev/null | grep -q expects
+}
+
+# The tail of a trace from the first row of another, against that trace
+same_tail() {
+    local first row
+    first=$(sed -n 2p "$2")
+    row=$(grep -nxF -- "$first" "$1" | head -1 | cut -d: -f1)
+    [ -n "$row" ] && cmp <(tail -n "+$row" "$1") <(tail -n +2 "$2")
+}
+
+cat > cal.yaml <<EOF
+kpFast: 2.5
+kpSlow: 0.5
+pLimitExternalMinimum: 0.25
+pRequestMax: 10
+pRequestMin: -10
+dt: 0.0001
+EOF
+awk 'BEGIN {
+    print "v_ref,v_cap,p_pv,line_freq,external_Plimit"
+    for (k = 0; k < 20000; k++) printf "1,%.6g,%.6g,50,20\n", 0.9 + 0.05 * sin(k * 0.003), 0.3 * sin(k * 0.01)
+}' > input.csv
+
+sim() { "$BIN/mdl_sim" "$MODEL" "$ELEMENT" --cal cal.yaml --steps 20000 "$@"; }
+
+echo "mdl_sim"
+check "rejects --steps abc" rejects sim --steps abc
+check "rejects --dt 0" rejects sim --dt 0
+check "rejects --checkpoint-every 0" rejects sim --checkpoint ck --checkpoint-every 0
+sim --input input.csv -o interpreted.csv >/dev/null
+sim --input input.csv --native --cache-dir cache -o native.csv >/dev/null
+check "native trace == interpreted trace" cmp interpreted.csv native.csv
+sim --input input.csv --tiered --cache-dir cache -o tiered.csv >/dev/null
+check "tiered trace == interpreted trace" cmp interpreted.csv tiered.csv
+for mode in interpreted native ode45; do
+    case $mode in
+        interpreted) flags=() ;;
+        native) flags=(--native --cache-dir cache) ;;
+        ode45) flags=(--solver ode45) ;;
+    esac
+    sim --input input.csv "${flags[@]}" --checkpoint "ck-$mode" --checkpoint-every 0.1 -o "full-$mode.csv" >/dev/null
+    # A checkpoint taken before the writer caught up is replaced, so resume from the first one written
+    first=$(ls "ck-$mode"-*.ocp | sort -t- -k3 -n | head -1)
+    sim --input input.csv "${flags[@]}" --resume "$first" -o "resumed-$mode.csv" >/dev/null
+    check "$mode: resumed run == uninterrupted tail" same_tail "full-$mode.csv" "resumed-$mode.csv"
+done
+
+echo "mdl_sweep"
+printf 'kpFast: [1, 2.5]\nkpSlow: 0.5:0.5:1\npLimitExternalMinimum: uniform(0.1, 0.4)\n' > space.yaml
+sweep() {
+    "$BIN/mdl_sweep" "$MODEL" "$ELEMENT" --space space.yaml --cal cal.yaml --samples 3 --seeds 2 --steps 5000 \
+        --noise v_cap=0.01 --set v_ref=1 --set v_cap=0.9 --set line_freq=50 --set external_Plimit=20 "$@" >/dev/null
+}
+check "rejects --samples 0" rejects sweep --samples 0
+sweep --threads 1 -o sweep-1.csv
+sweep --threads 2 --batch 3 -o sweep-2.csv
+check "results on 1 thread == on 2 threads" cmp <(sort sweep-1.csv) <(sort sweep-2.csv)
+
+echo "oc_trace"
+"$BIN/oc_trace" from-csv interpreted.csv -o interpreted.oct >/dev/null
+"$BIN/oc_trace" to-csv interpreted.oct -o roundtrip.csv >/dev/null
+check "CSV -> .oct -> CSV is byte for byte" cmp interpreted.csv roundtrip.csv
+sim --input input.csv -o binary.oct >/dev/null
+"$BIN/oc_trace" to-csv binary.oct --signals P_request -o binary.csv >/dev/null
+check ".oct trace == CSV trace" cmp interpreted.csv binary.csv
+"$BIN/oc_trace" from-csv input.csv --dt 0.0001 -o input.oct >/dev/null
+sim --input input.oct -o from-oct.csv >/dev/null
+check ".oct input == CSV input" cmp interpreted.csv from-oct.csv
+printf 'time,x\n0,1\n0.1,2\n0.2,3\n' > shifted.csv
+"$BIN/oc_trace" from-csv shifted.csv -o shifted.oct >/dev/null
+"$BIN/oc_trace" info shifted.oct > shifted.txt
+check "time column starting at 0 is kept" grep -q ' time$' shifted.txt
+
+echo "mdl_to_cpp"
+check "rejects --pipeline x" rejects "$BIN/mdl_to_cpp" "$MODEL" --pipeline x "$ELEMENT"
+check "rejects --parallel 0" rejects "$BIN/mdl_to_cpp" "$MODEL" --parallel 0 "$ELEMENT"
+
+echo "mdl_tune"
+sed 's/^kpFast: .*/kpFast: 1.7/; s/^kpSlow: .*/kpSlow: 0.9/' cal.yaml > truth.yaml
+"$BIN/mdl_sim" "$MODEL" "$ELEMENT" --cal truth.yaml --input input.csv --steps 5000 -o truth.csv >/dev/null
+paste -d, <(head -5001 input.csv) <(head -5001 truth.csv | cut -d, -f2 | sed '1s/.*/target/') > scenario.csv
+tune() {
+    "$BIN/mdl_tune" "$MODEL" "$ELEMENT" --cal cal.yaml --input scenario.csv --param kpFast=0.5:4 --param kpSlow=0.1:2 \
+        --track P_request=target --generations 60 "$@" >/dev/null
+}
+tune --threads 1 -o tuned-1.yaml
+tune --threads 2 -o tuned-2.yaml
+check "recovers kpFast = 1.7, kpSlow = 0.9" \
+    awk '/^kpFast:/ { f = $2 } /^kpSlow:/ { s = $2 } END { exit !(f > 1.699 && f < 1.701 && s > 0.899 && s < 0.901) }' tuned-1.yaml
+check "result on 1 thread == on 2 threads" cmp tuned-1.yaml tuned-2.yaml
+
+echo "check_generated"
+$CXX $CXXFLAGS -o generate "$ROOT/tests/generate.cpp" || exit 2
+./generate "$MODEL" "$WORK" || exit 2
+$CXX $CXXFLAGS -isystem "$WORK" -o check_generated "$ROOT/tests/check_generated.cpp" -pthread -ldl || exit 2
+./check_generated "$MODEL"
+failures=$((failures + $?))
+
+echo "check_sim"
+$CXX $CXXFLAGS -o check_sim "$ROOT/tests/check_sim.cpp" -pthread -ldl || exit 2
+./check_sim "$MODEL"
+failures=$((failures + $?))
+
+echo "check_runtime"
+$CXX $CXXFLAGS -o check_runtime "$ROOT/tests/check_runtime.cpp" -pthread || exit 2
+./check_runtime
+failures=$((failures + $?))
+
+echo
+if [ "$failures" -ne 0 ]; then
+    echo "$failures check(s) failed"
+    exit "$failures"
+fi
+echo "All passed"
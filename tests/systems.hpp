@@ -0,0 +1,262 @@
+//
+// Open Controls - Regression Systems
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "../tools/libmdl/oc_mdl.hpp"
+#include <map>
+#include <string>
+
+// Small systems built block by block, for the checks the example models cannot exercise
+namespace oc::regress {
+
+    class builder {
+    public:
+        explicit builder(std::string name) { sys_.name = std::move(name); }
+
+        auto add(std::string type, std::string name, std::map<std::string, std::string> parameters = {}) -> builder& {
+            mdl::block blk;
+            blk.type = std::move(type);
+            blk.name = std::move(name);
+            blk.sid = std::to_string(sys_.blocks.size() + 1);
+            blk.parameters = std::move(parameters);
+            sids_[blk.name] = blk.sid;
+            sys_.blocks.push_back(std::move(blk));
+            return *this;
+        }
+
+        auto inport(const std::string& name) -> builder& { return add("Inport", name, {{"Port", std::to_string(++inports_)}}); }
+        auto outport(const std::string& name) -> builder& { return add("Outport", name, {{"Port", std::to_string(++outports_)}}); }
+
+        // A SubSystem running `child`, which is added to `model` for the generator and simulator to find
+        auto subsystem(const std::string& name, const builder& child, mdl::model& model) -> builder& {
+            auto ref = "system_" + child.system().name;
+            model.systems[ref] = child.system();
+            model.systems[ref].id = ref;
+            add("SubSystem", name);
+            sys_.blocks.back().subsystem_ref = ref;
+            return *this;
+        }
+
+        // Output `from_port` of `from` to input `port` of `to`
+        auto wire(const std::string& from, const std::string& to, int port = 1, int from_port = 1) -> builder& {
+            mdl::connection c;
+            c.source = sids_.at(from) + "#out:" + std::to_string(from_port);
+            c.destination = sids_.at(to) + "#in:" + std::to_string(port);
+            sys_.connections.push_back(std::move(c));
+            return *this;
+        }
+
+        // Name the last wire; a BusCreator names its fields after the lines feeding it
+        auto named(std::string name) -> builder& {
+            sys_.connections.back().name = std::move(name);
+            return *this;
+        }
+
+        [[nodiscard]] auto system() const -> const mdl::system& { return sys_; }
+
+    private:
+        mdl::system sys_;
+        std::map<std::string, std::string> sids_;
+        int inports_ = 0;
+        int outports_ = 0;
+    };
+
+    // Gains written with MATLAB's ^: specialized with scale bound and k left in the config, they
+    // must come out as std::pow, not as XOR; y = k^2 scale u and z = (k + 1)^-0.5 u
+    inline auto power() -> builder {
+        builder b("power");
+        b.inport("u")
+            .add("Gain", "square", {{"Gain", "k^2*scale"}})
+            .add("Gain", "root", {{"Gain", "(k+1)^-0.5"}})
+            .outport("y")
+            .outport("z");
+        b.wire("u", "square").wire("square", "y").wire("u", "root").wire("root", "z");
+        return b;
+    }
+
+    // Bus inport cmd = {level, rate}: level and u are bundled into a bus for the component mix,
+    // which sums them into a UnitDelay, and the bus outport status = {total, inner = {level, u}}
+    // carries its output next to the bundle itself; y = exp(sin(rate)), enough work for _update_n to
+    // gather cmd.rate into a window array
+    inline auto buses(mdl::model& model) -> builder {
+        builder mixer("mixer");
+        mixer.inport("in")
+            .add("BusSelector", "fields", {{"OutputSignals", "level,u"}})
+            .add("Sum", "sum", {{"Inputs", "++"}})
+            .add("UnitDelay", "hold")
+            .outport("total");
+        mixer.wire("in", "fields").wire("fields", "sum", 1, 1).wire("fields", "sum", 2, 2).wire("sum", "hold").wire("hold", "total");
+
+        builder b("buses");
+        b.inport("cmd").inport("u")
+            .add("BusSelector", "pick", {{"OutputSignals", "level,rate"}})
+            .add("Trigonometry", "shape", {{"Operator", "sin"}})
+            .add("Math", "grow", {{"Operator", "exp"}})
+            .add("BusCreator", "bundle", {{"Inputs", "2"}})
+            .subsystem("mix", mixer, model)
+            .add("BusCreator", "report", {{"Inputs", "2"}})
+            .outport("status")
+            .outport("y");
+        b.wire("cmd", "pick").wire("pick", "shape", 1, 2).wire("shape", "grow").wire("grow", "y")
+            .wire("pick", "bundle", 1, 1).named("level").wire("u", "bundle", 2).named("u")
+            .wire("bundle", "mix").wire("mix", "report").named("total").wire("bundle", "report", 2).named("inner")
+            .wire("report", "status");
+        return b;
+    }
+
+    // Three second-order TransferFcns (s + 2) / (0.01 s^2 + 0.3 s + 1), each followed by a Gain and
+    // closed through a UnitDelay: one linear region, with poles close to 1 at a fine step
+    inline auto cascade() -> builder {
+        builder b("cascade");
+        b.inport("u")
+            .add("Sum", "error", {{"Inputs", "+-"}})
+            .add("UnitDelay", "feedback")
+            .outport("y");
+        std::string previous = "error";
+        for (int i = 1; i <= 3; ++i) {
+            auto n = std::to_string(i);
+            b.add("TransferFcn", "tf" + n, {{"Numerator", "[1 2]"}, {"Denominator", "[0.01 0.3 1]"}})
+                .add("Gain", "g" + n, {{"Gain", "0.4"}});
+            b.wire(previous, "tf" + n).wire("tf" + n, "g" + n);
+            previous = "g" + n;
+        }
+        b.wire("u", "error").wire(previous, "feedback").wire("feedback", "error", 2).wire(previous, "y");
+        return b;
+    }
+
+    // One of each discrete block on u: a Delay ring of 5 samples to y1, y2 from a DiscreteFilter
+    // 0.2 + 0.3 z^-1 over 1 - 0.5 z^-1, y3 from a DiscreteTransferFcn 1 / (z - 0.9) and y4 from a
+    // two-state DiscreteStateSpace with direct feedthrough
+    inline auto discrete() -> builder {
+        builder b("discrete");
+        b.inport("u")
+            .add("Delay", "ring", {{"DelayLength", "5"}})
+            .add("DiscreteFilter", "filter", {{"Numerator", "[0.2 0.3]"}, {"Denominator", "[1 -0.5]"}})
+            .add("DiscreteTransferFcn", "lag", {{"Numerator", "[1]"}, {"Denominator", "[1 -0.9]"}})
+            .add("DiscreteStateSpace", "modes", {{"A", "[0.5 0.1; 0 0.8]"}, {"B", "[1; 0.5]"}, {"C", "[1 1]"}, {"D", "0.2"}})
+            .outport("y1")
+            .outport("y2")
+            .outport("y3")
+            .outport("y4");
+        b.wire("u", "ring").wire("ring", "y1").wire("u", "filter").wire("filter", "y2")
+            .wire("u", "lag").wire("lag", "y3").wire("u", "modes").wire("modes", "y4");
+        return b;
+    }
+
+    // Feedback closed only through a DiscreteFilter without direct feedthrough,
+    // y[k] = 0.3 y[k-1] + 0.5 g[k-1]: the filter breaks the loop like a UnitDelay
+    inline auto filter_loop() -> builder {
+        builder b("filter_loop");
+        b.inport("r")
+            .add("Sum", "error", {{"Inputs", "+-"}})
+            .add("Gain", "k", {{"Gain", "2"}})
+            .add("DiscreteFilter", "F", {{"Numerator", "[0 0.5]"}, {"Denominator", "[1 -0.3]"}})
+            .outport("y")
+            .outport("e");
+        b.wire("r", "error").wire("F", "error", 2).wire("error", "k").wire("k", "F").wire("F", "y").wire("error", "e");
+        return b;
+    }
+
+    // Controller whose outport u passes its fed-back inport y straight through, next to an error
+    // output r - y; closed around accumulator() it must see the plant, not an unconnected inport
+    inline auto pass_through() -> builder {
+        builder b("pass_through");
+        b.inport("y").inport("r")
+            .add("Sum", "error", {{"Inputs", "+-"}})
+            .outport("u")
+            .outport("e");
+        b.wire("y", "u").wire("r", "error").wire("y", "error", 2).wire("error", "e");
+        return b;
+    }
+
+    // Plant y[k] = u[k-1] + 1, so a loop closed with u = y counts the steps
+    inline auto accumulator() -> builder {
+        builder b("accumulator");
+        b.inport("u")
+            .add("Constant", "one", {{"Value", "1"}})
+            .add("Sum", "next", {{"Inputs", "++"}})
+            .add("UnitDelay", "hold")
+            .outport("y");
+        b.wire("u", "next").wire("one", "next", 2).wire("next", "hold").wire("hold", "y");
+        return b;
+    }
+
+    // Continuous only: a lightly damped second-order TransferFcn and a double integrator with
+    // velocity feedback, both driven by u; for the variable-step solver
+    inline auto continuous_plant() -> builder {
+        builder b("continuous_plant");
+        b.inport("u")
+            .add("TransferFcn", "resonance", {{"Numerator", "[400]"}, {"Denominator", "[1 4 400]"}})
+            .add("Sum", "force", {{"Inputs", "+-"}})
+            .add("Integrator", "velocity")
+            .add("Gain", "damping", {{"Gain", "3"}})
+            .add("Integrator", "position")
+            .outport("y")
+            .outport("x");
+        b.wire("u", "resonance").wire("resonance", "y")
+            .wire("u", "force").wire("damping", "force", 2)
+            .wire("force", "velocity").wire("velocity", "damping").wire("velocity", "position")
+            .wire("position", "x");
+        return b;
+    }
+
+    // PI loop around a second-order plant, measured through a UnitDelay, with a Delay ring and a
+    // DiscreteFilter on a second output; linear from u to both outputs
+    inline auto linear_loop() -> builder {
+        builder b("linear_loop");
+        b.inport("u")
+            .add("Sum", "err", {{"Inputs", "+-"}})
+            .add("Gain", "kp", {{"Gain", "2.5"}})
+            .add("Integrator", "I")
+            .add("Gain", "ki", {{"Gain", "40"}})
+            .add("Sum", "pi", {{"Inputs", "++"}})
+            .add("TransferFcn", "plant", {{"Numerator", "[1]"}, {"Denominator", "[0.01 0.3 1]"}})
+            .add("UnitDelay", "meas")
+            .add("Delay", "D3", {{"DelayLength", "3"}})
+            .add("DiscreteFilter", "F", {{"Numerator", "[0.2 0.3]"}, {"Denominator", "[1 -0.5]"}})
+            .add("Gain", "half", {{"Gain", "0.5"}})
+            .outport("y")
+            .outport("y2");
+        b.wire("u", "err").wire("meas", "err", 2)
+            .wire("err", "kp").wire("err", "I").wire("I", "ki")
+            .wire("kp", "pi").wire("ki", "pi", 2)
+            .wire("pi", "plant").wire("plant", "meas")
+            .wire("plant", "D3").wire("D3", "F").wire("F", "half").wire("half", "y")
+            .wire("plant", "y2");
+        return b;
+    }
+
+    // Four independent branches with transcendental math and state of their own, summed at the end;
+    // wide enough for the parallel runner and deep enough for pipeline stages. The first gain is the
+    // config value `gain`.
+    inline auto wide() -> builder {
+        builder b("wide");
+        b.add("Sum", "total", {{"Inputs", "++++"}}).outport("y");
+        for (int i = 1; i <= 4; ++i) {
+            auto n = std::to_string(i);
+            b.inport("u" + n)
+                .add("Gain", "g" + n, {{"Gain", i == 1 ? "gain" : std::to_string(0.5 * i)}})
+                .add("Trigonometry", "sin" + n, {{"Operator", "sin"}})
+                .add("Math", "exp" + n, {{"Operator", "exp"}})
+                .add("TransferFcn", "tf" + n, {{"Numerator", "[1]"}, {"Denominator", "[0.02 0.4 1]"}})
+                .add("UnitDelay", "z" + n)
+                .add("Sum", "mix" + n, {{"Inputs", "+-"}})
+                .add("Trigonometry", "cos" + n, {{"Operator", "cos"}});
+            b.wire("u" + n, "g" + n).wire("g" + n, "sin" + n).wire("sin" + n, "exp" + n)
+                .wire("exp" + n, "tf" + n).wire("tf" + n, "mix" + n).wire("z" + n, "mix" + n, 2)
+                .wire("mix" + n, "z" + n).wire("mix" + n, "cos" + n).wire("cos" + n, "total", i);
+        }
+        b.wire("total", "y");
+        return b;
+    }
+
+} // namespace oc::regress
@@ -0,0 +1,277 @@
+//
+// Open Controls - Simulation Checkpoints
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "oc_sim.hpp"
+#include <condition_variable>
+#include <mutex>
+
+namespace oc::checkpoint {
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Layout
+    // ─────────────────────────────────────────────────────────────────────────────
+    //
+    //   header       64 bytes, below
+    //   signals      signal_count floats, inputs included
+    //   memory       memory_count floats: filter states, delay rings and their heads
+    //   solver       time, next step size, sample hits and the solver_stats counters (64 bytes)
+    //   states       state_count doubles, the continuous states of the variable-step solver
+    //
+    // Host byte order, as for traces. The checksum is FNV-1a over everything after the header, and
+    // `system` is the simulator's fingerprint: a checkpoint restores only into the same compiled system.
+
+    inline constexpr char magic[8] = {'O', 'C', 'C', 'H', 'E', 'C', 'K', '\0'};
+    inline constexpr std::uint32_t format_version = 1;
+    inline constexpr std::string_view extension = ".ocp";
+
+    struct header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t signal_count;
+        std::uint32_t memory_count;
+        std::uint32_t state_count;
+        std::uint64_t system;
+        std::int64_t steps;
+        std::uint64_t cursor;        // the caller's position in its input, e.g. the next row of a trace
+        std::uint64_t checksum;
+        std::uint64_t reserved;
+    };
+    static_assert(sizeof(header) == 64);
+
+    struct solver_block {
+        double time;
+        double step;
+        std::int64_t hits;
+        std::uint64_t steps;
+        std::uint64_t rejected;
+        std::uint64_t evaluations;
+        std::uint64_t zero_crossings;
+        double last_step;
+    };
+    static_assert(sizeof(solver_block) == 64);
+
+    // A snapshot read back, with the input position saved alongside it
+    struct file {
+        sim::snapshot state;
+        std::uint64_t cursor = 0;
+    };
+
+    class checksum {
+    public:
+        void add(const void* data, std::size_t size) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i) hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+        }
+        [[nodiscard]] auto value() const -> std::uint64_t { return hash_; }
+
+    private:
+        std::uint64_t hash_ = 14695981039346656037ull;
+    };
+
+    // The file name of the checkpoint taken at simulated time steps * dt
+    [[nodiscard]] inline auto path_for(std::string_view prefix, long long steps) -> std::string {
+        return std::string(prefix) + "-" + std::to_string(steps) + std::string(extension);
+    }
+
+    // Written to a temporary name and renamed, so a checkpoint on disk is always complete
+    [[nodiscard]] inline auto write(const std::string& path, const sim::snapshot& state, std::uint64_t cursor) -> bool {
+        solver_block solver{state.time, state.step, state.hits, state.stats.steps, state.stats.rejected,
+                            state.stats.evaluations, state.stats.zero_crossings, state.stats.last_step};
+        auto signals = std::as_bytes(std::span(state.signals));
+        auto memory = std::as_bytes(std::span(state.memory));
+        auto states = std::as_bytes(std::span(state.x));
+
+        header head{};
+        std::memcpy(head.magic, magic, sizeof(magic));
+        head.version = format_version;
+        head.signal_count = static_cast<std::uint32_t>(state.signals.size());
+        head.memory_count = static_cast<std::uint32_t>(state.memory.size());
+        head.state_count = static_cast<std::uint32_t>(state.x.size());
+        head.system = state.system;
+        head.steps = state.steps;
+        head.cursor = cursor;
+        checksum sum;
+        sum.add(signals.data(), signals.size());
+        sum.add(memory.data(), memory.size());
+        sum.add(&solver, sizeof(solver));
+        sum.add(states.data(), states.size());
+        head.checksum = sum.value();
+
+        auto temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+            out.write(reinterpret_cast<const char*>(signals.data()), static_cast<std::streamsize>(signals.size()));
+            out.write(reinterpret_cast<const char*>(memory.data()), static_cast<std::streamsize>(memory.size()));
+            out.write(reinterpret_cast<const char*>(&solver), sizeof(solver));
+            out.write(reinterpret_cast<const char*>(states.data()), static_cast<std::streamsize>(states.size()));
+            if (!out.flush()) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        return !ec;
+    }
+
+    [[nodiscard]] inline auto read(const std::string& path, std::string& error) -> std::optional<file> {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "Could not open " + path;
+            return std::nullopt;
+        }
+        header head{};
+        if (!in.read(reinterpret_cast<char*>(&head), sizeof(head)) || std::memcmp(head.magic, magic, sizeof(magic)) != 0) {
+            error = path + " is not a checkpoint";
+            return std::nullopt;
+        }
+        if (head.version != format_version) {
+            error = path + " has checkpoint version " + std::to_string(head.version);
+            return std::nullopt;
+        }
+
+        file result;
+        auto& state = result.state;
+        state.system = head.system;
+        state.steps = head.steps;
+        state.signals.resize(head.signal_count);
+        state.memory.resize(head.memory_count);
+        state.x.resize(head.state_count);
+        solver_block solver{};
+        in.read(reinterpret_cast<char*>(state.signals.data()), static_cast<std::streamsize>(state.signals.size() * sizeof(float)));
+        in.read(reinterpret_cast<char*>(state.memory.data()), static_cast<std::streamsize>(state.memory.size() * sizeof(float)));
+        in.read(reinterpret_cast<char*>(&solver), sizeof(solver));
+        in.read(reinterpret_cast<char*>(state.x.data()), static_cast<std::streamsize>(state.x.size() * sizeof(double)));
+        if (!in) {
+            error = path + " is truncated";
+            return std::nullopt;
+        }
+        checksum sum;
+        sum.add(state.signals.data(), state.signals.size() * sizeof(float));
+        sum.add(state.memory.data(), state.memory.size() * sizeof(float));
+        sum.add(&solver, sizeof(solver));
+        sum.add(state.x.data(), state.x.size() * sizeof(double));
+        if (sum.value() != head.checksum) {
+            error = path + " is corrupt (checksum mismatch)";
+            return std::nullopt;
+        }
+
+        state.time = solver.time;
+        state.step = solver.step;
+        state.hits = solver.hits;
+        state.stats = {solver.steps, solver.rejected, solver.evaluations, solver.zero_crossings, solver.last_step};
+        result.cursor = head.cursor;
+        return result;
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Background Writer
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Takes snapshots on the stepping thread and writes them on its own. A snapshot is copied into a
+    // spare buffer, which is then swapped with the pending one under a lock held only for the swap;
+    // the thread swaps the pending buffer with the one it writes from. The three buffers keep their
+    // capacity, so after the first checkpoint taking one neither allocates nor waits for the disk. If
+    // the disk falls behind, a pending snapshot not yet taken is replaced by the newer one.
+    class writer {
+    public:
+        explicit writer(std::string prefix) : prefix_(std::move(prefix)), thread_([this] { run(); }) {}
+        writer(const writer&) = delete;
+        auto operator=(const writer&) -> writer& = delete;
+        ~writer() { close(); }
+
+        // Saved as path_for(prefix, step), where step counts dt steps up to the simulator's time
+        void take(const sim::simulator& sim, std::uint64_t cursor, long long step) {
+            sim.save(spare_);
+            {
+                std::lock_guard lock(mutex_);
+                std::swap(spare_, pending_);
+                if (has_pending_) ++dropped_;
+                pending_cursor_ = cursor;
+                pending_step_ = step;
+                has_pending_ = true;
+            }
+            ready_.notify_one();
+        }
+
+        // Writes what is still pending and stops the thread
+        void close() {
+            {
+                std::lock_guard lock(mutex_);
+                if (closing_) return;
+                closing_ = true;
+            }
+            ready_.notify_one();
+            thread_.join();
+        }
+
+        [[nodiscard]] auto written() const -> std::size_t {
+            std::lock_guard lock(mutex_);
+            return written_;
+        }
+        [[nodiscard]] auto dropped() const -> std::size_t {
+            std::lock_guard lock(mutex_);
+            return dropped_;
+        }
+        [[nodiscard]] auto last() const -> std::string {
+            std::lock_guard lock(mutex_);
+            return last_;
+        }
+        [[nodiscard]] auto error() const -> std::string {
+            std::lock_guard lock(mutex_);
+            return error_;
+        }
+
+    private:
+        void run() {
+            for (;;) {
+                std::uint64_t cursor = 0;
+                long long step = 0;
+                {
+                    std::unique_lock lock(mutex_);
+                    ready_.wait(lock, [&] { return has_pending_ || closing_; });
+                    if (!has_pending_) return;
+                    std::swap(pending_, writing_);
+                    cursor = pending_cursor_;
+                    step = pending_step_;
+                    has_pending_ = false;
+                }
+                auto path = path_for(prefix_, step);
+                bool ok = write(path, writing_, cursor);
+                std::lock_guard lock(mutex_);
+                if (ok) {
+                    ++written_;
+                    last_ = path;
+                } else if (error_.empty()) {
+                    error_ = "Could not write " + path;
+                }
+            }
+        }
+
+        std::string prefix_;
+        sim::snapshot spare_;                  // stepping thread only
+        sim::snapshot pending_;                // under mutex_
+        sim::snapshot writing_;                // writer thread only
+        std::uint64_t pending_cursor_ = 0;
+        long long pending_step_ = 0;
+        bool has_pending_ = false;
+        bool closing_ = false;
+        std::size_t written_ = 0;
+        std::size_t dropped_ = 0;
+        std::string last_;
+        std::string error_;
+        mutable std::mutex mutex_;
+        std::condition_variable ready_;
+        std::thread thread_;                   // last, so it starts once everything above is constructed
+    };
+
+} // namespace oc::checkpoint
@@ -17,9 +17,13 @@
 #include <map>
 #include <queue>
 #include <algorithm>
+#include <bit>
 #include <functional>
 #include <cmath>
 #include <iomanip>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <regex>
 
 namespace oc::codegen {
@@ -132,6 +136,230 @@ namespace oc::codegen {
         return oss.str();
     }
 
+    // Format a folded value as a float literal that round-trips
+    inline auto format_constant(double val) -> std::string {
+        if (std::isinf(val)) {
+            return val > 0 ? "std::numeric_limits<float>::infinity()" : "-std::numeric_limits<float>::infinity()";
+        }
+        if (std::isnan(val)) return "std::numeric_limits<float>::quiet_NaN()";
+
+        std::ostringstream oss;
+        oss << std::setprecision(9) << static_cast<float>(val);
+        auto text = oss.str();
+        if (text.find_first_of(".e") == std::string::npos) text += ".0";
+        return text + "f";
+    }
+
+    // Map a Simulink OutDataTypeStr to a C++ type; inherited and fixed-point types give none
+    [[nodiscard]] inline auto cpp_data_type(std::string_view type) -> std::optional<std::string> {
+        static const std::map<std::string, std::string, std::less<>> types = {
+            {"boolean", "bool"}, {"single", "float"}, {"double", "double"},
+            {"int8", "std::int8_t"}, {"uint8", "std::uint8_t"},
+            {"int16", "std::int16_t"}, {"uint16", "std::uint16_t"},
+            {"int32", "std::int32_t"}, {"uint32", "std::uint32_t"}
+        };
+        if (auto it = types.find(type); it != types.end()) return it->second;
+        return std::nullopt;
+    }
+
+    // Zero initializer for a generated C++ scalar type
+    [[nodiscard]] inline auto zero_value(std::string_view type) -> std::string {
+        if (type == "float") return "0.0f";
+        if (type == "double") return "0.0";
+        if (type == "bool") return "false";
+        return "0";
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Parameter Expression Evaluation
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Evaluates scalar MATLAB parameter expressions such as "2*pi*fNom" or "-kp/(1+tau)".
+    // Identifiers resolve through the supplied values; anything else makes the result empty.
+    class expression_evaluator {
+        std::string_view src_;
+        std::size_t pos_ = 0;
+        const std::map<std::string, double>& values_;
+        bool ok_ = true;
+
+    public:
+        explicit expression_evaluator(const std::map<std::string, double>& values) : values_(values) {}
+
+        [[nodiscard]] auto evaluate(std::string_view expr) -> std::optional<double> {
+            src_ = expr;
+            pos_ = 0;
+            ok_ = true;
+            auto v = parse_sum();
+            skip_space();
+            if (!ok_ || pos_ != src_.size()) return std::nullopt;
+            return v;
+        }
+
+    private:
+        void skip_space() {
+            while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) ++pos_;
+        }
+
+        auto accept(char c) -> bool {
+            skip_space();
+            // MATLAB element-wise operators (.* ./ .^) are the scalar operators here
+            if (pos_ + 1 < src_.size() && src_[pos_] == '.' && src_[pos_ + 1] == c && c != '.') {
+                pos_ += 2;
+                return true;
+            }
+            if (pos_ < src_.size() && src_[pos_] == c) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        auto parse_sum() -> double {
+            auto v = parse_product();
+            while (ok_) {
+                if (accept('+')) v += parse_product();
+                else if (accept('-')) v -= parse_product();
+                else break;
+            }
+            return v;
+        }
+
+        auto parse_product() -> double {
+            auto v = parse_unary();
+            while (ok_) {
+                if (accept('*')) v *= parse_unary();
+                else if (accept('/')) v /= parse_unary();
+                else break;
+            }
+            return v;
+        }
+
+        auto parse_unary() -> double {
+            if (accept('-')) return -parse_unary();
+            if (accept('+')) return parse_unary();
+            return parse_power();
+        }
+
+        auto parse_power() -> double {
+            auto base = parse_primary();
+            if (accept('^')) return std::pow(base, parse_unary());
+            return base;
+        }
+
+        auto parse_primary() -> double {
+            skip_space();
+            if (pos_ >= src_.size()) { ok_ = false; return 0.0; }
+
+            if (accept('(')) {
+                auto v = parse_sum();
+                if (!accept(')')) ok_ = false;
+                return v;
+            }
+
+            char c = src_[pos_];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                auto start = pos_;
+                while (pos_ < src_.size() &&
+                       (std::isdigit(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '.')) ++pos_;
+                if (pos_ < src_.size() && (src_[pos_] == 'e' || src_[pos_] == 'E')) {
+                    ++pos_;
+                    if (pos_ < src_.size() && (src_[pos_] == '+' || src_[pos_] == '-')) ++pos_;
+                    while (pos_ < src_.size() && std::isdigit(static_cast<unsigned char>(src_[pos_]))) ++pos_;
+                }
+                try {
+                    return std::stod(std::string(src_.substr(start, pos_ - start)));
+                } catch (...) {
+                    ok_ = false;
+                    return 0.0;
+                }
+            }
+
+            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                auto start = pos_;
+                while (pos_ < src_.size() &&
+                       (std::isalnum(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '_')) ++pos_;
+                auto name = std::string(src_.substr(start, pos_ - start));
+
+                if (accept('(')) {
+                    auto arg = parse_sum();
+                    if (!accept(')')) { ok_ = false; return 0.0; }
+                    if (name == "sqrt") return std::sqrt(arg);
+                    if (name == "exp") return std::exp(arg);
+                    if (name == "log") return std::log(arg);
+                    if (name == "log10") return std::log10(arg);
+                    if (name == "sin") return std::sin(arg);
+                    if (name == "cos") return std::cos(arg);
+                    if (name == "tan") return std::tan(arg);
+                    if (name == "abs") return std::abs(arg);
+                    ok_ = false;
+                    return 0.0;
+                }
+
+                if (name == "pi") return 3.14159265358979323846;
+                if (name == "inf" || name == "Inf") return std::numeric_limits<double>::infinity();
+                if (name == "eps") return static_cast<double>(std::numeric_limits<float>::epsilon());
+                if (name == "true") return 1.0;
+                if (name == "false") return 0.0;
+                if (auto it = values_.find(name); it != values_.end()) return it->second;
+                ok_ = false;
+                return 0.0;
+            }
+
+            ok_ = false;
+            return 0.0;
+        }
+    };
+
+    [[nodiscard]] inline auto evaluate_expression(std::string_view expr, const std::map<std::string, double>& values = {})
+        -> std::optional<double> {
+        return expression_evaluator(values).evaluate(expr);
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Calibration Files
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Parse a calibration file: "name: value" lines, where value is a parameter expression.
+    // A key without a value may be followed by an indented "default:" or "value:" line, so the
+    // CONFIG section of a schema written by mdl_to_yaml can be used as a calibration as well.
+    [[nodiscard]] inline auto parse_calibration(std::string_view text) -> std::map<std::string, double> {
+        std::map<std::string, double> values;
+        std::string pending;
+
+        std::istringstream in{std::string(text)};
+        std::string line;
+        while (std::getline(in, line)) {
+            if (auto hash = line.find('#'); hash != std::string::npos) line.erase(hash);
+            auto colon = line.find(':');
+            if (colon == std::string::npos) continue;
+
+            auto trim = [](std::string str) {
+                auto first = str.find_first_not_of(" \t\r'\"");
+                if (first == std::string::npos) return std::string{};
+                auto last = str.find_last_not_of(" \t\r'\"");
+                return str.substr(first, last - first + 1);
+            };
+            auto key = trim(line.substr(0, colon));
+            auto value = trim(line.substr(colon + 1));
+
+            if (value.empty()) {
+                pending = key;
+                continue;
+            }
+            if (key == "default" || key == "value") {
+                if (!pending.empty()) {
+                    if (auto v = evaluate_expression(value, values)) values[pending] = *v;
+                }
+                continue;
+            }
+            if (auto v = evaluate_expression(value, values)) {
+                values[key] = *v;
+                pending.clear();
+            }
+        }
+        return values;
+    }
+
     // Parse a TransferFcn block and return order
     inline auto parse_transfer_function(const mdl::block& blk) -> transfer_function {
         transfer_function tf;
@@ -149,6 +377,139 @@ namespace oc::codegen {
         return tf;
     }
 
+    // Numeric matrix from MATLAB syntax such as "[1 0.1; 0 1]", one vector per row; entries may
+    // name values bound at generation time
+    [[nodiscard]] inline auto parse_matrix(std::string_view text, const std::map<std::string, double>& values = {})
+        -> std::optional<std::vector<std::vector<double>>> {
+        std::string s(text);
+        std::erase(s, '[');
+        std::erase(s, ']');
+
+        std::vector<std::vector<double>> rows;
+        std::istringstream rows_in(s);
+        for (std::string row; std::getline(rows_in, row, ';');) {
+            std::ranges::replace(row, ',', ' ');
+            std::vector<double> entries;
+            std::istringstream entries_in(row);
+            for (std::string entry; entries_in >> entry;) {
+                auto value = evaluate_expression(entry, values);
+                if (!value) return std::nullopt;
+                entries.push_back(*value);
+            }
+            if (!entries.empty()) rows.push_back(std::move(entries));
+        }
+        return rows;
+    }
+
+    // Discrete filter in direct form II transposed: y = b0*u + z0, z[i] = b[i+1]*u + z[i+1] - a[i+1]*y
+    struct discrete_filter {
+        std::vector<double> num;  // b0, b1, ..., bn in powers of z^-1, normalized by a0
+        std::vector<double> den;  // 1, a1, ..., an
+
+        [[nodiscard]] auto order() const -> int { return static_cast<int>(den.size()) - 1; }
+
+        // Without direct feedthrough the output depends only on the state, so the block breaks
+        // feedback loops like a UnitDelay
+        [[nodiscard]] auto strictly_proper() const -> bool { return order() > 0 && num[0] == 0.0; }
+
+        // z * H(z) of a strictly proper filter: its output is the original's output one step ahead,
+        // which is what a loop-breaking filter leaves in its state for the next step's readers
+        [[nodiscard]] auto advanced() const -> discrete_filter {
+            discrete_filter ahead = *this;
+            ahead.num.erase(ahead.num.begin());
+            ahead.num.push_back(0.0);
+            return ahead;
+        }
+    };
+
+    // DiscreteFilter lists coefficients in ascending powers of z^-1 and DiscreteTransferFcn in
+    // descending powers of z; both end up in z^-1 form with numerator and denominator of one length
+    [[nodiscard]] inline auto parse_discrete_filter(const mdl::block& blk, const std::map<std::string, double>& values = {})
+        -> std::optional<discrete_filter> {
+        auto num = parse_matrix(blk.param("Numerator").value_or("[1]"), values);
+        auto den = parse_matrix(blk.param("Denominator").value_or("[1 0.5]"), values);
+        if (!num || !den || num->size() != 1 || den->size() != 1 || den->front()[0] == 0.0) return std::nullopt;
+
+        discrete_filter filter{.num = num->front(), .den = den->front()};
+        if (blk.type == "DiscreteTransferFcn") {
+            if (filter.num.size() > filter.den.size()) return std::nullopt;  // improper
+            filter.num.insert(filter.num.begin(), filter.den.size() - filter.num.size(), 0.0);
+        }
+        auto length = std::max(filter.num.size(), filter.den.size());
+        filter.num.resize(length, 0.0);
+        filter.den.resize(length, 0.0);
+        auto a0 = filter.den[0];
+        for (auto& c : filter.num) c /= a0;
+        for (auto& c : filter.den) c /= a0;
+        return filter;
+    }
+
+    // Single-input single-output discrete state space: x[k+1] = A*x + B*u, y = C*x + D*u
+    struct discrete_state_space {
+        std::vector<std::vector<double>> a;
+        std::vector<double> b;    // column
+        std::vector<double> c;    // row
+        double d = 0.0;
+    };
+
+    [[nodiscard]] inline auto parse_discrete_state_space(const mdl::block& blk, const std::map<std::string, double>& values = {})
+        -> std::optional<discrete_state_space> {
+        auto a = parse_matrix(blk.param("A").value_or("1"), values);
+        auto b = parse_matrix(blk.param("B").value_or("1"), values);
+        auto c = parse_matrix(blk.param("C").value_or("1"), values);
+        auto d = parse_matrix(blk.param("D").value_or("1"), values);
+        if (!a || !b || !c || !d || a->empty()) return std::nullopt;
+
+        auto n = a->size();
+        if (std::ranges::any_of(*a, [&](const auto& row) { return row.size() != n; })) return std::nullopt;
+        if (b->size() != n || std::ranges::any_of(*b, [](const auto& row) { return row.size() != 1; })) return std::nullopt;
+        if (c->size() != 1 || c->front().size() != n || d->size() != 1 || d->front().size() != 1) return std::nullopt;
+
+        discrete_state_space ss{.a = std::move(*a), .b = {}, .c = c->front(), .d = d->front()[0]};
+        for (const auto& row : *b) ss.b.push_back(row[0]);
+        return ss;
+    }
+
+    // Samples an integer Delay holds, when its length is set in the dialog as a literal or bound value
+    [[nodiscard]] inline auto delay_length(const mdl::block& blk, const std::map<std::string, double>& values = {})
+        -> std::optional<int> {
+        if (blk.param("DelayLengthSource").value_or("Dialog") != "Dialog") return std::nullopt;
+        auto length = evaluate_expression(blk.param("DelayLength").value_or("2"), values);
+        if (!length || *length < 0 || *length != std::floor(*length)) return std::nullopt;
+        return static_cast<int>(*length);
+    }
+
+    // Double literal that reads back as the same value, e.g. "0.99950012496875523"
+    [[nodiscard]] inline auto format_double(double val) -> std::string {
+        std::ostringstream oss;
+        oss << std::setprecision(17) << val;
+        auto text = oss.str();
+        if (text.find_first_of(".e") == std::string::npos) text += ".0";
+        return text;
+    }
+
+    // Sum of weighted terms without zero weights or unit factors, e.g. "x - 0.5f * y"; with exact,
+    // weights are double literals and the sum is evaluated in double
+    [[nodiscard]] inline auto weighted_sum(const std::vector<std::pair<double, std::string>>& terms, bool exact = false)
+        -> std::string {
+        std::string expr;
+        for (const auto& [weight, operand] : terms) {
+            if (weight == 0.0) continue;
+            auto term = operand;
+            if (std::abs(weight) != 1.0) {
+                term = (exact ? format_double(std::abs(weight)) : format_constant(std::abs(weight))) + " * " + term;
+            }
+            if (expr.empty()) expr = (weight < 0 ? "-" : "") + term;
+            else expr += (weight < 0 ? " - " : " + ") + term;
+        }
+        return expr.empty() ? std::string("0.0f") : expr;
+    }
+
+    // Block SID part of a signal key such as "12#out:1"
+    [[nodiscard]] inline auto signal_block_sid(std::string_view key) -> std::string {
+        return std::string(key.substr(0, key.find('#')));
+    }
+
     // Helper function to sanitize names (public for reuse)
     [[nodiscard]] inline auto sanitize_name(std::string_view name) -> std::string {
         std::string result;
@@ -165,12 +526,47 @@ namespace oc::codegen {
         return result;
     }
 
+    // Name of the line feeding a block input port, as used for BusCreator field names
+    [[nodiscard]] inline auto incoming_signal_name(const mdl::system& sys, const std::string& sid, int port)
+        -> std::string {
+        for (const auto& conn : sys.connections) {
+            auto feeds = [&](const std::string& dst_str) {
+                auto dst = mdl::endpoint::parse(dst_str);
+                return dst && dst->block_sid == sid && dst->port_index == port;
+            };
+            bool found = feeds(conn.destination);
+            for (const auto& br : conn.branches) found = found || feeds(br.destination);
+            if (found) return conn.name;
+        }
+        return "";
+    }
+
+    [[nodiscard]] inline auto split_signal_list(std::string_view list) -> std::vector<std::string> {
+        std::vector<std::string> items;
+        std::string item;
+        for (char c : list) {
+            if (c == ',') {
+                if (!item.empty()) items.push_back(item);
+                item.clear();
+            } else if (!std::isspace(static_cast<unsigned char>(c))) {
+                item += c;
+            }
+        }
+        if (!item.empty()) items.push_back(item);
+        return items;
+    }
+
+    // Leaf fields of a bus signal as {dotted path, type}, in declaration order
+    using bus_layout = std::vector<std::pair<std::string, std::string>>;
+
     // Struct to represent a generated component (nested subsystem)
     struct generated_component {
         std::string name;                                              // e.g., "SOGI"
         std::vector<std::pair<std::string, std::string>> inports;      // {name, type}
         std::vector<std::pair<std::string, std::string>> outports;     // {name, type}
         std::vector<std::pair<std::string, std::string>> state_vars;   // {name, comment}
+        std::map<std::string, std::string> state_types;                // state var -> type, when not float
+        std::map<std::string, bus_layout> bus_types;                   // bus struct name -> leaf fields
         std::set<std::string> config_vars;
         std::string operation_code;
         std::vector<generated_component> child_components;             // recursive children
@@ -181,16 +577,291 @@ namespace oc::codegen {
         std::vector<std::pair<std::string, std::string>> inports;      // {name, type}
         std::vector<std::pair<std::string, std::string>> outports;     // {name, type}
         std::vector<std::pair<std::string, std::string>> state_vars;   // {name, comment}
+        std::map<std::string, std::string> state_types;                // state var -> type, when not float
+        std::map<std::string, bus_layout> bus_types;                   // bus struct name -> leaf fields
         std::set<std::string> config_vars;
         std::string operation_code;
         std::vector<generated_component> components;                   // nested subsystem components
     };
 
+    // Closed range of values a signal can take; an unbounded end is infinite
+    struct interval {
+        double lo = -std::numeric_limits<double>::infinity();
+        double hi = std::numeric_limits<double>::infinity();
+
+        [[nodiscard]] static auto point(double value) -> interval { return {value, value}; }
+        [[nodiscard]] auto is_point() const -> bool { return lo == hi; }
+        [[nodiscard]] auto bounded() const -> bool { return std::isfinite(lo) && std::isfinite(hi); }
+        [[nodiscard]] auto contains(double value) const -> bool { return lo <= value && value <= hi; }
+        [[nodiscard]] auto hull(const interval& other) const -> interval {
+            return {std::min(lo, other.lo), std::max(hi, other.hi)};
+        }
+        [[nodiscard]] auto intersect(const interval& other) const -> interval {
+            return {std::max(lo, other.lo), std::min(hi, other.hi)};
+        }
+        // Widened outward so the float arithmetic of the generated code stays inside
+        [[nodiscard]] auto rounded() const -> interval {
+            if (std::isnan(lo) || std::isnan(hi)) return {};
+            return {lo - std::abs(lo) * 1e-6, hi + std::abs(hi) * 1e-6};
+        }
+        auto operator==(const interval&) const -> bool = default;
+    };
+
+    [[nodiscard]] inline auto operator-(const interval& a) -> interval { return {-a.hi, -a.lo}; }
+    [[nodiscard]] inline auto operator+(const interval& a, const interval& b) -> interval { return {a.lo + b.lo, a.hi + b.hi}; }
+    [[nodiscard]] inline auto operator*(const interval& a, const interval& b) -> interval {
+        auto mul = [](double x, double y) { return x == 0.0 || y == 0.0 ? 0.0 : x * y; };  // 0 * inf = 0
+        auto products = {mul(a.lo, b.lo), mul(a.lo, b.hi), mul(a.hi, b.lo), mul(a.hi, b.hi)};
+        return {std::min(products), std::max(products)};
+    }
+    [[nodiscard]] inline auto operator/(const interval& a, const interval& b) -> interval {
+        if (b.contains(0.0)) return {};
+        return a * interval{1.0 / b.hi, 1.0 / b.lo};
+    }
+
+    // Smallest Simulink fixed-point type of 16 or 32 bits holding the range, e.g. "sfix16_En12"
+    [[nodiscard]] inline auto fixed_point_type(const interval& range) -> std::string {
+        if (!range.bounded()) return "unbounded";
+        bool is_signed = range.lo < 0.0;
+        auto magnitude = std::max(std::abs(range.lo), std::abs(range.hi));
+        int integer_bits = magnitude > 0.0 ? std::max(0, static_cast<int>(std::floor(std::log2(magnitude))) + 1) : 0;
+        for (int word : {16, 32}) {
+            int fraction = word - integer_bits - (is_signed ? 1 : 0);
+            if (fraction < 0) continue;
+            auto name = std::string(is_signed ? "sfix" : "ufix") + std::to_string(word);
+            return fraction > 0 ? name + "_En" + std::to_string(fraction) : name;
+        }
+        return "unbounded";
+    }
+
+    // Parse a ranges file: "name: [lo, hi]" lines, or "name: value" for a single value;
+    // either end may be -inf/inf
+    [[nodiscard]] inline auto parse_ranges(std::string_view text) -> std::map<std::string, interval> {
+        std::map<std::string, interval> ranges;
+
+        std::istringstream in{std::string(text)};
+        std::string line;
+        while (std::getline(in, line)) {
+            if (auto hash = line.find('#'); hash != std::string::npos) line.erase(hash);
+            auto colon = line.find(':');
+            if (colon == std::string::npos) continue;
+
+            auto key = line.substr(0, colon);
+            std::erase_if(key, [](char c) { return std::isspace(static_cast<unsigned char>(c)) || c == '\'' || c == '"'; });
+            auto bounds = parse_matrix(line.substr(colon + 1));
+            if (key.empty() || !bounds || bounds->size() != 1) continue;
+
+            const auto& row = bounds->front();
+            if (row.size() == 1) ranges[key] = interval::point(row[0]);
+            else if (row.size() == 2 && row[0] <= row[1]) ranges[key] = {row[0], row[1]};
+        }
+        return ranges;
+    }
+
+    // What --ranges found in one generated function
+    struct range_stats {
+        std::map<std::string, interval> signals;                       // local or state name -> range
+        int clamps_removed = 0;                                        // Saturates that never engage
+        int clamps_narrowed = 0;                                       // Saturates left with one limit
+        int comparisons_folded = 0;                                    // comparisons and Switches decided
+    };
+
+    // Dataflow view of one system: execution order plus the wiring of every block input
+    struct dataflow {
+        std::vector<std::string> sorted_sids;                          // topological execution order
+        std::map<std::string, std::vector<std::string>> block_inputs;  // SID -> input expression per port
+        std::map<std::string, std::vector<std::string>> input_keys;    // SID -> source signal key per port
+        std::map<std::string, std::string> state_var_map;              // SID -> state variable name
+        std::map<std::string, std::string> filter_state;               // banked TransferFcn SID -> field pattern
+        std::set<std::string> state_sids;
+
+        // Filled when specializing against a calibration
+        std::map<std::string, double> constants;                      // signal key -> folded value
+        std::map<std::string, std::string> forwards;                   // signal key -> key it passes through
+        std::set<std::string> removed;                                 // SIDs that emit no code
+
+        // Filled when propagating data types
+        std::map<std::string, std::string> signal_types;               // signal key -> C++ type
+
+        // Bus signals, lowered to their leaf signals: bus key -> {dotted path, leaf signal key}
+        std::map<std::string, std::vector<std::pair<std::string, std::string>>> buses;
+
+        // Filled when scheduling for liveness: peak live signals in the original and the chosen order
+        int max_live_before = 0;
+        int max_live = 0;
+
+        // Filled by range analysis
+        std::map<std::string, interval> ranges;                        // signal key -> values it can take
+        std::map<std::string, mdl::block> narrowed;                    // Saturate SID -> copy keeping one limit
+        int clamps_removed = 0;
+        int clamps_narrowed = 0;
+        int comparisons_folded = 0;
+
+        [[nodiscard]] auto resolve(std::string key) const -> std::string {
+            for (auto it = forwards.find(key); it != forwards.end(); it = forwards.find(key)) key = it->second;
+            return key;
+        }
+
+        [[nodiscard]] auto type_of(const std::string& key) const -> std::string {
+            if (key.empty()) return "float";
+            auto resolved = resolve(key);
+            if (constants.contains(resolved)) return "float";
+            auto it = signal_types.find(resolved);
+            return it != signal_types.end() ? it->second : "float";
+        }
+
+        [[nodiscard]] auto input_types(const std::string& sid) const -> std::vector<std::string> {
+            std::vector<std::string> types;
+            if (auto it = input_keys.find(sid); it != input_keys.end()) {
+                for (const auto& key : it->second) types.push_back(type_of(key));
+            }
+            return types;
+        }
+    };
+
+    // Types of the signals one block reads and writes; empty when types are not propagated.
+    // Bus inputs carry their leaf expressions so they can be passed field by field.
+    struct signal_typing {
+        std::vector<std::string> inputs;
+        std::string output;
+        std::vector<std::vector<std::pair<std::string, std::string>>> input_buses;  // {path, expression}
+    };
+
+    // Options that select optional emission modes; defaults reproduce the plain output
+    struct generator_options {
+        bool update_n = false;           // also emit <elem>_update_n over a window of time steps
+        int window = 64;                 // time steps processed per stateless pass in _update_n
+        std::map<std::string, double> calibration;  // config values bound at generation time
+        bool typed = false;              // propagate block data types instead of float everywhere
+        bool state_space = false;        // compile linear subgraphs into one state-space update
+        bool fuse = false;               // fold single-use signals into their reader's expression
+        bool schedule = false;           // order blocks for few live signals, keep temporaries in scratch slots
+        bool bank = false;               // update TransferFcns in per-order banks, commit delays in one copy
+        bool range_analysis = false;     // drop saturations and comparisons the signal ranges decide
+        std::map<std::string, interval> ranges;  // inport and config ranges seeding the analysis
+        int pipeline = 0;                // also emit <elem>_pipeline over this many threaded stages
+        int parallel = 0;                // also emit <elem>_parallel over up to this many threads
+        std::vector<std::string> derivatives;  // config fields and inports <elem>_ad differentiates by
+    };
+
+    // What --schedule did to one generated function
+    struct schedule_stats {
+        int max_live_before = 0;                                       // peak live signals in the original order
+        int max_live = 0;                                              // peak live signals once rescheduled
+        int scratch_slots = 0;                                         // size of its scratch array
+    };
+
+    // What --pipeline made of one element
+    struct pipeline_stats {
+        int requested = 0;                                             // stages asked for
+        std::vector<int> costs;                                        // estimated cost of each stage, in order
+        int handed_over = 0;                                           // signals crossing a cut
+
+        [[nodiscard]] auto latency() const -> int { return static_cast<int>(costs.size()) - 1; }
+    };
+
+    // What --parallel made of one element
+    struct parallel_stats {
+        int work = 0;                                                  // estimated cost of one step
+        int span = 0;                                                  // cost of its longest dependency chain
+        int groups = 0;                                                // blocks sharing no signal or state
+        int head = 0;                                                  // cost run serially before the partitions
+        int tail = 0;                                                  // and after them
+        std::vector<int> loads;                                        // cost per partition; one when serial
+        std::string serial;                                            // why it fell back to serial code
+
+        [[nodiscard]] auto width() const -> double { return span > 0 ? static_cast<double>(work) / span : 1.0; }
+    };
+
+    // What --ad made of one element
+    struct derivative_stats {
+        std::vector<std::string> seeded;                               // derivative index -> config field or inport
+        std::vector<std::string> missing;                              // asked for but not in the config or input
+    };
+
+    // The blocks one update emits, in execution order, with the dataflow they are emitted from
+    struct block_order {
+        dataflow df;
+        std::map<std::string, std::string> signal_map;
+        std::map<std::string, const generated_component*> component_map;
+        std::vector<const mdl::block*> blocks;
+        std::map<std::string, int> position;                           // SID -> index in blocks
+
+        // A key, or each leaf of a bus
+        [[nodiscard]] auto leaves(const std::string& src_key) const -> std::vector<std::string> {
+            std::vector<std::string> keys{df.resolve(src_key)};
+            if (auto bus = df.buses.find(keys.front()); bus != df.buses.end()) {
+                keys.clear();
+                for (const auto& [path, leaf] : bus->second) keys.push_back(df.resolve(leaf));
+            }
+            return keys;
+        }
+
+        // Index of the block producing a signal; -1 for one no emitted block produces (inports, constants)
+        [[nodiscard]] auto producer(const std::string& key) const -> int {
+            if (df.constants.contains(key)) return -1;
+            auto it = position.find(signal_block_sid(key));
+            return it != position.end() ? it->second : -1;
+        }
+
+        // Calls f(reader, producer, key) for every signal an emitted block reads from another
+        template <typename F>
+        void for_each_read(F&& f) const {
+            for (int b = 0; b < static_cast<int>(blocks.size()); ++b) {
+                auto it = df.input_keys.find(blocks[b]->sid);
+                if (it == df.input_keys.end()) continue;
+                for (const auto& src_key : it->second) {
+                    if (src_key.empty()) continue;
+                    for (const auto& key : leaves(src_key)) {
+                        if (auto p = producer(key); p >= 0) f(b, p, key);
+                    }
+                }
+            }
+        }
+    };
+
+    // Linear blocks of one system replaced by a single x[k+1] = Ax + Bu, y = Cx + Du update
+    struct linear_region {
+        std::set<std::string> blocks;                                  // SIDs the update replaces
+        std::string insert_before;                                     // SID it is emitted ahead of; empty = last
+        std::string code;
+    };
+
+    // Slots --bank gives the states of one system: one array for the delays, one set per TransferFcn order
+    struct state_banks {
+        std::map<std::string, int> delays;                             // UnitDelay/Memory SID -> index
+        std::map<std::string, std::pair<int, int>> filters;            // TransferFcn SID -> {order, index}
+        std::map<int, int> filter_count;                               // order -> TransferFcns in its bank
+    };
+
+    // Same-order TransferFcns of one system updated together by one loop over their bank
+    struct filter_bank {
+        int order = 1;
+        std::vector<std::string> members;                              // SIDs, in loop order
+        std::string insert_before;                                     // SID it is emitted ahead of; empty = last
+    };
+
     class generator {
         const mdl::model* model_ = nullptr;
+        generator_options options_;
         std::string indent_ = "        ";
         int max_inline_depth_ = 10;
 
+        // Fused Gain/Product expressions -> their two factors, so a Sum reading one can use std::fma
+        std::map<std::string, std::pair<std::string, std::string>> fused_products_;
+
+        // Scratch slots of the function being generated, shared with the subsystems inlined into it
+        struct {
+            std::set<int> free;
+            int count = 0;
+        } scratch_;
+        std::map<std::string, schedule_stats> schedule_report_;  // function name -> stats
+        std::map<std::string, range_stats> range_report_;        // function name -> ranges found
+        std::map<std::string, pipeline_stats> pipeline_report_;  // element name -> stages
+        std::map<std::string, parallel_stats> parallel_report_;  // element name -> partitions
+        std::map<std::string, derivative_stats> derivative_report_;  // element name -> seeded derivatives
+        range_stats ranges_;                                     // function being generated, with its inlined systems
+
         // Accumulated state variables from all inlined subsystems
         std::vector<std::pair<std::string, std::string>> all_state_vars_;  // {state_var_name, comment}
 
@@ -199,6 +870,22 @@ namespace oc::codegen {
 
     public:
         void set_model(const mdl::model* m) { model_ = m; }
+        void set_options(const generator_options& o) { options_ = o; }
+
+        // Live-signal and scratch figures of every function generated so far with --schedule
+        [[nodiscard]] auto schedule_report() const -> const std::map<std::string, schedule_stats>& { return schedule_report_; }
+
+        // Signal ranges and decided clamps/comparisons of every function generated so far with range analysis
+        [[nodiscard]] auto range_report() const -> const std::map<std::string, range_stats>& { return range_report_; }
+
+        // Stage costs of every element generated so far with a pipeline
+        [[nodiscard]] auto pipeline_report() const -> const std::map<std::string, pipeline_stats>& { return pipeline_report_; }
+
+        // Width and partitions of every element generated so far with a parallel runner
+        [[nodiscard]] auto parallel_report() const -> const std::map<std::string, parallel_stats>& { return parallel_report_; }
+
+        // Seeded derivatives of every element generated so far with an AD variant
+        [[nodiscard]] auto derivative_report() const -> const std::map<std::string, derivative_stats>& { return derivative_report_; }
 
         // Generate structured parts that can be used by different output formats (OC, C++, etc.)
         [[nodiscard]] auto generate_parts(const mdl::system& sys, std::string_view prefix = "") -> generated_parts {
@@ -207,7 +894,9 @@ namespace oc::codegen {
             all_config_vars_.clear();
 
             // Collect only local state/config variables (not recursing into subsystems)
-            collect_local_variables(sys, std::string(prefix));
+            std::map<std::string, std::string> state_types;
+            collect_local_variables(sys, std::string(prefix), state_types);
+            if (prefix.empty()) pack_banked_states(sys, all_state_vars_, state_types);
 
             // Generate components for each subsystem block
             std::vector<generated_component> components;
@@ -230,39 +919,16 @@ namespace oc::codegen {
             }
 
             // Build component_map (block SID -> generated_component*) for code generation
-            std::map<std::string, const generated_component*> component_map;
-            for (const auto& blk : sys.blocks) {
-                if (!blk.is_subsystem()) continue;
-                auto name = sanitize_name(blk.name);
-                for (const auto& c : components) {
-                    if (c.name == name) {
-                        component_map[blk.sid] = &c;
-                        break;
-                    }
-                }
-            }
+            auto component_map = build_component_map(sys, components);
 
             // Get inputs and outputs
-            auto inports = sys.inports();
-            std::ranges::sort(inports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
-
-            auto outports = sys.outports();
-            std::ranges::sort(outports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
+            auto inports = sorted_by_port(sys.inports());
+            auto outports = sorted_by_port(sys.outports());
 
             // Build inports list
             std::vector<std::pair<std::string, std::string>> inports_list;
             for (const auto& inp : inports) {
-                inports_list.emplace_back(sanitize_name(inp.name), "float");
+                inports_list.emplace_back(sanitize_name(inp.name), declared_type(inp).value_or("float"));
             }
 
             // Build outports list
@@ -281,38 +947,27 @@ namespace oc::codegen {
                 signal_map[key] = "in." + sanitize_name(inp.name);
             }
 
-            generate_system_code(sys, std::string(prefix), signal_map, code, 0, component_map);
+            auto df = generate_system_code(sys, std::string(prefix), signal_map, code, 0, component_map);
 
             // Generate output assignments
             code << "\n" << indent_ << "// Outputs\n";
-            for (const auto& outp : outports) {
-                // Find what connects to this outport
-                for (const auto& conn : sys.connections) {
-                    auto check_dst = [&](const std::string& dst_str) {
-                        if (auto dst = mdl::endpoint::parse(dst_str)) {
-                            if (dst->block_sid == outp.sid) {
-                                if (auto src = mdl::endpoint::parse(conn.source)) {
-                                    auto src_key = src->block_sid + "#out:" + std::to_string(src->port_index);
-                                    if (signal_map.count(src_key)) {
-                                        code << indent_ << "out." << sanitize_name(outp.name)
-                                             << " = " << signal_map[src_key] << ";\n";
-                                    }
-                                }
-                            }
-                        }
-                    };
+            generate_output_assignments(sys, outports, signal_map, code, df);
 
-                    check_dst(conn.destination);
-                    for (const auto& br : conn.branches) {
-                        check_dst(br.destination);
-                    }
-                }
+            drop_calibrated(all_config_vars_, code.view());
+
+            if (options_.typed) {
+                apply_signal_types(df, outports, outports_list, state_types);
             }
+            std::map<std::string, bus_layout> bus_types;
+            apply_bus_types(sanitize_name(sys.name.empty() ? sys.id : sys.name), df,
+                            inports, inports_list, outports, outports_list, bus_types);
 
             return generated_parts{
                 .inports = std::move(inports_list),
                 .outports = std::move(outports_list),
                 .state_vars = all_state_vars_,
+                .state_types = std::move(state_types),
+                .bus_types = std::move(bus_types),
                 .config_vars = all_config_vars_,
                 .operation_code = code.str(),
                 .components = std::move(components)
@@ -327,24 +982,12 @@ namespace oc::codegen {
             func.name = sanitize_name(sys.name.empty() ? sys.id : sys.name);
 
             // Extract inports (sorted by port number)
-            auto inports = sys.inports();
-            std::ranges::sort(inports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
+            auto inports = sorted_by_port(sys.inports());
             for (const auto& inp : inports)
-                func.inports.emplace_back(sanitize_name(inp.name), "float");
+                func.inports.emplace_back(sanitize_name(inp.name), declared_type(inp).value_or("float"));
 
             // Extract outports (sorted by port number)
-            auto outports = sys.outports();
-            std::ranges::sort(outports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
+            auto outports = sorted_by_port(sys.outports());
             for (const auto& outp : outports)
                 func.outports.emplace_back(sanitize_name(outp.name), "float");
 
@@ -368,8 +1011,14 @@ namespace oc::codegen {
                     }
                 }
 
+                for (const auto& field : discrete_state_fields(blk, blk_name)) {
+                    func.state_vars.emplace_back(field.name, field.comment + " in " + func.name);
+                    if (field.type != "float") func.state_types[field.name] = field.type;
+                }
+
                 collect_config_from_block_into(blk, func.config_vars);
             }
+            pack_banked_states(sys, func.state_vars, func.state_types);
 
             // Process child subsystems recursively
             for (const auto& blk : sys.blocks) {
@@ -414,31 +1063,18 @@ namespace oc::codegen {
             }
 
             // Generate system code with component calls for child subsystems
-            generate_system_code(sys, "", signal_map, code, 0, child_component_map);
+            auto df = generate_system_code(sys, "", signal_map, code, 0, child_component_map);
 
             // Generate output assignments
             code << "\n" << indent_ << "// Outputs\n";
-            for (const auto& outp : outports) {
-                for (const auto& conn : sys.connections) {
-                    auto check_dst = [&](const std::string& dst_str) {
-                        if (auto dst = mdl::endpoint::parse(dst_str)) {
-                            if (dst->block_sid == outp.sid) {
-                                if (auto src = mdl::endpoint::parse(conn.source)) {
-                                    auto src_key = src->block_sid + "#out:" + std::to_string(src->port_index);
-                                    if (signal_map.count(src_key)) {
-                                        code << indent_ << "out." << sanitize_name(outp.name)
-                                             << " = " << signal_map[src_key] << ";\n";
-                                    }
-                                }
-                            }
-                        }
-                    };
-                    check_dst(conn.destination);
-                    for (const auto& br : conn.branches) {
-                        check_dst(br.destination);
-                    }
-                }
+            generate_output_assignments(sys, outports, signal_map, code, df);
+
+            drop_calibrated(func.config_vars, code.view());
+
+            if (options_.typed) {
+                apply_signal_types(df, outports, func.outports, func.state_types);
             }
+            apply_bus_types(func.name, df, inports, func.inports, outports, func.outports, func.bus_types);
 
             func.operation_code = code.str();
             return func;
@@ -454,32 +1090,210 @@ namespace oc::codegen {
             std::ostringstream out;
             out << "namespace " << ns_name << " {\n\n";
 
-            // Emit all components depth-first (children before parents)
-            for (const auto& comp : parts.components) {
-                emit_component_cpp(out, comp);
-            }
+            bool needs_config = !parts.config_vars.empty() || !parts.components.empty();
+            emit_element(out, parts, elem_name, needs_config);
 
-            // Input struct
-            out << "    struct " << elem_name << "_input {\n";
-            for (const auto& [name, type] : parts.inports) {
-                out << "        " << type << " " << name << " = 0.0f;\n";
+            if (options_.update_n) {
+                emit_update_n(out, sys, parts, elem_name, needs_config);
             }
-            out << "    };\n\n";
-
-            // Output struct
-            out << "    struct " << elem_name << "_output {\n";
-            for (const auto& [name, type] : parts.outports) {
-                out << "        " << type << " " << name << " = 0.0f;\n";
+            if (options_.pipeline > 0) {
+                emit_pipeline(out, sys, parts, elem_name, needs_config);
+            }
+            if (options_.parallel > 0) {
+                emit_parallel(out, sys, parts, elem_name, needs_config);
+            }
+            if (!options_.derivatives.empty()) {
+                emit_derivatives(out, parts, elem_name, needs_config);
             }
-            out << "    };\n\n";
 
-            // State struct
-            if (!parts.state_vars.empty()) {
-                out << "    struct " << elem_name << "_state {\n";
-                for (const auto& [var, comment] : parts.state_vars) {
-                    bool is_component_state = (comment == "component state");
-                    if (is_component_state) {
+            out << "} // namespace " << ns_name << "\n";
+
+            return out.str();
+        }
+
+        // Generate a standalone benchmark that times a scalar loop of <elem>_update against
+        // <elem>_update_n over the same pseudo-random input trace and compares the outputs
+        [[nodiscard]] auto generate_benchmark(const mdl::system& sys, std::string_view ns_name,
+                                              std::string_view header_name) -> std::string {
+            auto parts = generate_parts(sys, "");
+            auto e = sanitize_name(sys.name.empty() ? sys.id : sys.name);
+            bool needs_config = !parts.config_vars.empty() || !parts.components.empty();
+            bool has_state = !parts.state_vars.empty();
+
+            // Scalar fields of a port; bus ports contribute one field per leaf
+            auto fields = [&](const std::string& name, const std::string& type) {
+                std::vector<std::string> result;
+                if (auto bus = parts.bus_types.find(type); bus != parts.bus_types.end()) {
+                    for (const auto& [path, leaf_type] : bus->second) result.push_back(name + "." + path);
+                } else {
+                    result.push_back(name);
+                }
+                return result;
+            };
+
+            std::ostringstream out;
+            out << "#include \"" << header_name << "\"\n";
+            out << "#include <chrono>\n";
+            out << "#include <cstdint>\n";
+            out << "#include <cstdio>\n";
+            out << "#include <cstdlib>\n";
+            out << "#include <cstring>\n";
+            out << "#include <vector>\n\n";
+
+            out << "auto main(int argc, char* argv[]) -> int {\n";
+            out << "    using namespace " << ns_name << ";\n";
+            out << "    using clock = std::chrono::steady_clock;\n\n";
+            out << "    const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;\n";
+            out << "    constexpr int reps = 5;\n\n";
+
+            out << "    // Deterministic input trace in [-1, 1)\n";
+            out << "    std::uint32_t seed = 12345u;\n";
+            out << "    auto next = [&seed] {\n";
+            out << "        seed = seed * 1664525u + 1013904223u;\n";
+            out << "        return static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;\n";
+            out << "    };\n";
+            out << "    std::vector<" << e << "_input> in(n);\n";
+            out << "    for (auto& s : in) {\n";
+            for (const auto& [name, type] : parts.inports) {
+                for (const auto& field : fields(name, type))
+                    out << "        s." << field << " = next();\n";
+            }
+            if (parts.inports.empty())
+                out << "        (void)s;\n";
+            out << "    }\n\n";
+
+            if (needs_config) {
+                out << "    " << e << "_config cfg{};\n";
+                for (const auto& var : parts.config_vars)
+                    out << "    cfg." << var << " = 0.5f;\n";
+                out << "\n";
+            }
+
+            std::string cfg_arg = needs_config ? "cfg, " : "";
+            std::string state_arg_scalar = has_state ? "state, " : "";
+            std::string state_arg_window = has_state ? ", state" : "";
+            std::string cfg_arg_window = needs_config ? ", cfg" : "";
+
+            out << "    std::vector<" << e << "_output> out_scalar(n), out_window(n);\n";
+            if (has_state) out << "    " << e << "_state state_scalar{}, state_window{};\n";
+            out << "    double best_scalar = 1e30, best_window = 1e30;\n\n";
+            out << "    for (int r = 0; r < reps; ++r) {\n";
+            if (has_state) out << "        auto& state = state_scalar = {};\n";
+            out << "        auto t0 = clock::now();\n";
+            out << "        for (std::size_t i = 0; i < n; ++i)\n";
+            out << "            " << e << "_update(in[i], " << cfg_arg << state_arg_scalar << "out_scalar[i]);\n";
+            out << "        auto t1 = clock::now();\n";
+            out << "        best_scalar = std::min(best_scalar, std::chrono::duration<double>(t1 - t0).count());\n";
+            out << "    }\n\n";
+            out << "    for (int r = 0; r < reps; ++r) {\n";
+            if (has_state) out << "        auto& state = state_window = {};\n";
+            out << "        auto t0 = clock::now();\n";
+            out << "        " << e << "_update_n(in, out_window, n" << cfg_arg_window << state_arg_window << ");\n";
+            out << "        auto t1 = clock::now();\n";
+            out << "        best_window = std::min(best_window, std::chrono::duration<double>(t1 - t0).count());\n";
+            out << "    }\n\n";
+
+            out << "    double max_diff = 0.0;\n";
+            out << "    for (std::size_t i = 0; i < n; ++i) {\n";
+            for (const auto& [name, type] : parts.outports) {
+                for (const auto& field : fields(name, type))
+                    out << "        max_diff = std::max(max_diff, std::abs(static_cast<double>(out_scalar[i]." << field
+                        << ") - static_cast<double>(out_window[i]." << field << ")));\n";
+            }
+            out << "    }\n\n";
+
+            out << "    std::printf(\"" << e << ": %zu steps\\n\", n);\n";
+            out << "    std::printf(\"  _update loop : %8.2f ns/step\\n\", best_scalar * 1e9 / static_cast<double>(n));\n";
+            out << "    std::printf(\"  _update_n    : %8.2f ns/step\\n\", best_window * 1e9 / static_cast<double>(n));\n";
+            out << "    std::printf(\"  speedup      : %8.2fx\\n\", best_scalar / best_window);\n";
+            out << "    std::printf(\"  max |diff|   : %g\\n\", max_diff);\n";
+            if (has_state) {
+                out << "    std::printf(\"  final state  : %s\\n\",\n";
+                out << "        std::memcmp(&state_scalar, &state_window, sizeof(state_scalar)) == 0 ? \"identical\" : \"differs\");\n";
+            }
+            out << "    return 0;\n";
+            out << "}\n";
+
+            return out.str();
+        }
+
+    private:
+        // Map subsystem block SIDs to the generated component that implements them
+        [[nodiscard]] static auto build_component_map(const mdl::system& sys,
+                                                      const std::vector<generated_component>& components)
+            -> std::map<std::string, const generated_component*> {
+            std::map<std::string, const generated_component*> component_map;
+            for (const auto& blk : sys.blocks) {
+                if (!blk.is_subsystem()) continue;
+                auto name = sanitize_name(blk.name);
+                for (const auto& c : components) {
+                    if (c.name == name) {
+                        component_map[blk.sid] = &c;
+                        break;
+                    }
+                }
+            }
+            return component_map;
+        }
+
+        [[nodiscard]] static auto sorted_by_port(std::vector<mdl::block> ports) -> std::vector<mdl::block> {
+            std::ranges::sort(ports, [](const auto& a, const auto& b) {
+                int pa = 1, pb = 1;
+                if (auto v = a.param("Port")) pa = std::stoi(*v);
+                if (auto v = b.param("Port")) pb = std::stoi(*v);
+                return pa < pb;
+            });
+            return ports;
+        }
+
+        // Rough per-step cost of a stateless block, used to decide whether a separate pass pays off
+        [[nodiscard]] static auto stateless_cost(const mdl::block& blk) -> int {
+            if (blk.type == "Trigonometry") return 20;
+            if (blk.type == "Math") {
+                auto func = blk.param("Operator").value_or("sqrt");
+                if (func == "square") return 1;
+                return func == "sqrt" ? 4 : 20;
+            }
+            if (blk.type == "Product" && blk.param("Inputs").value_or("**").find('/') != std::string::npos) return 4;
+            return 1;
+        }
+
+        // Components, port, state and config structs and <elem>_update of one element
+        void emit_element(std::ostringstream& out, const generated_parts& parts, const std::string& elem_name,
+                          bool needs_config) {
+            // Emit all components depth-first (children before parents)
+            for (const auto& comp : parts.components) {
+                emit_component_cpp(out, comp);
+            }
+
+            // Bus structs used by the ports
+            for (const auto& [name, layout] : parts.bus_types) {
+                emit_bus_struct(out, name, layout);
+            }
+
+            // Input struct
+            out << "    struct " << elem_name << "_input {\n";
+            for (const auto& [name, type] : parts.inports) {
+                out << "        " << port_declaration(name, type, parts.bus_types) << "\n";
+            }
+            out << "    };\n\n";
+
+            // Output struct
+            out << "    struct " << elem_name << "_output {\n";
+            for (const auto& [name, type] : parts.outports) {
+                out << "        " << port_declaration(name, type, parts.bus_types) << "\n";
+            }
+            out << "    };\n\n";
+
+            // State struct
+            if (!parts.state_vars.empty()) {
+                out << "    struct " << elem_name << "_state {\n";
+                for (const auto& [var, comment] : parts.state_vars) {
+                    bool is_component_state = (comment == "component state");
+                    if (is_component_state) {
                         out << "        " << var << "_state " << var << "{};";
+                    } else if (auto it = parts.state_types.find(var); it != parts.state_types.end()) {
+                        out << "        " << state_declaration(it->second, var);
                     } else {
                         out << "        float " << var << " = 0.0f;";
                     }
@@ -490,7 +1304,6 @@ namespace oc::codegen {
             }
 
             // Config struct (emit if there are config vars or components that need config)
-            bool needs_config = !parts.config_vars.empty() || !parts.components.empty();
             if (needs_config) {
                 out << "    struct " << elem_name << "_config {\n";
                 for (const auto& var : parts.config_vars) {
@@ -515,12 +1328,998 @@ namespace oc::codegen {
             out << parts.operation_code;
 
             out << "    }\n\n";
-            out << "} // namespace " << ns_name << "\n";
+        }
 
-            return out.str();
+        // Text of generated code with every float a dual and the math calls routed to dual_math, whose
+        // overloads take the float ones from std and add the dual ones. Numeric literals and the float
+        // of numeric_limits<float> are left alone.
+        [[nodiscard]] static auto dual_code(std::string_view code) -> std::string {
+            static const std::set<std::string_view> math = {
+                "abs", "min", "max", "clamp", "sqrt", "exp", "log", "log10", "pow", "fma",
+                "sin", "cos", "tan", "asin", "acos", "atan", "sinh", "cosh", "tanh"
+            };
+            auto word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+            std::string result;
+            std::size_t i = 0;
+            while (i < code.size()) {
+                if (!word(code[i])) {
+                    result += code[i++];
+                    continue;
+                }
+                auto start = i;
+                if (std::isdigit(static_cast<unsigned char>(code[i]))) {
+                    while (i < code.size() && (word(code[i]) || code[i] == '.' ||
+                                               ((code[i] == '-' || code[i] == '+') && (code[i - 1] == 'e' || code[i - 1] == 'E')))) ++i;
+                    result += code.substr(start, i - start);
+                    continue;
+                }
+                while (i < code.size() && word(code[i])) ++i;
+                auto token = code.substr(start, i - start);
+                if (token == "float" && !result.ends_with("numeric_limits<")) {
+                    result += "dual";
+                } else if (token == "std" && code.substr(i).starts_with("::")) {
+                    auto name_end = i + 2;
+                    while (name_end < code.size() && word(code[name_end])) ++name_end;
+                    auto name = code.substr(i + 2, name_end - i - 2);
+                    if (math.contains(name) && name_end < code.size() && code[name_end] == '(') {
+                        result += "dual_math::";
+                        result += name;
+                        i = name_end;
+                    } else {
+                        result += token;
+                    }
+                } else {
+                    result += token;
+                }
+            }
+            return result;
+        }
+
+        // Emit <elem>_ad, a forward-mode automatic differentiation variant of the element: its structs
+        // and update again, with every float a dual number that carries, next to its value, its
+        // derivatives by the seeded config fields and inports. The update then propagates them through
+        // each block by the chain rule, so one pass gives the outputs and their sensitivities: Tustin
+        // transfer functions differentiate through their dt-dependent coefficients, Saturate, MinMax
+        // and Switch pass on the derivative of the branch taken, and Math and Trigonometry blocks apply
+        // the derivative of their function.
+        void emit_derivatives(std::ostringstream& out, const generated_parts& parts, const std::string& elem_name,
+                              bool needs_config) {
+            auto& stats = derivative_report_[elem_name];
+            stats = {};
+            std::vector<std::string> fields;
+            for (const auto& name : options_.derivatives) {
+                auto field = sanitize_name(name);
+                bool inport = std::ranges::any_of(parts.inports, [&](const auto& port) {
+                    return port.first == field && !parts.bus_types.contains(port.second);
+                });
+                if (needs_config && (field == "dt" || parts.config_vars.contains(field))) {
+                    fields.push_back("cfg." + field);
+                } else if (inport) {
+                    fields.push_back("in." + field);
+                } else {
+                    stats.missing.push_back(name);
+                    continue;
+                }
+                stats.seeded.push_back(name);
+            }
+            if (fields.empty()) return;
+            auto n = std::to_string(fields.size());
+
+            std::ostringstream element;
+            emit_element(element, parts, elem_name, needs_config);
+
+            out << "    // Forward-mode AD variant of " << elem_name << "_update: the same structs and update with every\n";
+            out << "    // float a dual number carrying its derivatives by the fields in wrt, so one pass gives the\n";
+            out << "    // outputs and their sensitivities. seed() marks those fields on the input and config.\n";
+            out << "    namespace " << elem_name << "_ad {\n\n";
+            out << "        // Derivative index -> the field it is taken with respect to\n";
+            out << "        inline constexpr const char* wrt[] = {";
+            for (std::size_t i = 0; i < fields.size(); ++i) out << (i ? ", " : "") << "\"" << fields[i] << "\"";
+            out << "};\n\n";
+
+            out << "        struct dual {\n";
+            out << "            static constexpr int n = " << n << ";\n";
+            out << "            float v = 0.0f;\n";
+            out << "            float d[n] = {};\n\n";
+            out << "            dual() = default;\n";
+            out << "            dual(float value) : v(value) {}\n";
+            out << "            explicit operator float() const { return v; }\n\n";
+            out << "            // Value v, with derivatives da times those of a (plus db times those of b)\n";
+            out << "            static auto chain(const dual& a, float v, float da) -> dual {\n";
+            out << "                dual r(v);\n";
+            out << "                for (int i = 0; i < n; ++i) r.d[i] = da * a.d[i];\n";
+            out << "                return r;\n";
+            out << "            }\n";
+            out << "            static auto chain(const dual& a, const dual& b, float v, float da, float db) -> dual {\n";
+            out << "                dual r(v);\n";
+            out << "                for (int i = 0; i < n; ++i) r.d[i] = da * a.d[i] + db * b.d[i];\n";
+            out << "                return r;\n";
+            out << "            }\n\n";
+            out << "            friend auto operator+(const dual& a, const dual& b) -> dual { return chain(a, b, a.v + b.v, 1.0f, 1.0f); }\n";
+            out << "            friend auto operator+(const dual& a, float b) -> dual { return chain(a, a.v + b, 1.0f); }\n";
+            out << "            friend auto operator+(float a, const dual& b) -> dual { return chain(b, a + b.v, 1.0f); }\n";
+            out << "            friend auto operator-(const dual& a, const dual& b) -> dual { return chain(a, b, a.v - b.v, 1.0f, -1.0f); }\n";
+            out << "            friend auto operator-(const dual& a, float b) -> dual { return chain(a, a.v - b, 1.0f); }\n";
+            out << "            friend auto operator-(float a, const dual& b) -> dual { return chain(b, a - b.v, -1.0f); }\n";
+            out << "            friend auto operator*(const dual& a, const dual& b) -> dual { return chain(a, b, a.v * b.v, b.v, a.v); }\n";
+            out << "            friend auto operator*(const dual& a, float b) -> dual { return chain(a, a.v * b, b); }\n";
+            out << "            friend auto operator*(float a, const dual& b) -> dual { return chain(b, a * b.v, a); }\n";
+            out << "            friend auto operator/(const dual& a, const dual& b) -> dual {\n";
+            out << "                float v = a.v / b.v;\n";
+            out << "                return chain(a, b, v, 1.0f / b.v, -v / b.v);\n";
+            out << "            }\n";
+            out << "            friend auto operator/(const dual& a, float b) -> dual { return chain(a, a.v / b, 1.0f / b); }\n";
+            out << "            friend auto operator/(float a, const dual& b) -> dual {\n";
+            out << "                float v = a / b.v;\n";
+            out << "                return chain(b, v, -v / b.v);\n";
+            out << "            }\n";
+            out << "            friend auto operator-(const dual& a) -> dual { return chain(a, -a.v, -1.0f); }\n";
+            out << "            auto operator+=(const dual& b) -> dual& { return *this = *this + b; }\n";
+            out << "            auto operator-=(const dual& b) -> dual& { return *this = *this - b; }\n";
+            out << "            auto operator*=(const dual& b) -> dual& { return *this = *this * b; }\n";
+            out << "            auto operator/=(const dual& b) -> dual& { return *this = *this / b; }\n\n";
+            out << "            // Comparisons, and so Switch conditions, look at the values only\n";
+            out << "            friend auto operator==(const dual& a, const dual& b) -> bool { return a.v == b.v; }\n";
+            out << "            friend auto operator!=(const dual& a, const dual& b) -> bool { return a.v != b.v; }\n";
+            out << "            friend auto operator<(const dual& a, const dual& b) -> bool { return a.v < b.v; }\n";
+            out << "            friend auto operator<=(const dual& a, const dual& b) -> bool { return a.v <= b.v; }\n";
+            out << "            friend auto operator>(const dual& a, const dual& b) -> bool { return a.v > b.v; }\n";
+            out << "            friend auto operator>=(const dual& a, const dual& b) -> bool { return a.v >= b.v; }\n";
+            out << "        };\n\n";
+
+            out << "        // The float functions of std plus their dual counterparts; a function that picks one of its\n";
+            out << "        // arguments (min, max, clamp) passes on that argument's derivatives\n";
+            out << "        namespace dual_math {\n";
+            out << "            using std::abs, std::min, std::max, std::clamp, std::sqrt, std::exp, std::log, std::log10, std::pow, std::fma;\n";
+            out << "            using std::sin, std::cos, std::tan, std::asin, std::acos, std::atan, std::sinh, std::cosh, std::tanh;\n\n";
+            out << "            inline auto abs(const dual& a) -> dual { return dual::chain(a, std::abs(a.v), a.v > 0.0f ? 1.0f : a.v < 0.0f ? -1.0f : 0.0f); }\n";
+            out << "            inline auto min(const dual& a, const dual& b) -> dual { return b < a ? b : a; }\n";
+            out << "            inline auto max(const dual& a, const dual& b) -> dual { return a < b ? b : a; }\n";
+            out << "            inline auto clamp(const dual& x, const dual& lo, const dual& hi) -> dual { return x < lo ? lo : hi < x ? hi : x; }\n";
+            out << "            inline auto fma(const dual& a, const dual& b, const dual& c) -> dual { return a * b + c; }\n";
+            out << "            inline auto sqrt(const dual& a) -> dual {\n";
+            out << "                float v = std::sqrt(a.v);\n";
+            out << "                return dual::chain(a, v, v > 0.0f ? 0.5f / v : 0.0f);\n";
+            out << "            }\n";
+            out << "            inline auto exp(const dual& a) -> dual {\n";
+            out << "                float v = std::exp(a.v);\n";
+            out << "                return dual::chain(a, v, v);\n";
+            out << "            }\n";
+            out << "            inline auto log(const dual& a) -> dual { return dual::chain(a, std::log(a.v), 1.0f / a.v); }\n";
+            out << "            inline auto log10(const dual& a) -> dual { return dual::chain(a, std::log10(a.v), 0.4342944819f / a.v); }\n";
+            out << "            inline auto pow(const dual& a, const dual& b) -> dual {\n";
+            out << "                float v = std::pow(a.v, b.v);\n";
+            out << "                return dual::chain(a, b, v, b.v * std::pow(a.v, b.v - 1.0f), a.v > 0.0f ? v * std::log(a.v) : 0.0f);\n";
+            out << "            }\n";
+            out << "            inline auto sin(const dual& a) -> dual { return dual::chain(a, std::sin(a.v), std::cos(a.v)); }\n";
+            out << "            inline auto cos(const dual& a) -> dual { return dual::chain(a, std::cos(a.v), -std::sin(a.v)); }\n";
+            out << "            inline auto tan(const dual& a) -> dual {\n";
+            out << "                float v = std::tan(a.v);\n";
+            out << "                return dual::chain(a, v, 1.0f + v * v);\n";
+            out << "            }\n";
+            out << "            inline auto asin(const dual& a) -> dual { return dual::chain(a, std::asin(a.v), 1.0f / std::sqrt(1.0f - a.v * a.v)); }\n";
+            out << "            inline auto acos(const dual& a) -> dual { return dual::chain(a, std::acos(a.v), -1.0f / std::sqrt(1.0f - a.v * a.v)); }\n";
+            out << "            inline auto atan(const dual& a) -> dual { return dual::chain(a, std::atan(a.v), 1.0f / (1.0f + a.v * a.v)); }\n";
+            out << "            inline auto sinh(const dual& a) -> dual { return dual::chain(a, std::sinh(a.v), std::cosh(a.v)); }\n";
+            out << "            inline auto cosh(const dual& a) -> dual { return dual::chain(a, std::cosh(a.v), std::sinh(a.v)); }\n";
+            out << "            inline auto tanh(const dual& a) -> dual {\n";
+            out << "                float v = std::tanh(a.v);\n";
+            out << "                return dual::chain(a, v, 1.0f - v * v);\n";
+            out << "            }\n";
+            out << "        } // namespace dual_math\n\n";
+
+            // The element again, one level deeper
+            std::istringstream lines(dual_code(element.str()));
+            for (std::string line; std::getline(lines, line);) {
+                out << (line.empty() ? "" : "    ") << line << "\n";
+            }
+
+            out << "        // Derivative i of the result is by wrt[i]: set its derivative to 1 on the input and config\n";
+            out << "        inline void seed(";
+            if (needs_config) out << "[[maybe_unused]] " << elem_name << "_config& cfg, ";
+            out << "[[maybe_unused]] " << elem_name << "_input& in) {\n";
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                out << "            " << fields[i] << ".d[" << i << "] = 1.0f;\n";
+            }
+            out << "        }\n\n";
+            out << "    } // namespace " << elem_name << "_ad\n\n";
+        }
+
+        // Emit <elem>_update_n, which advances the element over n time steps in one call.
+        // The state is copied into a local that stays in registers across the window and is written
+        // back once at the end. When the stateless blocks fed only by inputs carry enough work (math
+        // functions, divisions), they are split into a pass of their own over each window: the inputs
+        // they read are gathered into per-field arrays so the pass has unit stride and no loop-carried
+        // dependency, which lets the compiler vectorize it. Cheap arithmetic stays in the per-step loop,
+        // where it executes in the shadow of the state recurrences.
+        void emit_update_n(std::ostringstream& out, const mdl::system& sys, const generated_parts& parts,
+                           const std::string& elem_name, bool needs_config)
+        {
+            constexpr int split_cost = 16;
+
+            auto inports = sorted_by_port(sys.inports());
+            auto outports = sorted_by_port(sys.outports());
+            auto component_map = build_component_map(sys, parts.components);
+
+            std::map<std::string, std::string> signal_map;
+            std::map<std::string, std::string> window_map;  // inports read from gathered window arrays
+            auto window_array = [](std::string access) {
+                std::ranges::replace(access, '.', '_');
+                return "in_" + access + "_w";
+            };
+            for (const auto& inp : inports) {
+                auto name = sanitize_name(inp.name);
+                auto key = inp.sid + "#out:1";
+                signal_map[key] = "in." + name;
+                window_map[key] = window_array(name) + "[step]";
+                // Bus inports are flattened to one unit-stride array per leaf field
+                for (const auto& path : selected_paths(sys, key, component_map)) {
+                    window_map[key + "." + path] = window_array(name + "." + path) + "[step]";
+                }
+            }
+
+            auto df = build_dataflow(sys, "", signal_map);
+            auto window_df = build_dataflow(sys, "", window_map);
+            lower_buses(sys, df, signal_map, component_map);
+            lower_buses(sys, window_df, window_map, component_map);
+            if (options_.typed) {
+                infer_types(sys, df, component_map);
+                infer_types(sys, window_df, component_map);
+            }
+            std::vector<linear_region> linear;
+            if (options_.state_space) {
+                auto saved_indent = indent_;
+                indent_ = "                ";
+                linear = compile_linear_regions(sys, df, signal_map, "");
+                indent_ = saved_indent;
+            }
+
+            // Blocks whose every input is an inport or another hoisted block
+            std::set<std::string> hoisted;
+            std::map<std::string, std::string> gathered;  // input field access -> type
+            int hoisted_cost = 0;
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || !is_stateless(*blk) || df.removed.contains(sid)) continue;
+                if (std::ranges::any_of(linear, [&](const auto& region) { return region.blocks.contains(sid); })) continue;
+
+                bool input_only = true;
+                std::map<std::string, std::string> reads;
+                for (const auto& src_key : df.input_keys[sid]) {
+                    if (src_key.empty() || df.constants.contains(df.resolve(src_key))) continue;
+                    auto key = df.resolve(src_key);
+                    auto src = signal_block_sid(key);
+                    auto* src_blk = sys.find_block_by_sid(src);
+                    if (src_blk && src_blk->is_inport()) {
+                        auto field = key.substr(key.find("#out:1") + 6);  // ".path" for a bus leaf
+                        reads[sanitize_name(src_blk->name) + field] = df.type_of(key);
+                    } else if (!hoisted.contains(src)) {
+                        input_only = false;
+                        break;
+                    }
+                }
+                if (input_only) {
+                    hoisted.insert(sid);
+                    gathered.insert(reads.begin(), reads.end());
+                    hoisted_cost += stateless_cost(*blk);
+                }
+            }
+            if (hoisted_cost < split_cost) {
+                hoisted.clear();
+                gathered.clear();
+            }
+
+            // Hoisted signals read by the per-step pass are carried across in window arrays
+            std::vector<std::string> carried;
+            std::map<std::string, std::string> carried_types;
+            for (const auto& [sid, sources] : df.input_keys) {
+                if (hoisted.contains(sid) || df.removed.contains(sid)) continue;
+                for (const auto& src_key : sources) {
+                    // A bus carries each of its leaves
+                    std::vector<std::string> keys{df.resolve(src_key)};
+                    if (auto bus = df.buses.find(keys.front()); bus != df.buses.end()) {
+                        keys.clear();
+                        for (const auto& [path, leaf] : bus->second) keys.push_back(df.resolve(leaf));
+                    }
+                    for (const auto& key : keys) {
+                        auto var = signal_map[key];
+                        if (hoisted.contains(signal_block_sid(key)) && std::ranges::find(carried, var) == carried.end()) {
+                            carried.push_back(var);
+                            carried_types[var] = df.type_of(key);
+                        }
+                    }
+                }
+            }
+
+            auto saved_indent = indent_;
+            indent_ = "                ";
+
+            std::ostringstream stateless_code;
+            std::ostringstream step_code;
+            for (const auto& sid : df.sorted_sids) {
+                if (emit_linear_regions(linear, sid, step_code)) continue;
+
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || blk->is_inport() || blk->is_outport() || df.removed.contains(sid)) continue;
+                if (auto it = df.narrowed.find(sid); it != df.narrowed.end()) blk = &it->second;
+
+                auto var_prefix = sanitize_name(blk->name);
+                auto out_var = signal_map[sid + "#out:1"];
+                auto state_var = block_state(df, sid);
+
+                if (hoisted.contains(sid)) {
+                    generate_block_code(*blk, window_df.block_inputs[sid], out_var, var_prefix, state_var,
+                                        window_map, stateless_code, 0, component_map, block_types(window_df, sid, window_map));
+                } else {
+                    generate_block_code(*blk, df.block_inputs[sid], out_var, var_prefix, state_var,
+                                        signal_map, step_code, 0, component_map, block_types(df, sid, signal_map));
+                }
+            }
+            emit_linear_regions(linear, "", step_code);
+            step_code << "\n" << indent_ << "// Outputs\n";
+            generate_output_assignments(sys, outports, signal_map, step_code, df);
+
+            indent_ = saved_indent;
+
+            bool has_state = !parts.state_vars.empty();
+
+            out << "    inline auto " << elem_name << "_update_n(\n";
+            out << "        std::span<const " << elem_name << "_input> in_n,\n";
+            out << "        std::span<" << elem_name << "_output> out_n,\n";
+            out << "        std::size_t n";
+            if (needs_config) out << ",\n        const " << elem_name << "_config& cfg";
+            if (has_state) out << ",\n        " << elem_name << "_state& state_n";
+            out << ") -> void\n";
+            out << "    {\n";
+            if (has_state) {
+                out << "        auto state = state_n;  // working copy, written back after the last step\n";
+            }
+            out << "        constexpr std::size_t window = " << options_.window << ";\n\n";
+            out << "        for (std::size_t base = 0; base < n; base += window) {\n";
+            out << "            const auto count = std::min(window, n - base);\n";
+
+            if (!hoisted.empty()) {
+                for (const auto& [access, type] : gathered) {
+                    out << "            " << type << " " << window_array(access) << "[window];\n";
+                }
+                for (const auto& var : carried) {
+                    out << "            " << carried_types[var] << " " << var << "_w[window];\n";
+                }
+                out << "\n";
+                out << "            // Gather the inputs read by the stateless pass into unit-stride arrays\n";
+                out << "            for (std::size_t step = 0; step < count; ++step) {\n";
+                for (const auto& [access, type] : gathered) {
+                    out << "                " << window_array(access) << "[step] = in_n[base + step]." << access << ";\n";
+                }
+                out << "            }\n\n";
+                out << "            // Stateless pass: blocks fed only by inputs, for the whole window\n";
+                out << "            for (std::size_t step = 0; step < count; ++step) {\n";
+                out << stateless_code.str();
+                for (const auto& var : carried) {
+                    out << "                " << var << "_w[step] = " << var << ";\n";
+                }
+                out << "            }\n";
+            }
+
+            out << "\n";
+            out << "            // Per-step pass: everything that reads or writes state\n";
+            out << "            for (std::size_t step = 0; step < count; ++step) {\n";
+            out << "                [[maybe_unused]] const auto& in = in_n[base + step];\n";
+            out << "                auto& out = out_n[base + step];\n";
+            for (const auto& var : carried) {
+                out << "                const auto " << var << " = " << var << "_w[step];\n";
+            }
+            out << step_code.str();
+            out << "            }\n";
+            out << "        }\n";
+            if (has_state) {
+                out << "\n        state_n = state;\n";
+            }
+            out << "    }\n\n";
+        }
+
+        // Rough per-step cost of any block, for balancing pipeline stages; a subsystem costs what its blocks do
+        [[nodiscard]] auto block_cost(const mdl::block& blk, int depth = 0) const -> int {
+            if (blk.is_subsystem()) {
+                const auto* subsys = model_ && depth < max_inline_depth_ ? model_->get_system(blk.subsystem_ref) : nullptr;
+                if (!subsys) return 1;
+                int cost = 0;
+                for (const auto& child : subsys->blocks) {
+                    if (!child.is_inport() && !child.is_outport()) cost += block_cost(child, depth + 1);
+                }
+                return std::max(cost, 1);
+            }
+            if (is_stateless(blk)) return stateless_cost(blk);
+            if (blk.type == "TransferFcn") return 2 + 2 * parse_transfer_function(blk).order;
+            return 2;
+        }
+
+        [[nodiscard]] static auto is_identifier(std::string_view text) -> bool {
+            if (text.empty() || std::isdigit(static_cast<unsigned char>(text.front()))) return false;
+            return std::ranges::all_of(text, [](unsigned char c) { return std::isalnum(c) || c == '_'; });
+        }
+
+        // The blocks an update emits, ordered as in <elem>_update, for modes that split it across threads
+        [[nodiscard]] auto emission_order(const mdl::system& sys, const generated_parts& parts) -> block_order {
+            block_order graph;
+            graph.component_map = build_component_map(sys, parts.components);
+            for (const auto& inp : sorted_by_port(sys.inports())) {
+                graph.signal_map[inp.sid + "#out:1"] = "in." + sanitize_name(inp.name);
+            }
+            graph.df = build_dataflow(sys, "", graph.signal_map);
+            lower_buses(sys, graph.df, graph.signal_map, graph.component_map);
+            if (options_.typed) {
+                infer_types(sys, graph.df, graph.component_map);
+            }
+            for (const auto& sid : graph.df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || blk->is_inport() || blk->is_outport() || graph.df.removed.contains(sid)) continue;
+                graph.position[sid] = static_cast<int>(graph.blocks.size());
+                graph.blocks.push_back(blk);
+            }
+            return graph;
+        }
+
+        // Code of one block of an emission order
+        void emit_block(block_order& graph, int b, std::ostringstream& code) {
+            auto& df = graph.df;
+            const auto& sid = graph.blocks[b]->sid;
+            const auto* blk = graph.blocks[b];
+            if (auto it = df.narrowed.find(sid); it != df.narrowed.end()) blk = &it->second;
+            generate_block_code(*blk, df.block_inputs[sid], graph.signal_map[sid + "#out:1"], sanitize_name(blk->name),
+                                block_state(df, sid), graph.signal_map, code, 0, graph.component_map,
+                                block_types(df, sid, graph.signal_map));
+        }
+
+        // Output assignments, as generate_output_assignments writes them, each with the block producing
+        // its value (-1 for an inport or a constant)
+        [[nodiscard]] auto output_lines(const mdl::system& sys, block_order& graph) -> std::vector<std::pair<int, std::string>> {
+            const auto& df = graph.df;
+            auto& signal_map = graph.signal_map;
+            std::vector<std::pair<int, std::string>> lines;
+            for (const auto& outp : sorted_by_port(sys.outports())) {
+                auto sources = df.input_keys.find(outp.sid);
+                if (sources == df.input_keys.end() || sources->second.empty() || sources->second[0].empty()) continue;
+                const auto& src_key = sources->second[0];
+                auto name = sanitize_name(outp.name);
+                if (auto bus = df.buses.find(df.resolve(src_key)); bus != df.buses.end()) {
+                    for (const auto& [path, leaf] : bus->second) {
+                        lines.emplace_back(graph.producer(df.resolve(leaf)),
+                                           indent_ + "out." + name + "." + path + " = " + signal_map[leaf] + ";\n");
+                    }
+                } else if (signal_map.count(src_key)) {
+                    lines.emplace_back(graph.producer(df.resolve(src_key)),
+                                       indent_ + "out." + name + " = " + signal_map[src_key] + ";\n");
+                }
+            }
+            return lines;
+        }
+
+        // Private members shared by the threaded runners: a cache-line flag, a spin wait and core pinning
+        static void emit_spin_helpers(std::ostringstream& out) {
+            out << "        struct alignas(64) flag {\n";
+            out << "            std::atomic<std::uint64_t> value{0};\n";
+            out << "        };\n\n";
+            out << "        // Spins briefly, then yields so an oversubscribed machine still makes progress\n";
+            out << "        static void relax(int& spins) {\n";
+            out << "            if (++spins > 4096) {\n";
+            out << "                std::this_thread::yield();\n";
+            out << "                return;\n";
+            out << "            }\n";
+            out << "#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))\n";
+            out << "            __builtin_ia32_pause();\n";
+            out << "#endif\n";
+            out << "        }\n\n";
+            out << "        static void pin([[maybe_unused]] std::thread::native_handle_type thread, [[maybe_unused]] int core) {\n";
+            out << "#if defined(__linux__)\n";
+            out << "            cpu_set_t set;\n";
+            out << "            CPU_ZERO(&set);\n";
+            out << "            CPU_SET(core, &set);\n";
+            out << "            pthread_setaffinity_np(thread, sizeof(set), &set);\n";
+            out << "#endif\n";
+            out << "        }\n\n";
+        }
+
+        // Emit <elem>_pipeline, which runs the update as stages on threads of their own, one step apart:
+        // while stage 0 takes step k, stage s works on step k - s, so a step costs only the dearest stage
+        // and the outputs lag the inputs by stages - 1 steps. The stages are contiguous runs of the
+        // execution order, balanced by estimated cost. A cut never falls between a state block and a
+        // block reading its state, so every feedback loop runs within one stage and sees its state exactly
+        // as the plain update does; locals crossing a cut are handed to the next stage in a struct, double
+        // buffered by step parity, that later stages forward along with the inputs and the outputs.
+        void emit_pipeline(std::ostringstream& out, const mdl::system& sys, const generated_parts& parts,
+                           const std::string& elem_name, bool needs_config)
+        {
+            auto graph = emission_order(sys, parts);
+            auto& df = graph.df;
+            auto& signal_map = graph.signal_map;
+            auto count = static_cast<int>(graph.blocks.size());
+
+            auto handed_local = [&](const std::string& key) {
+                return !df.state_sids.contains(signal_block_sid(key)) && is_identifier(signal_map[key]);
+            };
+
+            // No cut between a state and its readers, or between a signal that is not a plain local and
+            // its readers: blocked[c] counts the spans a cut ahead of block c would split
+            std::vector<int> blocked(count + 2, 0);
+            graph.for_each_read([&](int b, int p, const std::string& key) {
+                if (handed_local(key)) return;
+                ++blocked[std::min(p, b) + 1];
+                --blocked[std::max(p, b) + 1];
+            });
+
+            // Runs of blocks no cut may split, packed greedily under the smallest bound that fits
+            std::vector<int> run_cost, run_of(count);
+            for (int b = 0, open = 0; b < count; ++b) {
+                open += blocked[b];
+                if (b == 0 || open == 0) run_cost.push_back(0);
+                run_cost.back() += block_cost(*graph.blocks[b]);
+                run_of[b] = static_cast<int>(run_cost.size()) - 1;
+            }
+            auto pack = [&](int bound) {
+                std::vector<int> stage_of_run, costs{0};
+                for (auto cost : run_cost) {
+                    if (costs.back() > 0 && costs.back() + cost > bound) costs.push_back(0);
+                    costs.back() += cost;
+                    stage_of_run.push_back(static_cast<int>(costs.size()) - 1);
+                }
+                return std::pair{stage_of_run, costs};
+            };
+            int lo = run_cost.empty() ? 0 : std::ranges::max(run_cost);
+            int hi = std::accumulate(run_cost.begin(), run_cost.end(), 0);
+            while (lo < hi) {
+                auto mid = lo + (hi - lo) / 2;
+                if (static_cast<int>(pack(mid).second.size()) <= options_.pipeline) hi = mid;
+                else lo = mid + 1;
+            }
+            auto [stage_of_run, costs] = pack(lo);
+            auto stages = static_cast<int>(costs.size());
+            auto stage_of = [&](int b) { return b < 0 ? 0 : stage_of_run[run_of[b]]; };
+
+            // Locals each stage reads from an earlier one, and what every boundary carries
+            std::vector<std::set<std::string>> taken(stages);
+            std::vector<std::map<std::string, std::string>> handed(stages);  // boundary s -> s + 1: local -> type
+            std::map<std::string, int> origin;
+            graph.for_each_read([&](int b, int p, const std::string& key) {
+                if (stage_of(p) == stage_of(b)) return;
+                const auto& var = signal_map[key];
+                origin[var] = stage_of(p);
+                taken[stage_of(b)].insert(var);
+                for (int s = stage_of(p); s < stage_of(b); ++s) handed[s][var] = df.type_of(key);
+            });
+
+            // Each output is assigned by the stage that produces it, which sees every state it reads
+            // as updated; the stages after it pass the value on
+            std::vector<std::ostringstream> assigned(stages);
+            for (const auto& [p, line] : output_lines(sys, graph)) assigned[stage_of(p)] << line;
+
+            std::vector<std::ostringstream> body(stages);
+            for (int b = 0; b < count; ++b) emit_block(graph, b, body[stage_of(b)]);
+
+            auto& stats = pipeline_report_[elem_name];
+            stats.requested = options_.pipeline;
+            stats.costs = costs;
+            stats.handed_over = static_cast<int>(origin.size());
+
+            bool has_state = !parts.state_vars.empty();
+            auto pipe = [&](int s) { return elem_name + "_pipe" + std::to_string(s); };
+            auto stage = [&](int s) { return elem_name + "_stage" + std::to_string(s); };
+            std::string cost_list;
+            for (auto cost : costs) cost_list += (cost_list.empty() ? "" : ", ") + std::to_string(cost);
+
+            out << "    // " << elem_name << "_pipeline: " << stages << " stage(s), outputs " << stages - 1
+                << " step(s) behind their inputs; estimated cost per stage " << cost_list << "\n\n";
+
+            for (int s = 0; s + 1 < stages; ++s) {
+                out << "    struct " << pipe(s) << " {\n";
+                out << "        " << elem_name << "_input in;\n";
+                out << "        " << elem_name << "_output out;\n";
+                for (const auto& [var, type] : handed[s]) {
+                    out << "        " << type << " " << var << " = " << zero_value(type) << ";\n";
+                }
+                out << "    };\n\n";
+            }
+
+            for (int s = 0; s < stages; ++s) {
+                bool first = s == 0, last = s + 1 == stages;
+                out << "    inline auto " << stage(s) << "(\n";
+                if (first) out << "        [[maybe_unused]] const " << elem_name << "_input& in,\n";
+                else out << "        const " << pipe(s - 1) << "& stage_in,\n";
+                if (needs_config) out << "        [[maybe_unused]] const " << elem_name << "_config& cfg,\n";
+                if (has_state) out << "        [[maybe_unused]] " << elem_name << "_state& state,\n";
+                if (last) out << "        " << elem_name << "_output& out) -> void\n";
+                else out << "        " << pipe(s) << "& stage_out) -> void\n";
+                out << "    {\n";
+                if (!first) {
+                    out << indent_ << "[[maybe_unused]] const auto& in = stage_in.in;\n";
+                    for (const auto& var : taken[s]) out << indent_ << "const auto " << var << " = stage_in." << var << ";\n";
+                }
+                if (!last) {
+                    out << indent_ << "stage_out.in = in;\n";
+                    if (!first) out << indent_ << "stage_out.out = stage_in.out;\n";
+                    out << indent_ << "[[maybe_unused]] auto& out = stage_out.out;\n";
+                } else if (!first) {
+                    out << indent_ << "out = stage_in.out;\n";
+                }
+                out << body[s].str();
+                if (!last) {
+                    for (const auto& [var, type] : handed[s]) {
+                        bool local = origin[var] == s || taken[s].contains(var);
+                        out << indent_ << "stage_out." << var << " = " << (local ? "" : "stage_in.") << var << ";\n";
+                    }
+                }
+                if (assigned[s].tellp() > 0) {
+                    out << "\n" << indent_ << "// Outputs\n" << assigned[s].str();
+                }
+                out << "    }\n\n";
+            }
+
+            auto e = elem_name;
+            out << "    // Runs the stages of " << e << " on threads of their own, stage s pinned to cores[s] when\n";
+            out << "    // cores are given. Stage 0 runs on the thread calling step(), which is pinned to cores[0].\n";
+            out << "    // step() takes one input and returns the output for the input of `latency` calls before;\n";
+            out << "    // until the pipeline has filled, out is left as it was. The handoff is lock-free: step()\n";
+            out << "    // publishes a step count the workers spin on, and each worker publishes it back when done.\n";
+            out << "    class " << e << "_pipeline {\n";
+            out << "    public:\n";
+            out << "        static constexpr int stages = " << stages << ";\n";
+            out << "        static constexpr int latency = stages - 1;\n\n";
+            out << "        explicit " << e << "_pipeline(";
+            if (needs_config) out << "const " << e << "_config& cfg, ";
+            out << "std::span<const int> cores = {})";
+            if (needs_config) out << "\n            : cfg_(cfg)";
+            out << "\n        {\n";
+            out << "            for (int s = 1; s < stages; ++s) {\n";
+            out << "                workers_[s - 1] = std::thread([this, s] { run(s); });\n";
+            out << "                if (static_cast<std::size_t>(s) < cores.size()) pin(workers_[s - 1].native_handle(), cores[s]);\n";
+            out << "            }\n";
+            out << "#if defined(__linux__)\n";
+            out << "            if (!cores.empty()) pin(pthread_self(), cores[0]);\n";
+            out << "#endif\n";
+            out << "        }\n\n";
+            out << "        " << e << "_pipeline(const " << e << "_pipeline&) = delete;\n";
+            out << "        auto operator=(const " << e << "_pipeline&) -> " << e << "_pipeline& = delete;\n\n";
+            out << "        ~" << e << "_pipeline() {\n";
+            out << "            stopping_.store(true, std::memory_order_relaxed);\n";
+            out << "            tick_.fetch_add(1, std::memory_order_release);\n";
+            out << "            for (auto& worker : workers_) worker.join();\n";
+            out << "        }\n\n";
+
+            auto args = [&](std::string first, std::string last) {
+                std::string text = first + ", ";
+                if (needs_config) text += "cfg_, ";
+                if (has_state) text += "state_, ";
+                return text + last;
+            };
+            out << "        void step(const " << e << "_input& in, " << e << "_output& out) {\n";
+            if (stages == 1) {
+                out << "            " << stage(0) << "(" << args("in", "out") << ");\n";
+            } else {
+                out << "            auto tick = ++ticks_;\n";
+                out << "            tick_.store(tick, std::memory_order_release);\n";
+                out << "            " << stage(0) << "(" << args("in", "pipe0_[tick & 1]") << ");\n";
+                out << "            for (int spins = 0; auto& stage : done_) {\n";
+                out << "                while (stage.value.load(std::memory_order_acquire) != tick) relax(spins);\n";
+                out << "            }\n";
+                out << "            if (tick > latency) out = output_;\n";
+            }
+            out << "        }\n";
+            if (has_state) {
+                out << "\n        // Between calls to step() every stage is idle\n";
+                out << "        [[nodiscard]] auto state() -> " << e << "_state& { return state_; }\n";
+            }
+            out << "\n    private:\n";
+            emit_spin_helpers(out);
+            out << "        // Stage s runs step tick - s, reading what stage s - 1 wrote on the previous tick\n";
+            out << "        void run(int s) {\n";
+            out << "            for (std::uint64_t seen = 0;;) {\n";
+            out << "                std::uint64_t tick;\n";
+            out << "                for (int spins = 0; (tick = tick_.load(std::memory_order_acquire)) == seen;) relax(spins);\n";
+            out << "                if (stopping_.load(std::memory_order_relaxed)) return;\n";
+            out << "                seen = tick;\n";
+            out << "                if (tick > static_cast<std::uint64_t>(s)) {\n";
+            out << "                    switch (s) {\n";
+            for (int s = 1; s < stages; ++s) {
+                auto from = "pipe" + std::to_string(s - 1) + "_[(tick - 1) & 1]";
+                auto to = s + 1 == stages ? std::string("output_") : "pipe" + std::to_string(s) + "_[tick & 1]";
+                out << "                    case " << s << ": " << stage(s) << "(" << args(from, to) << "); break;\n";
+            }
+            out << "                    }\n";
+            out << "                }\n";
+            out << "                done_[s - 1].value.store(tick, std::memory_order_release);\n";
+            out << "            }\n";
+            out << "        }\n\n";
+            if (needs_config) out << "        " << e << "_config cfg_;\n";
+            if (has_state) out << "        " << e << "_state state_{};\n";
+            for (int s = 0; s + 1 < stages; ++s) {
+                out << "        alignas(64) " << pipe(s) << " pipe" << s << "_[2]{};\n";
+            }
+            out << "        " << e << "_output output_{};\n";
+            out << "        std::uint64_t ticks_ = 0;\n";
+            out << "        alignas(64) std::atomic<std::uint64_t> tick_{0};\n";
+            out << "        std::atomic<bool> stopping_{false};\n";
+            out << "        std::array<flag, stages - 1> done_{};\n";
+            out << "        std::array<std::thread, stages - 1> workers_{};\n";
+            out << "    };\n\n";
+        }
+
+        // Emit <elem>_parallel, which runs the blocks of one step as independent partitions on a persistent
+        // worker pool. The execution order is split into a serial head, a middle and a serial tail: the
+        // calling thread runs the head, releases the workers, and runs the tail after the one barrier of
+        // the step. Middle blocks are grouped when one reads a signal or a state of the other, so two
+        // groups share nothing and run at once without synchronizing; every block keeps its place in
+        // <elem>_update, so the results are the same. Groups are packed into partitions by estimated cost,
+        // heaviest first onto the lightest, and the head and tail are chosen to minimize the estimated
+        // step. When no choice pays for the barrier, the class calls <elem>_update instead and says why.
+        // Locals crossing from one part to another are handed over in a frame owned by the class.
+        void emit_parallel(std::ostringstream& out, const mdl::system& sys, const generated_parts& parts,
+                           const std::string& elem_name, bool needs_config)
+        {
+            constexpr int sync_cost = 64;  // rough cost of waking the workers and the barrier, in block cost units
+            constexpr int max_cuts = 48;   // head and tail candidates tried, each
+
+            auto graph = emission_order(sys, parts);
+            auto& df = graph.df;
+            auto& signal_map = graph.signal_map;
+            auto count = static_cast<int>(graph.blocks.size());
+            auto handed_local = [&](const std::string& key) {
+                return !df.state_sids.contains(signal_block_sid(key)) && is_identifier(signal_map[key]);
+            };
+
+            // Reads as {earlier, later} by execution order; a cut may not separate a signal that is not
+            // a plain local from its readers
+            std::vector<std::pair<int, int>> links;
+            std::vector<int> blocked(count + 2, 0);
+            graph.for_each_read([&](int b, int p, const std::string& key) {
+                links.emplace_back(std::min(b, p), std::max(b, p));
+                if (!handed_local(key) && !df.state_sids.contains(signal_block_sid(key))) {
+                    ++blocked[p + 1];
+                    --blocked[b + 1];
+                }
+            });
+
+            auto& stats = parallel_report_[elem_name];
+            stats = {};
+            std::vector<int> cost(count), finish(count), prefix(count + 1, 0);
+            std::vector<std::vector<int>> before(count);
+            for (const auto& [p, b] : links) before[b].push_back(p);
+            for (int b = 0; b < count; ++b) {
+                cost[b] = block_cost(*graph.blocks[b]);
+                finish[b] = cost[b];
+                for (auto p : before[b]) finish[b] = std::max(finish[b], finish[p] + cost[b]);
+                stats.work += cost[b];
+                stats.span = std::max(stats.span, finish[b]);
+                prefix[b + 1] = prefix[b] + cost[b];
+            }
+
+            // Groups of the middle blocks [head, tail), packed into at most options_.parallel partitions
+            struct split {
+                int head = 0, tail = 0, groups = 0;
+                std::vector<int> loads;
+                std::vector<int> partition_of;  // per middle block
+            };
+            auto divide = [&](int head, int tail) {
+                split result;
+                result.head = head;
+                result.tail = tail;
+                std::vector<int> group(count);
+                std::iota(group.begin(), group.end(), 0);
+                auto root = [&](int b) {
+                    while (group[b] != b) b = group[b] = group[group[b]];
+                    return b;
+                };
+                for (const auto& [p, b] : links) {
+                    if (p >= head && b < tail) group[root(b)] = root(p);
+                }
+                std::map<int, int> group_cost;
+                for (int b = head; b < tail; ++b) group_cost[root(b)] += cost[b];
+                result.groups = static_cast<int>(group_cost.size());
+
+                std::vector<std::pair<int, int>> by_cost;
+                for (const auto& [g, c] : group_cost) by_cost.emplace_back(c, g);
+                std::ranges::sort(by_cost, std::greater<>{});
+                result.loads.assign(std::max(1, std::min(options_.parallel, result.groups)), 0);
+                std::map<int, int> partition_of_group;
+                for (const auto& [c, g] : by_cost) {
+                    auto lightest = std::ranges::min_element(result.loads) - result.loads.begin();
+                    partition_of_group[g] = static_cast<int>(lightest);
+                    result.loads[lightest] += c;
+                }
+                result.partition_of.assign(count, 0);
+                for (int b = head; b < tail; ++b) result.partition_of[b] = partition_of_group[root(b)];
+                return result;
+            };
+            auto estimate = [&](const split& s) {
+                return prefix[s.head] + std::ranges::max(s.loads) + (prefix[count] - prefix[s.tail]) + sync_cost;
+            };
+
+            std::vector<int> cuts;
+            for (int c = 0, open = 0; c <= count; ++c) {
+                open += blocked[c];
+                if (open == 0 || c == 0 || c == count) cuts.push_back(c);
+            }
+            if (static_cast<int>(cuts.size()) > max_cuts) {
+                std::vector<int> sampled;
+                for (int i = 0; i < max_cuts; ++i) sampled.push_back(cuts[i * (cuts.size() - 1) / (max_cuts - 1)]);
+                cuts = std::move(sampled);
+            }
+            std::optional<split> best;
+            if (options_.parallel >= 2) {
+                for (auto head : cuts) {
+                    for (auto tail : cuts) {
+                        if (tail <= head) continue;
+                        auto candidate = divide(head, tail);
+                        if (candidate.loads.size() < 2) continue;
+                        if (!best || estimate(candidate) < estimate(*best)) best = std::move(candidate);
+                    }
+                }
+            }
+
+            if (options_.parallel < 2) {
+                stats.serial = "one thread";
+            } else if (!best) {
+                stats.serial = "no independent blocks";
+            } else if (estimate(*best) >= stats.work) {
+                stats.serial = "the barrier costs more than the partitions save";
+            }
+            if (!stats.serial.empty()) {
+                stats.groups = best ? best->groups : 1;
+                stats.loads = {stats.work};
+            } else {
+                stats.groups = best->groups;
+                stats.head = prefix[best->head];
+                stats.tail = prefix[count] - prefix[best->tail];
+                stats.loads = best->loads;
+            }
+
+            bool has_state = !parts.state_vars.empty();
+            auto e = elem_name;
+            auto parameters = [&](bool maybe_unused, bool frame) {
+                auto attribute = std::string(maybe_unused ? "[[maybe_unused]] " : "");
+                std::string text = "        " + attribute + "const " + e + "_input& in,\n";
+                if (needs_config) text += "        " + attribute + "const " + e + "_config& cfg,\n";
+                if (has_state) text += "        " + attribute + e + "_state& state,\n";
+                text += "        " + attribute + e + "_output& out";
+                if (frame) text += ",\n        [[maybe_unused]] " + e + "_frame& frame";
+                return text + ")";
+            };
+            auto arguments = [&](const std::string& prefix, const std::string& suffix, bool frame) {
+                std::string text = prefix + "in" + suffix;
+                if (needs_config) text += ", " + prefix + "cfg" + suffix;
+                if (has_state) text += ", " + prefix + "state" + suffix;
+                return text + ", " + prefix + "out" + suffix + (frame ? ", frame_" : "");
+            };
+
+            if (!stats.serial.empty()) {
+                out << "    // " << e << "_parallel: serial, " << stats.serial << "\n";
+                out << "    class " << e << "_parallel {\n";
+                out << "    public:\n";
+                out << "        static constexpr int partitions = 1;\n\n";
+                out << "        explicit " << e << "_parallel(std::span<const int> = {}) {}\n\n";
+                out << "        void step(\n" << parameters(false, false) << " {\n";
+                out << "            " << e << "_update(" << arguments("", "", false) << ");\n";
+                out << "        }\n";
+                out << "    };\n\n";
+                return;
+            }
+
+            // Parts: 0 the head, 1..partitions the middle, partitions + 1 the tail
+            auto partitions = static_cast<int>(best->loads.size());
+            auto part_of = [&](int b) {
+                if (b < best->head) return 0;
+                if (b >= best->tail) return partitions + 1;
+                return 1 + best->partition_of[b];
+            };
+            std::vector<std::ostringstream> body(partitions + 2), assigned(partitions + 2);
+            std::vector<std::set<std::string>> taken(partitions + 2), given(partitions + 2);
+            std::map<std::string, std::string> frame;  // local -> type
+            graph.for_each_read([&](int b, int p, const std::string& key) {
+                if (part_of(b) == part_of(p) || !handed_local(key)) return;
+                const auto& var = signal_map[key];
+                frame[var] = df.type_of(key);
+                given[part_of(p)].insert(var);
+                taken[part_of(b)].insert(var);
+            });
+            for (int b = 0; b < count; ++b) emit_block(graph, b, body[part_of(b)]);
+            for (const auto& [p, line] : output_lines(sys, graph)) assigned[p < 0 ? 1 : part_of(p)] << line;
+
+            auto name_of = [&](int i) {
+                if (i == 0) return e + "_head";
+                if (i == partitions + 1) return e + "_tail";
+                return e + "_part" + std::to_string(i - 1);
+            };
+            std::string load_list;
+            for (auto load : best->loads) load_list += (load_list.empty() ? "" : ", ") + std::to_string(load);
+            out << "    // " << e << "_parallel: " << partitions << " partitions of " << stats.groups
+                << " independent groups; estimated cost head " << stats.head << ", partitions " << load_list
+                << ", tail " << stats.tail << "\n\n";
+            out << "    struct " << e << "_frame {\n";
+            for (const auto& [var, type] : frame) out << "        " << type << " " << var << " = " << zero_value(type) << ";\n";
+            out << "    };\n\n";
+            for (int i = 0; i < partitions + 2; ++i) {
+                bool empty = body[i].tellp() == 0 && assigned[i].tellp() == 0;
+                if (empty && (i == 0 || i == partitions + 1)) continue;
+                out << "    inline auto " << name_of(i) << "(\n" << parameters(true, true) << " -> void\n";
+                out << "    {\n";
+                for (const auto& var : taken[i]) out << indent_ << "const auto " << var << " = frame." << var << ";\n";
+                out << body[i].str();
+                for (const auto& var : given[i]) out << indent_ << "frame." << var << " = " << var << ";\n";
+                if (assigned[i].tellp() > 0) {
+                    out << "\n" << indent_ << "// Outputs\n" << assigned[i].str();
+                }
+                out << "    }\n\n";
+            }
+            bool has_head = body[0].tellp() > 0 || assigned[0].tellp() > 0;
+            bool has_tail = body[partitions + 1].tellp() > 0 || assigned[partitions + 1].tellp() > 0;
+
+            out << "    // Runs " << e << "_update as " << partitions << " partitions sharing no signal or state: the\n";
+            out << "    // thread calling step() runs the head, partition 0 and the tail, and a worker each of the\n";
+            out << "    // other partitions, pinned to cores[p] when cores are given. step() publishes a step count\n";
+            out << "    // the workers spin on and runs the tail once every worker has published it back, the one\n";
+            out << "    // barrier of the step.\n";
+            out << "    class " << e << "_parallel {\n";
+            out << "    public:\n";
+            out << "        static constexpr int partitions = " << partitions << ";\n\n";
+            out << "        explicit " << e << "_parallel(std::span<const int> cores = {}) {\n";
+            out << "            for (int p = 1; p < partitions; ++p) {\n";
+            out << "                workers_[p - 1] = std::thread([this, p] { run(p); });\n";
+            out << "                if (static_cast<std::size_t>(p) < cores.size()) pin(workers_[p - 1].native_handle(), cores[p]);\n";
+            out << "            }\n";
+            out << "#if defined(__linux__)\n";
+            out << "            if (!cores.empty()) pin(pthread_self(), cores[0]);\n";
+            out << "#endif\n";
+            out << "        }\n\n";
+            out << "        " << e << "_parallel(const " << e << "_parallel&) = delete;\n";
+            out << "        auto operator=(const " << e << "_parallel&) -> " << e << "_parallel& = delete;\n\n";
+            out << "        ~" << e << "_parallel() {\n";
+            out << "            stopping_.store(true, std::memory_order_relaxed);\n";
+            out << "            tick_.fetch_add(1, std::memory_order_release);\n";
+            out << "            for (auto& worker : workers_) worker.join();\n";
+            out << "        }\n\n";
+            out << "        void step(\n" << parameters(false, false) << " {\n";
+            if (has_head) out << "            " << name_of(0) << "(" << arguments("", "", true) << ");\n";
+            out << "            in_ = &in;\n";
+            if (needs_config) out << "            cfg_ = &cfg;\n";
+            if (has_state) out << "            state_ = &state;\n";
+            out << "            out_ = &out;\n";
+            out << "            auto tick = ++ticks_;\n";
+            out << "            tick_.store(tick, std::memory_order_release);\n";
+            out << "            " << name_of(1) << "(" << arguments("", "", true) << ");\n";
+            out << "            for (int spins = 0; auto& partition : done_) {\n";
+            out << "                while (partition.value.load(std::memory_order_acquire) != tick) relax(spins);\n";
+            out << "            }\n";
+            if (has_tail) out << "            " << name_of(partitions + 1) << "(" << arguments("", "", true) << ");\n";
+            out << "        }\n\n";
+            out << "    private:\n";
+            emit_spin_helpers(out);
+            out << "        void run(int p) {\n";
+            out << "            for (std::uint64_t seen = 0;;) {\n";
+            out << "                std::uint64_t tick;\n";
+            out << "                for (int spins = 0; (tick = tick_.load(std::memory_order_acquire)) == seen;) relax(spins);\n";
+            out << "                if (stopping_.load(std::memory_order_relaxed)) return;\n";
+            out << "                seen = tick;\n";
+            out << "                switch (p) {\n";
+            for (int i = 1; i < partitions; ++i) {
+                out << "                case " << i << ": " << name_of(i + 1) << "(" << arguments("*", "_", true) << "); break;\n";
+            }
+            out << "                }\n";
+            out << "                done_[p - 1].value.store(tick, std::memory_order_release);\n";
+            out << "            }\n";
+            out << "        }\n\n";
+            out << "        " << e << "_frame frame_{};\n";
+            out << "        const " << e << "_input* in_ = nullptr;\n";
+            if (needs_config) out << "        const " << e << "_config* cfg_ = nullptr;\n";
+            if (has_state) out << "        " << e << "_state* state_ = nullptr;\n";
+            out << "        " << e << "_output* out_ = nullptr;\n";
+            out << "        std::uint64_t ticks_ = 0;\n";
+            out << "        alignas(64) std::atomic<std::uint64_t> tick_{0};\n";
+            out << "        std::atomic<bool> stopping_{false};\n";
+            out << "        std::array<flag, partitions - 1> done_{};\n";
+            out << "        std::array<std::thread, partitions - 1> workers_{};\n";
+            out << "    };\n\n";
         }
 
-    private:
         // Collect all state and config variables recursively (legacy - kept for reference)
         void collect_all_variables(const mdl::system& sys, const std::string& prefix, int depth) {
             if (depth > max_inline_depth_) return;
@@ -567,7 +2366,8 @@ namespace oc::codegen {
         }
 
         // Collect only local state and config variables (no subsystem recursion)
-        void collect_local_variables(const mdl::system& sys, const std::string& prefix) {
+        void collect_local_variables(const mdl::system& sys, const std::string& prefix,
+                                     std::map<std::string, std::string>& types) {
             for (const auto& blk : sys.blocks) {
                 auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
 
@@ -592,11 +2392,122 @@ namespace oc::codegen {
                     }
                 }
 
-                // Config from block parameters (no subsystem recursion)
+                for (const auto& field : discrete_state_fields(blk, var_prefix)) {
+                    all_state_vars_.emplace_back(field.name, field.comment + " in " + (prefix.empty() ? "root" : prefix));
+                    if (field.type != "float") types[field.name] = field.type;
+                }
+
+                // Config from block parameters (no subsystem recursion)
                 collect_config_from_block(blk);
             }
         }
 
+        // State fields of the integer Delay and discrete filter blocks: a Delay of one sample keeps a float like
+        // UnitDelay, longer ones a power-of-two ring buffer and its read position, filters one float per state
+        struct state_field {
+            std::string name;
+            std::string type;
+            std::string comment;
+        };
+
+        [[nodiscard]] auto discrete_state_fields(const mdl::block& blk, const std::string& var_prefix) const
+            -> std::vector<state_field> {
+            if (blk.type == "Delay") {
+                auto length = delay_length(blk, options_.calibration);
+                if (!length || *length == 0) return {};
+                if (*length == 1) return {{var_prefix + "_state", "float", "Delay"}};
+                auto ring = std::bit_ceil(static_cast<unsigned>(*length));
+                return {{var_prefix + "_buf", "float[" + std::to_string(ring) + "]", "Delay ring buffer"},
+                        {var_prefix + "_head", "int", "Delay read position"}};
+            }
+            if (blk.type == "DiscreteFilter" || blk.type == "DiscreteTransferFcn") {
+                auto filter = parse_discrete_filter(blk, options_.calibration);
+                if (!filter || filter->order() == 0) return {};
+                std::vector<state_field> fields{{var_prefix + "_z", "float[" + std::to_string(filter->order()) + "]", blk.type + " state"}};
+                if (filter->strictly_proper()) fields.push_back({var_prefix + "_state", "float", blk.type + " output"});
+                return fields;
+            }
+            if (blk.type == "DiscreteStateSpace") {
+                auto ss = parse_discrete_state_space(blk, options_.calibration);
+                if (!ss) return {};
+                return {{var_prefix + "_x", "float[" + std::to_string(ss->a.size()) + "]", "DiscreteStateSpace state"}};
+            }
+            return {};
+        }
+
+        // Bank slots of the delays and first/second-order TransferFcns of one system; empty without --bank.
+        // Typed delays keep their own fields so each can carry its type.
+        [[nodiscard]] auto bank_layout(const mdl::system& sys) const -> state_banks {
+            state_banks banks;
+            if (!options_.bank) return banks;
+            for (const auto& blk : sys.blocks) {
+                if ((blk.type == "UnitDelay" || blk.type == "Memory") && !options_.typed) {
+                    banks.delays.emplace(blk.sid, static_cast<int>(banks.delays.size()));
+                } else if (blk.type == "TransferFcn") {
+                    auto order = parse_transfer_function(blk).order;
+                    if (order == 1 || order == 2) banks.filters[blk.sid] = {order, banks.filter_count[order]++};
+                }
+            }
+            return banks;
+        }
+
+        // Replace the fields of banked states with their bank arrays, placed where the first one was
+        void pack_banked_states(const mdl::system& sys, std::vector<std::pair<std::string, std::string>>& vars,
+                                std::map<std::string, std::string>& types) const {
+            auto banks = bank_layout(sys);
+            std::map<std::string, std::pair<std::string, std::string>> bank_of;  // field -> {bank array, comment}
+            for (const auto& blk : sys.blocks) {
+                auto name = sanitize_name(blk.name);
+                if (banks.delays.contains(blk.sid)) {
+                    bank_of[name + "_state"] = {"delay_bank", "UnitDelay/Memory states, committed together"};
+                }
+                if (auto it = banks.filters.find(blk.sid); it != banks.filters.end()) {
+                    auto order = std::to_string(it->second.first);
+                    for (int i = 0; i < it->second.first; ++i) {
+                        auto n = std::to_string(i);
+                        bank_of[name + "_tf_x" + n] = {"tf" + order + "_bank_x" + n, "TransferFcn state " + n + ", order " + order};
+                        bank_of[name + "_tf_u" + n] = {"tf" + order + "_bank_u" + n, "TransferFcn input history " + n + ", order " + order};
+                    }
+                }
+            }
+            if (bank_of.empty()) return;
+
+            std::vector<std::pair<std::string, std::string>> packed;
+            for (auto& [var, comment] : vars) {
+                auto it = bank_of.find(var);
+                if (comment == "component state" || it == bank_of.end()) {
+                    packed.emplace_back(std::move(var), std::move(comment));
+                    continue;
+                }
+                const auto& [bank, bank_comment] = it->second;
+                if (types.contains(bank)) continue;
+                auto size = bank == "delay_bank" ? banks.delays.size() : banks.filter_count[bank[2] - '0'];
+                types[bank] = "float[" + std::to_string(size) + "]";
+                packed.emplace_back(bank, bank_comment);
+            }
+            vars = std::move(packed);
+        }
+
+        // Zero-initialized declaration of one state field; an array type such as "float[4]" declares a bank
+        [[nodiscard]] static auto state_declaration(const std::string& type, const std::string& var) -> std::string {
+            if (auto open = type.find('['); open != std::string::npos) {
+                return type.substr(0, open) + " " + var + type.substr(open) + " = {};";
+            }
+            return type + " " + var + " = " + zero_value(type) + ";";
+        }
+
+        // State argument of one block: its state variable, or the field pattern of a banked TransferFcn
+        [[nodiscard]] static auto block_state(const dataflow& df, const std::string& sid) -> std::string {
+            if (auto it = df.state_var_map.find(sid); it != df.state_var_map.end()) return it->second;
+            if (auto it = df.filter_state.find(sid); it != df.filter_state.end()) return it->second;
+            return "";
+        }
+
+        // One TransferFcn state field from a pattern whose '%' stands for the field (x0, u0, ...)
+        [[nodiscard]] static auto filter_field(std::string pattern, const std::string& field) -> std::string {
+            return pattern.replace(pattern.find('%'), 1, field);
+        }
+
         static void collect_config_from_block_into(const mdl::block& blk, std::set<std::string>& config) {
             static constexpr std::array param_names = {
                 "Gain", "UpperLimit", "LowerLimit", "Value", "InitialCondition",
@@ -615,153 +2526,1973 @@ namespace oc::codegen {
         }
 
         // Generate code for a system, populating signal_map with output variable names
-        void generate_system_code(
+        auto generate_system_code(
             const mdl::system& sys,
             const std::string& prefix,
             std::map<std::string, std::string>& signal_map,
             std::ostringstream& code,
             int depth,
-            const std::map<std::string, const generated_component*>& component_map = {})
+            const std::map<std::string, const generated_component*>& component_map = {}) -> dataflow
         {
             if (depth > max_inline_depth_) {
                 code << indent_ << "// Max inline depth reached\n";
-                return;
+                return {};
+            }
+
+            auto df = build_dataflow(sys, prefix, signal_map);
+            lower_buses(sys, df, signal_map, component_map);
+            if (options_.typed) {
+                infer_types(sys, df, component_map);
+            }
+            if (options_.range_analysis) {
+                if (depth == 0) ranges_ = {};
+                record_ranges(sys, df, signal_map);
+            }
+            std::vector<linear_region> linear;
+            if (options_.state_space) {
+                linear = compile_linear_regions(sys, df, signal_map, prefix);
+            }
+            std::map<std::string, std::pair<std::string, std::size_t>> fusable;
+            if (options_.fuse) {
+                fusable = fusable_signals(sys, df, linear);
+            }
+
+            // Scheduled code goes to the scratch array of the outermost system, declared once its size is known
+            std::ostringstream scheduled;
+            auto& body = options_.schedule && depth == 0 ? scheduled : code;
+
+            // Banked TransferFcns run as one loop per bank; delays stage their next value and commit together
+            std::vector<filter_bank> banks;
+            std::map<std::string, int> staged;  // delay SID -> bank index
+            if (options_.bank && prefix.empty()) {
+                banks = plan_filter_banks(sys, df, linear, fusable);
+                staged = staged_delays(sys, df, linear);
+            }
+            std::set<std::string> banked;
+            for (const auto& bank : banks) banked.insert(bank.members.begin(), bank.members.end());
+            if (!staged.empty()) {
+                body << indent_ << "float delay_next[" << staged.size() << "];  // delay updates, committed after the last block\n";
+            }
+
+            std::map<std::string, int> last_use;
+            std::vector<std::pair<int, int>> held;  // {last use, slot} taken at this level
+            if (options_.schedule) {
+                if (depth == 0) scratch_ = {};
+                last_use = scratch_candidates(sys, df, signal_map, linear, fusable, banks);
+            }
+
+            // Generate code for each block; positions are doubled as in runs_at()
+            std::map<std::string, int> order;
+            for (int i = 0; const auto& sid : df.sorted_sids) order[sid] = 2 * ++i;
+            for (int position = 0; const auto& sid : df.sorted_sids) {
+                position += 2;
+                emit_filter_banks(sys, df, banks, sid, signal_map, body);
+                if (emit_linear_regions(linear, sid, body)) continue;
+
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || blk->is_inport() || blk->is_outport() || df.removed.contains(sid) || banked.contains(sid)) continue;
+                if (auto it = df.narrowed.find(sid); it != df.narrowed.end()) blk = &it->second;
+
+                auto& inputs = df.block_inputs[sid];
+                auto var_prefix = prefix.empty() ? sanitize_name(blk->name) : prefix + "_" + sanitize_name(blk->name);
+                auto out_key = sid + "#out:1";
+                auto out_var = signal_map[out_key];
+                auto state_var = block_state(df, sid);
+
+                // A staged delay writes its next value; blocks after it read that value as before
+                if (auto stage = staged.find(sid); stage != staged.end()) {
+                    auto next = "delay_next[" + std::to_string(stage->second) + "]";
+                    generate_block_code(*blk, inputs, out_var, var_prefix, next, signal_map, body, depth, component_map,
+                                        block_types(df, sid, signal_map));
+                    for (auto& [reader, keys] : df.input_keys) {
+                        auto* reader_blk = sys.find_block_by_sid(reader);
+                        if (!reader_blk || reader_blk->is_outport() || order[reader] < position) continue;
+                        for (std::size_t i = 0; i < keys.size(); ++i) {
+                            if (keys[i].empty() || df.resolve(keys[i]) != out_key) continue;
+                            if (df.block_inputs[reader][i] == state_var) df.block_inputs[reader][i] = next;
+                        }
+                    }
+                    continue;
+                }
+
+                // A single-use signal becomes part of its reader's expression instead of a local
+                if (auto fuse = fusable.find(out_key); fuse != fusable.end()) {
+                    std::ostringstream block_code;
+                    generate_block_code(*blk, inputs, out_var, var_prefix, state_var, signal_map, block_code, depth,
+                                        component_map, block_types(df, sid, signal_map));
+                    auto expr = fused_expression(block_code.str(), out_var);
+                    if (!expr) {
+                        body << block_code.str();
+                        continue;
+                    }
+
+                    auto fused = operand(*expr);
+                    auto lhs = inputs.empty() ? std::string() : inputs[0] + " * ";
+                    if ((blk->type == "Gain" || blk->type == "Product") && !lhs.empty() && expr->starts_with(lhs)) {
+                        auto rhs = expr->substr(lhs.size());
+                        if (is_atomic(inputs[0]) && is_atomic(rhs)) fused_products_[fused] = {inputs[0], rhs};
+                    }
+                    const auto& [reader, port] = fuse->second;
+                    df.block_inputs[reader][port] = fused;
+                    continue;
+                }
+
+                // A temporary takes a scratch slot whose previous signal has no reader left
+                if (auto use = last_use.find(out_key); use != last_use.end()) {
+                    std::ostringstream block_code;
+                    generate_block_code(*blk, inputs, out_var, var_prefix, state_var, signal_map, block_code, depth,
+                                        component_map, block_types(df, sid, signal_map));
+                    auto expr = fused_expression(block_code.str(), out_var);
+                    if (!expr) {
+                        body << block_code.str();
+                        continue;
+                    }
+
+                    std::erase_if(held, [&](const auto& entry) {
+                        if (entry.first > position) return false;
+                        scratch_.free.insert(entry.second);
+                        return true;
+                    });
+                    int slot = scratch_.count;
+                    if (scratch_.free.empty()) ++scratch_.count;
+                    else slot = scratch_.free.extract(scratch_.free.begin()).value();
+                    held.emplace_back(use->second, slot);
+
+                    auto name = "scratch[" + std::to_string(slot) + "]";
+                    body << block_code.str().substr(0, block_code.str().find('\n') + 1);
+                    body << indent_ << name << " = " << *expr << ";\n";
+                    for (auto& [reader, keys] : df.input_keys) {
+                        for (std::size_t i = 0; i < keys.size(); ++i) {
+                            if (keys[i].empty() || df.resolve(keys[i]) != out_key) continue;
+                            if (df.block_inputs[reader][i] == out_var) df.block_inputs[reader][i] = name;
+                        }
+                    }
+                    signal_map[out_key] = name;
+                    continue;
+                }
+
+                generate_block_code(*blk, inputs, out_var, var_prefix, state_var, signal_map, body, depth, component_map,
+                                    block_types(df, sid, signal_map));
+            }
+            emit_filter_banks(sys, df, banks, "", signal_map, body);
+            emit_linear_regions(linear, "", body);
+            if (!staged.empty()) {
+                body << indent_ << "std::copy_n(delay_next, " << staged.size() << ", state.delay_bank);\n";
+            }
+
+            if (options_.schedule) {
+                for (const auto& [use, slot] : held) scratch_.free.insert(slot);
+                if (depth == 0) {
+                    if (scratch_.count > 0) {
+                        code << indent_ << "float scratch[" << scratch_.count << "];  // temporaries, reused by liveness\n";
+                    }
+                    code << scheduled.str();
+                    auto& stats = schedule_report_[sanitize_name(sys.name.empty() ? sys.id : sys.name)];
+                    stats = {df.max_live_before, df.max_live, scratch_.count};
+                }
+            }
+            if (options_.range_analysis && depth == 0) {
+                range_report_[sanitize_name(sys.name.empty() ? sys.id : sys.name)] = std::move(ranges_);
+            }
+
+            return df;
+        }
+
+        // Where the code of every block ends up, as a doubled position in execution order: 2i for the
+        // i-th block and 2i - 1 for code emitted ahead of it. A fused block runs in its reader, a member
+        // of a linear subsystem with the state-space update and a banked TransferFcn with its bank.
+        [[nodiscard]] static auto runs_at(const dataflow& df, const std::vector<linear_region>& linear,
+                                          const std::map<std::string, std::pair<std::string, std::size_t>>& fusable,
+                                          const std::vector<filter_bank>& banks) -> std::map<std::string, int> {
+            std::map<std::string, int> position;
+            for (int i = 0; const auto& sid : df.sorted_sids) position[sid] = 2 * ++i;
+            auto ahead_of = [&](const std::string& sid) {
+                return sid.empty() ? 2 * static_cast<int>(df.sorted_sids.size()) + 1 : position[sid] - 1;
+            };
+
+            // Readers come later in the order, so walking backwards resolves them first
+            std::map<std::string, int> runs;
+            for (const auto& sid : df.sorted_sids | std::views::reverse) {
+                auto& at = runs[sid] = position[sid];
+                for (const auto& region : linear) {
+                    if (region.blocks.contains(sid)) at = ahead_of(region.insert_before);
+                }
+                for (const auto& bank : banks) {
+                    if (std::ranges::find(bank.members, sid) != bank.members.end()) at = ahead_of(bank.insert_before);
+                }
+                if (auto it = fusable.find(sid + "#out:1"); it != fusable.end()) at = runs[it->second.first];
+            }
+            return runs;
+        }
+
+        // Delays --bank stages in delay_next and commits with one copy: all of the system's banked
+        // delays, or none when one of them is folded away or updated by a linear subsystem
+        [[nodiscard]] auto staged_delays(const mdl::system& sys, const dataflow& df,
+                                         const std::vector<linear_region>& linear) const -> std::map<std::string, int> {
+            auto delays = bank_layout(sys).delays;
+            for (const auto& [sid, index] : delays) {
+                bool emitted = std::ranges::find(df.sorted_sids, sid) != df.sorted_sids.end() && !df.removed.contains(sid);
+                if (!emitted || std::ranges::any_of(linear, [&](const auto& region) { return region.blocks.contains(sid); })) {
+                    return {};
+                }
+            }
+            return delays;
+        }
+
+        // Group the banked TransferFcns of one order that can run at a single point: after all their inputs,
+        // before any reader of their outputs and on the same side of every state update they read. Those
+        // wired to another TransferFcn or to a linear subsystem keep their own code, as do groups of one.
+        [[nodiscard]] auto plan_filter_banks(const mdl::system& sys, const dataflow& df,
+                                             const std::vector<linear_region>& linear,
+                                             const std::map<std::string, std::pair<std::string, std::size_t>>& fusable) const
+            -> std::vector<filter_bank> {
+            auto runs = runs_at(df, linear, fusable, {});
+            int end = 2 * static_cast<int>(df.sorted_sids.size()) + 1;
+            auto in_region = [&](const std::string& sid) {
+                return std::ranges::any_of(linear, [&](const auto& region) { return region.blocks.contains(sid); });
+            };
+
+            std::map<std::string, std::pair<int, int>> window;  // TransferFcn SID -> {after, before}
+            for (const auto& sid : df.sorted_sids) {
+                if (df.filter_state.contains(sid) && !df.removed.contains(sid)) window[sid] = {0, end};
+            }
+            std::set<std::string> alone;
+            for (const auto& [sid, keys] : df.input_keys) {
+                if (df.removed.contains(sid)) continue;
+                auto* reader = sys.find_block_by_sid(sid);
+                for (const auto& raw : keys) {
+                    if (raw.empty() || df.constants.contains(df.resolve(raw))) continue;
+                    auto src = signal_block_sid(df.resolve(raw));
+                    auto* producer = sys.find_block_by_sid(src);
+                    if (!producer || producer->is_inport() || !runs.contains(src)) continue;
+
+                    if (window.contains(sid) && window.contains(src)) {
+                        alone.insert({sid, src});
+                    } else if (window.contains(sid)) {
+                        auto& [after, before] = window[sid];
+                        if (in_region(src)) alone.insert(sid);
+                        else if (!df.state_sids.contains(src)) after = std::max(after, runs[src]);
+                        else if (runs[sid] > runs[src]) after = std::max(after, runs[src]);
+                        else before = std::min(before, runs[src]);
+                    } else if (window.contains(src)) {
+                        if (in_region(sid)) alone.insert(src);
+                        else if (reader && !reader->is_outport()) window[src].second = std::min(window[src].second, runs[sid]);
+                    }
+                }
+            }
+
+            std::vector<filter_bank> banks;
+            auto close = [&](filter_bank& bank, int before) {
+                if (bank.members.size() > 1) {
+                    bank.insert_before = before >= end ? "" : df.sorted_sids[(before + 1) / 2 - 1];
+                    banks.push_back(std::move(bank));
+                }
+                bank = {};
+            };
+            for (int order : {1, 2}) {
+                filter_bank bank{.order = order, .members = {}, .insert_before = {}};
+                int after = 0, before = end;
+                for (const auto& sid : df.sorted_sids) {
+                    if (!window.contains(sid) || alone.contains(sid) || in_region(sid)) continue;
+                    if (df.filter_state.at(sid).find("tf" + std::to_string(order)) == std::string::npos) continue;
+                    auto [lo, hi] = window[sid];
+                    if (!bank.members.empty() && std::max(after, lo) < std::min(before, hi)) {
+                        after = std::max(after, lo);
+                        before = std::min(before, hi);
+                    } else {
+                        close(bank, before);
+                        bank.order = order;
+                        after = lo;
+                        before = hi;
+                    }
+                    bank.members.push_back(sid);
+                }
+                close(bank, before);
+            }
+            return banks;
+        }
+
+        // Continuous numerator and denominator of a first- or second-order TransferFcn padded to order + 1
+        // terms, as the per-block code reads them
+        [[nodiscard]] static auto filter_coefficients(const transfer_function& tf)
+            -> std::pair<std::vector<double>, std::vector<double>> {
+            const auto& num = tf.num;
+            const auto& den = tf.den;
+            if (tf.order == 1) {
+                return {{num.size() > 1 ? num[0] : 0.0, num.size() > 1 ? num[1] : (num.size() == 1 ? num[0] : 1.0)},
+                        {den.empty() ? 0.0 : den[0], den.size() > 1 ? den[1] : 1.0}};
+            }
+            return {{num.size() > 2 ? num[0] : 0.0, num.size() > 2 ? num[1] : (num.size() > 1 ? num[0] : 0.0),
+                     num.size() > 2 ? num[2] : (num.size() > 1 ? num[1] : num[0])},
+                    {den[0], den.size() > 1 ? den[1] : 0.0, den.size() > 2 ? den[2] : 1.0}};
+        }
+
+        // Emit the banks due ahead of one block (empty SID: after the last one). Every bank is one loop with
+        // the per-block Tustin coefficients in arrays; each output is then read from its slot.
+        void emit_filter_banks(const mdl::system& sys, dataflow& df, const std::vector<filter_bank>& banks,
+                               const std::string& sid, const std::map<std::string, std::string>& signal_map,
+                               std::ostringstream& code) const {
+            for (const auto& bank : banks) {
+                if (bank.insert_before != sid) continue;
+
+                // Loop order follows the slots so a contiguous bank is indexed directly
+                auto slot = [&](const std::string& member) {
+                    const auto& pattern = df.filter_state.at(member);
+                    return std::stoi(pattern.substr(pattern.rfind('[') + 1));
+                };
+                auto members = bank.members;
+                std::ranges::sort(members, {}, slot);
+                std::vector<std::string> names;
+                std::map<std::string, std::vector<std::string>> coeffs;  // b0, b1, ... -> one literal per member
+                std::vector<std::string> inputs;
+                for (const auto& member : members) {
+                    const auto& blk = *sys.find_block_by_sid(member);
+                    names.push_back(blk.name);
+                    auto [num, den] = filter_coefficients(parse_transfer_function(blk));
+                    for (int i = 0; i <= bank.order; ++i) {
+                        coeffs["b" + std::to_string(i)].push_back(format_float(num[i]));
+                        coeffs["a" + std::to_string(i)].push_back(format_float(den[i]));
+                    }
+                    const auto& in = df.block_inputs[member];
+                    inputs.push_back(!in.empty() && !in[0].empty() ? in[0] : "0.0f /* missing input 1 */");
+                }
+
+                auto n = std::to_string(members.size());
+                int first = slot(members.front());
+                bool contiguous = slot(members.back()) - first + 1 == static_cast<int>(members.size());
+                auto bank_name = "state.tf" + std::to_string(bank.order) + "_bank_";
+                std::string index = first == 0 ? "i" : "i + " + std::to_string(first);
+                auto list = [](const std::vector<std::string>& items) {
+                    std::string joined;
+                    for (const auto& item : items) joined += (joined.empty() ? "" : ", ") + item;
+                    return joined;
+                };
+
+                code << indent_ << "// TransferFcn bank (order " << bank.order << "): " << list(names) << "\n";
+                code << indent_ << "{\n";
+                for (const auto& [name, values] : coeffs) {
+                    code << indent_ << "    static constexpr float " << name << "[] = {" << list(values) << "};\n";
+                }
+                if (!contiguous) {
+                    std::vector<std::string> slots;
+                    for (const auto& member : members) slots.push_back(std::to_string(slot(member)));
+                    code << indent_ << "    static constexpr int slot[] = {" << list(slots) << "};\n";
+                    index = "slot[i]";
+                }
+                auto field = [&](const std::string& f) { return bank_name + f + "[" + index + "]"; };
+                code << indent_ << "    const float k = 2.0f / " << dt_expression() << ";\n";
+                if (bank.order == 2) code << indent_ << "    const float k2 = k * k;\n";
+                code << indent_ << "    const float u[] = {" << list(inputs) << "};\n";
+                code << indent_ << "    for (int i = 0; i < " << n << "; ++i) {\n";
+                auto in = indent_ + "        ";
+                if (bank.order == 1) {
+                    code << in << "const float b0_d = b0[i] * k + b1[i];\n";
+                    code << in << "const float b1_d = -b0[i] * k + b1[i];\n";
+                    code << in << "const float a0_d = a0[i] * k + a1[i];\n";
+                    code << in << "const float a1_d = -a0[i] * k + a1[i];\n";
+                    code << in << "const float y_n = (b0_d * u[i] + b1_d * " << field("u0") << " - a1_d * " << field("x0") << ") / a0_d;\n";
+                    code << in << field("u0") << " = u[i];\n";
+                    code << in << field("x0") << " = y_n;\n";
+                } else {
+                    code << in << "const float b0_d = b0[i]*k2 + b1[i]*k + b2[i];\n";
+                    code << in << "const float b1_d = 2.0f*b2[i] - 2.0f*b0[i]*k2;\n";
+                    code << in << "const float b2_d = b0[i]*k2 - b1[i]*k + b2[i];\n";
+                    code << in << "const float a0_d = a0[i]*k2 + a1[i]*k + a2[i];\n";
+                    code << in << "const float a1_d = 2.0f*a2[i] - 2.0f*a0[i]*k2;\n";
+                    code << in << "const float a2_d = a0[i]*k2 - a1[i]*k + a2[i];\n";
+                    code << in << "const float y_n = (b0_d*u[i] + b1_d*" << field("u0") << " + b2_d*" << field("u1")
+                         << " - a1_d*" << field("x0") << " - a2_d*" << field("x1") << ") / a0_d;\n";
+                    code << in << field("u1") << " = " << field("u0") << ";\n";
+                    code << in << field("u0") << " = u[i];\n";
+                    code << in << field("x1") << " = " << field("x0") << ";\n";
+                    code << in << field("x0") << " = y_n;\n";
+                }
+                code << indent_ << "    }\n";
+                code << indent_ << "}\n";
+                for (const auto& member : members) {
+                    auto decl = options_.typed ? block_types(df, member, signal_map).output : std::string("auto");
+                    code << indent_ << decl << " " << signal_map.at(member + "#out:1") << " = "
+                         << filter_field(df.filter_state.at(member), "x0") << ";\n";
+                }
+            }
+        }
+
+        // Temporaries that --schedule keeps in scratch slots, as signal key -> position of their last
+        // reader. Single-assignment float signals qualify; those read by outputs, buses or a linear
+        // subsystem, named (probed) lines and constants keep their locals.
+        [[nodiscard]] auto scratch_candidates(const mdl::system& sys, const dataflow& df,
+                                              const std::map<std::string, std::string>& signal_map,
+                                              const std::vector<linear_region>& linear,
+                                              const std::map<std::string, std::pair<std::string, std::size_t>>& fusable,
+                                              const std::vector<filter_bank>& banks) const
+            -> std::map<std::string, int> {
+            auto evaluated_at = runs_at(df, linear, fusable, banks);
+            auto in_region = [&](const std::string& sid) {
+                return std::ranges::any_of(linear, [&](const auto& region) { return region.blocks.contains(sid); });
+            };
+
+            std::set<std::string> kept;
+            for (const auto& conn : sys.connections) {
+                if (!conn.name.empty()) kept.insert(conn.source);
+            }
+            for (const auto& [bus, leaves] : df.buses) {
+                kept.insert(bus);
+                for (const auto& [path, leaf] : leaves) kept.insert(df.resolve(leaf));
+            }
+
+            std::map<std::string, int> last_use;
+            for (const auto& [sid, keys] : df.input_keys) {
+                if (df.removed.contains(sid)) continue;
+                auto* reader = sys.find_block_by_sid(sid);
+                for (std::size_t i = 0; i < keys.size(); ++i) {
+                    if (keys[i].empty()) continue;
+                    auto key = df.resolve(keys[i]);
+                    if (kept.contains(key)) continue;
+
+                    auto src = signal_block_sid(key);
+                    auto* producer = sys.find_block_by_sid(src);
+                    auto current = signal_map.find(key);
+                    bool qualifies = producer && reader && is_stateless(*producer) && producer->type != "Constant" &&
+                                     producer->port_out == 1 && !df.removed.contains(src) && !fusable.contains(key) &&
+                                     !in_region(src) && !in_region(sid) && !reader->is_outport() &&
+                                     reader->type != "BusCreator" && reader->type != "BusSelector" &&
+                                     current != signal_map.end() && df.block_inputs.at(sid)[i] == current->second &&
+                                     (!options_.typed || df.type_of(key) == "float");
+                    if (!qualifies) {
+                        kept.insert(key);
+                        last_use.erase(key);
+                        continue;
+                    }
+                    last_use[key] = std::max(last_use[key], evaluated_at[sid]);
+                }
+            }
+            return last_use;
+        }
+
+        // Name every block output, resolve block inputs and sort blocks into execution order
+        [[nodiscard]] auto build_dataflow(
+            const mdl::system& sys,
+            const std::string& prefix,
+            std::map<std::string, std::string>& signal_map) -> dataflow
+        {
+            dataflow df;
+
+            // Build state block set for this system
+            for (const auto& blk : sys.blocks) {
+                if (blk.type == "UnitDelay" || blk.type == "Integrator" ||
+                    blk.type == "DiscreteIntegrator" || blk.type == "Memory") {
+                    df.state_sids.insert(blk.sid);
+                    auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
+                    df.state_var_map[blk.sid] = "state." + var_prefix + "_state";
+                }
+                // A Delay output is the sample it read; longer delays read their ring at the head
+                if (auto length = blk.type == "Delay" ? delay_length(blk, options_.calibration) : std::nullopt; length > 0) {
+                    df.state_sids.insert(blk.sid);
+                    auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
+                    df.state_var_map[blk.sid] = *length == 1 ? "state." + var_prefix + "_state"
+                                                             : "state." + var_prefix + "_buf[state." + var_prefix + "_head]";
+                }
+                // A filter without direct feedthrough holds its next output, like a UnitDelay
+                if (blk.type == "DiscreteFilter" || blk.type == "DiscreteTransferFcn") {
+                    if (auto filter = parse_discrete_filter(blk, options_.calibration); filter && filter->strictly_proper()) {
+                        df.state_sids.insert(blk.sid);
+                        auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
+                        df.state_var_map[blk.sid] = "state." + var_prefix + "_state";
+                    }
+                }
+            }
+            if (prefix.empty()) {
+                auto banks = bank_layout(sys);
+                for (const auto& [sid, index] : banks.delays) {
+                    df.state_var_map[sid] = "state.delay_bank[" + std::to_string(index) + "]";
+                }
+                for (const auto& [sid, slot] : banks.filters) {
+                    df.filter_state[sid] = "state.tf" + std::to_string(slot.first) + "_bank_%[" + std::to_string(slot.second) + "]";
+                }
+            }
+
+            // Assign output variable names for all blocks
+            for (const auto& blk : sys.blocks) {
+                if (blk.is_inport() || blk.is_outport()) continue;
+
+                auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
+
+                int num_outputs = blk.port_out;
+
+                // For subsystems, pre-map outputs to the names that will be created during inlining/call
+                if (blk.is_subsystem()) {
+                    for (int i = 1; i <= num_outputs; ++i) {
+                        auto key = blk.sid + "#out:" + std::to_string(i);
+                        signal_map[key] = var_prefix + "_out" + std::to_string(i);
+                    }
+                    continue;
+                }
+
+                for (int i = 1; i <= num_outputs; ++i) {
+                    auto key = blk.sid + "#out:" + std::to_string(i);
+
+                    // State blocks output from state variable
+                    if (df.state_sids.contains(blk.sid)) {
+                        signal_map[key] = df.state_var_map[blk.sid];
+                    } else {
+                        auto var = var_prefix;
+                        if (num_outputs > 1) var += "_" + std::to_string(i);
+                        signal_map[key] = var;
+                    }
+                }
+            }
+
+            // Build dependencies and input mappings
+            std::map<std::string, std::set<std::string>> dependencies;
+
+            for (const auto& blk : sys.blocks) {
+                if (blk.is_inport()) continue;
+                dependencies[blk.sid] = {};
+                df.block_inputs[blk.sid] = {};
+            }
+
+            for (const auto& conn : sys.connections) {
+                auto src = mdl::endpoint::parse(conn.source);
+                if (!src) continue;
+
+                auto src_key = src->block_sid + "#out:" + std::to_string(src->port_index);
+                auto src_var = signal_map.count(src_key) ? signal_map[src_key] : "0.0f /* unknown */";
+
+                auto add_connection = [&](const std::string& dst_str) {
+                    auto dst = mdl::endpoint::parse(dst_str);
+                    if (!dst) return;
+
+                    auto& inputs = df.block_inputs[dst->block_sid];
+                    auto& sources = df.input_keys[dst->block_sid];
+                    if (inputs.size() < static_cast<size_t>(dst->port_index)) {
+                        inputs.resize(dst->port_index);
+                        sources.resize(dst->port_index);
+                    }
+                    inputs[dst->port_index - 1] = src_var;
+                    sources[dst->port_index - 1] = src_key;
+
+                    if (dependencies.count(dst->block_sid)) {
+                        auto* src_blk = sys.find_block_by_sid(src->block_sid);
+                        bool is_inport = src_blk && src_blk->is_inport();
+                        bool is_state = df.state_sids.contains(src->block_sid);
+
+                        if (!is_inport && !is_state) {
+                            dependencies[dst->block_sid].insert(src->block_sid);
+                        }
+                    }
+                };
+
+                if (!conn.destination.empty()) {
+                    add_connection(conn.destination);
+                }
+                for (const auto& branch : conn.branches) {
+                    add_connection(branch.destination);
+                }
+            }
+
+            // Topological sort
+            std::map<std::string, int> in_degree;
+            for (const auto& [sid, deps] : dependencies) {
+                if (!in_degree.count(sid)) in_degree[sid] = 0;
+                for (const auto& dep : deps) {
+                    if (auto* blk = sys.find_block_by_sid(dep); blk && !blk->is_inport()) {
+                        in_degree[sid]++;
+                    }
+                }
+            }
+
+            std::queue<std::string> ready;
+            for (const auto& [sid, deg] : in_degree) {
+                if (deg == 0) ready.push(sid);
+            }
+
+            while (!ready.empty()) {
+                auto sid = ready.front();
+                ready.pop();
+                df.sorted_sids.push_back(sid);
+
+                for (auto& [other_sid, deps] : dependencies) {
+                    if (deps.contains(sid)) {
+                        deps.erase(sid);
+                        in_degree[other_sid]--;
+                        if (in_degree[other_sid] == 0) {
+                            ready.push(other_sid);
+                        }
+                    }
+                }
+            }
+
+            if (!options_.calibration.empty()) {
+                specialize_dataflow(sys, df, signal_map);
+            }
+            if (options_.range_analysis) {
+                analyze_ranges(sys, df, signal_map, prefix);
+            }
+            if (options_.schedule) {
+                schedule_for_liveness(sys, df);
+            }
+
+            return df;
+        }
+
+        // Peak number of block outputs held in locals at once when blocks run in the given order
+        [[nodiscard]] static auto max_live_signals(const std::vector<std::string>& order,
+                                                   const std::map<std::string, std::vector<std::string>>& produces,
+                                                   std::map<std::string, int> readers,
+                                                   const std::map<std::string, std::vector<std::string>>& reads) -> int {
+            int live = 0, peak = 0;
+            for (const auto& sid : order) {
+                if (auto it = produces.find(sid); it != produces.end()) live += static_cast<int>(it->second.size());
+                peak = std::max(peak, live);
+                if (auto it = reads.find(sid); it != reads.end()) {
+                    for (const auto& key : it->second) {
+                        if (--readers[key] == 0) --live;
+                    }
+                }
+            }
+            return peak;
+        }
+
+        // Reorder blocks to keep few signals live: among the blocks whose inputs are ready, run the one
+        // that frees the most signals for the fewest new ones (first in the original order on ties).
+        // A block reading a delay or integrator output stays on the same side of that state's update.
+        void schedule_for_liveness(const mdl::system& sys, dataflow& df) const {
+            std::map<std::string, int> position;
+            for (int i = 0; const auto& sid : df.sorted_sids) position[sid] = i++;
+
+            std::map<std::string, std::set<std::string>> after;         // SID -> SIDs it has to follow
+            std::map<std::string, std::vector<std::string>> produces;   // SID -> local signals it writes
+            std::map<std::string, std::vector<std::string>> reads;      // SID -> local signals it reads (once per port)
+            std::map<std::string, int> readers;                         // local signal -> reads left
+            std::vector<std::string> first, last;                        // inports, outports: no code
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (blk && blk->is_inport()) {
+                    first.push_back(sid);
+                    continue;
+                }
+                if (blk && blk->is_outport()) last.push_back(sid);
+                after[sid];
+                if (df.removed.contains(sid)) continue;
+
+                const auto& keys = df.input_keys[sid];
+                for (const auto& raw : keys) {
+                    if (raw.empty()) continue;
+                    auto key = df.resolve(raw);
+                    auto src = signal_block_sid(key);
+                    auto* src_blk = sys.find_block_by_sid(src);
+                    if (!position.contains(src) || !src_blk || src_blk->is_inport() || src == sid ||
+                        df.constants.contains(key)) continue;
+
+                    if (df.state_sids.contains(src)) {
+                        if (blk && blk->is_outport()) continue;  // outputs are assigned after every update
+                        if (position[sid] < position[src]) after[src].insert(sid);
+                        else after[sid].insert(src);
+                        continue;
+                    }
+                    after[sid].insert(src);
+                    if (df.removed.contains(src)) continue;
+                    if (!readers.contains(key)) produces[src].push_back(key);
+                    ++readers[key];
+                    // Outputs are assigned after the last block, so they hold their signal to the end
+                    if (!blk || !blk->is_outport()) reads[sid].push_back(key);
+                }
+            }
+            auto before = max_live_signals(df.sorted_sids, produces, readers, reads);
+
+            std::map<std::string, int> waiting;
+            std::map<std::string, std::vector<std::string>> unblocks;
+            for (const auto& [sid, deps] : after) {
+                waiting[sid] = static_cast<int>(deps.size());
+                for (const auto& dep : deps) unblocks[dep].push_back(sid);
+            }
+            std::set<std::pair<int, std::string>> ready;  // {original position, SID}
+            for (const auto& [sid, count] : waiting) {
+                if (count == 0 && std::ranges::find(last, sid) == last.end()) ready.emplace(position[sid], sid);
+            }
+
+            auto left = readers;
+            std::vector<std::string> order = first;
+            while (!ready.empty()) {
+                auto best = ready.begin();
+                int best_delta = std::numeric_limits<int>::max();
+                for (auto it = ready.begin(); it != ready.end(); ++it) {
+                    const auto& sid = it->second;
+                    int delta = produces.contains(sid) ? static_cast<int>(produces[sid].size()) : 0;
+                    std::map<std::string, int> taken;
+                    for (const auto& key : reads[sid]) ++taken[key];
+                    for (const auto& [key, count] : taken) {
+                        if (left[key] == count) --delta;
+                    }
+                    if (delta < best_delta) {
+                        best = it;
+                        best_delta = delta;
+                    }
+                }
+
+                auto sid = best->second;
+                ready.erase(best);
+                order.push_back(sid);
+                for (const auto& key : reads[sid]) --left[key];
+                for (const auto& next : unblocks[sid]) {
+                    if (--waiting[next] == 0 && std::ranges::find(last, next) == last.end()) ready.emplace(position[next], next);
+                }
+            }
+            order.insert(order.end(), last.begin(), last.end());
+            df.max_live_before = df.max_live = before;
+            if (order.size() != df.sorted_sids.size()) return;
+
+            // Greedy choices can lose to the original order; keep whichever peaks lower
+            if (auto peak = max_live_signals(order, produces, readers, reads); peak < before) {
+                df.sorted_sids = std::move(order);
+                df.max_live = peak;
+            }
+        }
+
+        // Dotted field paths read from a bus signal: what BusSelectors select (following
+        // selected sub-buses) and what components that take it as a bus input expect
+        [[nodiscard]] static auto selected_paths(const mdl::system& sys, const std::string& src_key,
+                                                 const std::map<std::string, const generated_component*>& component_map)
+            -> std::vector<std::string> {
+            std::vector<std::string> paths;
+            auto add = [&](std::string path) {
+                if (std::ranges::find(paths, path) == paths.end()) paths.push_back(std::move(path));
+            };
+
+            for (const auto& conn : sys.connections) {
+                auto src = mdl::endpoint::parse(conn.source);
+                if (!src || src->block_sid + "#out:" + std::to_string(src->port_index) != src_key) continue;
+
+                auto visit = [&](const std::string& dst_str) {
+                    auto dst = mdl::endpoint::parse(dst_str);
+                    auto* blk = dst ? sys.find_block_by_sid(dst->block_sid) : nullptr;
+                    if (!blk) return;
+
+                    if (blk->type == "BusSelector" && dst->port_index == 1) {
+                        auto items = split_signal_list(blk->param("OutputSignals").value_or(""));
+                        for (std::size_t j = 0; j < items.size(); ++j) {
+                            auto sub = selected_paths(sys, blk->sid + "#out:" + std::to_string(j + 1), component_map);
+                            if (sub.empty()) add(items[j]);
+                            for (const auto& p : sub) add(items[j] + "." + p);
+                        }
+                    } else if (auto it = component_map.find(blk->sid); it != component_map.end()) {
+                        const auto& comp = *it->second;
+                        auto port = static_cast<std::size_t>(dst->port_index - 1);
+                        if (port < comp.inports.size()) {
+                            if (auto bus = comp.bus_types.find(comp.inports[port].second); bus != comp.bus_types.end()) {
+                                for (const auto& [path, type] : bus->second) add(path);
+                            }
+                        }
+                    }
+                };
+                visit(conn.destination);
+                for (const auto& br : conn.branches) visit(br.destination);
+            }
+            return paths;
+        }
+
+        // Lower bus signals to their leaves: BusCreator and BusSelector emit no code, selected
+        // fields read the original signal directly, and bus ports are accessed field by field
+        void lower_buses(const mdl::system& sys, dataflow& df, std::map<std::string, std::string>& signal_map,
+                         const std::map<std::string, const generated_component*>& component_map) const {
+            bool has_buses = std::ranges::any_of(sys.blocks, [](const auto& b) {
+                return b.type == "BusCreator" || b.type == "BusSelector";
+            }) || std::ranges::any_of(component_map, [](const auto& entry) {
+                return !entry.second->bus_types.empty();
+            });
+            if (!has_buses) return;
+
+            // Inports whose fields are selected downstream carry a bus
+            for (const auto& blk : sys.blocks) {
+                if (!blk.is_inport()) continue;
+                auto key = blk.sid + "#out:1";
+                for (const auto& path : selected_paths(sys, key, component_map)) {
+                    auto leaf = key + "." + path;
+                    if (!signal_map.count(leaf)) signal_map[leaf] = signal_map[key] + "." + path;
+                    df.buses[key].emplace_back(path, leaf);
+                }
+            }
+
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk) continue;
+
+                if (auto it = component_map.find(sid); it != component_map.end()) {
+                    // Bus outputs of a component are read straight from its output struct
+                    const auto& comp = *it->second;
+                    for (std::size_t i = 0; i < comp.outports.size(); ++i) {
+                        auto bus = comp.bus_types.find(comp.outports[i].second);
+                        if (bus == comp.bus_types.end()) continue;
+                        auto key = sid + "#out:" + std::to_string(i + 1);
+                        for (const auto& [path, type] : bus->second) {
+                            auto leaf = key + "." + path;
+                            signal_map[leaf] = sanitize_name(blk->name) + "_out." + comp.outports[i].first + "." + path;
+                            df.buses[key].emplace_back(path, leaf);
+                        }
+                    }
+                } else if (blk->type == "BusCreator") {
+                    auto& fields = df.buses[sid + "#out:1"];
+                    const auto& keys = df.input_keys[sid];
+                    for (std::size_t i = 0; i < keys.size(); ++i) {
+                        auto name = sanitize_name(incoming_signal_name(sys, sid, static_cast<int>(i + 1)));
+                        if (name.empty()) name = "signal" + std::to_string(i + 1);
+                        auto key = df.resolve(keys[i]);
+                        if (auto sub = df.buses.find(key); sub != df.buses.end()) {
+                            for (const auto& [path, leaf] : sub->second) fields.emplace_back(name + "." + path, leaf);
+                        } else {
+                            fields.emplace_back(name, key);
+                        }
+                    }
+                    df.removed.insert(sid);
+                } else if (blk->type == "BusSelector") {
+                    const auto& keys = df.input_keys[sid];
+                    auto bus = keys.empty() ? df.buses.end() : df.buses.find(df.resolve(keys.front()));
+                    if (bus == df.buses.end()) continue;
+
+                    auto fields = bus->second;
+                    auto items = split_signal_list(blk->param("OutputSignals").value_or(""));
+                    for (std::size_t j = 0; j < items.size(); ++j) {
+                        auto out_key = sid + "#out:" + std::to_string(j + 1);
+                        for (const auto& [path, leaf] : fields) {
+                            if (path == items[j]) {
+                                df.forwards[out_key] = leaf;
+                            } else if (path.starts_with(items[j] + ".")) {
+                                df.buses[out_key].emplace_back(path.substr(items[j].size() + 1), leaf);
+                            }
+                        }
+                    }
+                    df.removed.insert(sid);
+                }
+            }
+
+            // Readers of selected fields use the leaf signal itself
+            for (const auto& [key, target] : df.forwards) {
+                signal_map[key] = signal_map[df.resolve(target)];
+            }
+            for (auto& [sid, keys] : df.input_keys) {
+                auto& inputs = df.block_inputs[sid];
+                for (std::size_t i = 0; i < keys.size() && i < inputs.size(); ++i) {
+                    if (df.forwards.contains(keys[i])) inputs[i] = signal_map[df.resolve(keys[i])];
+                }
+            }
+        }
+
+        // Give bus-carrying ports a struct type named after the owner and port
+        static void apply_bus_types(const std::string& owner, const dataflow& df,
+                                    const std::vector<mdl::block>& inports,
+                                    std::vector<std::pair<std::string, std::string>>& inport_types,
+                                    const std::vector<mdl::block>& outports,
+                                    std::vector<std::pair<std::string, std::string>>& outport_types,
+                                    std::map<std::string, bus_layout>& bus_types) {
+            if (df.buses.empty()) return;
+
+            auto assign = [&](const std::string& key, std::pair<std::string, std::string>& port) {
+                auto bus = df.buses.find(df.resolve(key));
+                if (bus == df.buses.end()) return;
+                bus_layout layout;
+                for (const auto& [path, leaf] : bus->second) layout.emplace_back(path, df.type_of(leaf));
+                port.second = owner + "_" + port.first + "_bus";
+                bus_types[port.second] = std::move(layout);
+            };
+            for (std::size_t i = 0; i < inports.size() && i < inport_types.size(); ++i) {
+                assign(inports[i].sid + "#out:1", inport_types[i]);
+            }
+            for (std::size_t i = 0; i < outports.size() && i < outport_types.size(); ++i) {
+                if (auto it = df.input_keys.find(outports[i].sid); it != df.input_keys.end() && !it->second.empty()) {
+                    assign(it->second.front(), outport_types[i]);
+                }
+            }
+        }
+
+        // Designated initializer for a bus struct, e.g. {.x = a, .pos = {.z = b}}
+        template <typename ValueOf>
+        [[nodiscard]] static auto bus_initializer(const bus_layout& layout, const ValueOf& value_of,
+                                                  const std::string& prefix = "") -> std::string {
+            std::string init = "{";
+            std::set<std::string> done;
+            for (const auto& [path, type] : layout) {
+                if (!path.starts_with(prefix)) continue;
+                auto rest = path.substr(prefix.size());
+                auto dot = rest.find('.');
+                auto field = rest.substr(0, dot);
+                if (!done.insert(field).second) continue;
+                if (init.size() > 1) init += ", ";
+                init += "." + field + " = ";
+                init += dot == std::string::npos ? value_of(path, type)
+                                                 : bus_initializer(layout, value_of, prefix + field + ".");
+            }
+            return init + "}";
+        }
+
+        // Bus struct with nested members for dotted paths
+        static void emit_bus_struct(std::ostringstream& out, const std::string& name, const bus_layout& layout) {
+            auto emit_fields = [&](auto& self, const std::string& prefix, const std::string& indent) -> void {
+                std::set<std::string> done;
+                for (const auto& [path, type] : layout) {
+                    if (!path.starts_with(prefix)) continue;
+                    auto rest = path.substr(prefix.size());
+                    auto dot = rest.find('.');
+                    auto field = rest.substr(0, dot);
+                    if (!done.insert(field).second) continue;
+                    if (dot == std::string::npos) {
+                        out << indent << type << " " << field << " = " << zero_value(type) << ";\n";
+                    } else {
+                        out << indent << "struct {\n";
+                        self(self, prefix + field + ".", indent + "    ");
+                        out << indent << "} " << field << ";\n";
+                    }
+                }
+            };
+            out << "    struct " << name << " {\n";
+            emit_fields(emit_fields, "", "        ");
+            out << "    };\n\n";
+        }
+
+        // Port field declaration: scalars get a zero initializer, bus structs value-initialize
+        [[nodiscard]] static auto port_declaration(const std::string& name, const std::string& type,
+                                                   const std::map<std::string, bus_layout>& bus_types) -> std::string {
+            if (bus_types.contains(type)) return type + " " + name + "{};";
+            return type + " " + name + " = " + zero_value(type) + ";";
+        }
+
+        // Sample time as read by generated code: the calibrated value once dt is bound
+        [[nodiscard]] auto dt_expression() const -> std::string {
+            auto it = options_.calibration.find("dt");
+            return it != options_.calibration.end() ? format_constant(it->second) : "cfg.dt";
+        }
+
+        // Blocks whose output is a linear function of their inputs and state, with coefficients
+        // known at generation time (literal or calibrated; Integrator and TransferFcn need dt)
+        [[nodiscard]] auto linear_block(const mdl::block& blk) const -> bool {
+            if (auto declared = declared_type(blk); declared && *declared != "float" && *declared != "double") return false;
+
+            bool has_dt = options_.calibration.contains("dt");
+            if (blk.type == "Gain") return evaluate_expression(blk.param("Gain").value_or("1"), options_.calibration).has_value();
+            if (blk.type == "Sum") return blk.param("Inputs").value_or("++").find_first_of("+-") != std::string::npos;
+            if (blk.type == "UnitDelay" || blk.type == "Memory") return true;
+            if (blk.type == "Integrator" || blk.type == "DiscreteIntegrator") return has_dt;
+            if (blk.type == "TransferFcn") {
+                auto order = parse_transfer_function(blk).order;
+                return has_dt && (order == 1 || order == 2);
+            }
+            return false;
+        }
+
+        // Split the linear blocks of a system into connected subgraphs and compile each one that can
+        // be scheduled as a unit; the rest keep their per-block code
+        [[nodiscard]] auto compile_linear_regions(const mdl::system& sys, dataflow& df,
+                                                  const std::map<std::string, std::string>& signal_map,
+                                                  const std::string& prefix) const -> std::vector<linear_region> {
+            std::map<std::string, std::string> parent;  // union-find over linear SIDs
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (blk && !df.removed.contains(sid) && linear_block(*blk)) parent[sid] = sid;
+            }
+            auto find = [&](std::string sid) {
+                while (parent[sid] != sid) sid = parent[sid] = parent[parent[sid]];
+                return sid;
+            };
+            for (const auto& [sid, root] : std::map(parent)) {
+                for (const auto& key : df.input_keys[sid]) {
+                    if (key.empty()) continue;
+                    auto src = signal_block_sid(df.resolve(key));
+                    if (parent.contains(src)) parent[find(src)] = find(sid);
+                }
+            }
+
+            std::map<std::string, std::set<std::string>> components;
+            for (const auto& sid : df.sorted_sids) {
+                if (parent.contains(sid)) components[find(sid)].insert(sid);
+            }
+            std::vector<linear_region> regions;
+            for (const auto& sid : df.sorted_sids) {
+                auto it = components.find(sid);
+                if (it == components.end() || it->second.size() < 2) continue;
+                auto base = (prefix.empty() ? std::string("linear") : prefix + "_linear") + std::to_string(regions.size());
+                if (auto region = compile_linear_region(sys, df, signal_map, prefix, it->second, base)) {
+                    regions.push_back(std::move(*region));
+                }
+            }
+            return regions;
+        }
+
+        // Emit the updates scheduled ahead of a block (or after the last one, for an empty SID);
+        // true when the block itself is replaced by one of them
+        static auto emit_linear_regions(const std::vector<linear_region>& regions, const std::string& sid,
+                                        std::ostringstream& code) -> bool {
+            bool replaced = false;
+            for (const auto& region : regions) {
+                if (region.insert_before == sid) code << region.code;
+                replaced = replaced || region.blocks.contains(sid);
+            }
+            return replaced;
+        }
+
+        // Build the state-space update for one linear subgraph. Its blocks are evaluated symbolically
+        // in emission order with states written in place, so the matrices are the per-block updates
+        // composed. Folded coefficients of poles near z = 1 do not survive rounding to float, so rows
+        // are evaluated in double with double coefficients; the result still differs from the
+        // per-block float code by rounding. Fails when the subgraph cannot run as one unit at a single
+        // point of the schedule.
+        [[nodiscard]] auto compile_linear_region(const mdl::system& sys, dataflow& df,
+                                                 const std::map<std::string, std::string>& signal_map,
+                                                 const std::string& prefix, std::set<std::string> blocks,
+                                                 const std::string& base) const -> std::optional<linear_region> {
+            using linear_form = std::map<std::string, double>;  // column ("x:" state, "u:" input) -> coefficient
+
+            linear_region region;
+            region.blocks = std::move(blocks);
+
+            std::vector<std::string> states, inputs;                  // column order
+            std::map<std::string, linear_form> state_val;             // state field -> current value
+            std::map<std::string, linear_form> signal_val;            // signal key -> value
+            std::map<std::string, int> position;                      // SID -> index in emission order
+            int last_producer = -1;                                   // latest outside block feeding the region
+            bool feasible = true;
+
+            auto add = [](linear_form& acc, double a, const linear_form& v) {
+                for (const auto& [col, c] : v) acc[col] += a * c;
+            };
+            auto state_field = [&](const std::string& field) -> linear_form& {
+                if (!state_val.contains(field)) {
+                    states.push_back(field);
+                    state_val[field] = {{"x:" + field, 1.0}};
+                }
+                return state_val[field];
+            };
+            // Current value of a region signal; state blocks output their state as it is right now
+            auto region_value = [&](const std::string& key) -> linear_form {
+                auto src = signal_block_sid(key);
+                if (df.state_sids.contains(src)) return state_field(df.state_var_map[src]);
+                return signal_val[key];
+            };
+            auto input_value = [&](const std::string& sid, std::size_t port) -> linear_form {
+                const auto& keys = df.input_keys[sid];
+                if (port >= keys.size() || keys[port].empty()) return {};
+                auto key = df.resolve(keys[port]);
+                auto src = signal_block_sid(key);
+                if (region.blocks.contains(src)) return region_value(key);
+                if (df.state_sids.contains(src)) feasible = false;  // outside state may change mid-step
+                if (auto it = position.find(src); it != position.end()) last_producer = std::max(last_producer, it->second);
+
+                std::string expr;
+                if (auto c = df.constants.find(key); c != df.constants.end()) {
+                    expr = format_constant(c->second);
+                } else if (auto it = signal_map.find(key); it != signal_map.end()) {
+                    expr = it->second;
+                } else {
+                    feasible = false;
+                    return {};
+                }
+                if (std::ranges::find(inputs, expr) == inputs.end()) inputs.push_back(expr);
+                return {{"u:" + expr, 1.0}};
+            };
+
+            struct reader { std::string sid; std::size_t port; std::string key; linear_form value; };
+            std::vector<reader> readers;
+            int first_reader = -1;
+
+            for (const auto& sid : df.sorted_sids) {
+                auto index = static_cast<int>(position.size());
+                position[sid] = index;
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || blk->is_inport() || blk->is_outport() || df.removed.contains(sid)) continue;
+
+                if (!region.blocks.contains(sid)) {
+                    const auto& keys = df.input_keys[sid];
+                    for (std::size_t i = 0; i < keys.size(); ++i) {
+                        if (keys[i].empty()) continue;
+                        auto key = df.resolve(keys[i]);
+                        if (!region.blocks.contains(signal_block_sid(key))) continue;
+                        if (blk->type == "BusCreator" || blk->type == "BusSelector") return std::nullopt;
+                        readers.push_back({sid, i, key, region_value(key)});
+                        if (first_reader < 0) first_reader = index;
+                    }
+                    continue;
+                }
+
+                linear_form y;
+                if (blk->type == "Gain") {
+                    add(y, *evaluate_expression(blk->param("Gain").value_or("1"), options_.calibration), input_value(sid, 0));
+                } else if (blk->type == "Sum") {
+                    std::size_t idx = 0;
+                    for (char c : blk->param("Inputs").value_or("++")) {
+                        if (c == '+' || c == '-') add(y, c == '+' ? 1.0 : -1.0, input_value(sid, idx++));
+                    }
+                } else if (blk->type == "UnitDelay" || blk->type == "Memory") {
+                    auto u = input_value(sid, 0);
+                    state_field(df.state_var_map[sid]) = std::move(u);
+                    continue;
+                } else if (blk->type == "Integrator" || blk->type == "DiscreteIntegrator") {
+                    auto u = input_value(sid, 0);
+                    add(state_field(df.state_var_map[sid]), options_.calibration.at("dt"), u);
+                    continue;
+                } else if (blk->type == "TransferFcn") {
+                    // Same Tustin coefficients as the per-block TransferFcn code
+                    auto tf = parse_transfer_function(*blk);
+                    double k = 2.0 / options_.calibration.at("dt");
+                    auto var_prefix = prefix.empty() ? sanitize_name(blk->name) : prefix + "_" + sanitize_name(blk->name);
+                    auto pattern = df.filter_state.contains(sid) ? df.filter_state[sid] : "state." + var_prefix + "_tf_%";
+                    auto field = [&](const std::string& f) -> linear_form& { return state_field(filter_field(pattern, f)); };
+                    auto u = input_value(sid, 0);
+                    if (tf.order == 1) {
+                        double b0 = tf.num.size() > 1 ? tf.num[0] : 0.0;
+                        double b1 = tf.num.size() > 1 ? tf.num[1] : (tf.num.size() == 1 ? tf.num[0] : 1.0);
+                        double a0 = tf.den.size() > 0 ? tf.den[0] : 0.0;
+                        double a1 = tf.den.size() > 1 ? tf.den[1] : 1.0;
+                        if (tf.num.size() == 1) { b0 = 0.0; b1 = tf.num[0]; }
+                        double b0_d = b0 * k + b1, b1_d = -b0 * k + b1;
+                        double a0_d = a0 * k + a1, a1_d = -a0 * k + a1;
+                        add(y, b0_d / a0_d, u);
+                        add(y, b1_d / a0_d, field("u0"));
+                        add(y, -a1_d / a0_d, field("x0"));
+                        field("u0") = u;
+                        field("x0") = y;
+                    } else {
+                        double b0 = tf.num.size() > 2 ? tf.num[0] : 0.0;
+                        double b1 = tf.num.size() > 2 ? tf.num[1] : (tf.num.size() > 1 ? tf.num[0] : 0.0);
+                        double b2 = tf.num.size() > 2 ? tf.num[2] : (tf.num.size() > 1 ? tf.num[1] : tf.num[0]);
+                        double a0 = tf.den[0];
+                        double a1 = tf.den.size() > 1 ? tf.den[1] : 0.0;
+                        double a2 = tf.den.size() > 2 ? tf.den[2] : 1.0;
+                        if (tf.num.size() == 1) { b0 = 0; b1 = 0; b2 = tf.num[0]; }
+                        double k2 = k * k;
+                        double b0_d = b0 * k2 + b1 * k + b2, b1_d = 2.0 * b2 - 2.0 * b0 * k2, b2_d = b0 * k2 - b1 * k + b2;
+                        double a0_d = a0 * k2 + a1 * k + a2, a1_d = 2.0 * a2 - 2.0 * a0 * k2, a2_d = a0 * k2 - a1 * k + a2;
+                        add(y, b0_d / a0_d, u);
+                        add(y, b1_d / a0_d, field("u0"));
+                        add(y, b2_d / a0_d, field("u1"));
+                        add(y, -a1_d / a0_d, field("x0"));
+                        add(y, -a2_d / a0_d, field("x1"));
+                        field("u1") = linear_form(field("u0"));
+                        field("u0") = u;
+                        field("x1") = linear_form(field("x0"));
+                        field("x0") = y;
+                    }
+                }
+                signal_val[sid + "#out:1"] = std::move(y);
+            }
+
+            // Outputs are assigned after every block has run
+            for (const auto& outp : sys.outports()) {
+                auto it = df.input_keys.find(outp.sid);
+                if (it == df.input_keys.end() || it->second.empty() || it->second.front().empty()) continue;
+                auto key = df.resolve(it->second.front());
+                if (region.blocks.contains(signal_block_sid(key))) readers.push_back({outp.sid, 0, key, region_value(key)});
+            }
+
+            // Everything feeding the region has to run before anything that reads it
+            if (!feasible || (first_reader >= 0 && last_producer >= first_reader)) return std::nullopt;
+            if (first_reader >= 0) region.insert_before = df.sorted_sids[first_reader];
+
+            // Rows of [C D] for the signals read outside the region, rows of [A B] for the states it writes
+            std::vector<std::pair<std::string, linear_form>> outputs;  // variable -> value
+            for (const auto& r : readers) {
+                auto src = signal_block_sid(r.key);
+                if (df.state_sids.contains(src)) {
+                    // A state read sees the updated state unless it ran before the update did
+                    if (r.value == state_val[df.state_var_map[src]]) continue;
+                    auto var = base + "_y" + std::to_string(outputs.size());
+                    outputs.emplace_back(var, r.value);
+                    df.block_inputs[r.sid][r.port] = var;
+                } else if (auto var = signal_map.at(r.key);
+                           std::ranges::find(outputs, var, &std::pair<std::string, linear_form>::first) == outputs.end()) {
+                    outputs.emplace_back(var, r.value);
+                }
+            }
+            std::vector<std::pair<std::string, linear_form>> updates;  // state field -> next value
+            for (const auto& field : states) {
+                if (state_val[field] != linear_form{{"x:" + field, 1.0}}) updates.emplace_back(field, state_val[field]);
+            }
+
+            std::vector<std::string> columns;
+            for (const auto& field : states) columns.push_back("x:" + field);
+            for (const auto& expr : inputs) columns.push_back("u:" + expr);
+
+            std::ostringstream code;
+            code << indent_ << "// Linear subsystem: " << states.size() << " states, " << inputs.size() << " inputs, "
+                 << outputs.size() << " outputs\n";
+
+            // Products are evaluated before any state is written; output rows can be declared directly,
+            // state rows go through temporaries since later rows still read the old state. Both are
+            // summed in double and stored as float.
+            auto product = [&](const std::vector<std::pair<std::string, linear_form>>& rows, const std::string& name,
+                               bool declare_rows) {
+                std::size_t nonzeros = 0;
+                for (const auto& [var, row] : rows) {
+                    nonzeros += std::ranges::count_if(row, [](const auto& entry) { return entry.second != 0.0; });
+                }
+                auto total = rows.size() * columns.size();
+
+                // Dense matvec once the matrix is big and mostly filled, straight-line terms otherwise
+                if (total > 64 && nonzeros * 2 >= total) {
+                    code << indent_ << "static constexpr double " << name << "[" << rows.size() << "][" << columns.size() << "] = {\n";
+                    for (const auto& [var, row] : rows) {
+                        code << indent_ << "    {";
+                        for (std::size_t j = 0; j < columns.size(); ++j) {
+                            auto it = row.find(columns[j]);
+                            code << (j ? ", " : "") << format_double(it != row.end() ? it->second : 0.0);
+                        }
+                        code << "},\n";
+                    }
+                    code << indent_ << "};\n";
+                    code << indent_ << "const double " << name << "_v[" << columns.size() << "] = {";
+                    for (std::size_t j = 0; j < columns.size(); ++j) code << (j ? ", " : "") << columns[j].substr(2);
+                    code << "};\n";
+                    code << indent_ << "double " << name << "_r[" << rows.size() << "] = {};\n";
+                    code << indent_ << "for (std::size_t i = 0; i < " << rows.size() << "; ++i) {\n";
+                    code << indent_ << "    for (std::size_t j = 0; j < " << columns.size() << "; ++j) {\n";
+                    code << indent_ << "        " << name << "_r[i] += " << name << "[i][j] * " << name << "_v[j];\n";
+                    code << indent_ << "    }\n";
+                    code << indent_ << "}\n";
+                    std::vector<std::string> results;
+                    for (std::size_t i = 0; i < rows.size(); ++i) {
+                        results.push_back("static_cast<float>(" + name + "_r[" + std::to_string(i) + "])");
+                    }
+                    return results;
+                }
+
+                std::vector<std::string> results;
+                for (const auto& [var, row] : rows) {
+                    std::vector<std::pair<double, std::string>> terms;
+                    for (const auto& col : columns) {
+                        if (auto it = row.find(col); it != row.end()) terms.emplace_back(it->second, col.substr(2));
+                    }
+                    auto result = declare_rows ? var : name + std::to_string(results.size());
+                    code << indent_ << (declare_rows ? "auto " : "const float ") << result << " = static_cast<float>("
+                         << weighted_sum(terms, true) << ");\n";
+                    results.push_back(result);
+                }
+                return results;
+            };
+
+            auto y = product(outputs, base + "_CD", true);
+            auto x = product(updates, base + "_AB", false);
+            for (std::size_t i = 0; i < outputs.size(); ++i) {
+                if (y[i] != outputs[i].first) code << indent_ << "auto " << outputs[i].first << " = " << y[i] << ";\n";
+            }
+            for (std::size_t i = 0; i < updates.size(); ++i) {
+                code << indent_ << updates[i].first << " = " << x[i] << ";\n";
+            }
+
+            region.code = code.str();
+            return region;
+        }
+
+        // Declared output type of a block, when typed generation is on and the model names one
+        [[nodiscard]] auto declared_type(const mdl::block& blk) const -> std::optional<std::string> {
+            if (!options_.typed) return std::nullopt;
+            if (auto v = blk.param("OutDataTypeStr")) return cpp_data_type(*v);
+            return std::nullopt;
+        }
+
+        // Types a block reads and writes, or empty when types are not propagated
+        [[nodiscard]] auto block_types(const dataflow& df, const std::string& sid,
+                                       const std::map<std::string, std::string>& signal_map) const -> signal_typing {
+            signal_typing types;
+            if (options_.typed) {
+                types.inputs = df.input_types(sid);
+                types.output = df.type_of(sid + "#out:1");
+            }
+            if (auto it = df.input_keys.find(sid); it != df.input_keys.end() && !df.buses.empty()) {
+                for (std::size_t i = 0; i < it->second.size(); ++i) {
+                    auto bus = df.buses.find(df.resolve(it->second[i]));
+                    if (bus == df.buses.end()) continue;
+                    types.input_buses.resize(it->second.size());
+                    for (const auto& [path, leaf] : bus->second) {
+                        auto expr = signal_map.find(leaf);
+                        types.input_buses[i].emplace_back(path, expr != signal_map.end() ? expr->second : "0.0f");
+                    }
+                }
+            }
+            return types;
+        }
+
+        // Propagate data types forward through the graph: explicit OutDataTypeStr wins, logic
+        // and comparisons produce bool, selection blocks keep the type of their data inputs
+        // and arithmetic is float (double when any operand is double)
+        void infer_types(const mdl::system& sys, dataflow& df,
+                         const std::map<std::string, const generated_component*>& component_map) const {
+            for (const auto& blk : sys.blocks) {
+                if (blk.is_inport()) df.signal_types[blk.sid + "#out:1"] = declared_type(blk).value_or("float");
+            }
+
+            auto common = [](const std::vector<std::string>& types) -> std::string {
+                if (types.empty()) return "float";
+                if (std::ranges::all_of(types, [&](const auto& t) { return t == types.front(); })) return types.front();
+                return std::ranges::find(types, "double") != types.end() ? "double" : "float";
+            };
+
+            // State blocks take the type of their input, which is only known after a first pass
+            for (int pass = 0; pass < 3; ++pass) {
+                bool changed = false;
+                for (const auto& sid : df.sorted_sids) {
+                    auto* blk = sys.find_block_by_sid(sid);
+                    if (!blk || blk->is_inport() || blk->is_outport()) continue;
+
+                    if (auto it = component_map.find(sid); it != component_map.end()) {
+                        const auto& ports = it->second->outports;
+                        for (std::size_t i = 0; i < ports.size(); ++i) {
+                            df.signal_types[sid + "#out:" + std::to_string(i + 1)] = ports[i].second;
+                        }
+                        continue;
+                    }
+                    if (blk->is_subsystem()) continue;
+
+                    auto in = df.input_types(sid);
+                    std::string type;
+                    if (auto declared = declared_type(*blk)) {
+                        type = *declared;
+                    } else if (blk->type == "RelationalOperator" || blk->type == "Logic") {
+                        type = "bool";
+                    } else if (blk->type == "Constant") {
+                        auto value = blk->param("Value").value_or("");
+                        type = (value == "true" || value == "false") ? "bool" : "float";
+                    } else if (blk->type == "UnitDelay" || blk->type == "Memory" || blk->type == "Delay") {
+                        type = in.empty() ? "float" : in.front();
+                    } else if (blk->type == "Switch") {
+                        std::vector<std::string> data;
+                        if (!in.empty()) data.push_back(in[0]);
+                        if (in.size() > 2) data.push_back(in[2]);
+                        type = common(data);
+                    } else if (blk->type == "MinMax") {
+                        type = common(in);
+                    } else {
+                        type = std::ranges::find(in, "double") != in.end() ? "double" : "float";
+                    }
+
+                    auto key = sid + "#out:1";
+                    if (df.signal_types[key] != type) {
+                        df.signal_types[key] = type;
+                        changed = true;
+                    }
+                }
+                if (!changed) break;
+            }
+        }
+
+        // Copy propagated types onto the output ports and the state variables of a system
+        static void apply_signal_types(const dataflow& df, const std::vector<mdl::block>& outports,
+                                       std::vector<std::pair<std::string, std::string>>& port_types,
+                                       std::map<std::string, std::string>& state_types) {
+            for (std::size_t i = 0; i < outports.size() && i < port_types.size(); ++i) {
+                if (auto v = outports[i].param("OutDataTypeStr"); v && cpp_data_type(*v)) {
+                    port_types[i].second = *cpp_data_type(*v);
+                } else if (auto it = df.input_keys.find(outports[i].sid); it != df.input_keys.end() && !it->second.empty()) {
+                    port_types[i].second = df.type_of(it->second.front());
+                }
+            }
+            for (const auto& [sid, var] : df.state_var_map) {
+                if (var.ends_with(']')) continue;  // banked, always float
+                auto type = df.type_of(sid + "#out:1");
+                if (type != "float") state_types[var.substr(var.find('.') + 1)] = type;
+            }
+        }
+
+        // Operand text that needs no parentheses: a name, a literal or one call
+        [[nodiscard]] static auto is_atomic(const std::string& expr) -> bool {
+            auto open = expr.find('(');
+            auto head = expr.substr(0, open);
+            bool plain = !head.empty() && std::ranges::all_of(head, [](char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == ':';
+            });
+            if (open == std::string::npos || !plain || expr.back() != ')') return plain;
+
+            int level = 0;
+            for (std::size_t i = open; i < expr.size(); ++i) {
+                if (expr[i] == '(') ++level;
+                else if (expr[i] == ')' && --level == 0) return i + 1 == expr.size();
             }
+            return false;
+        }
 
-            // Build state block set for this system
-            std::set<std::string> state_sids;
-            std::map<std::string, std::string> state_var_map;  // SID -> state variable name
+        [[nodiscard]] static auto operand(const std::string& expr) -> std::string {
+            return is_atomic(expr) ? expr : "(" + expr + ")";
+        }
 
-            for (const auto& blk : sys.blocks) {
-                if (blk.type == "UnitDelay" || blk.type == "Integrator" ||
-                    blk.type == "DiscreteIntegrator" || blk.type == "Memory") {
-                    state_sids.insert(blk.sid);
-                    auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
-                    state_var_map[blk.sid] = "state." + var_prefix + "_state";
+        // Signals that --fuse folds into their only reader, as signal key -> {reader SID, input port}.
+        // Fan-out, named (probed) lines, bus leaves, state updates and linear subsystems keep their locals,
+        // as do readers that take inputs other than as expressions (outputs, subsystems, buses).
+        [[nodiscard]] auto fusable_signals(const mdl::system& sys, const dataflow& df,
+                                           const std::vector<linear_region>& linear) const
+            -> std::map<std::string, std::pair<std::string, std::size_t>> {
+            std::set<std::string> kept;
+            for (const auto& conn : sys.connections) {
+                if (!conn.name.empty()) kept.insert(conn.source);
+            }
+            for (const auto& [bus, leaves] : df.buses) {
+                kept.insert(bus);
+                for (const auto& [path, leaf] : leaves) kept.insert(df.resolve(leaf));
+            }
+            auto in_region = [&](const std::string& sid) {
+                return std::ranges::any_of(linear, [&](const auto& region) { return region.blocks.contains(sid); });
+            };
+
+            std::map<std::string, std::vector<std::pair<std::string, std::size_t>>> readers;
+            for (const auto& [sid, keys] : df.input_keys) {
+                if (df.removed.contains(sid)) continue;
+                for (std::size_t i = 0; i < keys.size(); ++i) {
+                    if (!keys[i].empty()) readers[df.resolve(keys[i])].emplace_back(sid, i);
                 }
             }
 
-            // Assign output variable names for all blocks
-            for (const auto& blk : sys.blocks) {
-                if (blk.is_inport() || blk.is_outport()) continue;
+            std::map<std::string, std::pair<std::string, std::size_t>> fusable;
+            for (const auto& [key, uses] : readers) {
+                if (uses.size() != 1 || kept.contains(key) || df.constants.contains(key)) continue;
+
+                auto src = signal_block_sid(key);
+                auto* producer = sys.find_block_by_sid(src);
+                auto* reader = sys.find_block_by_sid(uses.front().first);
+                if (!producer || !reader || !is_stateless(*producer) || producer->port_out != 1) continue;
+                if (df.removed.contains(src) || in_region(src) || in_region(reader->sid)) continue;
+                if (reader->is_outport() || reader->is_subsystem() || reader->type == "BusCreator" ||
+                    reader->type == "BusSelector") continue;
+                if (options_.typed && (df.type_of(key) != "float" ||
+                                       std::ranges::any_of(df.input_types(src), [](const auto& t) { return t != "float"; }))) continue;
+                fusable[key] = uses.front();
+            }
+            return fusable;
+        }
 
-                auto var_prefix = prefix.empty() ? sanitize_name(blk.name) : prefix + "_" + sanitize_name(blk.name);
+        // Expression of a block emitted as "// comment" plus one "<decl> <out> = <expr>;" line.
+        // Expressions reading state are not moved: a state update may sit between producer and reader.
+        [[nodiscard]] auto fused_expression(const std::string& block_code, const std::string& out_var) const
+            -> std::optional<std::string> {
+            std::vector<std::string> lines;
+            std::istringstream stream(block_code);
+            for (std::string text; std::getline(stream, text);) lines.push_back(text);
+            if (lines.size() != 2 || !lines[0].starts_with(indent_ + "// ")) return std::nullopt;
+
+            const auto& line = lines[1];
+            auto assign = " " + out_var + " = ";
+            auto pos = line.find(assign);
+            if (!line.starts_with(indent_) || pos == std::string::npos || !line.ends_with(";")) return std::nullopt;
+            if (line.substr(indent_.size(), pos - indent_.size()).find(' ') != std::string::npos) return std::nullopt;
+
+            auto expr = line.substr(pos + assign.size(), line.size() - pos - assign.size() - 1);
+            if (expr.find("state.") != std::string::npos || expr.find("//") != std::string::npos) return std::nullopt;
+            return expr;
+        }
 
-                int num_outputs = blk.port_out;
+        // Pure blocks: output is a function of the current inputs and parameters only
+        [[nodiscard]] static auto is_stateless(const mdl::block& blk) -> bool {
+            static const std::set<std::string> stateless_types = {
+                "Gain", "Sum", "Product", "Saturate", "MinMax", "Abs", "Constant",
+                "RelationalOperator", "Logic", "Switch", "Trigonometry", "Math"
+            };
+            return stateless_types.contains(blk.type);
+        }
 
-                // For subsystems, pre-map outputs to the names that will be created during inlining/call
-                if (blk.is_subsystem()) {
-                    for (int i = 1; i <= num_outputs; ++i) {
-                        auto key = blk.sid + "#out:" + std::to_string(i);
-                        signal_map[key] = var_prefix + "_out" + std::to_string(i);
+        // Switch semantics shared by folding and code generation: condition on input 2
+        [[nodiscard]] static auto switch_condition(const mdl::block& blk, double u2, double threshold) -> bool {
+            auto criteria = blk.param("Criteria").value_or("u2 >= Threshold");
+            if (criteria.find(">=") != std::string::npos) return u2 >= threshold;
+            if (criteria.find(">") != std::string::npos) return u2 > threshold;
+            if (criteria.find("!=") != std::string::npos || criteria.find("~=") != std::string::npos) return u2 != threshold;
+            return u2 != 0.0;
+        }
+
+        // Evaluate a stateless block whose inputs are all known (mirrors generate_block_code)
+        [[nodiscard]] auto fold_block(const mdl::block& blk, const std::vector<std::optional<double>>& inputs) const
+            -> std::optional<double> {
+            for (const auto& v : inputs) {
+                if (!v) return std::nullopt;
+            }
+            auto in = [&](std::size_t idx) { return idx < inputs.size() ? *inputs[idx] : 0.0; };
+            auto param = [&](const std::string& name, double def) -> std::optional<double> {
+                if (auto v = blk.param(name)) return evaluate_expression(*v, options_.calibration);
+                return def;
+            };
+
+            if (blk.type == "Constant") return param("Value", 0.0);
+            if (blk.type == "Gain") {
+                auto gain = param("Gain", 1.0);
+                if (!gain) return std::nullopt;
+                return in(0) * *gain;
+            }
+            if (blk.type == "Sum") {
+                double sum = 0.0;
+                std::size_t idx = 0;
+                for (char c : blk.param("Inputs").value_or("++")) {
+                    if (c == '+') sum += in(idx++);
+                    else if (c == '-') sum -= in(idx++);
+                }
+                return sum;
+            }
+            if (blk.type == "Product") {
+                double prod = 1.0;
+                std::size_t idx = 0;
+                for (char c : blk.param("Inputs").value_or("**")) {
+                    if (c == '*') prod = idx == 0 ? in(idx++) : prod * in(idx++);
+                    else if (c == '/') prod = idx == 0 ? in(idx++) : prod / in(idx++);
+                }
+                if (idx == 0) prod = in(0) * in(1);
+                return prod;
+            }
+            if (blk.type == "Saturate") {
+                auto upper = param("UpperLimit", 1.0);
+                auto lower = param("LowerLimit", -1.0);
+                if (!upper || !lower) return std::nullopt;
+                return std::clamp(in(0), *lower, *upper);
+            }
+            if (blk.type == "MinMax") {
+                auto func = blk.param("Function").value_or("min");
+                return (func == "max" || func == "Max") ? std::max(in(0), in(1)) : std::min(in(0), in(1));
+            }
+            if (blk.type == "Abs") return std::abs(in(0));
+            if (blk.type == "RelationalOperator") {
+                auto op = blk.param("Operator").value_or("==");
+                bool r = op == "<" ? in(0) < in(1) : op == "<=" ? in(0) <= in(1) :
+                         op == ">" ? in(0) > in(1) : op == ">=" ? in(0) >= in(1) :
+                         (op == "~=" || op == "!=") ? in(0) != in(1) : in(0) == in(1);
+                return r ? 1.0 : 0.0;
+            }
+            if (blk.type == "Logic") {
+                auto op = blk.param("Operator").value_or("AND");
+                bool a = in(0) != 0.0, b = in(1) != 0.0;
+                if (op == "NOT") return a ? 0.0 : 1.0;
+                if (op == "OR") return (a || b) ? 1.0 : 0.0;
+                if (op == "XOR") return (a != b) ? 1.0 : 0.0;
+                return (a && b) ? 1.0 : 0.0;
+            }
+            if (blk.type == "Switch") {
+                auto threshold = param("Threshold", 0.0);
+                if (!threshold) return std::nullopt;
+                return switch_condition(blk, in(1), *threshold) ? in(0) : in(2);
+            }
+            if (blk.type == "Trigonometry") {
+                auto func = blk.param("Operator").value_or("sin");
+                if (func == "sin") return std::sin(in(0));
+                if (func == "cos") return std::cos(in(0));
+                if (func == "tan") return std::tan(in(0));
+                return std::nullopt;
+            }
+            if (blk.type == "Math") {
+                auto func = blk.param("Operator").value_or("sqrt");
+                if (func == "sqrt") return std::sqrt(in(0));
+                if (func == "exp") return std::exp(in(0));
+                if (func == "log") return std::log(in(0));
+                if (func == "log10") return std::log10(in(0));
+                if (func == "square") return in(0) * in(0);
+                if (func == "pow") return std::pow(in(0), in(1));
+                return std::nullopt;
+            }
+            return std::nullopt;
+        }
+
+        // Bind calibrated config values: fold constant signals through stateless blocks, turn
+        // Switches whose condition is constant into wires, and drop blocks that nothing live reads
+        void specialize_dataflow(const mdl::system& sys, dataflow& df, std::map<std::string, std::string>& signal_map) {
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || !is_stateless(*blk) || blk->port_out != 1) continue;
+
+                const auto& keys = df.input_keys[sid];
+                std::vector<std::optional<double>> values;
+                for (const auto& key : keys) {
+                    if (key.empty()) {
+                        values.emplace_back(0.0);  // unconnected ports read 0.0f
+                    } else if (auto it = df.constants.find(df.resolve(key)); it != df.constants.end()) {
+                        values.emplace_back(it->second);
+                    } else {
+                        values.emplace_back(std::nullopt);
                     }
+                }
+
+                auto out_key = sid + "#out:1";
+                if (auto v = fold_block(*blk, values)) {
+                    df.constants[out_key] = *v;
+                    df.removed.insert(sid);
                     continue;
                 }
 
-                for (int i = 1; i <= num_outputs; ++i) {
-                    auto key = blk.sid + "#out:" + std::to_string(i);
+                // A Switch with a constant condition forwards the selected data input
+                if (blk->type == "Switch" && values.size() > 1 && values[1]) {
+                    auto threshold = blk->param("Threshold")
+                        ? evaluate_expression(*blk->param("Threshold"), options_.calibration)
+                        : std::optional<double>(0.0);
+                    if (!threshold) continue;
 
-                    // State blocks output from state variable
-                    if (state_sids.contains(blk.sid)) {
-                        signal_map[key] = state_var_map[blk.sid];
+                    std::size_t selected = switch_condition(*blk, *values[1], *threshold) ? 0 : 2;
+                    if (selected < keys.size() && !keys[selected].empty()) {
+                        df.forwards[out_key] = keys[selected];
                     } else {
-                        auto var = var_prefix;
-                        if (num_outputs > 1) var += "_" + std::to_string(i);
-                        signal_map[key] = var;
+                        df.constants[out_key] = 0.0;
                     }
+                    df.removed.insert(sid);
                 }
             }
+            prune_dataflow(sys, df, signal_map);
+        }
 
-            // Build dependencies and input mappings
-            std::map<std::string, std::set<std::string>> dependencies;
-            std::map<std::string, std::vector<std::string>> block_inputs;
-
+        // Drop the blocks that nothing live reads once signals were folded or forwarded, and point
+        // the remaining readers at the folded values and forwarded signals
+        void prune_dataflow(const mdl::system& sys, dataflow& df, std::map<std::string, std::string>& signal_map) {
+            // Liveness from the outports and every block with effects beyond its output
+            std::set<std::string> live;
+            std::vector<std::string> work;
             for (const auto& blk : sys.blocks) {
-                if (blk.is_inport()) continue;
-                dependencies[blk.sid] = {};
-                block_inputs[blk.sid] = {};
+                if (blk.is_inport() || df.removed.contains(blk.sid)) continue;
+                if (blk.is_outport() || !is_stateless(blk)) {
+                    live.insert(blk.sid);
+                    work.push_back(blk.sid);
+                }
+            }
+            while (!work.empty()) {
+                auto sid = work.back();
+                work.pop_back();
+                for (const auto& key : df.input_keys[sid]) {
+                    if (key.empty()) continue;
+                    auto resolved = df.resolve(key);
+                    if (df.constants.contains(resolved)) continue;
+                    auto src = signal_block_sid(resolved);
+                    if (!df.removed.contains(src) && live.insert(src).second) work.push_back(src);
+                }
+            }
+            for (const auto& blk : sys.blocks) {
+                if (is_stateless(blk) && !live.contains(blk.sid)) df.removed.insert(blk.sid);
             }
 
-            for (const auto& conn : sys.connections) {
-                auto src = mdl::endpoint::parse(conn.source);
-                if (!src) continue;
+            // Rewrite signal names and block inputs to the folded values and forwarded signals
+            for (const auto& [key, value] : df.constants) {
+                signal_map[key] = format_constant(value);
+            }
+            for (const auto& [key, target] : df.forwards) {
+                signal_map[key] = signal_map[df.resolve(target)];
+            }
+            for (auto& [sid, keys] : df.input_keys) {
+                auto& inputs = df.block_inputs[sid];
+                for (std::size_t i = 0; i < keys.size() && i < inputs.size(); ++i) {
+                    if (keys[i].empty()) continue;
+                    if (df.constants.contains(keys[i]) || df.forwards.contains(keys[i])) {
+                        inputs[i] = signal_map[keys[i]];
+                    }
+                }
+            }
+        }
 
-                auto src_key = src->block_sid + "#out:" + std::to_string(src->port_index);
-                auto src_var = signal_map.count(src_key) ? signal_map[src_key] : "0.0f /* unknown */";
+        // Interval of a block parameter: the float the code embeds for a literal or calibrated value,
+        // else the --ranges entry of the config name it reads, possibly negated
+        [[nodiscard]] auto parameter_range(const mdl::block& blk, const std::string& name, double def) const -> interval {
+            auto text = blk.param(name);
+            if (!text) return interval::point(static_cast<float>(def));
+            if (auto v = evaluate_expression(*text, options_.calibration)) return interval::point(static_cast<float>(*v));
+
+            auto config = *text;
+            std::erase_if(config, [](char c) { return std::isspace(static_cast<unsigned char>(c)); });
+            bool negated = config.starts_with('-');
+            if (negated) config.erase(0, 1);
+            auto it = options_.ranges.find(config);
+            if (it == options_.ranges.end()) return {};
+            return negated ? -it->second : it->second;
+        }
 
-                auto add_connection = [&](const std::string& dst_str) {
-                    auto dst = mdl::endpoint::parse(dst_str);
-                    if (!dst) return;
+        // Outcome of a comparison that holds, or fails, for every pair of values in the ranges
+        [[nodiscard]] static auto decide_relation(std::string_view op, const interval& a, const interval& b)
+            -> std::optional<bool> {
+            if (op == "<") {
+                if (a.hi < b.lo) return true;
+                if (a.lo >= b.hi) return false;
+            } else if (op == "<=") {
+                if (a.hi <= b.lo) return true;
+                if (a.lo > b.hi) return false;
+            } else if (op == ">") {
+                return decide_relation("<", b, a);
+            } else if (op == ">=") {
+                return decide_relation("<=", b, a);
+            } else if (op == "~=" || op == "!=") {
+                if (auto equal = decide_relation("==", a, b)) return !*equal;
+            } else {
+                if (a.is_point() && a == b) return true;
+                if (a.hi < b.lo || b.hi < a.lo) return false;
+            }
+            return std::nullopt;
+        }
 
-                    auto& inputs = block_inputs[dst->block_sid];
-                    if (inputs.size() < static_cast<size_t>(dst->port_index)) {
-                        inputs.resize(dst->port_index);
-                    }
-                    inputs[dst->port_index - 1] = src_var;
+        // Switch condition the ranges decide (mirrors switch_condition)
+        [[nodiscard]] static auto decide_switch(const mdl::block& blk, const interval& u2, const interval& threshold)
+            -> std::optional<bool> {
+            auto criteria = blk.param("Criteria").value_or("u2 >= Threshold");
+            if (criteria.find(">=") != std::string::npos) return decide_relation(">=", u2, threshold);
+            if (criteria.find(">") != std::string::npos) return decide_relation(">", u2, threshold);
+            if (criteria.find("!=") != std::string::npos || criteria.find("~=") != std::string::npos) {
+                return decide_relation("~=", u2, threshold);
+            }
+            return decide_relation("~=", u2, interval::point(0.0));
+        }
 
-                    if (dependencies.count(dst->block_sid)) {
-                        auto* src_blk = sys.find_block_by_sid(src->block_sid);
-                        bool is_inport = src_blk && src_blk->is_inport();
-                        bool is_state = state_sids.contains(src->block_sid);
+        // Interval of a stateless block's output given the intervals of its inputs (mirrors fold_block)
+        [[nodiscard]] auto block_range(const mdl::block& blk, const std::vector<interval>& inputs) const -> interval {
+            auto in = [&](std::size_t idx) { return idx < inputs.size() ? inputs[idx] : interval::point(0.0); };
 
-                        if (!is_inport && !is_state) {
-                            dependencies[dst->block_sid].insert(src->block_sid);
-                        }
-                    }
-                };
+            if (std::ranges::all_of(inputs, &interval::is_point)) {
+                std::vector<std::optional<double>> values;
+                for (const auto& range : inputs) values.emplace_back(range.lo);
+                if (auto v = fold_block(blk, values)) return interval::point(static_cast<float>(*v));
+            }
 
-                if (!conn.destination.empty()) {
-                    add_connection(conn.destination);
+            auto range = [&]() -> interval {
+                if (blk.type == "Constant") return parameter_range(blk, "Value", 0.0);
+                if (blk.type == "Gain") return (in(0) * parameter_range(blk, "Gain", 1.0)).rounded();
+                if (blk.type == "Sum") {
+                    auto spec = blk.param("Inputs").value_or("++");
+                    if (spec.find_first_of("+-") == std::string::npos) return {};
+                    auto sum = interval::point(0.0);
+                    std::size_t idx = 0;
+                    for (char c : spec) {
+                        if (c == '+') sum = (sum + in(idx++)).rounded();
+                        else if (c == '-') sum = (sum + -in(idx++)).rounded();
+                    }
+                    return sum;
                 }
-                for (const auto& branch : conn.branches) {
-                    add_connection(branch.destination);
+                if (blk.type == "Product") {
+                    auto prod = interval::point(1.0);
+                    std::size_t idx = 0;
+                    for (char c : blk.param("Inputs").value_or("**")) {
+                        if (c == '*') prod = idx == 0 ? in(idx++) : (prod * in(idx++)).rounded();
+                        else if (c == '/') prod = idx == 0 ? in(idx++) : (prod / in(idx++)).rounded();
+                    }
+                    if (idx == 0) prod = (in(0) * in(1)).rounded();
+                    return prod;
+                }
+                if (blk.type == "Saturate") {
+                    auto upper = parameter_range(blk, "UpperLimit", 1.0);
+                    auto lower = parameter_range(blk, "LowerLimit", -1.0);
+                    return {std::min(std::max(in(0).lo, lower.lo), upper.lo), std::min(std::max(in(0).hi, lower.hi), upper.hi)};
+                }
+                if (blk.type == "MinMax") {
+                    auto func = blk.param("Function").value_or("min");
+                    if (func == "max" || func == "Max") return {std::max(in(0).lo, in(1).lo), std::max(in(0).hi, in(1).hi)};
+                    return {std::min(in(0).lo, in(1).lo), std::min(in(0).hi, in(1).hi)};
+                }
+                if (blk.type == "Abs") {
+                    auto x = in(0);
+                    if (x.lo >= 0.0) return x;
+                    if (x.hi <= 0.0) return -x;
+                    return {0.0, std::max(-x.lo, x.hi)};
+                }
+                if (blk.type == "RelationalOperator") {
+                    if (auto r = decide_relation(blk.param("Operator").value_or("=="), in(0), in(1))) return interval::point(*r);
+                    return {0.0, 1.0};
+                }
+                if (blk.type == "Logic") return {0.0, 1.0};
+                if (blk.type == "Switch") {
+                    if (auto c = decide_switch(blk, in(1), parameter_range(blk, "Threshold", 0.0))) return *c ? in(0) : in(2);
+                    return in(0).hull(in(2));
+                }
+                if (blk.type == "Trigonometry") {
+                    auto func = blk.param("Operator").value_or("sin");
+                    if (func == "sin" || func == "cos") return {-1.0, 1.0};
+                }
+                if (blk.type == "Math") {
+                    auto func = blk.param("Operator").value_or("sqrt");
+                    auto x = in(0);
+                    if (func == "sqrt" && x.lo >= 0.0) return interval{std::sqrt(x.lo), std::sqrt(x.hi)}.rounded();
+                    if (func == "exp") return interval{std::exp(x.lo), std::exp(x.hi)}.rounded();
+                    if (func == "square") {
+                        auto a = x.lo >= 0.0 ? x : x.hi <= 0.0 ? -x : interval{0.0, std::max(-x.lo, x.hi)};
+                        return (a * a).rounded();
+                    }
+                }
+                return {};
+            }();
+
+            // Integer outputs truncate toward zero
+            if (options_.typed) {
+                if (auto type = blk.param("OutDataTypeStr").and_then(cpp_data_type);
+                    type && type->starts_with("std::") && range.bounded()) {
+                    return {std::min(0.0, std::floor(range.lo)), std::max(0.0, std::ceil(range.hi))};
                 }
             }
+            return range;
+        }
 
-            // Topological sort
-            std::map<std::string, int> in_degree;
-            for (const auto& [sid, deps] : dependencies) {
-                if (!in_degree.count(sid)) in_degree[sid] = 0;
-                for (const auto& dep : deps) {
-                    if (auto* blk = sys.find_block_by_sid(dep); blk && !blk->is_inport()) {
-                        in_degree[sid]++;
+        // Interval analysis of one system. Inports are seeded from the --ranges entries of their names
+        // (top level only) and their OutMin/OutMax, parameters from the calibration or the entries of
+        // the config names they read. Ranges flow through the stateless blocks in execution order;
+        // UnitDelay, Memory and Delay outputs start at their zero state and widen with what they are
+        // fed until nothing changes, jumping to a power of two and then to infinity if they keep
+        // growing. Every other state is unbounded. Stateless blocks left with a single value become
+        // constants, decided Switches become wires, and a Saturate is dropped when the signal never
+        // reaches its limits or loses the limit the signal cannot reach.
+        void analyze_ranges(const mdl::system& sys, dataflow& df, std::map<std::string, std::string>& signal_map,
+                            const std::string& prefix) {
+            constexpr double inf = std::numeric_limits<double>::infinity();
+
+            auto range_of = [&](const std::string& key) -> interval {
+                if (key.empty()) return interval::point(0.0);  // unconnected ports read 0.0f
+                auto resolved = df.resolve(key);
+                if (auto it = df.constants.find(resolved); it != df.constants.end()) {
+                    return interval::point(static_cast<float>(it->second));
+                }
+                if (auto it = df.ranges.find(resolved); it != df.ranges.end()) return it->second;
+                return {};
+            };
+            auto input_ranges = [&](const std::string& sid) {
+                std::vector<interval> ranges;
+                for (const auto& key : df.input_keys[sid]) ranges.push_back(range_of(key));
+                return ranges;
+            };
+
+            std::vector<std::string> delays;
+            for (const auto& blk : sys.blocks) {
+                auto key = blk.sid + "#out:1";
+                if (blk.is_inport()) {
+                    interval seed;
+                    if (prefix.empty()) {
+                        if (auto it = options_.ranges.find(blk.name); it != options_.ranges.end()) seed = it->second;
+                        else if (auto it = options_.ranges.find(sanitize_name(blk.name)); it != options_.ranges.end()) seed = it->second;
                     }
+                    df.ranges[key] = seed.intersect({parameter_range(blk, "OutMin", -inf).lo, parameter_range(blk, "OutMax", inf).hi});
+                } else if (df.state_sids.contains(blk.sid) &&
+                           (blk.type == "UnitDelay" || blk.type == "Memory" || blk.type == "Delay")) {
+                    df.ranges[key] = interval::point(0.0);
+                    delays.push_back(blk.sid);
                 }
             }
 
-            std::queue<std::string> ready;
-            for (const auto& [sid, deg] : in_degree) {
-                if (deg == 0) ready.push(sid);
+            for (int round = 1;; ++round) {
+                for (const auto& sid : df.sorted_sids) {
+                    auto* blk = sys.find_block_by_sid(sid);
+                    if (!blk || !is_stateless(*blk) || blk->port_out != 1 || df.removed.contains(sid)) continue;
+                    df.ranges[sid + "#out:1"] = block_range(*blk, input_ranges(sid));
+                }
+
+                bool stable = true;
+                for (const auto& sid : delays) {
+                    auto& current = df.ranges[sid + "#out:1"];
+                    auto inputs = input_ranges(sid);
+                    auto next = current.hull(inputs.empty() ? interval::point(0.0) : inputs.front());
+                    if (next == current) continue;
+
+                    stable = false;
+                    if (round >= 16) {
+                        if (next.lo < current.lo) next.lo = -inf;
+                        if (next.hi > current.hi) next.hi = inf;
+                    } else if (round >= 8) {
+                        if (next.lo < current.lo) next.lo = next.lo >= 0.0 ? 0.0 : -std::exp2(std::ceil(std::log2(-next.lo)) + 1.0);
+                        if (next.hi > current.hi) next.hi = next.hi <= 0.0 ? 0.0 : std::exp2(std::ceil(std::log2(next.hi)) + 1.0);
+                    }
+                    current = next;
+                }
+                if (stable) break;
             }
 
-            std::vector<std::string> sorted_sids;
-            while (!ready.empty()) {
-                auto sid = ready.front();
-                ready.pop();
-                sorted_sids.push_back(sid);
+            for (const auto& sid : df.sorted_sids) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk || !is_stateless(*blk) || blk->port_out != 1 || df.removed.contains(sid)) continue;
+
+                const auto& keys = df.input_keys[sid];
+                auto inputs = input_ranges(sid);
+                auto out_key = sid + "#out:1";
+                if (auto out = df.ranges[out_key]; out.is_point()) {
+                    if (blk->type == "RelationalOperator") ++df.comparisons_folded;
+                    df.constants[out_key] = out.lo;
+                    df.removed.insert(sid);
+                    continue;
+                }
 
-                for (auto& [other_sid, deps] : dependencies) {
-                    if (deps.contains(sid)) {
-                        deps.erase(sid);
-                        in_degree[other_sid]--;
-                        if (in_degree[other_sid] == 0) {
-                            ready.push(other_sid);
-                        }
+                if (blk->type == "Switch" && inputs.size() > 1) {
+                    auto condition = decide_switch(*blk, inputs[1], parameter_range(*blk, "Threshold", 0.0));
+                    if (!condition) continue;
+
+                    std::size_t selected = *condition ? 0 : 2;
+                    if (selected < keys.size() && !keys[selected].empty()) {
+                        df.forwards[out_key] = keys[selected];
+                    } else {
+                        df.constants[out_key] = 0.0;
+                    }
+                    df.removed.insert(sid);
+                    ++df.comparisons_folded;
+                } else if (blk->type == "Saturate" && !keys.empty() && !keys[0].empty()) {
+                    auto upper = parameter_range(*blk, "UpperLimit", 1.0);
+                    auto lower = parameter_range(*blk, "LowerLimit", -1.0);
+                    bool reaches_upper = inputs[0].hi > upper.lo;
+                    bool reaches_lower = inputs[0].lo < lower.hi;
+                    if (!reaches_upper && !reaches_lower) {
+                        df.forwards[out_key] = keys[0];
+                        df.removed.insert(sid);
+                        ++df.clamps_removed;
+                    } else if ((!reaches_upper && upper.lo != inf) || (!reaches_lower && lower.hi != -inf)) {
+                        auto narrowed = *blk;
+                        if (reaches_upper) narrowed.parameters["LowerLimit"] = "-inf";
+                        else narrowed.parameters["UpperLimit"] = "inf";
+                        df.narrowed[sid] = std::move(narrowed);
+                        ++df.clamps_narrowed;
                     }
                 }
             }
+            prune_dataflow(sys, df, signal_map);
+        }
 
-            // Generate code for each block
-            for (const auto& sid : sorted_sids) {
+        // Note the ranges of the signals one system keeps, for the report of the function it is part of
+        void record_ranges(const mdl::system& sys, const dataflow& df, const std::map<std::string, std::string>& signal_map) {
+            for (const auto& [key, range] : df.ranges) {
+                auto sid = signal_block_sid(key);
                 auto* blk = sys.find_block_by_sid(sid);
-                if (!blk || blk->is_inport() || blk->is_outport()) continue;
+                auto name = signal_map.find(key);
+                if (!blk || blk->is_inport() || df.removed.contains(sid) || name == signal_map.end()) continue;
+                ranges_.signals[name->second] = range;
+            }
+            ranges_.clamps_removed += df.clamps_removed;
+            ranges_.clamps_narrowed += df.clamps_narrowed;
+            ranges_.comparisons_folded += df.comparisons_folded;
+        }
 
-                auto& inputs = block_inputs[sid];
-                auto var_prefix = prefix.empty() ? sanitize_name(blk->name) : prefix + "_" + sanitize_name(blk->name);
-                auto out_var = signal_map[sid + "#out:1"];
-                auto state_var = state_var_map.count(sid) ? state_var_map[sid] : "";
+        // Calibrated names are bound into the code and leave the config struct, as do
+        // parameters whose only readers were folded or removed
+        void drop_calibrated(std::set<std::string>& config, std::string_view code) const {
+            if (options_.calibration.empty() && !options_.range_analysis) return;
+
+            std::erase_if(config, [&](const std::string& name) {
+                if (options_.calibration.contains(name)) return true;
+                auto ref = "cfg." + name;
+                for (auto pos = code.find(ref); pos != std::string_view::npos; pos = code.find(ref, pos + 1)) {
+                    auto end = pos + ref.size();
+                    if (end == code.size() || (!std::isalnum(static_cast<unsigned char>(code[end])) && code[end] != '_')) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+        }
+
+        // Assign every outport from the signal that drives it
+        void generate_output_assignments(
+            const mdl::system& sys,
+            const std::vector<mdl::block>& outports,
+            std::map<std::string, std::string>& signal_map,
+            std::ostringstream& code,
+            const dataflow& df = {})
+        {
+            for (const auto& outp : outports) {
+                // Find what connects to this outport
+                for (const auto& conn : sys.connections) {
+                    auto check_dst = [&](const std::string& dst_str) {
+                        if (auto dst = mdl::endpoint::parse(dst_str)) {
+                            if (dst->block_sid == outp.sid) {
+                                if (auto src = mdl::endpoint::parse(conn.source)) {
+                                    auto src_key = src->block_sid + "#out:" + std::to_string(src->port_index);
+                                    if (auto bus = df.buses.find(df.resolve(src_key)); bus != df.buses.end()) {
+                                        // Bus outputs are written field by field
+                                        for (const auto& [path, leaf] : bus->second) {
+                                            code << indent_ << "out." << sanitize_name(outp.name) << "." << path
+                                                 << " = " << signal_map[leaf] << ";\n";
+                                        }
+                                    } else if (signal_map.count(src_key)) {
+                                        code << indent_ << "out." << sanitize_name(outp.name)
+                                             << " = " << signal_map[src_key] << ";\n";
+                                    }
+                                }
+                            }
+                        }
+                    };
 
-                generate_block_code(*blk, inputs, out_var, var_prefix, state_var, signal_map, code, depth, component_map);
+                    check_dst(conn.destination);
+                    for (const auto& br : conn.branches) {
+                        check_dst(br.destination);
+                    }
+                }
             }
         }
 
@@ -774,7 +4505,8 @@ namespace oc::codegen {
             std::map<std::string, std::string>& signal_map,
             std::ostringstream& code,
             int depth,
-            const std::map<std::string, const generated_component*>& component_map = {})
+            const std::map<std::string, const generated_component*>& component_map = {},
+            const signal_typing& types = {})
         {
             auto get_input = [&](int idx) -> std::string {
                 if (idx < static_cast<int>(inputs.size()) && !inputs[idx].empty()) {
@@ -783,9 +4515,25 @@ namespace oc::codegen {
                 return "0.0f /* missing input " + std::to_string(idx + 1) + " */";
             };
 
+            // With propagated types, outputs are declared with their type and operands are
+            // converted where a template (std::min, std::clamp) needs matching arguments
+            bool typed = !types.output.empty();
+            auto decl = typed ? types.output : std::string("auto");
+            auto input_type = [&](int idx) -> std::string {
+                return idx < static_cast<int>(types.inputs.size()) ? types.inputs[idx] : "float";
+            };
+            auto input_as = [&](int idx, const std::string& type) -> std::string {
+                if (input_type(idx) == type) return get_input(idx);
+                return "static_cast<" + type + ">(" + get_input(idx) + ")";
+            };
+            auto input_bool = [&](int idx) -> std::string {
+                if (input_type(idx) == "bool") return get_input(idx);
+                return "(" + get_input(idx) + " != 0.0f)";
+            };
+
             auto get_param = [&](const std::string& name, const std::string& def = "0.0f") -> std::string {
                 if (auto v = blk.param(name)) {
-                    return format_param_value(*v);
+                    return param_expression(*v);
                 }
                 return def;
             };
@@ -793,7 +4541,7 @@ namespace oc::codegen {
             // Handle SubSystem - use component call if available, otherwise inline
             if (blk.type == "SubSystem") {
                 if (auto it = component_map.find(blk.sid); it != component_map.end()) {
-                    generate_component_call(*it->second, blk, inputs, var_prefix, signal_map, code);
+                    generate_component_call(*it->second, blk, inputs, var_prefix, signal_map, code, types);
                     return;
                 }
                 // Fallback to inline (legacy path)
@@ -812,11 +4560,28 @@ namespace oc::codegen {
 
             if (blk.type == "Gain") {
                 auto gain = get_param("Gain", "1.0f");
-                code << indent_ << "auto " << out_var << " = " << get_input(0) << " * " << gain << ";\n";
+                code << indent_ << decl << " " << out_var << " = " << get_input(0) << " * " << gain << ";\n";
             }
             else if (blk.type == "Sum") {
                 auto inputs_spec = blk.param("Inputs").value_or("++");
-                code << indent_ << "auto " << out_var << " = ";
+
+                // Two terms, one a fused product: a single rounding with std::fma
+                std::vector<std::pair<char, int>> terms;
+                for (char c : inputs_spec) {
+                    if (c == '+' || c == '-') terms.emplace_back(c, static_cast<int>(terms.size()));
+                }
+                if (terms.size() == 2) {
+                    for (auto [product, addend] : {std::pair{terms[1], terms[0]}, std::pair{terms[0], terms[1]}}) {
+                        auto it = fused_products_.find(get_input(product.second));
+                        if (it == fused_products_.end()) continue;
+                        auto negate = [](char sign, const std::string& expr) { return sign == '-' ? "-" + operand(expr) : expr; };
+                        code << indent_ << decl << " " << out_var << " = std::fma(" << negate(product.first, it->second.first)
+                             << ", " << it->second.second << ", " << negate(addend.first, get_input(addend.second)) << ");\n";
+                        return;
+                    }
+                }
+
+                code << indent_ << decl << " " << out_var << " = ";
 
                 bool first = true;
                 int input_idx = 0;
@@ -834,7 +4599,7 @@ namespace oc::codegen {
             }
             else if (blk.type == "Product") {
                 auto inputs_spec = blk.param("Inputs").value_or("**");
-                code << indent_ << "auto " << out_var << " = ";
+                code << indent_ << decl << " " << out_var << " = ";
 
                 int idx = 0;
                 bool first = true;
@@ -853,46 +4618,147 @@ namespace oc::codegen {
             else if (blk.type == "Saturate") {
                 auto upper = get_param("UpperLimit", "1.0f");
                 auto lower = get_param("LowerLimit", "-1.0f");
-                code << indent_ << "auto " << out_var << " = std::clamp(" << get_input(0)
-                     << ", " << lower << ", " << upper << ");\n";
+                auto value = get_input(0);
+                if (typed && input_type(0) == "double") {
+                    upper = "static_cast<double>(" + upper + ")";
+                    lower = "static_cast<double>(" + lower + ")";
+                } else if (typed) {
+                    value = input_as(0, "float");
+                    // Integer literals such as "0" would make std::clamp deduce mixed types
+                    if (auto v = evaluate_expression(upper)) upper = format_constant(*v);
+                    if (auto v = evaluate_expression(lower)) lower = format_constant(*v);
+                }
+                // Range analysis leaves a limit the signal cannot reach at infinity: clamp on one side only
+                auto unreachable = [&](const char* name, double bound) {
+                    auto limit = blk.param(name);
+                    return options_.range_analysis && limit && evaluate_expression(*limit, options_.calibration) == bound;
+                };
+                auto as_float = [&](const std::string& limit) {
+                    if (auto v = evaluate_expression(limit)) return format_constant(*v);
+                    return limit;
+                };
+                if (unreachable("UpperLimit", std::numeric_limits<double>::infinity())) {
+                    code << indent_ << decl << " " << out_var << " = std::max(" << value << ", " << as_float(lower) << ");\n";
+                } else if (unreachable("LowerLimit", -std::numeric_limits<double>::infinity())) {
+                    code << indent_ << decl << " " << out_var << " = std::min(" << value << ", " << as_float(upper) << ");\n";
+                } else {
+                    code << indent_ << decl << " " << out_var << " = std::clamp(" << value
+                         << ", " << lower << ", " << upper << ");\n";
+                }
             }
             else if (blk.type == "MinMax") {
                 auto func = blk.param("Function").value_or("min");
                 std::string fn = (func == "max" || func == "Max") ? "std::max" : "std::min";
-                code << indent_ << "auto " << out_var << " = " << fn << "("
-                     << get_input(0) << ", " << get_input(1) << ");\n";
+                auto a = get_input(0), b = get_input(1);
+                if (typed && input_type(0) != input_type(1)) {
+                    auto common = (input_type(0) == "double" || input_type(1) == "double") ? "double" : "float";
+                    a = input_as(0, common);
+                    b = input_as(1, common);
+                }
+                code << indent_ << decl << " " << out_var << " = " << fn << "(" << a << ", " << b << ");\n";
             }
             else if (blk.type == "Abs") {
-                code << indent_ << "auto " << out_var << " = std::abs(" << get_input(0) << ");\n";
+                code << indent_ << decl << " " << out_var << " = std::abs(" << get_input(0) << ");\n";
             }
             else if (blk.type == "Constant") {
                 auto value = get_param("Value", "0.0f");
-                code << indent_ << "auto " << out_var << " = " << value << ";\n";
+                if (typed) {
+                    if (auto v = blk.param("Value"); v && (*v == "true" || *v == "false")) value = *v;
+                }
+                code << indent_ << decl << " " << out_var << " = " << value << ";\n";
             }
             else if (blk.type == "UnitDelay" || blk.type == "Memory") {
                 // Output already comes from state variable, just update state
                 code << indent_ << state_var << " = " << get_input(0) << ";  // update for next step\n";
             }
             else if (blk.type == "Integrator" || blk.type == "DiscreteIntegrator") {
-                code << indent_ << state_var << " += " << get_input(0) << " * cfg.dt;\n";
+                code << indent_ << state_var << " += " << get_input(0) << " * " << dt_expression() << ";\n";
+            }
+            else if (blk.type == "Delay" && delay_length(blk, options_.calibration)) {
+                auto length = *delay_length(blk, options_.calibration);
+                if (length == 0) {
+                    code << indent_ << decl << " " << out_var << " = " << get_input(0) << ";\n";
+                } else if (length == 1) {
+                    code << indent_ << state_var << " = " << get_input(0) << ";  // update for next step\n";
+                } else {
+                    // The head slot was read this step; the input lands where it is read again after length steps
+                    auto ring = std::bit_ceil(static_cast<unsigned>(length));
+                    auto buf = "state." + var_prefix + "_buf";
+                    auto head = "state." + var_prefix + "_head";
+                    auto mask = std::to_string(ring - 1);
+                    auto slot = ring == static_cast<unsigned>(length) ? head : "(" + head + " + " + std::to_string(length) + ") & " + mask;
+                    code << indent_ << "// " << length << " samples, ring of " << ring << "\n";
+                    code << indent_ << buf << "[" << slot << "] = " << get_input(0) << ";\n";
+                    code << indent_ << head << " = (" << head << " + 1) & " << mask << ";\n";
+                }
+            }
+            else if ((blk.type == "DiscreteFilter" || blk.type == "DiscreteTransferFcn") &&
+                     parse_discrete_filter(blk, options_.calibration)) {
+                // Direct form II transposed: one state per order and no shifting of past samples. A strictly
+                // proper filter is a state block: it runs one step ahead and leaves next step's output in its state.
+                auto filter = *parse_discrete_filter(blk, options_.calibration);
+                bool ahead = filter.strictly_proper() && !state_var.empty();
+                if (ahead) filter = filter.advanced();
+                int n = filter.order();
+                auto u = get_input(0);
+                auto y_var = ahead ? state_var : out_var;
+                auto z = [&](int i) { return "state." + var_prefix + "_z[" + std::to_string(i) + "]"; };
+                code << indent_ << "// order " << n << ", direct form II transposed" << (ahead ? ", one step ahead" : "") << "\n";
+                std::vector<std::pair<double, std::string>> y{{filter.num[0], u}};
+                if (n > 0) y.emplace_back(1.0, z(0));
+                code << indent_ << (ahead ? "" : decl + " ") << y_var << " = " << weighted_sum(y) << ";\n";
+                for (int i = 0; i < n; ++i) {
+                    std::vector<std::pair<double, std::string>> next{{filter.num[i + 1], u}};
+                    if (i + 1 < n) next.emplace_back(1.0, z(i + 1));
+                    next.emplace_back(-filter.den[i + 1], y_var);
+                    code << indent_ << z(i) << " = " << weighted_sum(next) << ";\n";
+                }
+            }
+            else if (blk.type == "DiscreteStateSpace" && parse_discrete_state_space(blk, options_.calibration)) {
+                auto ss = *parse_discrete_state_space(blk, options_.calibration);
+                auto n = ss.a.size();
+                auto x = [&](std::size_t i) { return "state." + var_prefix + "_x[" + std::to_string(i) + "]"; };
+                std::vector<std::pair<double, std::string>> y{{ss.d, get_input(0)}};
+                for (std::size_t j = 0; j < n; ++j) y.emplace_back(ss.c[j], x(j));
+                code << indent_ << decl << " " << out_var << " = " << weighted_sum(y) << ";\n";
+
+                // Every next state reads the old ones, so they are computed before any is written
+                code << indent_ << "{\n";
+                code << indent_ << "    const float u_n = " << get_input(0) << ";\n";
+                code << indent_ << "    const float x_n[" << n << "] = {\n";
+                for (std::size_t i = 0; i < n; ++i) {
+                    std::vector<std::pair<double, std::string>> row;
+                    for (std::size_t j = 0; j < n; ++j) row.emplace_back(ss.a[i][j], x(j));
+                    row.emplace_back(ss.b[i], "u_n");
+                    code << indent_ << "        " << weighted_sum(row) << (i + 1 < n ? ",\n" : "\n");
+                }
+                code << indent_ << "    };\n";
+                code << indent_ << "    std::copy_n(x_n, " << n << ", state." << var_prefix << "_x);\n";
+                code << indent_ << "}\n";
             }
             else if (blk.type == "RelationalOperator") {
                 auto op = blk.param("Operator").value_or("==");
                 std::string cpp_op = op;
                 if (op == "~=") cpp_op = "!=";
-                code << indent_ << "auto " << out_var << " = (" << get_input(0)
-                     << " " << cpp_op << " " << get_input(1) << ") ? 1.0f : 0.0f;\n";
+                code << indent_ << decl << " " << out_var << " = (" << get_input(0)
+                     << " " << cpp_op << " " << get_input(1) << ")" << (typed ? "" : " ? 1.0f : 0.0f") << ";\n";
             }
             else if (blk.type == "Logic") {
                 auto op = blk.param("Operator").value_or("AND");
-                if (op == "NOT") {
-                    code << indent_ << "auto " << out_var << " = (" << get_input(0)
+                if (typed && op == "NOT") {
+                    code << indent_ << decl << " " << out_var << " = !" << input_bool(0) << ";\n";
+                } else if (typed) {
+                    std::string cpp_op = op == "OR" ? "||" : op == "XOR" ? "!=" : "&&";
+                    code << indent_ << decl << " " << out_var << " = " << input_bool(0)
+                         << " " << cpp_op << " " << input_bool(1) << ";\n";
+                } else if (op == "NOT") {
+                    code << indent_ << decl << " " << out_var << " = (" << get_input(0)
                          << " == 0.0f) ? 1.0f : 0.0f;\n";
                 } else {
                     std::string cpp_op = "&&";
                     if (op == "OR") cpp_op = "||";
                     else if (op == "XOR") cpp_op = "!=";
-                    code << indent_ << "auto " << out_var << " = ((" << get_input(0)
+                    code << indent_ << decl << " " << out_var << " = ((" << get_input(0)
                          << " != 0.0f) " << cpp_op << " (" << get_input(1)
                          << " != 0.0f)) ? 1.0f : 0.0f;\n";
                 }
@@ -910,34 +4776,36 @@ namespace oc::codegen {
                 } else {
                     cond = get_input(1) + " != 0.0f";
                 }
-                code << indent_ << "auto " << out_var << " = (" << cond << ") ? "
+                code << indent_ << decl << " " << out_var << " = (" << cond << ") ? "
                      << get_input(0) << " : " << get_input(2) << ";\n";
             }
             else if (blk.type == "Trigonometry") {
                 auto func = blk.param("Operator").value_or("sin");
-                code << indent_ << "auto " << out_var << " = std::" << func << "("
+                code << indent_ << decl << " " << out_var << " = std::" << func << "("
                      << get_input(0) << ");\n";
             }
             else if (blk.type == "Math") {
                 auto func = blk.param("Operator").value_or("sqrt");
                 if (func == "sqrt" || func == "exp" || func == "log" || func == "log10") {
-                    code << indent_ << "auto " << out_var << " = std::" << func << "("
+                    code << indent_ << decl << " " << out_var << " = std::" << func << "("
                          << get_input(0) << ");\n";
                 } else if (func == "square") {
-                    code << indent_ << "auto " << out_var << " = " << get_input(0) << " * "
+                    code << indent_ << decl << " " << out_var << " = " << get_input(0) << " * "
                          << get_input(0) << ";\n";
                 } else if (func == "pow") {
-                    code << indent_ << "auto " << out_var << " = std::pow("
+                    code << indent_ << decl << " " << out_var << " = std::pow("
                          << get_input(0) << ", " << get_input(1) << ");\n";
                 } else {
-                    code << indent_ << "auto " << out_var << " = " << get_input(0)
+                    code << indent_ << decl << " " << out_var << " = " << get_input(0)
                          << "; // TODO: Math/" << func << "\n";
                 }
             }
             else if (blk.type == "TransferFcn") {
                 // Tustin discretization
                 auto tf = parse_transfer_function(blk);
-                auto state_prefix = "state." + var_prefix + "_tf_";
+                auto tf_field = [&](const std::string& field) {
+                    return filter_field(state_var.empty() ? "state." + var_prefix + "_tf_%" : state_var, field);
+                };
 
                 code << indent_ << "// TransferFcn: " << blk.name << " (order " << tf.order << ")\n";
                 code << indent_ << "{\n";
@@ -960,18 +4828,18 @@ namespace oc::codegen {
 
                     if (tf.num.size() == 1) { b0 = 0.0; b1 = tf.num[0]; }
 
-                    code << indent_ << "    float k = 2.0f / cfg.dt;\n";
+                    code << indent_ << "    float k = 2.0f / " << dt_expression() << ";\n";
                     code << indent_ << "    float b0_d = " << format_float(b0) << " * k + " << format_float(b1) << ";\n";
                     code << indent_ << "    float b1_d = -" << format_float(b0) << " * k + " << format_float(b1) << ";\n";
                     code << indent_ << "    float a0_d = " << format_float(a0) << " * k + " << format_float(a1) << ";\n";
                     code << indent_ << "    float a1_d = -" << format_float(a0) << " * k + " << format_float(a1) << ";\n";
                     code << indent_ << "    float u_n = " << get_input(0) << ";\n";
-                    code << indent_ << "    float y_n = (b0_d * u_n + b1_d * " << state_prefix << "u0"
-                         << " - a1_d * " << state_prefix << "x0) / a0_d;\n";
-                    code << indent_ << "    " << state_prefix << "u0 = u_n;\n";
-                    code << indent_ << "    " << state_prefix << "x0 = y_n;\n";
+                    code << indent_ << "    float y_n = (b0_d * u_n + b1_d * " << tf_field("u0")
+                         << " - a1_d * " << tf_field("x0") << ") / a0_d;\n";
+                    code << indent_ << "    " << tf_field("u0") << " = u_n;\n";
+                    code << indent_ << "    " << tf_field("x0") << " = y_n;\n";
                     code << indent_ << "}\n";
-                    code << indent_ << "auto " << out_var << " = " << state_prefix << "x0;\n";
+                    code << indent_ << decl << " " << out_var << " = " << tf_field("x0") << ";\n";
                 }
                 else if (tf.order == 2) {
                     // Second-order system
@@ -984,7 +4852,7 @@ namespace oc::codegen {
 
                     if (tf.num.size() == 1) { b0 = 0; b1 = 0; b2 = tf.num[0]; }
 
-                    code << indent_ << "    float k = 2.0f / cfg.dt;\n";
+                    code << indent_ << "    float k = 2.0f / " << dt_expression() << ";\n";
                     code << indent_ << "    float k2 = k * k;\n";
                     code << indent_ << "    float b0_d = " << format_float(b0) << "*k2 + " << format_float(b1) << "*k + " << format_float(b2) << ";\n";
                     code << indent_ << "    float b1_d = 2.0f*" << format_float(b2) << " - 2.0f*" << format_float(b0) << "*k2;\n";
@@ -993,24 +4861,24 @@ namespace oc::codegen {
                     code << indent_ << "    float a1_d = 2.0f*" << format_float(a2) << " - 2.0f*" << format_float(a0) << "*k2;\n";
                     code << indent_ << "    float a2_d = " << format_float(a0) << "*k2 - " << format_float(a1) << "*k + " << format_float(a2) << ";\n";
                     code << indent_ << "    float u_n = " << get_input(0) << ";\n";
-                    code << indent_ << "    float y_n = (b0_d*u_n + b1_d*" << state_prefix << "u0 + b2_d*"
-                         << state_prefix << "u1 - a1_d*" << state_prefix << "x0 - a2_d*" << state_prefix << "x1) / a0_d;\n";
-                    code << indent_ << "    " << state_prefix << "u1 = " << state_prefix << "u0;\n";
-                    code << indent_ << "    " << state_prefix << "u0 = u_n;\n";
-                    code << indent_ << "    " << state_prefix << "x1 = " << state_prefix << "x0;\n";
-                    code << indent_ << "    " << state_prefix << "x0 = y_n;\n";
+                    code << indent_ << "    float y_n = (b0_d*u_n + b1_d*" << tf_field("u0") << " + b2_d*"
+                         << tf_field("u1") << " - a1_d*" << tf_field("x0") << " - a2_d*" << tf_field("x1") << ") / a0_d;\n";
+                    code << indent_ << "    " << tf_field("u1") << " = " << tf_field("u0") << ";\n";
+                    code << indent_ << "    " << tf_field("u0") << " = u_n;\n";
+                    code << indent_ << "    " << tf_field("x1") << " = " << tf_field("x0") << ";\n";
+                    code << indent_ << "    " << tf_field("x0") << " = y_n;\n";
                     code << indent_ << "}\n";
-                    code << indent_ << "auto " << out_var << " = " << state_prefix << "x0;\n";
+                    code << indent_ << decl << " " << out_var << " = " << tf_field("x0") << ";\n";
                 }
                 else {
                     // Higher order - fallback to passthrough with warning
                     code << indent_ << "    // Order " << tf.order << " transfer function not yet supported\n";
                     code << indent_ << "}\n";
-                    code << indent_ << "auto " << out_var << " = " << get_input(0) << ";\n";
+                    code << indent_ << decl << " " << out_var << " = " << get_input(0) << ";\n";
                 }
             }
             else if (blk.type == "Derivative") {
-                code << indent_ << "auto " << out_var << " = " << get_input(0)
+                code << indent_ << decl << " " << out_var << " = " << get_input(0)
                      << "; // TODO: Derivative needs previous value\n";
             }
             else if (blk.type == "Demux") {
@@ -1023,10 +4891,10 @@ namespace oc::codegen {
             }
             else if (blk.type == "Mux") {
                 // Mux combines inputs - for now treat as first input
-                code << indent_ << "auto " << out_var << " = " << get_input(0) << "; // Mux\n";
+                code << indent_ << decl << " " << out_var << " = " << get_input(0) << "; // Mux\n";
             }
             else {
-                code << indent_ << "auto " << out_var << " = " << get_input(0)
+                code << indent_ << decl << " " << out_var << " = " << get_input(0)
                      << "; // TODO: " << blk.type << "\n";
             }
         }
@@ -1047,13 +4915,7 @@ namespace oc::codegen {
             std::map<std::string, std::string> sub_signal_map = parent_signal_map;
 
             // Map subsystem inports to the inputs passed to this block
-            auto inports = subsys.inports();
-            std::ranges::sort(inports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
+            auto inports = sorted_by_port(subsys.inports());
 
             for (std::size_t i = 0; i < inports.size(); ++i) {
                 auto key = inports[i].sid + "#out:1";
@@ -1068,13 +4930,7 @@ namespace oc::codegen {
             generate_system_code(subsys, var_prefix, sub_signal_map, code, depth + 1);
 
             // Map subsystem outports to the parent signal map
-            auto outports = subsys.outports();
-            std::ranges::sort(outports, [](const auto& a, const auto& b) {
-                int pa = 1, pb = 1;
-                if (auto v = a.param("Port")) pa = std::stoi(*v);
-                if (auto v = b.param("Port")) pb = std::stoi(*v);
-                return pa < pb;
-            });
+            auto outports = sorted_by_port(subsys.outports());
 
             for (std::size_t i = 0; i < outports.size(); ++i) {
                 // Find what connects to this outport in the subsystem
@@ -1118,9 +4974,11 @@ namespace oc::codegen {
             const std::vector<std::string>& inputs,
             const std::string& var_prefix,
             std::map<std::string, std::string>& signal_map,
-            std::ostringstream& code)
+            std::ostringstream& code,
+            const signal_typing& types = {})
         {
             auto func_name = func.name;
+            const auto& input_types = types.inputs;
             auto local_name = sanitize_name(blk.name);
 
             code << indent_ << "// Component call: " << blk.name << "\n";
@@ -1130,10 +4988,26 @@ namespace oc::codegen {
             for (std::size_t i = 0; i < func.inports.size(); ++i) {
                 if (i > 0) code << ", ";
                 code << "." << func.inports[i].first << " = ";
-                if (i < inputs.size() && !inputs[i].empty())
-                    code << inputs[i];
-                else
-                    code << "0.0f";
+                if (auto bus = func.bus_types.find(func.inports[i].second); bus != func.bus_types.end()) {
+                    // Bus inputs are built from the caller's leaf signals
+                    const auto* fields = i < types.input_buses.size() ? &types.input_buses[i] : nullptr;
+                    code << bus_initializer(bus->second, [&](const std::string& path, const std::string& type) {
+                        if (fields) {
+                            for (const auto& [p, expr] : *fields) {
+                                if (p == path) return expr;
+                            }
+                        }
+                        return zero_value(type);
+                    });
+                } else if (i < inputs.size() && !inputs[i].empty()) {
+                    // Braced initialization rejects narrowing, so convert between differing types
+                    if (i < input_types.size() && input_types[i] != func.inports[i].second)
+                        code << "static_cast<" << func.inports[i].second << ">(" << inputs[i] << ")";
+                    else
+                        code << inputs[i];
+                } else {
+                    code << zero_value(func.inports[i].second);
+                }
             }
             code << "};\n";
 
@@ -1152,7 +5026,7 @@ namespace oc::codegen {
                 first = false;
             }
             if (!first) code << ", ";
-            code << ".dt = cfg.dt}";
+            code << ".dt = " << dt_expression() << "}";
 
             // State parameter
             if (!func.state_vars.empty()) {
@@ -1164,6 +5038,7 @@ namespace oc::codegen {
 
             // Extract outputs into alias variables matching the pre-mapped signal names
             for (std::size_t i = 0; i < func.outports.size(); ++i) {
+                if (func.bus_types.contains(func.outports[i].second)) continue;  // read field by field
                 auto out_key = blk.sid + "#out:" + std::to_string(i + 1);
                 auto alias_var = var_prefix + "_out" + std::to_string(i + 1);
                 code << indent_ << "auto " << alias_var << " = "
@@ -1181,16 +5056,20 @@ namespace oc::codegen {
 
             auto fn = func.name;
 
+            // Bus structs used by the ports
+            for (const auto& [name, layout] : func.bus_types)
+                emit_bus_struct(out, name, layout);
+
             // Input struct
             out << "    struct " << fn << "_input {\n";
             for (const auto& [name, type] : func.inports)
-                out << "        " << type << " " << name << " = 0.0f;\n";
+                out << "        " << port_declaration(name, type, func.bus_types) << "\n";
             out << "    };\n\n";
 
             // Output struct
             out << "    struct " << fn << "_output {\n";
             for (const auto& [name, type] : func.outports)
-                out << "        " << type << " " << name << " = 0.0f;\n";
+                out << "        " << port_declaration(name, type, func.bus_types) << "\n";
             out << "    };\n\n";
 
             // State struct
@@ -1200,6 +5079,8 @@ namespace oc::codegen {
                     bool is_component_state = (comment == "component state");
                     if (is_component_state) {
                         out << "        " << var << "_state " << var << "{};";
+                    } else if (auto it = func.state_types.find(var); it != func.state_types.end()) {
+                        out << "        " << state_declaration(it->second, var);
                     } else {
                         out << "        float " << var << " = 0.0f;";
                     }
@@ -1228,12 +5109,17 @@ namespace oc::codegen {
             out << "    }\n\n";
         }
 
-        static void extract_config_vars(std::string_view expr, std::set<std::string>& vars) {
+        [[nodiscard]] static auto matlab_builtins() -> const std::set<std::string>& {
             static const std::set<std::string> builtins = {
                 "sqrt", "exp", "log", "log10", "sin", "cos", "tan", "asin", "acos", "atan",
                 "sinh", "cosh", "tanh", "abs", "floor", "ceil", "round", "mod", "sign",
                 "max", "min", "pi", "inf", "nan", "eps", "true", "false"
             };
+            return builtins;
+        }
+
+        static void extract_config_vars(std::string_view expr, std::set<std::string>& vars) {
+            const auto& builtins = matlab_builtins();
 
             std::string current;
             for (char c : expr) {
@@ -1255,6 +5141,86 @@ namespace oc::codegen {
             }
         }
 
+        // Parameter value as C++; when specializing, calibrated names are bound to their values
+        // and any remaining workspace variables read from the config struct
+        [[nodiscard]] auto param_expression(std::string_view value) const -> std::string {
+            if (options_.calibration.empty()) return format_param_value(value);
+            if (auto v = evaluate_expression(value, options_.calibration)) return format_constant(*v);
+
+            std::string bound;
+            std::size_t i = 0;
+            while (i < value.size()) {
+                char c = value[i];
+                if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                    auto start = i;
+                    while (i < value.size() && (std::isalnum(static_cast<unsigned char>(value[i])) || value[i] == '.' ||
+                           ((value[i] == '+' || value[i] == '-') && (value[i - 1] == 'e' || value[i - 1] == 'E')))) ++i;
+                    bound += value.substr(start, i - start);
+                } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                    auto start = i;
+                    while (i < value.size() && (std::isalnum(static_cast<unsigned char>(value[i])) || value[i] == '_')) ++i;
+                    auto name = std::string(value.substr(start, i - start));
+                    if (auto it = options_.calibration.find(name); it != options_.calibration.end()) {
+                        bound += format_constant(it->second);
+                    } else if (matlab_builtins().contains(name)) {
+                        bound += name;
+                    } else {
+                        bound += "cfg." + name;
+                    }
+                } else {
+                    bound += c;
+                    ++i;
+                }
+            }
+            return format_param_value(power_calls(bound));
+        }
+
+        // Rewrite MATLAB's a^b, which evaluate_expression reads as a power and C++ as XOR, as
+        // std::pow(a, b); operands are a name, a number or a parenthesized group (with its call)
+        [[nodiscard]] static auto power_calls(std::string text) -> std::string {
+            auto is_word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == ':'; };
+            auto is_exponent_sign = [&](const std::string& s, std::size_t at) {
+                return (s[at] == '+' || s[at] == '-') && at >= 2 && (s[at - 1] == 'e' || s[at - 1] == 'E') &&
+                       std::isdigit(static_cast<unsigned char>(s[at - 2]));
+            };
+            for (auto caret = text.find('^'); caret != std::string::npos; caret = text.find('^')) {
+                auto start = caret;
+                while (start > 0 && text[start - 1] == ' ') --start;
+                if (start > 0 && text[start - 1] == ')') {
+                    int depth = 0;
+                    do {
+                        --start;
+                        if (text[start] == ')') ++depth;
+                        else if (text[start] == '(') --depth;
+                    } while (start > 0 && depth > 0);
+                }
+                while (start > 0 && (is_word(text[start - 1]) || is_exponent_sign(text, start - 1))) --start;
+
+                auto end = caret + 1;
+                while (end < text.size() && text[end] == ' ') ++end;
+                if (end < text.size() && (text[end] == '-' || text[end] == '+')) ++end;
+                while (end < text.size() && (is_word(text[end]) || is_exponent_sign(text, end))) ++end;
+                if (end < text.size() && text[end] == '(') {
+                    int depth = 0;
+                    do {
+                        if (text[end] == '(') ++depth;
+                        else if (text[end] == ')') --depth;
+                        ++end;
+                    } while (end < text.size() && depth > 0);
+                }
+
+                auto trim = [](std::string_view operand) {
+                    while (!operand.empty() && operand.front() == ' ') operand.remove_prefix(1);
+                    while (!operand.empty() && operand.back() == ' ') operand.remove_suffix(1);
+                    return std::string(operand);
+                };
+                auto base = trim(std::string_view(text).substr(start, caret - start));
+                auto exponent = trim(std::string_view(text).substr(caret + 1, end - caret - 1));
+                text.replace(start, end - start, "std::pow(" + base + ", " + exponent + ")");
+            }
+            return text;
+        }
+
         // Format parameter value, replacing MATLAB constants with C++ equivalents
         [[nodiscard]] static auto format_param_value(std::string_view value) -> std::string {
             if (value.empty()) return "0.0f";
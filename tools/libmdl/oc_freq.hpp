@@ -0,0 +1,171 @@
+//
+// Open Controls - Frequency Response
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "oc_sim.hpp"
+#include <complex>
+#include <numbers>
+
+namespace oc::freq {
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Transfer Function
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Rational function of z, coefficients in descending powers as in codegen::transfer_function
+    struct z_transfer_function {
+        std::vector<double> num;
+        std::vector<double> den;
+
+        [[nodiscard]] auto order() const -> std::size_t { return den.empty() ? 0 : den.size() - 1; }
+    };
+
+    // H(z) = C (zI - A)^-1 B + D by Faddeev-LeVerrier: the characteristic polynomial and the
+    // adjugate come out of n matrix products, without finding any roots
+    [[nodiscard]] inline auto compose(const sim::linear_model& model) -> z_transfer_function {
+        auto n = model.states;
+        z_transfer_function tf;
+        tf.den.assign(n + 1, 0.0);
+        tf.den[0] = 1.0;
+
+        std::vector<double> adjugate(n, 0.0);  // C N_k B, the coefficient of z^(n-1-k)
+        std::vector<double> N(n * n, 0.0), AN(n * n, 0.0);
+        for (std::size_t i = 0; i < n; ++i) N[i * n + i] = 1.0;
+        for (std::size_t k = 0; k < n; ++k) {
+            for (std::size_t r = 0; r < n; ++r) {
+                double nb = 0.0;
+                for (std::size_t j = 0; j < n; ++j) nb += N[r * n + j] * model.b[j];
+                adjugate[k] += model.c[r] * nb;
+            }
+            double trace = 0.0;
+            for (std::size_t r = 0; r < n; ++r) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    double sum = 0.0;
+                    for (std::size_t i = 0; i < n; ++i) sum += model.a[r * n + i] * N[i * n + j];
+                    AN[r * n + j] = sum;
+                }
+                trace += AN[r * n + r];
+            }
+            tf.den[k + 1] = -trace / static_cast<double>(k + 1);
+            for (std::size_t i = 0; i < n; ++i) AN[i * n + i] += tf.den[k + 1];
+            std::swap(N, AN);
+        }
+
+        tf.num.assign(n + 1, 0.0);
+        for (std::size_t k = 0; k <= n; ++k) tf.num[k] = model.d * tf.den[k] + (k > 0 ? adjugate[k - 1] : 0.0);
+
+        // Pure delays leave a factor of z in both; drop it, and leading zeros of the numerator
+        double scale = 0.0;
+        for (auto v : tf.num) scale = std::max(scale, std::abs(v));
+        for (auto v : tf.den) scale = std::max(scale, std::abs(v));
+        auto negligible = [&](double v) { return std::abs(v) <= 1e-12 * scale; };
+        while (tf.den.size() > 1 && negligible(tf.num.back()) && negligible(tf.den.back())) {
+            tf.num.pop_back();
+            tf.den.pop_back();
+        }
+        while (tf.num.size() > 1 && negligible(tf.num.front())) tf.num.erase(tf.num.begin());
+        return tf;
+    }
+
+    [[nodiscard]] inline auto evaluate(const z_transfer_function& tf, double dt, double hz) -> std::complex<double> {
+        auto z = std::polar(1.0, 2.0 * std::numbers::pi * hz * dt);
+        auto horner = [&](const std::vector<double>& p) {
+            std::complex<double> sum = 0.0;
+            for (auto v : p) sum = sum * z + v;
+            return sum;
+        };
+        return horner(tf.num) / horner(tf.den);
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Bode Data
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    struct point {
+        double hz = 0.0;
+        double magnitude_db = 0.0;
+        double phase_deg = 0.0;
+    };
+
+    // Logarithmically spaced, both ends included
+    [[nodiscard]] inline auto log_grid(double from, double to, std::size_t points) -> std::vector<double> {
+        std::vector<double> grid;
+        if (points < 2) return {from};
+        for (std::size_t i = 0; i < points; ++i) {
+            grid.push_back(from * std::pow(to / from, static_cast<double>(i) / static_cast<double>(points - 1)));
+        }
+        return grid;
+    }
+
+    // Magnitude in dB and phase in degrees, unwrapped along the grid
+    [[nodiscard]] inline auto bode(std::span<const double> hz, std::span<const std::complex<double>> response) -> std::vector<point> {
+        std::vector<point> points;
+        double previous = 0.0;
+        for (std::size_t i = 0; i < hz.size(); ++i) {
+            auto phase = std::arg(response[i]) * 180.0 / std::numbers::pi;
+            if (i > 0) phase += 360.0 * std::round((previous - phase) / 360.0);
+            previous = phase;
+            points.push_back({hz[i], 20.0 * std::log10(std::abs(response[i])), phase});
+        }
+        return points;
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Simulated Sweep
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    struct sweep_options {
+        double amplitude = 0.01;     // of the cosine added to the input's operating point
+        double periods = 10;         // measured, after the system has settled
+        double settle_periods = 20;  // run first, and at least settle_time seconds
+        double settle_time = 0.0;
+    };
+
+    struct measurement {
+        double hz = 0.0;             // the grid frequency moved so that whole periods fill whole steps
+        std::complex<double> response;
+        long long steps = 0;
+    };
+
+    // First-harmonic response of a signal to a cosine on one input, around the operating point given
+    // by `inputs`. The input and output are correlated over the same samples, so the ratio is the
+    // discrete response at the tested frequency whatever the system does with its phase.
+    [[nodiscard]] inline auto measure(sim::simulator& sim, std::span<const float> inputs, std::size_t input, std::uint32_t output,
+                                      double hz, const sweep_options& options = {}) -> measurement {
+        auto dt = sim.dt();
+        auto cycles = std::max(1.0, std::round(options.periods));
+        auto samples = std::max(2LL, std::llround(cycles / (hz * dt)));
+        measurement result;
+        result.hz = cycles / (static_cast<double>(samples) * dt);
+        auto omega = 2.0 * std::numbers::pi * result.hz * dt;
+        auto settle = static_cast<long long>(std::ceil(std::max(options.settle_periods / result.hz, options.settle_time) / dt));
+
+        sim.reset();
+        for (std::size_t i = 0; i < inputs.size(); ++i) sim.set_input(i, inputs[i]);
+        float operating = input < inputs.size() ? inputs[input] : 0.0f;
+        std::complex<double> u_sum = 0.0, y_sum = 0.0;
+        for (long long k = 0; k < settle + samples; ++k) {
+            auto phase = omega * static_cast<double>(k);
+            float u = operating + static_cast<float>(options.amplitude * std::cos(phase));
+            sim.set_input(input, u);
+            sim.step();
+            if (k < settle) continue;
+            auto basis = std::polar(1.0, -phase);
+            u_sum += static_cast<double>(u - operating) * basis;
+            y_sum += static_cast<double>(sim.signal(output)) * basis;
+        }
+        result.response = y_sum / u_sum;
+        result.steps = settle + samples;
+        return result;
+    }
+
+} // namespace oc::freq
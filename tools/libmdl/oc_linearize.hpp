@@ -0,0 +1,182 @@
+//
+// Open Controls - Numerical Linearization
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "oc_sim.hpp"
+#include <atomic>
+
+namespace oc::lin {
+
+    struct linearize_options {
+        double delta = 1e-2;        // perturbation, relative to max(1, |value|); float steps need it this large
+        std::size_t lanes = 64;     // perturbed runs stepped together as one batch
+        std::size_t threads = 0;    // 0: all cores
+        bool minimal = true;        // keep only the states the inputs reach and the outputs see
+    };
+
+    // One step around an operating point: x[k] = A x[k-1] + B u[k], y[k] = C x[k-1] + D u[k], as in
+    // sim::linear_model, for every input and the chosen outputs. Matrices are row-major.
+    struct jacobians {
+        std::vector<std::string> states;
+        std::vector<std::string> inputs;
+        std::vector<double> a;      // states x states
+        std::vector<double> b;      // states x inputs
+        std::vector<double> c;      // outputs x states
+        std::vector<double> d;      // outputs x inputs
+        std::vector<double> x;      // operating point: the state before the step,
+        std::vector<double> u;      // the inputs,
+        std::vector<double> y;      // and the outputs after it
+        std::size_t runs = 0;       // perturbed steps taken
+        std::size_t all_states = 0; // before reduction
+    };
+
+    // Central differences of one step from the simulator's current state and inputs. Every state cell
+    // and every input is moved up and down by delta in its own lane; the lanes run in batches on the
+    // worker threads, each batch stepping all its lanes through the instruction stream together.
+    [[nodiscard]] inline auto linearize(const sim::simulator& sim, std::span<const std::uint32_t> outputs,
+                                        const linearize_options& options = {}) -> jacobians {
+        auto cells = sim.state_cells();
+        auto n = cells.size();
+        auto m = sim.inputs().size();
+        auto p = outputs.size();
+
+        jacobians result;
+        result.inputs = sim.inputs();
+        result.all_states = n;
+        for (const auto& cell : cells) {
+            result.states.push_back(cell.name);
+            result.x.push_back(sim.state_value(cell));
+        }
+        for (std::size_t i = 0; i < m; ++i) result.u.push_back(sim.input(i));
+
+        // Run 2j and 2j + 1 move variable j up and down; states come first, then inputs. The values are
+        // the floats actually stored, so rounding does not skew the quotients.
+        auto variables = n + m;
+        auto runs = 2 * variables;
+        std::vector<float> perturbed(runs);
+        for (std::size_t j = 0; j < variables; ++j) {
+            double base = j < n ? result.x[j] : result.u[j - n];
+            auto step = options.delta * std::max(1.0, std::abs(base));
+            perturbed[2 * j] = static_cast<float>(base + step);
+            perturbed[2 * j + 1] = static_cast<float>(base - step);
+        }
+
+        std::vector<double> next(runs * n), seen(runs * p);
+        result.y.resize(p);
+        auto lanes = std::max<std::size_t>(1, std::min(options.lanes, runs + 1));
+        auto batches = (runs + 1 + lanes - 1) / lanes;  // the last run is unperturbed, for y
+        auto threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max<std::size_t>(1, std::min(threads, batches));
+
+        std::vector<const sim::simulator*> sources(lanes, &sim);
+        std::atomic<std::size_t> next_batch{0};
+        auto work = [&] {
+            sim::batch group(sources);
+            for (auto index = next_batch.fetch_add(1); index < batches; index = next_batch.fetch_add(1)) {
+                auto first = index * lanes;
+                auto count = std::min(lanes, runs + 1 - first);
+                for (std::size_t lane = 0; lane < count; ++lane) {
+                    group.load(lane, sim);
+                    auto run = first + lane;
+                    if (run == runs) continue;
+                    auto j = run / 2;
+                    if (j < n) group.set_state_value(lane, cells[j], perturbed[run]);
+                    else group.set_input(lane, j - n, perturbed[run]);
+                }
+                group.step();
+                for (std::size_t lane = 0; lane < count; ++lane) {
+                    auto run = first + lane;
+                    if (run == runs) {
+                        for (std::size_t o = 0; o < p; ++o) result.y[o] = group.signal(lane, outputs[o]);
+                        continue;
+                    }
+                    for (std::size_t r = 0; r < n; ++r) next[run * n + r] = group.state_value(lane, cells[r]);
+                    for (std::size_t o = 0; o < p; ++o) seen[run * p + o] = group.signal(lane, outputs[o]);
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+        result.runs = runs + 1;
+
+        auto derivative = [&](const std::vector<double>& values, std::size_t width, std::size_t row, std::size_t j) {
+            auto moved = static_cast<double>(perturbed[2 * j]) - static_cast<double>(perturbed[2 * j + 1]);
+            return (values[2 * j * width + row] - values[(2 * j + 1) * width + row]) / moved;
+        };
+        std::vector<double> a(n * n), b(n * m), c(p * n), d(p * m);
+        for (std::size_t j = 0; j < variables; ++j) {
+            for (std::size_t r = 0; r < n; ++r) (j < n ? a[r * n + j] : b[r * m + j - n]) = derivative(next, n, r, j);
+            for (std::size_t o = 0; o < p; ++o) (j < n ? c[o * n + j] : d[o * m + j - n]) = derivative(seen, p, o, j);
+        }
+
+        // States an input reaches through A, then those an output sees through A
+        std::vector<std::size_t> kept;
+        if (options.minimal) {
+            std::vector<bool> driven(n, false), observed(n, false);
+            std::vector<std::size_t> stack;
+            for (std::size_t r = 0; r < n; ++r) {
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (b[r * m + i] != 0.0) stack.push_back(r);
+                }
+            }
+            while (!stack.empty()) {
+                auto j = stack.back();
+                stack.pop_back();
+                if (driven[j]) continue;
+                driven[j] = true;
+                for (std::size_t r = 0; r < n; ++r) {
+                    if (a[r * n + j] != 0.0) stack.push_back(r);
+                }
+            }
+            for (std::size_t j = 0; j < n; ++j) {
+                for (std::size_t o = 0; o < p; ++o) {
+                    if (c[o * n + j] != 0.0) stack.push_back(j);
+                }
+            }
+            while (!stack.empty()) {
+                auto r = stack.back();
+                stack.pop_back();
+                if (observed[r]) continue;
+                observed[r] = true;
+                for (std::size_t j = 0; j < n; ++j) {
+                    if (a[r * n + j] != 0.0) stack.push_back(j);
+                }
+            }
+            for (std::size_t j = 0; j < n; ++j) {
+                if (driven[j] && observed[j]) kept.push_back(j);
+            }
+        } else {
+            for (std::size_t j = 0; j < n; ++j) kept.push_back(j);
+        }
+
+        auto k = kept.size();
+        std::vector<std::string> states;
+        std::vector<double> x;
+        result.a.resize(k * k);
+        for (std::size_t r = 0; r < k; ++r) {
+            states.push_back(result.states[kept[r]]);
+            x.push_back(result.x[kept[r]]);
+            for (std::size_t j = 0; j < k; ++j) result.a[r * k + j] = a[kept[r] * n + kept[j]];
+            for (std::size_t i = 0; i < m; ++i) result.b.push_back(b[kept[r] * m + i]);
+        }
+        for (std::size_t o = 0; o < p; ++o) {
+            for (std::size_t j = 0; j < k; ++j) result.c.push_back(c[o * n + kept[j]]);
+        }
+        result.d = std::move(d);
+        result.states = std::move(states);
+        result.x = std::move(x);
+        return result;
+    }
+
+} // namespace oc::lin
@@ -0,0 +1,2116 @@
+//
+// Open Controls - MDL Simulator
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "oc_mdl.hpp"
+#include "oc_codegen.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <thread>
+#include <dlfcn.h>
+#include <link.h>
+#include <unistd.h>
+
+namespace oc::sim {
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Instruction Stream
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // One operation over the signal array. Operands are slot indices; slot 0 always holds 0.0f and
+    // stands in for unconnected ports. Blocks with more than one operation (Sum, Product) become a
+    // chain that accumulates in their output slot.
+    enum class op : std::uint8_t {
+        copy, neg, add, sub, mul, div, gain,
+        clamp, min, max, abs,
+        eq, ne, lt, le, gt, ge,
+        logic_and, logic_or, logic_xor, logic_not,
+        switch_ge, switch_gt, switch_ne, switch_nonzero,
+        sin, cos, tan, asin, acos, atan, sinh, cosh, tanh,
+        sqrt, exp, log, log10, square, pow,
+        integrate,   // out += a * k
+        delay_ring,  // ring buffer of c samples at memory[aux], size d (power of two), head in memory[b]
+        filter,      // direct form II transposed of order c, states at memory[aux], coefficients at coef[d]
+        state_space, // c states at memory[aux], A, B, C, D at coef[d]
+        tf1,         // Tustin first order: u0, x0 at memory[aux], b0_d b1_d a0_d a1_d at coef[d]
+        tf2,         // Tustin second order: u0 u1 x0 x1 at memory[aux], b0_d b1_d b2_d a0_d a1_d a2_d at coef[d]
+        continuous   // out = C x + D u of a continuous TransferFcn: c states at memory[aux], C then D at coef[d]
+    };
+
+    struct instruction {
+        op code = op::copy;
+        std::uint32_t out = 0;
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+        std::uint32_t c = 0;
+        std::uint32_t d = 0;
+        std::uint32_t aux = 0;
+        float k = 0.0f;
+        float k2 = 0.0f;
+    };
+
+    // Where and how the native tier is built
+    struct native_options {
+        std::string cache_dir;                      // compiled systems by content hash; default ~/.cache/open-controls
+        std::string compiler = "c++";               // invoked as <compiler> -std=c++17 -O2 -shared -fPIC
+        bool perf_map = true;                       // append the loaded code to /tmp/perf-<pid>.map for profilers
+        std::string name = "system";                // as the step function appears in the perf map
+    };
+
+    // Step function of a compiled system: signals, memory and coefficients as laid out by the simulator
+    using native_step = void (*)(float*, float*, const float*);
+
+    // Leaves of a bus signal as {dotted field, slot}, in field order; empty for a scalar
+    using bus_slots = std::vector<std::pair<std::string, std::uint32_t>>;
+
+    enum class solver_kind { fixed, ode45 };
+
+    struct sim_options {
+        std::map<std::string, double> calibration;  // parameter values; other config names read 0 as in the generated config
+        std::optional<double> dt;                   // step; else "dt" from the calibration, else 0.001
+
+        // ode45 integrates Integrator and TransferFcn blocks as continuous states with an embedded
+        // Dormand-Prince 5(4) pair; discrete blocks still update every dt
+        solver_kind solver = solver_kind::fixed;
+        double rel_tol = 1e-4;
+        double abs_tol = 1e-6;
+        double max_step = 0.0;                      // 0: dt if the system has discrete blocks, else unlimited
+        double zero_crossing_tol = 1e-9;            // how far past a zero crossing a step may end, in seconds
+    };
+
+    // Work done by the variable-step solver since the last reset
+    struct solver_stats {
+        std::size_t steps = 0;
+        std::size_t rejected = 0;
+        std::size_t evaluations = 0;
+        std::size_t zero_crossings = 0;
+        double last_step = 0.0;
+    };
+
+    // One fixed step from an input to a signal as a discrete linear system over n states:
+    // x[k] = A x[k-1] + B u[k], y[k] = C x[k-1] + D u[k], with A row-major
+    struct linear_model {
+        std::size_t states = 0;
+        std::vector<double> a;
+        std::vector<double> b;
+        std::vector<double> c;
+        double d = 0.0;
+        std::vector<std::string> state_names;  // "Sub/Block" for a slot, "Sub/Block#i" for its memory
+        std::string nonlinear;                 // the block that makes the path nonlinear, if one does
+    };
+
+    // A value one step carries over to the next: a slot read before the step writes it, a memory cell
+    // of a filter or transfer function, or the sample j steps back in a delay ring, found from its head
+    struct state_cell {
+        std::string name;                      // "Sub/Block" for a slot, "Sub/Block#j" for memory
+        bool memory = false;
+        std::uint32_t index = 0;               // slot, memory cell, or the first cell of the ring
+        std::uint32_t head = 0;                // ring: memory cell holding its head
+        std::uint32_t offset = 0;              // ring: cells past the head
+        std::uint32_t mask = 0;                // ring: size - 1; 0 for any other cell
+
+        // Memory cell, given the current value of the ring's head
+        [[nodiscard]] auto locate(float head_value) const -> std::uint32_t {
+            return mask ? index + ((static_cast<std::uint32_t>(head_value) + offset) & mask) : index;
+        }
+    };
+
+    // Everything a run carries from one step to the next, to continue it later or in another process.
+    // simulator::save fills one in place, so a snapshot kept between saves allocates only once.
+    struct snapshot {
+        std::uint64_t system = 0;              // simulator::fingerprint of the system that saved it
+        long long steps = 0;
+        std::vector<float> signals;            // inputs included
+        std::vector<float> memory;
+
+        // Variable-step solver
+        double time = 0.0;
+        double step = 0.0;                     // the step size it would try next
+        long long hits = 0;
+        std::vector<double> x;
+        solver_stats stats;
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Simulator
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Runs one system of a model without generating code. The system is compiled once: every
+    // subsystem is inlined at its place in the parent's execution order, each block output gets a
+    // slot in one contiguous float array (a delay or integrator output is its state slot, updated
+    // in place exactly as the generated code updates its state field), and the blocks become a flat
+    // instruction stream that step() runs top to bottom. Block semantics follow generate_block_code.
+    // Buses are lowered to their leaves, as in the generated code.
+    class simulator {
+    public:
+        simulator(const mdl::model& model, const mdl::system& sys, sim_options options = {})
+            : model_(&model), options_(std::move(options)) {
+            values_ = options_.calibration;
+            dt_ = options_.dt.value_or(values_.contains("dt") ? values_["dt"] : 0.001);
+            values_["dt"] = dt_;
+
+            signals_.push_back(0.0f);
+
+            // A bus port is one input or output per leaf, named <port>.<field>
+            std::vector<std::uint32_t> input_slots;
+            std::vector<bus_slots> input_buses;
+            for (const auto& blk : sorted_ports(sys.inports())) {
+                auto name = codegen::sanitize_name(blk.name);
+                auto& leaves = input_buses.emplace_back();
+                for (const auto& field : bus_fields(sys, blk.sid + "#out:1", 0)) {
+                    leaves.emplace_back(field, allocate());
+                    inputs_.push_back(name + "." + field);
+                }
+                input_slots.push_back(leaves.empty() ? allocate() : 0);
+                if (leaves.empty()) inputs_.push_back(name);
+            }
+            variable_step_ = options_.solver == solver_kind::ode45;
+            std::vector<bus_slots> output_buses;
+            auto output_slots = compile_system(sys, input_slots, "", 0, input_buses, &output_buses);
+            auto outports = sorted_ports(sys.outports());
+            for (std::size_t i = 0; i < outports.size(); ++i) {
+                auto name = codegen::sanitize_name(outports[i].name);
+                if (output_buses[i].empty()) {
+                    outputs_.push_back(name);
+                    output_slots_.push_back(output_slots[i]);
+                }
+                for (const auto& [field, slot] : output_buses[i]) {
+                    outputs_.push_back(name + "." + field);
+                    output_slots_.push_back(slot);
+                }
+            }
+            if (variable_step_) prepare_solver();
+
+            initial_signals_ = signals_;
+            initial_memory_ = memory_;
+            fingerprint_ = fingerprint();
+        }
+
+        // Back to the state at time zero, inputs included
+        void reset() {
+            signals_ = initial_signals_;
+            memory_ = initial_memory_;
+            steps_ = 0;
+            if (variable_step_) reset_solver();
+        }
+
+        ~simulator() {
+            if (compiler_.joinable()) compiler_.join();
+            if (library_) dlclose(library_);
+        }
+        simulator(const simulator&) = delete;
+        auto operator=(const simulator&) -> simulator& = delete;
+
+        // One time step: the native code once it is loaded, the instruction stream until then; with
+        // the variable-step solver, as many solver steps as it takes to advance by dt
+        void step() {
+            if (variable_step_) {
+                auto until = static_cast<double>(steps_ + 1) * dt_;
+                while (solver_step(until)) {}
+            } else if (auto native = native_.load(std::memory_order_acquire)) {
+                if (native_since_ < 0) native_since_ = steps_;
+                native(signals_.data(), memory_.data(), coef_.data());
+            } else {
+                interpret(program_);
+            }
+            ++steps_;
+        }
+
+        // Build the instruction stream as native code on a background thread: generate C++ over the same
+        // signal and memory arrays, compile it into a shared library cached by the hash of its source,
+        // and load it. step() switches over at the next step, with nothing to migrate.
+        void start_native(native_options options = {}) {
+            if (compiler_.joinable() || native_done_.load(std::memory_order_acquire)) return;
+            if (variable_step_) {
+                native_status_ = "not available with the variable-step solver";
+                native_done_.store(true, std::memory_order_release);
+                return;
+            }
+            compiler_ = std::thread([this, options = std::move(options)] { build_native(options); });
+        }
+
+        // Block until the background build has finished; false if it failed or never started
+        auto wait_native() -> bool {
+            if (compiler_.joinable()) compiler_.join();
+            return native_.load(std::memory_order_acquire) != nullptr;
+        }
+
+        // Step at which the native code took over, or -1
+        [[nodiscard]] auto native_since() const -> long long { return native_since_; }
+        // What the background build did, once it has finished
+        [[nodiscard]] auto native_status() const -> std::string {
+            return native_done_.load(std::memory_order_acquire) ? native_status_ : std::string("building");
+        }
+        [[nodiscard]] auto native_build_seconds() const -> double { return native_seconds_; }
+
+        // C++ source of the instruction stream, one statement per instruction with its operands as literals.
+        // It is not the generator's _update: the library's generated headers still fail to compile where
+        // Fcn text is copied verbatim (MATLAB vectors, j, ^, and workspace names such as VllRated that
+        // never become config fields), where std::max/std::clamp get float and int or double arguments,
+        // where a second Complex to Real-Imag or Demux output is read but never declared, and where a
+        // parent embeds <component>_state for a component that has no state.
+        [[nodiscard]] auto native_source(std::string_view symbol = "oc_sim_step") const -> std::string {
+            std::string code = "// Generated by mdl_sim from the instruction stream of one system\n"
+                               "#include <algorithm>\n#include <cmath>\n#include <limits>\n\n";
+            code += "extern \"C\" void " + std::string(symbol) + "(float* s, float* m, const float* coef) {\n";
+            code += "    (void)m;\n    (void)coef;\n";
+            for (const auto& in : program_) code += "    " + native_statement(in) + "\n";
+            code += "}\n";
+            return code;
+        }
+
+        // Inports and outports of the simulated system, in port order
+        [[nodiscard]] auto inputs() const -> const std::vector<std::string>& { return inputs_; }
+        [[nodiscard]] auto outputs() const -> const std::vector<std::string>& { return outputs_; }
+        void set_input(std::size_t index, float value) {
+            signals_[index + 1] = value;
+            fsal_ = false;
+        }
+        [[nodiscard]] auto input(std::size_t index) const -> float { return signals_[index + 1]; }
+        [[nodiscard]] auto output(std::size_t index) const -> float { return signals_[output_slots_[index]]; }
+        [[nodiscard]] auto output_slot(std::size_t index) const -> std::uint32_t { return output_slots_[index]; }
+
+        // Slot of a block output by its path below the simulated system, e.g. "Sub/Block" or "Sub/Block:2"
+        [[nodiscard]] auto find_signal(std::string_view path) const -> std::optional<std::uint32_t> {
+            auto name = std::string(path);
+            if (name.find(':') == std::string::npos) name += ":1";
+            if (auto it = paths_.find(name); it != paths_.end()) return it->second;
+            return std::nullopt;
+        }
+        [[nodiscard]] auto signal(std::uint32_t slot) const -> float { return signals_[slot]; }
+
+        [[nodiscard]] auto dt() const -> double { return dt_; }
+        [[nodiscard]] auto block_count() const -> std::size_t { return blocks_; }
+        [[nodiscard]] auto instruction_count() const -> std::size_t { return program_.size(); }
+        [[nodiscard]] auto signal_count() const -> std::size_t { return signals_.size(); }
+
+        // Blocks run as a pass-through, cycles left unscheduled and config names read as 0
+        [[nodiscard]] auto warnings() const -> const std::vector<std::string>& { return warnings_; }
+
+        // One accepted step of the variable-step solver. It ends at `until` at the latest, on the next
+        // sample hit of the discrete blocks, or just past the first zero crossing of a Switch,
+        // RelationalOperator or Saturate threshold; false once the solver has reached `until`.
+        // Within a step those blocks keep the branch they took at its start and discrete blocks
+        // hold their outputs, so every stage sees a smooth system.
+        auto solver_step(double until) -> bool {
+            if (!variable_step_ || until - t_ <= 1e-12 * std::max(1.0, std::abs(until))) return false;
+            constexpr double inf = std::numeric_limits<double>::infinity();
+            double limit = options_.max_step > 0 ? options_.max_step : discrete_ ? dt_ : inf;
+            double next_hit = discrete_ ? static_cast<double>(hits_ + 1) * dt_ : inf;
+            if (h_ <= 0.0) h_ = std::min(dt_, limit);
+            if (!fsal_) begin_step();
+
+            auto n = x_.size();
+            double proposed = h_;
+            for (int attempt = 0;; ++attempt) {
+                double end = std::min({until, next_hit, t_ + std::min(h_, limit)});
+                if (next_hit - end <= 1e-9 * dt_) end = next_hit;
+                double h = end - t_;
+
+                // The seventh stage is evaluated at the fifth-order solution, which leaves x_next_
+                // and the signals at the end of the step
+                for (std::size_t i = 1; i < 7; ++i) {
+                    for (std::size_t j = 0; j < n; ++j) {
+                        double sum = 0.0;
+                        for (std::size_t l = 0; l < i; ++l) sum += dormand_prince_a[i][l] * stage_[l][j];
+                        x_next_[j] = x_[j] + h * sum;
+                    }
+                    evaluate(x_next_, stage_[i], locked_program_);
+                }
+                double error = 0.0;
+                for (std::size_t j = 0; j < n; ++j) {
+                    double e = 0.0;
+                    for (std::size_t l = 0; l < 7; ++l) e += dormand_prince_e[l] * stage_[l][j];
+                    auto scale = options_.abs_tol + options_.rel_tol * std::max(std::abs(x_[j]), std::abs(x_next_[j]));
+                    error = std::max(error, std::abs(h * e) / scale);
+                }
+                double factor = error == 0.0 ? 5.0 : std::clamp(0.9 * std::pow(error, -0.2), 0.2, 5.0);
+
+                bool floor = h <= 1e-12 * std::max(1.0, std::abs(t_));
+                if (error > 1.0 && !floor) {
+                    ++stats_.rejected;
+                    h_ = h * factor;
+                    continue;
+                }
+                if (error > 1.0) warn("step size underflow at t = " + std::to_string(t_) + ", tolerances not met");
+
+                // A threshold crossed well inside the step: retry with the step ending just past it
+                crossing_values(g_end_);
+                bool crossed = false;
+                double theta = 1.0;
+                for (std::size_t i = 0; i < g_end_.size(); ++i) {
+                    auto side = [&](double g) { return crossings_[i].strict ? g > 0.0 : g >= 0.0; };
+                    if (side(g_start_[i]) == side(g_end_[i])) continue;
+                    crossed = true;
+                    theta = std::min(theta, g_start_[i] / (g_start_[i] - g_end_[i]));
+                }
+                if (crossed && h * (1.0 - theta) > options_.zero_crossing_tol && attempt < max_crossing_attempts_) {
+                    ++stats_.rejected;
+                    h_ = theta * h + 0.5 * options_.zero_crossing_tol;
+                    continue;
+                }
+
+                x_.swap(x_next_);
+                stage_[0].swap(stage_[6]);
+                g_start_.swap(g_end_);
+                t_ = end;
+                h_ = crossed ? proposed : h < h_ ? std::max(h_, h * factor) : h * factor;
+                ++stats_.steps;
+                stats_.last_step = h;
+
+                if (end == next_hit) {
+                    // Discrete blocks update on the real arrays, which also changes what the next step starts from
+                    ++hits_;
+                    t_ = static_cast<double>(hits_) * dt_;
+                    interpret(program_);
+                    fsal_ = false;
+                }
+                if (crossed) {
+                    ++stats_.zero_crossings;
+                    if (fsal_) begin_step();
+                }
+                return true;
+            }
+        }
+
+        // One step as a linear system from an input to a signal slot, read off the instruction stream by
+        // running it over linear forms in the input and the value each slot and memory cell held after
+        // the previous step. Constants and the other inputs are fixed and drop out, and a Product with a
+        // Constant is a gain. Only states both driven by the input and seen by the output are kept; any
+        // other instruction that reads a varying signal makes the path nonlinear.
+        [[nodiscard]] auto linear_path(std::size_t input, std::uint32_t output) const -> linear_model {
+            linear_model model;
+            if (variable_step_) {
+                model.nonlinear = "the variable-step solver";
+                return model;
+            }
+
+            // Cells are the signal slots, then memory, then a shift register for each delay ring
+            auto slots = signals_.size();
+            auto cells = slots + memory_.size();
+            std::vector<std::size_t> rings(program_.size(), 0);
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                if (program_[i].code != op::delay_ring) continue;
+                rings[i] = cells;
+                cells += program_[i].c - 1;
+            }
+            std::vector<bool> written(slots, false);
+            for (const auto& in : program_) written[in.out] = true;
+            auto fixed = [&](std::uint32_t slot) { return !written[slot] && (slot == 0 || slot > inputs_.size()); };
+
+            // k[0] weighs the input, k[1 + cell] the cell's value after the previous step
+            struct form {
+                std::map<std::size_t, double> k;
+                std::optional<std::size_t> nonlinear;  // instruction whose result is no linear form
+            };
+            const form zero;
+            std::vector<form> value(cells);
+            for (std::size_t cell = 0; cell < cells; ++cell) {
+                if (cell >= slots || written[cell]) value[cell].k[cell + 1] = 1.0;
+            }
+            if (input + 1 < slots && input < inputs_.size()) value[input + 1].k[0] = 1.0;
+
+            auto varies = [](const form& f) { return f.nonlinear || !f.k.empty(); };
+            auto sum = [](std::initializer_list<std::pair<const form*, double>> terms) {
+                form result;
+                for (auto [f, weight] : terms) {
+                    if (f->nonlinear && !result.nonlinear) result.nonlinear = f->nonlinear;
+                    for (auto [index, k] : f->k) {
+                        if (auto& v = result.k[index]; (v += weight * k) == 0.0) result.k.erase(index);
+                    }
+                }
+                return result;
+            };
+            auto weight = [](const form& f, std::size_t index) {
+                auto it = f.k.find(index);
+                return it == f.k.end() ? 0.0 : it->second;
+            };
+            auto cell_of = [&](std::uint32_t memory) -> form& { return value[slots + memory]; };
+
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                const auto& in = program_[i];
+                const auto* coef = coef_.data() + in.d;
+                const auto& a = value[in.a];
+                const auto& b = value[in.b];
+                form result;
+                switch (in.code) {
+                    case op::copy: result = a; break;
+                    case op::neg: result = sum({{&a, -1.0}}); break;
+                    case op::add: result = sum({{&a, 1.0}, {&b, 1.0}}); break;
+                    case op::sub: result = sum({{&a, 1.0}, {&b, -1.0}}); break;
+                    case op::gain: result = sum({{&a, in.k}}); break;
+                    case op::integrate: result = sum({{&value[in.out], 1.0}, {&a, in.k}}); break;
+                    case op::mul:
+                    case op::div:
+                        if (fixed(in.b)) {
+                            float k = initial_signals_[in.b];
+                            result = sum({{&a, in.code == op::mul ? k : 1.0 / k}});
+                        } else if (in.code == op::mul && fixed(in.a)) {
+                            result = sum({{&b, initial_signals_[in.a]}});
+                        } else {
+                            result = varies(a) || varies(b) ? form{{}, i} : zero;
+                        }
+                        break;
+                    case op::filter: {
+                        const auto* den = coef + in.c + 1;
+                        auto u = a;
+                        auto y = in.c > 0 ? sum({{&u, coef[0]}, {&cell_of(in.aux), 1.0}}) : sum({{&u, coef[0]}});
+                        for (std::uint32_t j = 0; j < in.c; ++j) {
+                            const auto& next = j + 1 < in.c ? cell_of(in.aux + j + 1) : zero;
+                            cell_of(in.aux + j) = sum({{&u, coef[j + 1]}, {&next, 1.0}, {&y, -den[j]}});
+                        }
+                        result = y;
+                        break;
+                    }
+                    case op::state_space: {
+                        auto n = in.c;
+                        const auto* sa = coef;
+                        const auto* sb = sa + n * n;
+                        const auto* sc = sb + n;
+                        auto u = a;
+                        std::vector<form> x;
+                        for (std::uint32_t j = 0; j < n; ++j) x.push_back(cell_of(in.aux + j));
+                        result = sum({{&u, sc[n]}});
+                        for (std::uint32_t j = 0; j < n; ++j) result = sum({{&result, 1.0}, {&x[j], sc[j]}});
+                        for (std::uint32_t r = 0; r < n; ++r) {
+                            auto next = sum({{&u, sb[r]}});
+                            for (std::uint32_t j = 0; j < n; ++j) next = sum({{&next, 1.0}, {&x[j], sa[r * n + j]}});
+                            cell_of(in.aux + r) = next;
+                        }
+                        break;
+                    }
+                    case op::tf1: {
+                        auto u = a;
+                        result = sum({{&u, coef[0] / coef[2]}, {&cell_of(in.aux), coef[1] / coef[2]}, {&cell_of(in.aux + 1), -coef[3] / coef[2]}});
+                        cell_of(in.aux) = u;
+                        cell_of(in.aux + 1) = result;
+                        break;
+                    }
+                    case op::tf2: {
+                        auto u = a;
+                        auto z0 = cell_of(in.aux);
+                        auto z2 = cell_of(in.aux + 2);
+                        result = sum({{&u, coef[0] / coef[3]}, {&z0, coef[1] / coef[3]}, {&cell_of(in.aux + 1), coef[2] / coef[3]},
+                                      {&z2, -coef[4] / coef[3]}, {&cell_of(in.aux + 3), -coef[5] / coef[3]}});
+                        cell_of(in.aux + 1) = z0;
+                        cell_of(in.aux) = u;
+                        cell_of(in.aux + 3) = z2;
+                        cell_of(in.aux + 2) = result;
+                        break;
+                    }
+                    case op::delay_ring: {
+                        // The output is the input of c - 1 steps ago
+                        auto* ring = value.data() + rings[i];
+                        result = ring[in.c - 2];
+                        for (auto j = in.c - 2; j > 0; --j) ring[j] = ring[j - 1];
+                        ring[0] = a;
+                        break;
+                    }
+                    default: {
+                        auto operands = slot_operands(in.code);
+                        bool moving = varies(a) || (operands > 1 && varies(b)) || (operands > 2 && varies(value[in.c]));
+                        if (in.code == op::continuous) moving = true;
+                        result = moving ? form{{}, i} : zero;
+                        break;
+                    }
+                }
+                value[in.out] = std::move(result);
+            }
+
+            // Names of the cells, for the states kept and the block a nonlinear result comes from
+            auto names = slot_names();
+            names.resize(cells);
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                const auto& in = program_[i];
+                std::size_t first = slots + in.aux, count = 0;
+                switch (in.code) {
+                    case op::filter: case op::state_space: count = in.c; break;
+                    case op::tf1: count = 2; break;
+                    case op::tf2: count = 4; break;
+                    case op::delay_ring: first = rings[i]; count = in.c - 1; break;
+                    default: break;
+                }
+                for (std::size_t j = 0; j < count; ++j) names[first + j] = names[in.out] + "#" + std::to_string(j);
+            }
+
+            const auto& y = value[output];
+            if (y.nonlinear) {
+                model.nonlinear = names[program_[*y.nonlinear].out];
+                return model;
+            }
+            // States the input reaches, then those the output sees; a nonlinear cell counts as driven
+            std::vector<std::vector<std::size_t>> readers(cells);
+            for (std::size_t cell = 0; cell < cells; ++cell) {
+                for (auto [index, k] : value[cell].k) {
+                    if (index > 0) readers[index - 1].push_back(cell);
+                }
+            }
+            std::vector<bool> driven(cells, false), seen(cells, false);
+            std::vector<std::size_t> stack;
+            for (std::size_t cell = 0; cell < cells; ++cell) {
+                if (value[cell].k.contains(0) || value[cell].nonlinear) stack.push_back(cell);
+            }
+            while (!stack.empty()) {
+                auto j = stack.back();
+                stack.pop_back();
+                if (driven[j]) continue;
+                driven[j] = true;
+                for (auto cell : readers[j]) stack.push_back(cell);
+            }
+            for (auto [index, k] : y.k) {
+                if (index > 0) stack.push_back(index - 1);
+            }
+            while (!stack.empty()) {
+                auto cell = stack.back();
+                stack.pop_back();
+                if (seen[cell]) continue;
+                seen[cell] = true;
+                if (value[cell].nonlinear && driven[cell]) {
+                    model.nonlinear = names[program_[*value[cell].nonlinear].out];
+                    return model;
+                }
+                for (auto [index, k] : value[cell].k) {
+                    if (index > 0) stack.push_back(index - 1);
+                }
+            }
+
+            std::vector<std::size_t> kept;
+            for (std::size_t cell = 0; cell < cells; ++cell) {
+                if (driven[cell] && seen[cell]) kept.push_back(cell);
+            }
+            auto n = kept.size();
+            model.states = n;
+            model.a.resize(n * n);
+            for (std::size_t r = 0; r < n; ++r) {
+                for (std::size_t j = 0; j < n; ++j) model.a[r * n + j] = weight(value[kept[r]], kept[j] + 1);
+                model.b.push_back(weight(value[kept[r]], 0));
+                model.c.push_back(weight(y, kept[r] + 1));
+                model.state_names.push_back(names[kept[r]]);
+            }
+            model.d = weight(y, 0);
+            return model;
+        }
+
+        // Every value the next step reads from this one, in program order: state slots, then the
+        // memory of each instruction. A delay ring contributes its c - 1 samples still to be read.
+        [[nodiscard]] auto state_cells() const -> std::vector<state_cell> {
+            auto names = slot_names();
+            std::vector<state_cell> cells;
+            std::vector<bool> written(signals_.size(), false), updated(signals_.size(), false), carried(signals_.size(), false);
+            for (const auto& in : program_) written[in.out] = true;
+            for (const auto& in : program_) {
+                std::uint32_t reads[] = {in.a, in.b, in.c, in.out};
+                auto operands = slot_operands(in.code);
+                for (int j = 0; j < 4; ++j) {
+                    if (j < 3 && j >= operands) continue;
+                    if (j == 3 && in.code != op::integrate) continue;
+                    auto slot = reads[j];
+                    if (written[slot] && !updated[slot] && !carried[slot]) {
+                        carried[slot] = true;
+                        cells.push_back({.name = names[slot], .index = slot});
+                    }
+                }
+                updated[in.out] = true;
+            }
+            for (const auto& in : program_) {
+                std::uint32_t count = 0;
+                switch (in.code) {
+                    case op::filter: case op::state_space: case op::continuous: count = in.c; break;
+                    case op::tf1: count = 2; break;
+                    case op::tf2: count = 4; break;
+                    case op::delay_ring:
+                        // Before a step the newest sample is c - 1 cells past the head
+                        for (std::uint32_t j = 0; j + 1 < in.c; ++j) {
+                            cells.push_back({.name = names[in.out] + "#" + std::to_string(j), .memory = true, .index = in.aux,
+                                             .head = in.b, .offset = in.c - 1 - j, .mask = in.d - 1});
+                        }
+                        break;
+                    default: break;
+                }
+                for (std::uint32_t j = 0; j < count; ++j) {
+                    cells.push_back({.name = names[in.out] + "#" + std::to_string(j), .memory = true, .index = in.aux + j});
+                }
+            }
+            return cells;
+        }
+        [[nodiscard]] auto state_value(const state_cell& cell) const -> float {
+            return cell.memory ? memory_[cell.locate(memory_[cell.head])] : signals_[cell.index];
+        }
+        void set_state_value(const state_cell& cell, float value) {
+            (cell.memory ? memory_[cell.locate(memory_[cell.head])] : signals_[cell.index]) = value;
+            fsal_ = false;
+        }
+
+        // Identifies the compiled system: instructions, coefficients, array sizes, dt and solver. A
+        // snapshot restores only into a simulator with the same fingerprint.
+        [[nodiscard]] auto fingerprint() const -> std::uint64_t {
+            std::uint64_t hash = 14695981039346656037ull;
+            auto mix = [&](const auto& value) {
+                unsigned char bytes[sizeof(value)];
+                std::memcpy(bytes, &value, sizeof(value));
+                for (auto b : bytes) hash = (hash ^ b) * 1099511628211ull;
+            };
+            mix(dt_);
+            mix(variable_step_);
+            mix(signals_.size());
+            mix(memory_.size());
+            for (const auto& in : program_) {
+                mix(in.code), mix(in.out), mix(in.a), mix(in.b), mix(in.c), mix(in.d), mix(in.aux), mix(in.k), mix(in.k2);
+            }
+            for (auto v : coef_) mix(v);
+            return hash;
+        }
+        [[nodiscard]] auto step_count() const -> long long { return steps_; }
+
+        void save(snapshot& into) const {
+            into.system = fingerprint_;
+            into.steps = steps_;
+            into.signals.assign(signals_.begin(), signals_.end());
+            into.memory.assign(memory_.begin(), memory_.end());
+            into.time = t_;
+            into.step = h_;
+            into.hits = hits_;
+            into.x.assign(x_.begin(), x_.end());
+            into.stats = stats_;
+        }
+
+        // False, leaving the simulator as it was, if the snapshot is of another system
+        auto restore(const snapshot& from) -> bool {
+            if (from.system != fingerprint_ || from.signals.size() != signals_.size() || from.memory.size() != memory_.size() ||
+                from.x.size() != x_.size()) {
+                return false;
+            }
+            steps_ = from.steps;
+            std::ranges::copy(from.signals, signals_.begin());
+            std::ranges::copy(from.memory, memory_.begin());
+            t_ = from.time;
+            h_ = from.step;
+            hits_ = from.hits;
+            std::ranges::copy(from.x, x_.begin());
+            stats_ = from.stats;
+            fsal_ = false;
+            return true;
+        }
+
+        // Simulated time of the variable-step solver
+        [[nodiscard]] auto time() const -> double { return t_; }
+        [[nodiscard]] auto stats() const -> const solver_stats& { return stats_; }
+        [[nodiscard]] auto continuous_states() const -> std::size_t { return x_.size(); }
+
+    private:
+        friend class batch;
+        friend class cosimulator;
+
+        // Empty signal space for systems compiled one after another
+        explicit simulator(sim_options options) : model_(nullptr), options_(std::move(options)) {
+            signals_.push_back(0.0f);
+        }
+
+        const mdl::model* model_;
+        sim_options options_;
+        std::map<std::string, double> values_;  // calibration, dt and defaulted config names
+        double dt_ = 0.001;
+
+        std::vector<instruction> program_;
+        std::vector<float> signals_;
+        std::vector<float> memory_;             // filter states, delay rings and their heads
+        std::vector<float> coef_;
+        std::vector<float> scratch_;
+        std::vector<float> initial_signals_;
+        std::vector<float> initial_memory_;
+
+        std::map<std::string, std::uint32_t> paths_;  // "Sub/Block:port" -> slot
+        std::vector<std::string> inputs_;
+        std::vector<std::string> outputs_;
+        std::vector<std::uint32_t> output_slots_;
+        std::size_t blocks_ = 0;
+        long long steps_ = 0;
+        std::uint64_t fingerprint_ = 0;
+        std::vector<std::string> warnings_;
+        std::set<std::string> warned_;
+
+        static constexpr int max_depth_ = 16;
+
+        // Native tier, written by the build thread before native_ or native_done_ is published
+        std::thread compiler_;
+        std::atomic<native_step> native_{nullptr};
+        std::atomic<bool> native_done_{false};
+        std::string native_status_;
+        double native_seconds_ = 0.0;
+        void* library_ = nullptr;
+        long long native_since_ = -1;
+
+        // Variable-step solver. Continuous states live in x_ as doubles and are stored into their
+        // slots (Integrator) or memory (TransferFcn) as floats before each evaluation.
+        struct continuous_block {
+            std::uint32_t u = 0;      // input slot
+            std::uint32_t state = 0;  // Integrator: its output slot; TransferFcn: its states in memory
+            std::uint32_t order = 0;  // 0 for an Integrator
+            std::uint32_t coef = 0;   // TransferFcn: C, D, then the denominator as x_n' = u - sum(den_j x_j)
+            std::uint32_t x = 0;      // first entry in x_
+        };
+        struct zero_crossing {
+            std::uint32_t a = 0;      // the block changes branch where s[a] - s[b] - k changes sign
+            std::uint32_t b = 0;
+            float k = 0.0f;
+            bool strict = false;      // zero counts as negative, as for u > k
+        };
+
+        static constexpr int max_crossing_attempts_ = 16;
+        static constexpr double dormand_prince_a[7][6] = {
+            {},
+            {1.0 / 5},
+            {3.0 / 40, 9.0 / 40},
+            {44.0 / 45, -56.0 / 15, 32.0 / 9},
+            {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+            {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656},
+            {35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84},
+        };
+        // Fifth- minus fourth-order weights
+        static constexpr double dormand_prince_e[7] = {
+            71.0 / 57600, 0.0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200, 22.0 / 525, -1.0 / 40
+        };
+
+        bool variable_step_ = false;
+        bool discrete_ = false;                 // blocks that update at every dt
+        std::vector<continuous_block> continuous_;
+        std::vector<std::uint32_t> held_;       // discrete state slots, which change only at sample hits
+        std::vector<zero_crossing> crossings_;
+        std::vector<std::size_t> mode_ops_;     // Switch, RelationalOperator and Saturate instructions
+        std::vector<instruction> held_program_;    // discrete updates as no-ops, so their outputs hold
+        std::vector<instruction> locked_program_;  // and the mode instructions fixed to their branch
+        std::vector<double> x_;
+        std::vector<double> initial_x_;
+        std::vector<double> x_next_;
+        std::array<std::vector<double>, 7> stage_;
+        std::vector<double> g_start_;
+        std::vector<double> g_end_;
+        double t_ = 0.0;
+        double h_ = 0.0;
+        long long hits_ = 0;
+        bool fsal_ = false;                     // stage_[0] and locked_program_ are those of x_
+        solver_stats stats_;
+
+        // State vector, zero-crossing functions, the programs run between sample hits and whether
+        // there are sample hits at all
+        void prepare_solver() {
+            for (auto& blk : continuous_) {
+                blk.x = static_cast<std::uint32_t>(initial_x_.size());
+                if (blk.order == 0) initial_x_.push_back(signals_[blk.state]);
+                for (std::uint32_t j = 0; j < blk.order; ++j) initial_x_.push_back(memory_[blk.state + j]);
+            }
+            discrete_ = !held_.empty();
+            held_program_ = program_;
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                const auto& in = program_[i];
+                auto mode = [&](zero_crossing crossing) {
+                    crossings_.push_back(crossing);
+                    if (mode_ops_.empty() || mode_ops_.back() != i) mode_ops_.push_back(i);
+                };
+                switch (in.code) {
+                    case op::switch_ge: mode({in.b, 0, in.k, false}); break;
+                    case op::switch_gt: case op::switch_ne: mode({in.b, 0, in.k, true}); break;
+                    case op::switch_nonzero: mode({in.b, 0, 0.0f, true}); break;
+                    case op::lt: case op::ge: mode({in.a, in.b, 0.0f, false}); break;
+                    case op::le: case op::gt: mode({in.a, in.b, 0.0f, true}); break;
+                    case op::clamp:
+                        mode({in.a, 0, in.k, false});
+                        mode({in.a, 0, in.k2, true});
+                        break;
+                    case op::integrate: case op::delay_ring: case op::filter: case op::state_space: case op::tf1: case op::tf2:
+                        discrete_ = true;
+                        held_program_[i] = {.code = op::copy, .out = in.out, .a = in.out};
+                        break;
+                    default:
+                        if (std::ranges::find(held_, in.out) != held_.end()) held_program_[i] = {.code = op::copy, .out = in.out, .a = in.out};
+                        break;
+                }
+            }
+            locked_program_ = held_program_;
+            x_next_.resize(initial_x_.size());
+            for (auto& k : stage_) k.resize(initial_x_.size());
+            g_start_.resize(crossings_.size());
+            g_end_.resize(crossings_.size());
+            reset_solver();
+        }
+
+        void reset_solver() {
+            x_ = initial_x_;
+            t_ = 0.0;
+            h_ = 0.0;
+            hits_ = 0;
+            fsal_ = false;
+            stats_ = {};
+        }
+
+        // Signals and derivatives at x_ with the blocks free to switch, then their branches locked for the step
+        void begin_step() {
+            evaluate(x_, stage_[0], held_program_);
+            crossing_values(g_start_);
+            const auto* s = signals_.data();
+            for (auto i : mode_ops_) {
+                const auto& in = held_program_[i];
+                auto constant = [&](float value) -> instruction { return {.code = op::clamp, .out = in.out, .k = value, .k2 = value}; };
+                auto pick = [&](bool first) -> instruction { return {.code = op::copy, .out = in.out, .a = first ? in.a : in.c}; };
+                auto& locked = locked_program_[i];
+                switch (in.code) {
+                    case op::switch_ge: locked = pick(s[in.b] >= in.k); break;
+                    case op::switch_gt: locked = pick(s[in.b] > in.k); break;
+                    case op::switch_ne: locked = pick(s[in.b] != in.k); break;
+                    case op::switch_nonzero: locked = pick(s[in.b] != 0.0f); break;
+                    case op::clamp:
+                        locked = s[in.a] < in.k ? constant(in.k) : s[in.a] > in.k2 ? constant(in.k2) :
+                                 instruction{.code = op::copy, .out = in.out, .a = in.a};
+                        break;
+                    default: locked = constant(s[in.out]); break;
+                }
+            }
+            fsal_ = true;
+        }
+
+        // Derivatives at x, computed in place: between sample hits the stream only moves continuous signals
+        void evaluate(const std::vector<double>& x, std::vector<double>& dx, std::span<const instruction> program) {
+            auto* s = signals_.data();
+            for (const auto& blk : continuous_) {
+                if (blk.order == 0) s[blk.state] = static_cast<float>(x[blk.x]);
+                for (std::uint32_t j = 0; j < blk.order; ++j) memory_[blk.state + j] = static_cast<float>(x[blk.x + j]);
+            }
+            interpret(program);
+            for (const auto& blk : continuous_) {
+                if (blk.order == 0) {
+                    dx[blk.x] = s[blk.u];
+                    continue;
+                }
+                const auto* den = coef_.data() + blk.coef + blk.order + 1;
+                double last = s[blk.u];
+                for (std::uint32_t j = 0; j < blk.order; ++j) {
+                    if (j + 1 < blk.order) dx[blk.x + j] = x[blk.x + j + 1];
+                    last -= den[j] * x[blk.x + j];
+                }
+                dx[blk.x + blk.order - 1] = last;
+            }
+            ++stats_.evaluations;
+        }
+
+        void crossing_values(std::vector<double>& g) const {
+            const auto* s = signals_.data();
+            for (std::size_t i = 0; i < crossings_.size(); ++i) {
+                g[i] = static_cast<double>(s[crossings_[i].a]) - s[crossings_[i].b] - crossings_[i].k;
+            }
+        }
+
+        void interpret(std::span<const instruction> program) { interpret(program, signals_.data(), memory_.data()); }
+
+        void interpret(std::span<const instruction> program, float* s, float* m) {
+            const auto* coef = coef_.data();
+            for (const auto& in : program) {
+                switch (in.code) {
+                    case op::copy: s[in.out] = s[in.a]; break;
+                    case op::neg: s[in.out] = -s[in.a]; break;
+                    case op::add: s[in.out] = s[in.a] + s[in.b]; break;
+                    case op::sub: s[in.out] = s[in.a] - s[in.b]; break;
+                    case op::mul: s[in.out] = s[in.a] * s[in.b]; break;
+                    case op::div: s[in.out] = s[in.a] / s[in.b]; break;
+                    case op::gain: s[in.out] = s[in.a] * in.k; break;
+                    case op::clamp: s[in.out] = std::clamp(s[in.a], in.k, in.k2); break;
+                    case op::min: s[in.out] = std::min(s[in.a], s[in.b]); break;
+                    case op::max: s[in.out] = std::max(s[in.a], s[in.b]); break;
+                    case op::abs: s[in.out] = std::abs(s[in.a]); break;
+                    case op::eq: s[in.out] = s[in.a] == s[in.b] ? 1.0f : 0.0f; break;
+                    case op::ne: s[in.out] = s[in.a] != s[in.b] ? 1.0f : 0.0f; break;
+                    case op::lt: s[in.out] = s[in.a] < s[in.b] ? 1.0f : 0.0f; break;
+                    case op::le: s[in.out] = s[in.a] <= s[in.b] ? 1.0f : 0.0f; break;
+                    case op::gt: s[in.out] = s[in.a] > s[in.b] ? 1.0f : 0.0f; break;
+                    case op::ge: s[in.out] = s[in.a] >= s[in.b] ? 1.0f : 0.0f; break;
+                    case op::logic_and: s[in.out] = (s[in.a] != 0.0f && s[in.b] != 0.0f) ? 1.0f : 0.0f; break;
+                    case op::logic_or: s[in.out] = (s[in.a] != 0.0f || s[in.b] != 0.0f) ? 1.0f : 0.0f; break;
+                    case op::logic_xor: s[in.out] = ((s[in.a] != 0.0f) != (s[in.b] != 0.0f)) ? 1.0f : 0.0f; break;
+                    case op::logic_not: s[in.out] = s[in.a] == 0.0f ? 1.0f : 0.0f; break;
+                    case op::switch_ge: s[in.out] = s[in.b] >= in.k ? s[in.a] : s[in.c]; break;
+                    case op::switch_gt: s[in.out] = s[in.b] > in.k ? s[in.a] : s[in.c]; break;
+                    case op::switch_ne: s[in.out] = s[in.b] != in.k ? s[in.a] : s[in.c]; break;
+                    case op::switch_nonzero: s[in.out] = s[in.b] != 0.0f ? s[in.a] : s[in.c]; break;
+                    case op::sin: s[in.out] = std::sin(s[in.a]); break;
+                    case op::cos: s[in.out] = std::cos(s[in.a]); break;
+                    case op::tan: s[in.out] = std::tan(s[in.a]); break;
+                    case op::asin: s[in.out] = std::asin(s[in.a]); break;
+                    case op::acos: s[in.out] = std::acos(s[in.a]); break;
+                    case op::atan: s[in.out] = std::atan(s[in.a]); break;
+                    case op::sinh: s[in.out] = std::sinh(s[in.a]); break;
+                    case op::cosh: s[in.out] = std::cosh(s[in.a]); break;
+                    case op::tanh: s[in.out] = std::tanh(s[in.a]); break;
+                    case op::sqrt: s[in.out] = std::sqrt(s[in.a]); break;
+                    case op::exp: s[in.out] = std::exp(s[in.a]); break;
+                    case op::log: s[in.out] = std::log(s[in.a]); break;
+                    case op::log10: s[in.out] = std::log10(s[in.a]); break;
+                    case op::square: s[in.out] = s[in.a] * s[in.a]; break;
+                    case op::pow: s[in.out] = std::pow(s[in.a], s[in.b]); break;
+                    case op::integrate: s[in.out] += s[in.a] * in.k; break;
+                    case op::delay_ring: {
+                        // The head slot was read this step; the input lands where it is read again after c steps
+                        auto* buf = m + in.aux;
+                        auto head = static_cast<std::uint32_t>(m[in.b]);
+                        buf[(head + in.c) & (in.d - 1)] = s[in.a];
+                        head = (head + 1) & (in.d - 1);
+                        m[in.b] = static_cast<float>(head);
+                        s[in.out] = buf[head];
+                        break;
+                    }
+                    case op::filter: {
+                        const auto* num = coef + in.d;
+                        const auto* den = num + in.c + 1;
+                        auto* z = m + in.aux;
+                        float u = s[in.a];
+                        float y = num[0] * u + (in.c > 0 ? z[0] : 0.0f);
+                        for (std::uint32_t i = 0; i < in.c; ++i) {
+                            z[i] = num[i + 1] * u + (i + 1 < in.c ? z[i + 1] : 0.0f) - den[i] * y;
+                        }
+                        s[in.out] = y;
+                        break;
+                    }
+                    case op::state_space: {
+                        auto n = in.c;
+                        const auto* a = coef + in.d;
+                        const auto* b = a + n * n;
+                        const auto* c = b + n;
+                        auto* x = m + in.aux;
+                        float u = s[in.a];
+                        float y = c[n] * u;  // D follows C
+                        for (std::uint32_t j = 0; j < n; ++j) y += c[j] * x[j];
+                        s[in.out] = y;
+                        // Every next state reads the old ones, so they are computed before any is written
+                        auto* next = scratch_.data();
+                        for (std::uint32_t i = 0; i < n; ++i) {
+                            float sum = b[i] * u;
+                            for (std::uint32_t j = 0; j < n; ++j) sum += a[i * n + j] * x[j];
+                            next[i] = sum;
+                        }
+                        std::copy_n(next, n, x);
+                        break;
+                    }
+                    case op::tf1: {
+                        const auto* k = coef + in.d;
+                        auto* z = m + in.aux;
+                        float u = s[in.a];
+                        float y = (k[0] * u + k[1] * z[0] - k[3] * z[1]) / k[2];
+                        z[0] = u;
+                        z[1] = y;
+                        s[in.out] = y;
+                        break;
+                    }
+                    case op::tf2: {
+                        const auto* k = coef + in.d;
+                        auto* z = m + in.aux;
+                        float u = s[in.a];
+                        float y = (k[0] * u + k[1] * z[0] + k[2] * z[1] - k[4] * z[2] - k[5] * z[3]) / k[3];
+                        z[1] = z[0];
+                        z[0] = u;
+                        z[3] = z[2];
+                        z[2] = y;
+                        s[in.out] = y;
+                        break;
+                    }
+                    case op::continuous: {
+                        const auto* c = coef + in.d;
+                        const auto* x = m + in.aux;
+                        float y = c[in.c] * s[in.a];
+                        for (std::uint32_t j = 0; j < in.c; ++j) y += c[j] * x[j];
+                        s[in.out] = y;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // One instruction as a C++ statement over s (signals), m (memory) and coef, mirroring interpret()
+        [[nodiscard]] static auto native_statement(const instruction& in) -> std::string {
+            auto s = [](std::uint32_t slot) { return "s[" + std::to_string(slot) + "]"; };
+            auto n = [](std::uint32_t value) { return std::to_string(value); };
+            auto out = s(in.out), a = s(in.a), b = s(in.b), c = s(in.c);
+            auto k = codegen::format_constant(in.k);
+            auto assign = [&](const std::string& expr) { return out + " = " + expr + ";"; };
+            auto flag = [&](const std::string& cond) { return assign("(" + cond + ") ? 1.0f : 0.0f"); };
+            auto call = [&](const std::string& fn) { return assign("std::" + fn + "(" + a + ")"); };
+
+            switch (in.code) {
+                case op::copy: return assign(a);
+                case op::neg: return assign("-" + a);
+                case op::add: return assign(a + " + " + b);
+                case op::sub: return assign(a + " - " + b);
+                case op::mul: return assign(a + " * " + b);
+                case op::div: return assign(a + " / " + b);
+                case op::gain: return assign(a + " * " + k);
+                case op::clamp: return assign("std::clamp(" + a + ", " + k + ", " + codegen::format_constant(in.k2) + ")");
+                case op::min: return assign("std::min(" + a + ", " + b + ")");
+                case op::max: return assign("std::max(" + a + ", " + b + ")");
+                case op::abs: return call("abs");
+                case op::eq: return flag(a + " == " + b);
+                case op::ne: return flag(a + " != " + b);
+                case op::lt: return flag(a + " < " + b);
+                case op::le: return flag(a + " <= " + b);
+                case op::gt: return flag(a + " > " + b);
+                case op::ge: return flag(a + " >= " + b);
+                case op::logic_and: return flag(a + " != 0.0f && " + b + " != 0.0f");
+                case op::logic_or: return flag(a + " != 0.0f || " + b + " != 0.0f");
+                case op::logic_xor: return flag("(" + a + " != 0.0f) != (" + b + " != 0.0f)");
+                case op::logic_not: return flag(a + " == 0.0f");
+                case op::switch_ge: return assign(b + " >= " + k + " ? " + a + " : " + c);
+                case op::switch_gt: return assign(b + " > " + k + " ? " + a + " : " + c);
+                case op::switch_ne: return assign(b + " != " + k + " ? " + a + " : " + c);
+                case op::switch_nonzero: return assign(b + " != 0.0f ? " + a + " : " + c);
+                case op::sin: return call("sin");
+                case op::cos: return call("cos");
+                case op::tan: return call("tan");
+                case op::asin: return call("asin");
+                case op::acos: return call("acos");
+                case op::atan: return call("atan");
+                case op::sinh: return call("sinh");
+                case op::cosh: return call("cosh");
+                case op::tanh: return call("tanh");
+                case op::sqrt: return call("sqrt");
+                case op::exp: return call("exp");
+                case op::log: return call("log");
+                case op::log10: return call("log10");
+                case op::square: return assign(a + " * " + a);
+                case op::pow: return assign("std::pow(" + a + ", " + b + ")");
+                case op::integrate: return out + " += " + a + " * " + k + ";";
+                case op::delay_ring:
+                    return "{ unsigned h = static_cast<unsigned>(m[" + n(in.b) + "]); m[" + n(in.aux) + " + ((h + " + n(in.c) +
+                           "u) & " + n(in.d - 1) + "u)] = " + a + "; h = (h + 1u) & " + n(in.d - 1) + "u; m[" + n(in.b) +
+                           "] = static_cast<float>(h); " + out + " = m[" + n(in.aux) + " + h]; }";
+                case op::filter:
+                    return "{ const float* num = coef + " + n(in.d) + "; const float* den = num + " + n(in.c + 1) +
+                           "; float* z = m + " + n(in.aux) + "; float u = " + a + "; float y = num[0] * u" +
+                           (in.c > 0 ? " + z[0]" : "") + "; for (unsigned i = 0; i < " + n(in.c) + "u; ++i) z[i] = num[i + 1] * u + (i + 1 < " +
+                           n(in.c) + "u ? z[i + 1] : 0.0f) - den[i] * y; " + out + " = y; }";
+                case op::state_space:
+                    return "{ constexpr unsigned n = " + n(in.c) + "u; const float* A = coef + " + n(in.d) +
+                           "; const float* B = A + n * n; const float* C = B + n; float* x = m + " + n(in.aux) + "; float u = " + a +
+                           "; float y = C[n] * u; for (unsigned j = 0; j < n; ++j) y += C[j] * x[j]; " + out +
+                           " = y; float next[n]; for (unsigned i = 0; i < n; ++i) { float sum = B[i] * u; "
+                           "for (unsigned j = 0; j < n; ++j) sum += A[i * n + j] * x[j]; next[i] = sum; } std::copy_n(next, n, x); }";
+                case op::tf1:
+                    return "{ const float* k = coef + " + n(in.d) + "; float* z = m + " + n(in.aux) + "; float u = " + a +
+                           "; float y = (k[0] * u + k[1] * z[0] - k[3] * z[1]) / k[2]; z[0] = u; z[1] = y; " + out + " = y; }";
+                case op::tf2:
+                    return "{ const float* k = coef + " + n(in.d) + "; float* z = m + " + n(in.aux) + "; float u = " + a +
+                           "; float y = (k[0] * u + k[1] * z[0] + k[2] * z[1] - k[4] * z[2] - k[5] * z[3]) / k[3]; "
+                           "z[1] = z[0]; z[0] = u; z[3] = z[2]; z[2] = y; " + out + " = y; }";
+                case op::continuous:
+                    return "{ const float* c = coef + " + n(in.d) + "; const float* x = m + " + n(in.aux) + "; float y = c[" + n(in.c) +
+                           "] * " + a + "; for (unsigned j = 0; j < " + n(in.c) + "u; ++j) y += c[j] * x[j]; " + out + " = y; }";
+            }
+            return "";
+        }
+
+        // FNV-1a, hex; names a compiled system in the cache
+        [[nodiscard]] static auto content_hash(std::string_view text) -> std::string {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (unsigned char ch : text) hash = (hash ^ ch) * 1099511628211ull;
+            std::ostringstream oss;
+            oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+            return oss.str();
+        }
+
+        void build_native(const native_options& options) {
+            namespace fs = std::filesystem;
+            auto start = std::chrono::steady_clock::now();
+            auto finish = [&](std::string status) {
+                native_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                native_status_ = std::move(status);
+                native_done_.store(true, std::memory_order_release);
+            };
+
+            fs::path dir = options.cache_dir;
+            if (dir.empty()) {
+                if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) dir = fs::path(xdg) / "open-controls";
+                else if (const char* home = std::getenv("HOME"); home && *home) dir = fs::path(home) / ".cache" / "open-controls";
+                else dir = fs::temp_directory_path() / "open-controls";
+            }
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+
+            auto source = native_source();
+            const std::string flags = " -std=c++17 -O2 -shared -fPIC";
+            auto name = content_hash(options.compiler + flags + "\n" + source);
+            auto library = dir / (name + ".so");
+            bool cached = fs::exists(library);
+            if (!cached) {
+                // Processes, and simulators within one, may build the same library at once, so each build
+                // works under its own names and renames the finished files into place
+                static std::atomic<unsigned> builds{0};
+                auto unique = name + "." + std::to_string(::getpid()) + "." + std::to_string(builds.fetch_add(1));
+                auto cpp = dir / (unique + ".cpp");
+                auto log = dir / (unique + ".log");
+                auto partial = dir / (unique + ".so");
+                if (std::ofstream file(cpp); file) file << source;
+                auto command = options.compiler + flags + " -o '" + partial.string() + "' '" + cpp.string() + "' > '" + log.string() + "' 2>&1";
+                if (std::system(command.c_str()) != 0) return finish("compile failed, see " + log.string());
+                fs::remove(log, ec);
+                fs::rename(cpp, dir / (name + ".cpp"), ec);
+                fs::rename(partial, library, ec);
+                if (ec) return finish("cannot store " + library.string() + ": " + ec.message());
+            }
+
+            library_ = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!library_) return finish(std::string("cannot load: ") + dlerror());
+            auto step = reinterpret_cast<native_step>(dlsym(library_, "oc_sim_step"));
+            if (!step) return finish("no oc_sim_step in " + library.string());
+
+            if (options.perf_map) write_perf_map(reinterpret_cast<void*>(step), options.name);
+            finish((cached ? "cached " : "compiled ") + library.string());
+            native_.store(step, std::memory_order_release);
+        }
+
+        // perf resolves JIT code through "<start> <size> <name>" lines in /tmp/perf-<pid>.map
+        static void write_perf_map(void* entry, const std::string& name) {
+            Dl_info info{};
+            ElfW(Sym)* symbol = nullptr;
+            if (!dladdr1(entry, &info, reinterpret_cast<void**>(&symbol), RTLD_DL_SYMENT) || !symbol) return;
+            std::ofstream map("/tmp/perf-" + std::to_string(::getpid()) + ".map", std::ios::app);
+            map << std::hex << reinterpret_cast<std::uintptr_t>(entry) << ' ' << symbol->st_size << std::dec
+                << " mdl_sim::" << name << "::step\n";
+        }
+
+        // How many of a, b, c an instruction reads as signal slots
+        [[nodiscard]] static auto slot_operands(op code) -> int {
+            switch (code) {
+                case op::add: case op::sub: case op::mul: case op::div: case op::min: case op::max:
+                case op::eq: case op::ne: case op::lt: case op::le: case op::gt: case op::ge:
+                case op::logic_and: case op::logic_or: case op::logic_xor: case op::pow:
+                    return 2;
+                case op::switch_ge: case op::switch_gt: case op::switch_ne: case op::switch_nonzero:
+                    return 3;
+                default:
+                    return 1;
+            }
+        }
+
+        // Block path of each slot, from its first output port
+        [[nodiscard]] auto slot_names() const -> std::vector<std::string> {
+            std::vector<std::string> names(signals_.size());
+            for (const auto& [path, slot] : paths_) {
+                auto name = path.substr(0, path.rfind(':'));
+                if (path.ends_with(":1") || names[slot].empty()) names[slot] = name;
+            }
+            return names;
+        }
+
+        void warn(std::string message) {
+            if (warned_.insert(message).second) warnings_.push_back(std::move(message));
+        }
+
+        auto allocate() -> std::uint32_t {
+            signals_.push_back(0.0f);
+            return static_cast<std::uint32_t>(signals_.size() - 1);
+        }
+
+        auto reserve_memory(std::size_t count) -> std::uint32_t {
+            memory_.resize(memory_.size() + count, 0.0f);
+            return static_cast<std::uint32_t>(memory_.size() - count);
+        }
+
+        auto add_coefficients(std::span<const float> values) -> std::uint32_t {
+            coef_.insert(coef_.end(), values.begin(), values.end());
+            return static_cast<std::uint32_t>(coef_.size() - values.size());
+        }
+
+        [[nodiscard]] static auto sorted_ports(std::vector<mdl::block> ports) -> std::vector<mdl::block> {
+            auto port = [](const mdl::block& b) { return std::stoi(b.param("Port").value_or("1")); };
+            std::ranges::stable_sort(ports, [&](const auto& a, const auto& b) { return port(a) < port(b); });
+            return ports;
+        }
+
+        // A parameter as the float the generated code computes; config names without a value read 0
+        [[nodiscard]] auto param(const mdl::block& blk, const std::string& name, double def) -> float {
+            auto text = blk.param(name);
+            if (!text) return static_cast<float>(def);
+            if (auto v = codegen::evaluate_expression(*text, values_)) return static_cast<float>(*v);
+
+            std::set<std::string> names;
+            extract_names(*text, names);
+            for (const auto& config : names) {
+                if (values_.emplace(config, 0.0).second) warn("config '" + config + "' has no value, using 0");
+            }
+            if (auto v = codegen::evaluate_expression(*text, values_)) return static_cast<float>(*v);
+            warn("cannot evaluate " + blk.type + " " + name + " '" + *text + "', using 0");
+            return 0.0f;
+        }
+
+        static void extract_names(std::string_view expr, std::set<std::string>& names) {
+            static const std::set<std::string> builtins = {
+                "sqrt", "exp", "log", "log10", "sin", "cos", "tan", "asin", "acos", "atan",
+                "sinh", "cosh", "tanh", "abs", "floor", "ceil", "round", "mod", "sign",
+                "max", "min", "pi", "inf", "nan", "eps", "true", "false"
+            };
+            std::string current;
+            for (char c : std::string(expr) + " ") {
+                if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+                    current += c;
+                    continue;
+                }
+                if (!current.empty() && std::isalpha(static_cast<unsigned char>(current[0])) && !builtins.contains(current)) {
+                    names.insert(current);
+                }
+                current.clear();
+            }
+        }
+
+        // Execution order of one system, with the same Kahn traversal as the code generator so
+        // that in-place state updates are seen by the same readers
+        [[nodiscard]] static auto execution_order(const mdl::system& sys, const std::set<std::string>& states)
+            -> std::vector<std::string> {
+            std::map<std::string, std::set<std::string>> dependencies;
+            for (const auto& blk : sys.blocks) {
+                if (!blk.is_inport()) dependencies[blk.sid] = {};
+            }
+            for (const auto& conn : sys.connections) {
+                auto src = mdl::endpoint::parse(conn.source);
+                if (!src) continue;
+                auto* src_blk = sys.find_block_by_sid(src->block_sid);
+                bool breaks = (src_blk && src_blk->is_inport()) || states.contains(src->block_sid);
+
+                auto add = [&](const std::string& dst_str) {
+                    auto dst = mdl::endpoint::parse(dst_str);
+                    if (!dst || breaks || !dependencies.contains(dst->block_sid)) return;
+                    dependencies[dst->block_sid].insert(src->block_sid);
+                };
+                if (!conn.destination.empty()) add(conn.destination);
+                for (const auto& branch : conn.branches) add(branch.destination);
+            }
+
+            std::map<std::string, int> in_degree;
+            for (const auto& [sid, deps] : dependencies) {
+                if (!in_degree.count(sid)) in_degree[sid] = 0;
+                for (const auto& dep : deps) {
+                    if (auto* blk = sys.find_block_by_sid(dep); blk && !blk->is_inport()) in_degree[sid]++;
+                }
+            }
+
+            std::queue<std::string> ready;
+            for (const auto& [sid, deg] : in_degree) {
+                if (deg == 0) ready.push(sid);
+            }
+            std::vector<std::string> order;
+            while (!ready.empty()) {
+                auto sid = ready.front();
+                ready.pop();
+                order.push_back(sid);
+                for (auto& [other, deps] : dependencies) {
+                    if (deps.erase(sid) && --in_degree[other] == 0) ready.push(other);
+                }
+            }
+            return order;
+        }
+
+        // Dotted fields a system reads from a bus signal: what its BusSelectors select, following
+        // sub-buses and subsystem inports, as the code generator types bus ports; empty for a scalar
+        [[nodiscard]] auto bus_fields(const mdl::system& sys, const std::string& key, int depth) const -> std::vector<std::string> {
+            std::vector<std::string> fields;
+            auto add = [&](const std::string& field) {
+                if (std::ranges::find(fields, field) == fields.end()) fields.push_back(field);
+            };
+            for (const auto& conn : sys.connections) {
+                auto src = mdl::endpoint::parse(conn.source);
+                if (!src || src->block_sid + "#out:" + std::to_string(src->port_index) != key) continue;
+
+                auto visit = [&](const std::string& dst_str) {
+                    auto dst = mdl::endpoint::parse(dst_str);
+                    const auto* blk = dst ? sys.find_block_by_sid(dst->block_sid) : nullptr;
+                    if (!blk) return;
+                    if (blk->type == "BusSelector" && dst->port_index == 1) {
+                        auto items = codegen::split_signal_list(blk->param("OutputSignals").value_or(""));
+                        for (std::size_t j = 0; j < items.size(); ++j) {
+                            auto sub = bus_fields(sys, blk->sid + "#out:" + std::to_string(j + 1), depth);
+                            if (sub.empty()) add(items[j]);
+                            for (const auto& field : sub) add(items[j] + "." + field);
+                        }
+                    } else if (blk->is_subsystem() && depth < max_depth_) {
+                        const auto* child = blk->subsystem_ref.empty() ? nullptr : model_->get_system(blk->subsystem_ref);
+                        auto inports = child ? sorted_ports(child->inports()) : std::vector<mdl::block>{};
+                        auto port = static_cast<std::size_t>(dst->port_index - 1);
+                        if (port < inports.size()) {
+                            for (const auto& field : bus_fields(*child, inports[port].sid + "#out:1", depth + 1)) add(field);
+                        }
+                    }
+                };
+                if (!conn.destination.empty()) visit(conn.destination);
+                for (const auto& branch : conn.branches) visit(branch.destination);
+            }
+            return fields;
+        }
+
+        // Compile one system given the slots of its inports, and the leaves of those carrying a
+        // bus; returns the slots of its outports, and fills in the leaves of those carrying a bus
+        auto compile_system(const mdl::system& sys, const std::vector<std::uint32_t>& input_slots,
+                            const std::string& path, int depth, const std::vector<bus_slots>& input_buses = {},
+                            std::vector<bus_slots>* output_buses = nullptr) -> std::vector<std::uint32_t> {
+            std::map<std::string, std::uint32_t> slots;  // signal key -> slot
+            std::map<std::string, bus_slots> buses;      // bus signal key -> its leaves
+            auto inports = sorted_ports(sys.inports());
+            for (std::size_t i = 0; i < inports.size(); ++i) {
+                slots[inports[i].sid + "#out:1"] = i < input_slots.size() ? input_slots[i] : 0;
+                if (i < input_buses.size() && !input_buses[i].empty()) buses[inports[i].sid + "#out:1"] = input_buses[i];
+            }
+
+            // Delay and integrator outputs are their state, so readers before the update see the last value
+            std::set<std::string> states;
+            for (const auto& blk : sys.blocks) {
+                bool state = blk.type == "UnitDelay" || blk.type == "Integrator" ||
+                             blk.type == "DiscreteIntegrator" || blk.type == "Memory";
+                if (blk.type == "Delay") state = codegen::delay_length(blk, values_) > 0;
+                if (blk.type == "DiscreteFilter" || blk.type == "DiscreteTransferFcn") {
+                    auto filter = codegen::parse_discrete_filter(blk, values_);
+                    state = filter && filter->strictly_proper();
+                }
+                if (!state) continue;
+                states.insert(blk.sid);
+                slots[blk.sid + "#out:1"] = allocate();
+                paths_[path + blk.name + ":1"] = slots[blk.sid + "#out:1"];
+                if (variable_step_ && blk.type != "Integrator") held_.push_back(slots[blk.sid + "#out:1"]);
+            }
+
+            std::map<std::string, std::vector<std::string>> sources;  // SID -> source key per input port
+            for (const auto& conn : sys.connections) {
+                auto add = [&](const std::string& dst_str) {
+                    auto dst = mdl::endpoint::parse(dst_str);
+                    if (!dst || dst->port_type != "in") return;
+                    auto& keys = sources[dst->block_sid];
+                    if (keys.size() < static_cast<std::size_t>(dst->port_index)) keys.resize(dst->port_index);
+                    keys[dst->port_index - 1] = conn.source;
+                };
+                if (!conn.destination.empty()) add(conn.destination);
+                for (const auto& branch : conn.branches) add(branch.destination);
+            }
+            for (auto& [sid, keys] : sources) {
+                for (auto& key : keys) {
+                    if (auto src = mdl::endpoint::parse(key)) key = src->block_sid + "#out:" + std::to_string(src->port_index);
+                }
+            }
+
+            auto order = execution_order(sys, states);
+            for (const auto& blk : sys.blocks) {
+                if (!blk.is_inport() && std::ranges::find(order, blk.sid) == order.end()) {
+                    warn("'" + path + blk.name + "' is on an algebraic loop and does not run");
+                }
+            }
+
+            std::vector<std::uint32_t> outputs(sys.outports().size(), 0);
+            if (output_buses) output_buses->assign(outputs.size(), {});
+            for (const auto& sid : order) {
+                auto* blk = sys.find_block_by_sid(sid);
+                if (!blk) continue;
+
+                std::vector<std::uint32_t> in;
+                std::vector<bus_slots> in_buses;
+                if (auto it = sources.find(sid); it != sources.end()) {
+                    for (const auto& key : it->second) {
+                        auto slot = slots.find(key);
+                        in.push_back(key.empty() || slot == slots.end() ? 0 : slot->second);
+                        auto bus = buses.find(key);
+                        in_buses.push_back(bus == buses.end() ? bus_slots{} : bus->second);
+                    }
+                }
+                auto bus_in = [&](std::size_t idx) -> const bus_slots& {
+                    static const bus_slots none;
+                    return idx < in_buses.size() ? in_buses[idx] : none;
+                };
+
+                if (blk->is_outport()) {
+                    auto port = static_cast<std::size_t>(std::stoi(blk->param("Port").value_or("1")));
+                    if (port >= 1 && port <= outputs.size()) {
+                        outputs[port - 1] = in.empty() ? 0 : in[0];
+                        if (output_buses) (*output_buses)[port - 1] = bus_in(0);
+                    }
+                    continue;
+                }
+
+                // Buses run no instructions: a BusCreator names the slots of its inputs as leaves
+                // and a BusSelector reads the leaves it selects in place
+                if (blk->type == "BusCreator") {
+                    auto& leaves = buses[sid + "#out:1"];
+                    for (std::size_t i = 0; i < in.size(); ++i) {
+                        auto name = codegen::sanitize_name(codegen::incoming_signal_name(sys, sid, static_cast<int>(i + 1)));
+                        if (name.empty()) name = "signal" + std::to_string(i + 1);
+                        if (bus_in(i).empty()) leaves.emplace_back(name, in[i]);
+                        for (const auto& [field, slot] : bus_in(i)) leaves.emplace_back(name + "." + field, slot);
+                    }
+                    continue;
+                }
+                if (blk->type == "BusSelector") {
+                    auto items = codegen::split_signal_list(blk->param("OutputSignals").value_or(""));
+                    for (std::size_t j = 0; j < items.size(); ++j) {
+                        auto key = sid + "#out:" + std::to_string(j + 1);
+                        for (const auto& [field, slot] : bus_in(0)) {
+                            if (field == items[j]) slots[key] = slot;
+                            else if (field.starts_with(items[j] + ".")) buses[key].emplace_back(field.substr(items[j].size() + 1), slot);
+                        }
+                        if (!slots.contains(key) && !buses.contains(key)) {
+                            warn("BusSelector '" + path + blk->name + "' selects '" + items[j] + "', which its bus does not carry");
+                        }
+                    }
+                    continue;
+                }
+                ++blocks_;
+
+                if (blk->is_subsystem()) {
+                    const auto* child = blk->subsystem_ref.empty() || !model_ ? nullptr : model_->get_system(blk->subsystem_ref);
+                    if (!child || depth >= max_depth_) {
+                        warn("subsystem '" + path + blk->name + "' not found, passing its first input through");
+                        slots[sid + "#out:1"] = in.empty() ? 0 : in[0];
+                        continue;
+                    }
+                    std::vector<bus_slots> child_buses;
+                    auto child_outputs = compile_system(*child, in, path + blk->name + "/", depth + 1, in_buses, &child_buses);
+                    for (std::size_t i = 0; i < child_outputs.size(); ++i) {
+                        auto key = sid + "#out:" + std::to_string(i + 1);
+                        slots[key] = child_outputs[i];
+                        if (!child_buses[i].empty()) buses[key] = child_buses[i];
+                        paths_[path + blk->name + ":" + std::to_string(i + 1)] = child_outputs[i];
+                    }
+                    continue;
+                }
+
+                // Demux outputs all carry its input
+                if (blk->type == "Demux") {
+                    for (int i = 1; i <= blk->port_out; ++i) slots[sid + "#out:" + std::to_string(i)] = in.empty() ? 0 : in[0];
+                    continue;
+                }
+
+                auto out_key = sid + "#out:1";
+                std::uint32_t out;
+                if (auto it = slots.find(out_key); it != slots.end()) {
+                    out = it->second;
+                } else {
+                    out = allocate();
+                    slots[out_key] = out;
+                    paths_[path + blk->name + ":1"] = out;
+                }
+                compile_block(*blk, in, out, path);
+            }
+            return outputs;
+        }
+
+        void compile_block(const mdl::block& blk, const std::vector<std::uint32_t>& in, std::uint32_t out, const std::string& path) {
+            auto input = [&](std::size_t idx) -> std::uint32_t { return idx < in.size() ? in[idx] : 0; };
+            auto emit = [&](op code, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0) {
+                program_.push_back({.code = code, .out = out, .a = a, .b = b, .c = c});
+                return &program_.back();
+            };
+            auto passthrough = [&] {
+                warn(blk.type + " '" + path + blk.name + "' is not simulated, passing its first input through");
+                emit(op::copy, input(0));
+            };
+
+            if (blk.type == "Gain") {
+                emit(op::gain, input(0))->k = param(blk, "Gain", 1.0);
+            }
+            else if (blk.type == "Sum" || blk.type == "Product") {
+                bool sum = blk.type == "Sum";
+                auto spec = blk.param("Inputs").value_or(sum ? "++" : "**");
+                std::uint32_t idx = 0;
+                for (char c : spec) {
+                    if (sum && (c == '+' || c == '-')) {
+                        if (idx == 0) emit(c == '-' ? op::neg : op::copy, input(idx));
+                        else emit(c == '-' ? op::sub : op::add, out, input(idx));
+                        ++idx;
+                    } else if (!sum && (c == '*' || c == '/')) {
+                        // The first factor is taken as is, as in the generated expression
+                        if (idx == 0) emit(op::copy, input(idx));
+                        else emit(c == '/' ? op::div : op::mul, out, input(idx));
+                        ++idx;
+                    }
+                }
+                if (idx == 0) {
+                    if (sum) emit(op::copy, 0);
+                    else emit(op::mul, input(0), input(1));
+                }
+            }
+            else if (blk.type == "Saturate") {
+                auto* in0 = emit(op::clamp, input(0));
+                in0->k = param(blk, "LowerLimit", -1.0);
+                in0->k2 = param(blk, "UpperLimit", 1.0);
+            }
+            else if (blk.type == "MinMax") {
+                auto func = blk.param("Function").value_or("min");
+                emit((func == "max" || func == "Max") ? op::max : op::min, input(0), input(1));
+            }
+            else if (blk.type == "Abs") {
+                emit(op::abs, input(0));
+            }
+            else if (blk.type == "Constant") {
+                // Constants are written once and never change
+                signals_[out] = param(blk, "Value", 0.0);
+            }
+            else if (blk.type == "UnitDelay" || blk.type == "Memory") {
+                emit(op::copy, input(0));
+            }
+            else if (blk.type == "Integrator" && variable_step_) {
+                // Integrated by the solver; the output slot is the state
+                continuous_.push_back({.u = input(0), .state = out});
+            }
+            else if (blk.type == "Integrator" || blk.type == "DiscreteIntegrator") {
+                emit(op::integrate, input(0))->k = static_cast<float>(dt_);
+            }
+            else if (blk.type == "Delay" && codegen::delay_length(blk, values_)) {
+                auto length = static_cast<std::uint32_t>(*codegen::delay_length(blk, values_));
+                if (length <= 1) {
+                    emit(op::copy, input(0));
+                } else {
+                    auto ring = std::bit_ceil(length);
+                    auto* in0 = emit(op::delay_ring, input(0), reserve_memory(1), length);
+                    in0->d = ring;
+                    in0->aux = reserve_memory(ring);
+                }
+            }
+            else if ((blk.type == "DiscreteFilter" || blk.type == "DiscreteTransferFcn") &&
+                     codegen::parse_discrete_filter(blk, values_)) {
+                // Without direct feedthrough the output slot is a state holding next step's output
+                auto filter = *codegen::parse_discrete_filter(blk, values_);
+                if (filter.strictly_proper()) filter = filter.advanced();
+                auto n = static_cast<std::uint32_t>(filter.order());
+                std::vector<float> k(filter.num.begin(), filter.num.end());
+                k.insert(k.end(), filter.den.begin() + 1, filter.den.end());
+                auto* in0 = emit(op::filter, input(0), 0, n);
+                in0->d = add_coefficients(k);
+                in0->aux = reserve_memory(n);
+            }
+            else if (blk.type == "DiscreteStateSpace" && codegen::parse_discrete_state_space(blk, values_)) {
+                auto ss = *codegen::parse_discrete_state_space(blk, values_);
+                auto n = static_cast<std::uint32_t>(ss.a.size());
+                std::vector<float> k;
+                for (const auto& row : ss.a) k.insert(k.end(), row.begin(), row.end());
+                k.insert(k.end(), ss.b.begin(), ss.b.end());
+                k.insert(k.end(), ss.c.begin(), ss.c.end());
+                k.push_back(static_cast<float>(ss.d));
+                auto* in0 = emit(op::state_space, input(0), 0, n);
+                in0->d = add_coefficients(k);
+                in0->aux = reserve_memory(n);
+                scratch_.resize(std::max<std::size_t>(scratch_.size(), n));
+            }
+            else if (blk.type == "RelationalOperator") {
+                auto oper = blk.param("Operator").value_or("==");
+                auto code = oper == "<" ? op::lt : oper == "<=" ? op::le : oper == ">" ? op::gt : oper == ">=" ? op::ge :
+                            (oper == "~=" || oper == "!=") ? op::ne : op::eq;
+                emit(code, input(0), input(1));
+            }
+            else if (blk.type == "Logic") {
+                auto oper = blk.param("Operator").value_or("AND");
+                if (oper == "NOT") emit(op::logic_not, input(0));
+                else emit(oper == "OR" ? op::logic_or : oper == "XOR" ? op::logic_xor : op::logic_and, input(0), input(1));
+            }
+            else if (blk.type == "Switch") {
+                auto criteria = blk.param("Criteria").value_or("u2 >= Threshold");
+                auto code = criteria.find(">=") != std::string::npos ? op::switch_ge :
+                            criteria.find(">") != std::string::npos ? op::switch_gt :
+                            (criteria.find("!=") != std::string::npos || criteria.find("~=") != std::string::npos) ? op::switch_ne :
+                            op::switch_nonzero;
+                emit(code, input(0), input(1), input(2))->k = param(blk, "Threshold", 0.0);
+            }
+            else if (blk.type == "Trigonometry" || blk.type == "Math") {
+                static const std::map<std::string, op> functions = {
+                    {"sin", op::sin}, {"cos", op::cos}, {"tan", op::tan}, {"asin", op::asin}, {"acos", op::acos},
+                    {"atan", op::atan}, {"sinh", op::sinh}, {"cosh", op::cosh}, {"tanh", op::tanh}
+                };
+                static const std::map<std::string, op> math = {
+                    {"sqrt", op::sqrt}, {"exp", op::exp}, {"log", op::log}, {"log10", op::log10},
+                    {"square", op::square}, {"pow", op::pow}
+                };
+                const auto& table = blk.type == "Math" ? math : functions;
+                auto func = blk.param("Operator").value_or(blk.type == "Math" ? "sqrt" : "sin");
+                if (auto it = table.find(func); it != table.end()) emit(it->second, input(0), input(1));
+                else passthrough();
+            }
+            else if (blk.type == "TransferFcn") {
+                compile_transfer_function(blk, input(0), out, path);
+            }
+            else if (blk.type == "Mux" || blk.type == "Derivative") {
+                emit(op::copy, input(0));
+            }
+            else {
+                passthrough();
+            }
+        }
+
+        // Tustin coefficients, computed in float from the same literals the generated code uses
+        void compile_transfer_function(const mdl::block& blk, std::uint32_t u, std::uint32_t out, const std::string& path) {
+            if (variable_step_) return compile_continuous_transfer_function(blk, u, out, path);
+            auto tf = codegen::parse_transfer_function(blk);
+            auto f = [](double v) { return static_cast<float>(v); };
+            float k = 2.0f / static_cast<float>(dt_);
+
+            if (tf.order == 1) {
+                double b0 = tf.num.size() > 1 ? tf.num[0] : 0.0;
+                double b1 = tf.num.size() > 1 ? tf.num[1] : (tf.num.size() == 1 ? tf.num[0] : 1.0);
+                double a0 = tf.den.size() > 0 ? tf.den[0] : 0.0;
+                double a1 = tf.den.size() > 1 ? tf.den[1] : 1.0;
+                if (tf.num.size() == 1) { b0 = 0.0; b1 = tf.num[0]; }
+
+                std::vector<float> c{f(b0) * k + f(b1), -f(b0) * k + f(b1), f(a0) * k + f(a1), -f(a0) * k + f(a1)};
+                program_.push_back({.code = op::tf1, .out = out, .a = u, .d = add_coefficients(c), .aux = reserve_memory(2)});
+            } else if (tf.order == 2) {
+                double b0 = tf.num.size() > 2 ? tf.num[0] : 0.0;
+                double b1 = tf.num.size() > 2 ? tf.num[1] : (tf.num.size() > 1 ? tf.num[0] : 0.0);
+                double b2 = tf.num.size() > 2 ? tf.num[2] : (tf.num.size() > 1 ? tf.num[1] : tf.num[0]);
+                double a0 = tf.den[0];
+                double a1 = tf.den.size() > 1 ? tf.den[1] : 0.0;
+                double a2 = tf.den.size() > 2 ? tf.den[2] : 1.0;
+                if (tf.num.size() == 1) { b0 = 0; b1 = 0; b2 = tf.num[0]; }
+
+                float k2 = k * k;
+                std::vector<float> c{f(b0) * k2 + f(b1) * k + f(b2), 2.0f * f(b2) - 2.0f * f(b0) * k2, f(b0) * k2 - f(b1) * k + f(b2),
+                                     f(a0) * k2 + f(a1) * k + f(a2), 2.0f * f(a2) - 2.0f * f(a0) * k2, f(a0) * k2 - f(a1) * k + f(a2)};
+                program_.push_back({.code = op::tf2, .out = out, .a = u, .d = add_coefficients(c), .aux = reserve_memory(4)});
+            } else {
+                warn("TransferFcn '" + path + blk.name + "' of order " + std::to_string(tf.order) + " passes its input through");
+                program_.push_back({.code = op::copy, .out = out, .a = u});
+            }
+        }
+
+        // Controllable canonical form for the solver, of any proper order: with the denominator
+        // monic, x_j' = x_(j+1), x_n' = u - sum(a_(n-j) x_j) and y = sum((b_(n-j) - a_(n-j) b_0) x_j) + b_0 u
+        void compile_continuous_transfer_function(const mdl::block& blk, std::uint32_t u, std::uint32_t out, const std::string& path) {
+            auto tf = codegen::parse_transfer_function(blk);
+            if (tf.den.empty() || tf.den[0] == 0.0 || tf.num.size() > tf.den.size()) {
+                warn("TransferFcn '" + path + blk.name + "' is not proper and passes its input through");
+                program_.push_back({.code = op::copy, .out = out, .a = u});
+                return;
+            }
+            auto n = static_cast<std::uint32_t>(tf.den.size() - 1);
+            std::vector<double> a, b(tf.den.size() - tf.num.size(), 0.0);
+            for (auto v : tf.den) a.push_back(v / tf.den[0]);
+            for (auto v : tf.num) b.push_back(v / tf.den[0]);
+            if (n == 0) {
+                program_.push_back({.code = op::gain, .out = out, .a = u, .k = static_cast<float>(b[0])});
+                return;
+            }
+
+            std::vector<float> c;
+            for (std::uint32_t j = 0; j < n; ++j) c.push_back(static_cast<float>(b[n - j] - a[n - j] * b[0]));
+            c.push_back(static_cast<float>(b[0]));
+            for (std::uint32_t j = 0; j < n; ++j) c.push_back(static_cast<float>(a[n - j]));
+            auto coef = add_coefficients(c);
+            auto memory = reserve_memory(n);
+            program_.push_back({.code = op::continuous, .out = out, .a = u, .c = n, .d = coef, .aux = memory});
+            continuous_.push_back({.u = u, .state = memory, .order = n, .coef = coef});
+        }
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Batch
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Simulators of one system that differ only in parameter values, stepped together. Signals,
+    // memory and coefficients are stored lane by lane (slot * lanes + lane), so each instruction
+    // runs as one loop over contiguous lanes, which the compiler vectorizes. Lanes must be
+    // compatible(): the same instruction stream with different constants.
+    class batch {
+    public:
+        explicit batch(std::span<const simulator* const> lanes) : lanes_(lanes.size()) {
+            if (lanes.empty()) return;
+            const auto& first = *lanes.front();
+            program_ = first.program_;
+            output_slots_ = first.output_slots_;
+            inputs_ = first.inputs_.size();
+            dt_ = first.dt_;
+
+            auto interleave = [&](auto member, std::vector<float>& into) {
+                auto count = (first.*member).size();
+                into.assign(count * lanes_, 0.0f);
+                for (std::size_t lane = 0; lane < lanes_; ++lane) {
+                    const auto& values = lanes[lane]->*member;
+                    for (std::size_t i = 0; i < count; ++i) into[i * lanes_ + lane] = values[i];
+                }
+            };
+            interleave(&simulator::initial_signals_, initial_signals_);
+            interleave(&simulator::initial_memory_, initial_memory_);
+            interleave(&simulator::coef_, coef_);
+            k_.resize(program_.size() * lanes_);
+            k2_.resize(program_.size() * lanes_);
+            for (std::size_t lane = 0; lane < lanes_; ++lane) {
+                for (std::size_t i = 0; i < program_.size(); ++i) {
+                    k_[i * lanes_ + lane] = lanes[lane]->program_[i].k;
+                    k2_[i * lanes_ + lane] = lanes[lane]->program_[i].k2;
+                }
+            }
+            scratch_.resize(first.scratch_.size());
+            reset();
+        }
+
+        // Same instructions over the same slots; only constants, gains, limits and coefficients differ
+        [[nodiscard]] static auto compatible(const simulator& a, const simulator& b) -> bool {
+            auto same = [](const instruction& x, const instruction& y) {
+                return x.code == y.code && x.out == y.out && x.a == y.a && x.b == y.b && x.c == y.c && x.d == y.d && x.aux == y.aux;
+            };
+            return a.dt_ == b.dt_ && a.signals_.size() == b.signals_.size() && a.memory_.size() == b.memory_.size() &&
+                   a.coef_.size() == b.coef_.size() && a.output_slots_ == b.output_slots_ &&
+                   std::ranges::equal(a.program_, b.program_, same);
+        }
+
+        void reset() {
+            signals_ = initial_signals_;
+            memory_ = initial_memory_;
+        }
+
+        void step() {
+            const auto n = lanes_;
+            auto* s = signals_.data();
+            auto* m = memory_.data();
+            const auto* coef = coef_.data();
+            for (std::size_t i = 0; i < program_.size(); ++i) {
+                const auto& in = program_[i];
+                auto* out = s + in.out * n;
+                const auto* a = s + in.a * n;
+                const auto* b = s + in.b * n;
+                const auto* c = s + in.c * n;
+                const auto* k = k_.data() + i * n;
+                const auto* k2 = k2_.data() + i * n;
+                auto each = [&](auto&& f) {
+                    for (std::size_t l = 0; l < n; ++l) out[l] = f(l);
+                };
+                auto flag = [](bool v) { return v ? 1.0f : 0.0f; };
+
+                switch (in.code) {
+                    case op::copy: each([&](auto l) { return a[l]; }); break;
+                    case op::neg: each([&](auto l) { return -a[l]; }); break;
+                    case op::add: each([&](auto l) { return a[l] + b[l]; }); break;
+                    case op::sub: each([&](auto l) { return a[l] - b[l]; }); break;
+                    case op::mul: each([&](auto l) { return a[l] * b[l]; }); break;
+                    case op::div: each([&](auto l) { return a[l] / b[l]; }); break;
+                    case op::gain: each([&](auto l) { return a[l] * k[l]; }); break;
+                    case op::clamp: each([&](auto l) { return std::clamp(a[l], k[l], k2[l]); }); break;
+                    case op::min: each([&](auto l) { return std::min(a[l], b[l]); }); break;
+                    case op::max: each([&](auto l) { return std::max(a[l], b[l]); }); break;
+                    case op::abs: each([&](auto l) { return std::abs(a[l]); }); break;
+                    case op::eq: each([&](auto l) { return flag(a[l] == b[l]); }); break;
+                    case op::ne: each([&](auto l) { return flag(a[l] != b[l]); }); break;
+                    case op::lt: each([&](auto l) { return flag(a[l] < b[l]); }); break;
+                    case op::le: each([&](auto l) { return flag(a[l] <= b[l]); }); break;
+                    case op::gt: each([&](auto l) { return flag(a[l] > b[l]); }); break;
+                    case op::ge: each([&](auto l) { return flag(a[l] >= b[l]); }); break;
+                    case op::logic_and: each([&](auto l) { return flag(a[l] != 0.0f && b[l] != 0.0f); }); break;
+                    case op::logic_or: each([&](auto l) { return flag(a[l] != 0.0f || b[l] != 0.0f); }); break;
+                    case op::logic_xor: each([&](auto l) { return flag((a[l] != 0.0f) != (b[l] != 0.0f)); }); break;
+                    case op::logic_not: each([&](auto l) { return flag(a[l] == 0.0f); }); break;
+                    case op::switch_ge: each([&](auto l) { return b[l] >= k[l] ? a[l] : c[l]; }); break;
+                    case op::switch_gt: each([&](auto l) { return b[l] > k[l] ? a[l] : c[l]; }); break;
+                    case op::switch_ne: each([&](auto l) { return b[l] != k[l] ? a[l] : c[l]; }); break;
+                    case op::switch_nonzero: each([&](auto l) { return b[l] != 0.0f ? a[l] : c[l]; }); break;
+                    case op::sin: each([&](auto l) { return std::sin(a[l]); }); break;
+                    case op::cos: each([&](auto l) { return std::cos(a[l]); }); break;
+                    case op::tan: each([&](auto l) { return std::tan(a[l]); }); break;
+                    case op::asin: each([&](auto l) { return std::asin(a[l]); }); break;
+                    case op::acos: each([&](auto l) { return std::acos(a[l]); }); break;
+                    case op::atan: each([&](auto l) { return std::atan(a[l]); }); break;
+                    case op::sinh: each([&](auto l) { return std::sinh(a[l]); }); break;
+                    case op::cosh: each([&](auto l) { return std::cosh(a[l]); }); break;
+                    case op::tanh: each([&](auto l) { return std::tanh(a[l]); }); break;
+                    case op::sqrt: each([&](auto l) { return std::sqrt(a[l]); }); break;
+                    case op::exp: each([&](auto l) { return std::exp(a[l]); }); break;
+                    case op::log: each([&](auto l) { return std::log(a[l]); }); break;
+                    case op::log10: each([&](auto l) { return std::log10(a[l]); }); break;
+                    case op::square: each([&](auto l) { return a[l] * a[l]; }); break;
+                    case op::pow: each([&](auto l) { return std::pow(a[l], b[l]); }); break;
+                    case op::integrate: each([&](auto l) { return out[l] + a[l] * k[l]; }); break;
+                    case op::delay_ring: {
+                        // Every lane has stepped as often, so the heads agree
+                        auto* head_slot = m + in.b * n;
+                        auto head = static_cast<std::uint32_t>(head_slot[0]);
+                        auto* write = m + (in.aux + ((head + in.c) & (in.d - 1))) * n;
+                        for (std::size_t l = 0; l < n; ++l) write[l] = a[l];
+                        head = (head + 1) & (in.d - 1);
+                        for (std::size_t l = 0; l < n; ++l) head_slot[l] = static_cast<float>(head);
+                        const auto* read = m + (in.aux + head) * n;
+                        each([&](auto l) { return read[l]; });
+                        break;
+                    }
+                    case op::filter: {
+                        const auto* num = coef + in.d * n;
+                        const auto* den = num + (in.c + 1) * n;
+                        auto* z = m + in.aux * n;
+                        for (std::size_t l = 0; l < n; ++l) {
+                            float u = a[l];
+                            float y = num[l] * u + (in.c > 0 ? z[l] : 0.0f);
+                            for (std::uint32_t j = 0; j < in.c; ++j) {
+                                z[j * n + l] = num[(j + 1) * n + l] * u + (j + 1 < in.c ? z[(j + 1) * n + l] : 0.0f) - den[j * n + l] * y;
+                            }
+                            out[l] = y;
+                        }
+                        break;
+                    }
+                    case op::state_space: {
+                        auto order = in.c;
+                        const auto* am = coef + in.d * n;
+                        const auto* bm = am + order * order * n;
+                        const auto* cm = bm + order * n;
+                        auto* x = m + in.aux * n;
+                        for (std::size_t l = 0; l < n; ++l) {
+                            float u = a[l];
+                            float y = cm[order * n + l] * u;
+                            for (std::uint32_t j = 0; j < order; ++j) y += cm[j * n + l] * x[j * n + l];
+                            out[l] = y;
+                            for (std::uint32_t r = 0; r < order; ++r) {
+                                float sum = bm[r * n + l] * u;
+                                for (std::uint32_t j = 0; j < order; ++j) sum += am[(r * order + j) * n + l] * x[j * n + l];
+                                scratch_[r] = sum;
+                            }
+                            for (std::uint32_t r = 0; r < order; ++r) x[r * n + l] = scratch_[r];
+                        }
+                        break;
+                    }
+                    case op::tf1: {
+                        const auto* kc = coef + in.d * n;
+                        auto* z = m + in.aux * n;
+                        for (std::size_t l = 0; l < n; ++l) {
+                            float u = a[l];
+                            float y = (kc[l] * u + kc[n + l] * z[l] - kc[3 * n + l] * z[n + l]) / kc[2 * n + l];
+                            z[l] = u;
+                            z[n + l] = y;
+                            out[l] = y;
+                        }
+                        break;
+                    }
+                    case op::tf2: {
+                        const auto* kc = coef + in.d * n;
+                        auto* z = m + in.aux * n;
+                        for (std::size_t l = 0; l < n; ++l) {
+                            float u = a[l];
+                            float y = (kc[l] * u + kc[n + l] * z[l] + kc[2 * n + l] * z[n + l] - kc[4 * n + l] * z[2 * n + l] -
+                                       kc[5 * n + l] * z[3 * n + l]) / kc[3 * n + l];
+                            z[n + l] = z[l];
+                            z[l] = u;
+                            z[3 * n + l] = z[2 * n + l];
+                            z[2 * n + l] = y;
+                            out[l] = y;
+                        }
+                        break;
+                    }
+                    case op::continuous: {
+                        const auto* kc = coef + in.d * n;
+                        const auto* x = m + in.aux * n;
+                        for (std::size_t l = 0; l < n; ++l) {
+                            float y = kc[in.c * n + l] * a[l];
+                            for (std::uint32_t j = 0; j < in.c; ++j) y += kc[j * n + l] * x[j * n + l];
+                            out[l] = y;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] auto lanes() const -> std::size_t { return lanes_; }
+        [[nodiscard]] auto dt() const -> double { return dt_; }
+        void set_input(std::size_t lane, std::size_t index, float value) {
+            if (index < inputs_) signals_[(index + 1) * lanes_ + lane] = value;
+        }
+        [[nodiscard]] auto output(std::size_t lane, std::size_t index) const -> float {
+            return signals_[output_slots_[index] * lanes_ + lane];
+        }
+        [[nodiscard]] auto signal(std::size_t lane, std::uint32_t slot) const -> float { return signals_[slot * lanes_ + lane]; }
+
+        // Continue a lane from where a compatible simulator is now, inputs included. Every lane must
+        // have taken as many steps, so that the delay ring heads agree.
+        void load(std::size_t lane, const simulator& sim) {
+            for (std::size_t i = 0; i < sim.signals_.size(); ++i) signals_[i * lanes_ + lane] = sim.signals_[i];
+            for (std::size_t i = 0; i < sim.memory_.size(); ++i) memory_[i * lanes_ + lane] = sim.memory_[i];
+        }
+        [[nodiscard]] auto state_value(std::size_t lane, const state_cell& cell) const -> float {
+            return cell.memory ? memory_[cell.locate(memory_[cell.head * lanes_]) * lanes_ + lane] : signals_[cell.index * lanes_ + lane];
+        }
+        void set_state_value(std::size_t lane, const state_cell& cell, float value) {
+            (cell.memory ? memory_[cell.locate(memory_[cell.head * lanes_]) * lanes_ + lane] : signals_[cell.index * lanes_ + lane]) = value;
+        }
+
+    private:
+        std::size_t lanes_;
+        std::size_t inputs_ = 0;
+        double dt_ = 0.001;
+        std::vector<instruction> program_;
+        std::vector<std::uint32_t> output_slots_;
+        std::vector<float> k_;
+        std::vector<float> k2_;
+        std::vector<float> signals_;
+        std::vector<float> memory_;
+        std::vector<float> coef_;
+        std::vector<float> scratch_;
+        std::vector<float> initial_signals_;
+        std::vector<float> initial_memory_;
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Co-simulation
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    struct cosim_options {
+        sim_options controller;
+        sim_options plant;                       // dt is the controller's divided by ratio unless given
+        std::uint32_t ratio = 1;                 // plant steps per controller step
+        std::vector<std::pair<std::string, std::string>> connections;  // {controller port, plant port} beyond equal names
+    };
+
+    // A controller and a plant, possibly from different models, compiled into one signal array.
+    // A controller output and the plant input it drives are one slot, and controller reads of a
+    // plant output read the plant's slot directly; only a fed-back inport that the controller
+    // passes straight out is copied. Ports connect by name, plus the explicit connections. step()
+    // runs the controller once and then the plant ratio times, so the controller sees the plant
+    // outputs of the previous step.
+    //
+    // Both sides run as instruction streams rather than generated _update code because plants are
+    // where the generated headers break: currentSource_A, the example plant, reads VllRated, SRated,
+    // Plimit, Qlimit and nominalFrequency without declaring them, clamps a float between a double
+    // and a float, embeds a current_modulator_state that is never emitted and reads an undeclared
+    // Complex_toxAReal_Imag_2. The simulator reads such names from the calibration and works in float.
+    class cosimulator {
+    public:
+        // An unconnected port, set or read from outside
+        struct port {
+            std::string name;  // "controller/<port>" or "plant/<port>"
+            std::uint32_t slot;
+        };
+
+        cosimulator(const mdl::model& controller_model, const mdl::system& controller,
+                    const mdl::model& plant_model, const mdl::system& plant, cosim_options options = {})
+            : sim_(options.controller), ratio_(std::max<std::uint32_t>(1, options.ratio)) {
+            auto names = [](const std::vector<mdl::block>& ports) {
+                std::vector<std::string> result;
+                for (const auto& blk : simulator::sorted_ports(ports)) result.push_back(codegen::sanitize_name(blk.name));
+                return result;
+            };
+            auto controller_inputs = names(controller.inports());
+            auto controller_outputs = names(controller.outports());
+            auto plant_inputs = names(plant.inports());
+            auto plant_outputs = names(plant.outports());
+
+            auto linked = [&](const std::string& controller_port, const std::string& plant_port) {
+                if (controller_port == plant_port) return true;
+                return std::ranges::any_of(options.connections, [&](const auto& c) {
+                    return codegen::sanitize_name(c.first) == controller_port && codegen::sanitize_name(c.second) == plant_port;
+                });
+            };
+
+            // Controller first, its inports in slots of their own for now
+            sim_.model_ = &controller_model;
+            sim_.values_ = options.controller.calibration;
+            sim_.dt_ = options.controller.dt.value_or(sim_.values_.contains("dt") ? sim_.values_["dt"] : 0.001);
+            sim_.values_["dt"] = sim_.dt_;
+            std::vector<std::uint32_t> placeholders;
+            for (std::size_t i = 0; i < controller_inputs.size(); ++i) placeholders.push_back(sim_.allocate());
+            auto controller_slots = sim_.compile_system(controller, placeholders, "controller/", 0);
+            split_ = sim_.program_.size();
+
+            // The plant reads each driven inport straight from the controller output
+            std::vector<std::uint32_t> plant_input_slots;
+            for (const auto& name : plant_inputs) {
+                std::optional<std::uint32_t> driven;
+                for (std::size_t o = 0; o < controller_outputs.size() && !driven; ++o) {
+                    if (linked(controller_outputs[o], name)) driven = controller_slots[o];
+                }
+                if (driven) {
+                    plant_input_slots.push_back(*driven);
+                    ++connected_;
+                    continue;
+                }
+                plant_input_slots.push_back(sim_.allocate());
+                inputs_.push_back({"plant/" + name, plant_input_slots.back()});
+            }
+            controller_dt_ = sim_.dt_;
+            sim_.model_ = &plant_model;
+            sim_.values_ = options.plant.calibration;
+            sim_.dt_ = options.plant.dt.value_or(controller_dt_ / static_cast<double>(ratio_));
+            sim_.values_["dt"] = sim_.dt_;
+            auto plant_slots = sim_.compile_system(plant, plant_input_slots, "plant/", 0);
+
+            // Controller inports fed back from the plant read its output slots. An inport that a controller
+            // outport passes straight through keeps its slot instead, copied from the plant output before the
+            // controller runs: the plant reads that slot on each of its steps and must see what the
+            // controller sent, not its own output changing under it.
+            std::vector<instruction> fed_back;
+            for (std::size_t i = 0; i < controller_inputs.size(); ++i) {
+                std::optional<std::uint32_t> source;
+                for (std::size_t o = 0; o < plant_outputs.size() && !source; ++o) {
+                    if (linked(controller_inputs[i], plant_outputs[o])) source = plant_slots[o];
+                }
+                if (!source) {
+                    inputs_.push_back({"controller/" + controller_inputs[i], placeholders[i]});
+                    continue;
+                }
+                ++connected_;
+                if (std::ranges::find(controller_slots, placeholders[i]) != controller_slots.end()) {
+                    fed_back.push_back({.code = op::copy, .out = placeholders[i], .a = *source});
+                    continue;
+                }
+                for (std::size_t k = 0; k < split_; ++k) {
+                    auto& in = sim_.program_[k];
+                    auto operands = simulator::slot_operands(in.code);
+                    if (in.a == placeholders[i]) in.a = *source;
+                    if (operands > 1 && in.b == placeholders[i]) in.b = *source;
+                    if (operands > 2 && in.c == placeholders[i]) in.c = *source;
+                }
+                for (auto& slot : controller_slots) {
+                    if (slot == placeholders[i]) slot = *source;
+                }
+                for (auto& [path, slot] : sim_.paths_) {
+                    if (slot == placeholders[i]) slot = *source;
+                }
+            }
+            sim_.program_.insert(sim_.program_.begin(), fed_back.begin(), fed_back.end());
+            split_ += fed_back.size();
+
+            for (std::size_t o = 0; o < controller_outputs.size(); ++o) outputs_.push_back({"controller/" + controller_outputs[o], controller_slots[o]});
+            for (std::size_t o = 0; o < plant_outputs.size(); ++o) outputs_.push_back({"plant/" + plant_outputs[o], plant_slots[o]});
+            sim_.initial_signals_ = sim_.signals_;
+            sim_.initial_memory_ = sim_.memory_;
+        }
+
+        void reset() { sim_.reset(); }
+
+        void step() {
+            std::span<const instruction> program = sim_.program_;
+            sim_.interpret(program.first(split_));
+            for (std::uint32_t i = 0; i < ratio_; ++i) sim_.interpret(program.subspan(split_));
+        }
+
+        // Inports left unconnected, and every outport of both sides
+        [[nodiscard]] auto inputs() const -> const std::vector<port>& { return inputs_; }
+        [[nodiscard]] auto outputs() const -> const std::vector<port>& { return outputs_; }
+        void set(std::uint32_t slot, float value) { sim_.signals_[slot] = value; }
+        [[nodiscard]] auto signal(std::uint32_t slot) const -> float { return sim_.signals_[slot]; }
+        [[nodiscard]] auto find_signal(std::string_view path) const -> std::optional<std::uint32_t> { return sim_.find_signal(path); }
+
+        [[nodiscard]] auto dt() const -> double { return controller_dt_; }
+        [[nodiscard]] auto ratio() const -> std::uint32_t { return ratio_; }
+        [[nodiscard]] auto connections() const -> std::size_t { return connected_; }
+        [[nodiscard]] auto controller_instructions() const -> std::size_t { return split_; }
+        [[nodiscard]] auto plant_instructions() const -> std::size_t { return sim_.program_.size() - split_; }
+        [[nodiscard]] auto block_count() const -> std::size_t { return sim_.blocks_; }
+        [[nodiscard]] auto warnings() const -> const std::vector<std::string>& { return sim_.warnings_; }
+
+    private:
+        simulator sim_;
+        std::uint32_t ratio_;
+        std::size_t split_ = 0;
+        std::size_t connected_ = 0;
+        double controller_dt_ = 0.001;
+        std::vector<port> inputs_;
+        std::vector<port> outputs_;
+    };
+
+} // namespace oc::sim
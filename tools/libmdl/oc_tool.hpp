@@ -0,0 +1,126 @@
+//
+// Open Controls - Command-Line Tool Helpers
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include "oc_mdl.hpp"
+#include "oc_codegen.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace oc::tool {
+
+    // A top-level subsystem block by name or sanitized name; an exact name wins over a partial match
+    [[nodiscard]] inline auto find_subsystem(const mdl::model& model, std::string_view name) -> const mdl::block* {
+        const auto* root = model.root_system();
+        if (!root) return nullptr;
+        const mdl::block* chosen = nullptr;
+        for (const auto& blk : root->blocks) {
+            if (!blk.is_subsystem() || blk.subsystem_ref.empty()) continue;
+            if (blk.name == name || codegen::sanitize_name(blk.name) == name) return &blk;
+            if (!chosen && blk.name.find(name) != std::string::npos) chosen = &blk;
+        }
+        return chosen;
+    }
+
+    // Index of a port by its name as the simulator lists it, or as written in the model
+    [[nodiscard]] inline auto port_index(const std::vector<std::string>& ports, std::string_view name) -> std::optional<std::size_t> {
+        auto sanitized = codegen::sanitize_name(name);
+        for (std::size_t i = 0; i < ports.size(); ++i) {
+            if (ports[i] == name || ports[i] == sanitized) return i;
+        }
+        return std::nullopt;
+    }
+
+    // A numeric option value into target; false, after a usage error naming the option, when the
+    // text is not a whole number of target's type
+    template <typename T>
+    [[nodiscard]] auto read_number(std::string_view option, std::string_view text, T& target) -> bool {
+        T value{};
+        const auto* end = text.data() + text.size();
+        auto [stop, ec] = std::from_chars(text.data(), end, value);
+        if (text.empty() || ec != std::errc{} || stop != end) {
+            std::println(stderr, "Error: {} expects a number, got '{}'", option, text);
+            return false;
+        }
+        target = value;
+        return true;
+    }
+
+    // As read_number, for a value that has to be above 0 such as a step size
+    template <typename T>
+    [[nodiscard]] auto read_positive(std::string_view option, std::string_view text, T& target) -> bool {
+        T value{};
+        if (!read_number(option, text, value)) return false;
+        if (!(value > T{})) {
+            std::println(stderr, "Error: {} expects a value above 0, got '{}'", option, text);
+            return false;
+        }
+        target = value;
+        return true;
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // CSV
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Comma-separated fields without blanks or quotes
+    [[nodiscard]] inline auto split_csv(const std::string& line) -> std::vector<std::string> {
+        std::vector<std::string> fields;
+        std::istringstream in(line);
+        for (std::string field; std::getline(in, field, ',');) {
+            std::erase_if(field, [](char c) { return std::isspace(static_cast<unsigned char>(c)) || c == '"'; });
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    // Values per row from a CSV file with a header row; short rows repeat their last value
+    struct table {
+        std::vector<std::string> columns;
+        std::vector<std::vector<float>> rows;
+    };
+
+    [[nodiscard]] inline auto read_csv(const std::string& path) -> std::optional<table> {
+        std::ifstream file(path);
+        if (!file) return std::nullopt;
+
+        table result;
+        std::string line;
+        if (!std::getline(file, line)) return result;
+        result.columns = split_csv(line);
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            std::vector<float> row;
+            for (const auto& field : split_csv(line)) row.push_back(std::strtof(field.c_str(), nullptr));
+            row.resize(result.columns.size(), row.empty() ? 0.0f : row.back());
+            result.rows.push_back(std::move(row));
+        }
+        return result;
+    }
+
+    // Shortest text that reads back as the same float
+    inline void append_float(std::string& out, float value) {
+        char buffer[32];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+} // namespace oc::tool
@@ -0,0 +1,347 @@
+//
+// Open Controls - Binary Trace Format
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oc::trace {
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Layout
+    // ─────────────────────────────────────────────────────────────────────────────
+    //
+    //   header       64 bytes, below
+    //   signals      per signal: group byte, name, NUL
+    //   schema       the element's YAML interface, as written by mdl_to_yaml (may be empty)
+    //   chunks       from data_offset (64-byte aligned), each chunk_rows rows of every signal:
+    //                column 0 [chunk_rows floats], column 1 [chunk_rows floats], ...
+    //
+    // Floats are stored in host byte order (little-endian on every supported target). chunk_rows is
+    // a multiple of 16, so every column starts on a 64-byte boundary of a mapped file. The last chunk
+    // is padded to full size; rows in the header counts the rows written, and is updated after every
+    // chunk so a trace cut short by a crash still reads up to its last complete chunk.
+
+    inline constexpr char magic[8] = {'O', 'C', 'T', 'R', 'A', 'C', 'E', '\0'};
+    inline constexpr std::uint32_t format_version = 1;
+    inline constexpr std::uint32_t default_chunk_rows = 4096;
+
+    struct header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t signal_count;
+        std::uint32_t chunk_rows;
+        std::uint32_t reserved;
+        std::uint64_t rows;
+        double dt;                   // sample period; row k is at time (k + 1) * dt, 0 if unknown
+        std::uint64_t schema_hash;   // FNV-1a of the schema text, to match traces to an interface
+        std::uint64_t data_offset;
+        std::uint32_t signals_size;
+        std::uint32_t schema_size;
+    };
+    static_assert(sizeof(header) == 64);
+
+    enum class group : std::uint8_t { input, output, state, probe };
+
+    [[nodiscard]] inline auto group_name(group g) -> std::string_view {
+        switch (g) {
+            case group::input: return "IN";
+            case group::output: return "OUT";
+            case group::state: return "STATE";
+            case group::probe: return "PROBE";
+        }
+        return "PROBE";
+    }
+
+    [[nodiscard]] inline auto parse_group(std::string_view name) -> group {
+        if (name == "IN") return group::input;
+        if (name == "OUT") return group::output;
+        if (name == "STATE") return group::state;
+        return group::probe;
+    }
+
+    struct signal {
+        std::string name;
+        group kind = group::probe;
+    };
+
+    [[nodiscard]] inline auto schema_hash(std::string_view text) -> std::uint64_t {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : text) hash = (hash ^ c) * 1099511628211ull;
+        return hash;
+    }
+
+    // Columns of an interface schema: its IN, OUT and STATE signals in order, arrays as name[i]
+    [[nodiscard]] inline auto interface_signals(std::string_view schema) -> std::vector<signal> {
+        std::vector<signal> signals;
+        group current = group::probe;
+        bool grouped = false;  // inside IN, OUT or STATE
+        bool in_signals = false;
+        std::istringstream in{std::string(schema)};
+        for (std::string line; std::getline(in, line);) {
+            auto indent = line.find_first_not_of(' ');
+            if (indent == std::string::npos) continue;
+            auto text = std::string_view(line).substr(indent);
+            if (indent == 0) {
+                auto name = text.substr(0, text.find(':'));
+                grouped = name == "IN" || name == "OUT" || name == "STATE";
+                if (grouped) current = parse_group(name);
+                in_signals = false;
+            } else if (grouped && indent == 4) {
+                in_signals = text.starts_with("signals:");
+            } else if (grouped && in_signals && indent == 8 && text.ends_with(":")) {
+                signals.push_back({std::string(text.substr(0, text.size() - 1)), current});
+            } else if (grouped && in_signals && indent == 12 && text.starts_with("array:") && !signals.empty()) {
+                auto size = std::stoi(std::string(text.substr(6)));
+                auto base = signals.back();
+                signals.pop_back();
+                for (int i = 0; i < size; ++i) signals.push_back({base.name + "[" + std::to_string(i) + "]", base.kind});
+            }
+        }
+        return signals;
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Writer
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Appends rows into one chunk buffer, allocated when the file is opened, and writes each chunk
+    // as it fills; nothing is reallocated or moved while a trace is recorded.
+    class writer {
+    public:
+        writer() = default;
+        writer(const writer&) = delete;
+        auto operator=(const writer&) -> writer& = delete;
+        ~writer() { close(); }
+
+        [[nodiscard]] auto open(const std::string& path, std::vector<signal> signals, double dt = 0.0,
+                                std::string_view schema = {}, std::uint32_t chunk_rows = default_chunk_rows) -> bool {
+            close();
+            chunk_rows = std::max<std::uint32_t>(16, (chunk_rows + 15) / 16 * 16);
+            out_.open(path, std::ios::binary | std::ios::trunc);
+            if (!out_) {
+                error_ = "cannot write " + path;
+                return false;
+            }
+
+            std::string names;
+            for (const auto& sig : signals) {
+                names += static_cast<char>(sig.kind);
+                names += sig.name;
+                names += '\0';
+            }
+
+            header_ = {};
+            std::memcpy(header_.magic, magic, sizeof(magic));
+            header_.version = format_version;
+            header_.signal_count = static_cast<std::uint32_t>(signals.size());
+            header_.chunk_rows = chunk_rows;
+            header_.dt = dt;
+            header_.schema_hash = schema.empty() ? 0 : schema_hash(schema);
+            header_.signals_size = static_cast<std::uint32_t>(names.size());
+            header_.schema_size = static_cast<std::uint32_t>(schema.size());
+            header_.data_offset = (sizeof(header) + names.size() + schema.size() + 63) / 64 * 64;
+
+            out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+            out_.write(names.data(), static_cast<std::streamsize>(names.size()));
+            out_.write(schema.data(), static_cast<std::streamsize>(schema.size()));
+            std::string padding(header_.data_offset - sizeof(header) - names.size() - schema.size(), '\0');
+            out_.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+            signals_ = std::move(signals);
+            chunk_.assign(static_cast<std::size_t>(chunk_rows) * signals_.size(), 0.0f);
+            filled_ = 0;
+            return static_cast<bool>(out_);
+        }
+
+        // One row, a value per signal in the order given to open()
+        void append(std::span<const float> row) {
+            for (std::size_t c = 0; c < signals_.size(); ++c) {
+                chunk_[c * header_.chunk_rows + filled_] = c < row.size() ? row[c] : 0.0f;
+            }
+            if (++filled_ == header_.chunk_rows) flush_chunk();
+        }
+
+        void close() {
+            if (!out_.is_open()) return;
+            if (filled_ > 0) {
+                for (std::size_t c = 0; c < signals_.size(); ++c) {
+                    std::fill_n(chunk_.begin() + static_cast<std::ptrdiff_t>(c * header_.chunk_rows + filled_),
+                                header_.chunk_rows - filled_, 0.0f);
+                }
+                flush_chunk();
+            }
+            out_.close();
+        }
+
+        [[nodiscard]] auto signals() const -> const std::vector<signal>& { return signals_; }
+        [[nodiscard]] auto rows() const -> std::uint64_t { return header_.rows + filled_; }
+        [[nodiscard]] auto error() const -> const std::string& { return error_; }
+
+    private:
+        std::ofstream out_;
+        header header_{};
+        std::vector<signal> signals_;
+        std::vector<float> chunk_;
+        std::uint32_t filled_ = 0;
+        std::string error_;
+
+        void flush_chunk() {
+            out_.write(reinterpret_cast<const char*>(chunk_.data()), static_cast<std::streamsize>(chunk_.size() * sizeof(float)));
+            header_.rows += filled_;
+            filled_ = 0;
+            auto end = out_.tellp();
+            out_.seekp(offsetof(header, rows));
+            out_.write(reinterpret_cast<const char*>(&header_.rows), sizeof(header_.rows));
+            out_.seekp(end);
+        }
+    };
+
+    // ─────────────────────────────────────────────────────────────────────────────
+    // Reader
+    // ─────────────────────────────────────────────────────────────────────────────
+
+    // Maps a trace read-only; columns are returned as spans into the mapping, one per chunk
+    class reader {
+    public:
+        reader() = default;
+        reader(const reader&) = delete;
+        auto operator=(const reader&) -> reader& = delete;
+        ~reader() { unmap(); }
+
+        [[nodiscard]] auto load(const std::string& path) -> bool {
+            unmap();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return fail("cannot open " + path);
+            struct stat st {};
+            if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(header)) {
+                ::close(fd);
+                return fail(path + " is not a trace");
+            }
+            size_ = static_cast<std::size_t>(st.st_size);
+            void* base = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) return fail("cannot map " + path);
+            base_ = static_cast<const std::byte*>(base);
+
+            std::memcpy(&header_, base_, sizeof(header_));
+            if (std::memcmp(header_.magic, magic, sizeof(magic)) != 0) return fail(path + " is not a trace");
+            if (header_.version != format_version) return fail(path + " has trace version " + std::to_string(header_.version));
+            if (header_.chunk_rows == 0 || header_.chunk_rows % 16 != 0 ||
+                sizeof(header) + header_.signals_size + header_.schema_size > header_.data_offset || header_.data_offset > size_) {
+                return fail(path + " has a damaged header");
+            }
+
+            const auto* names = reinterpret_cast<const char*>(base_ + sizeof(header));
+            const auto* names_end = names + header_.signals_size;
+            while (names < names_end && signals_.size() < header_.signal_count) {
+                auto kind = static_cast<group>(*names++);
+                auto length = ::strnlen(names, static_cast<std::size_t>(names_end - names));
+                signals_.push_back({std::string(names, length), kind});
+                names += length + 1;
+            }
+            if (signals_.size() != header_.signal_count) return fail(path + " has a damaged signal table");
+            schema_ = std::string_view(reinterpret_cast<const char*>(base_ + sizeof(header) + header_.signals_size), header_.schema_size);
+
+            // Only complete chunks count, whatever the header says
+            auto bytes = chunk_bytes();
+            auto chunks = bytes > 0 ? (size_ - header_.data_offset) / bytes : 0;
+            rows_ = std::min<std::uint64_t>(header_.rows, chunks * header_.chunk_rows);
+            return true;
+        }
+
+        [[nodiscard]] auto signals() const -> const std::vector<signal>& { return signals_; }
+        [[nodiscard]] auto rows() const -> std::uint64_t { return rows_; }
+        [[nodiscard]] auto dt() const -> double { return header_.dt; }
+        [[nodiscard]] auto schema() const -> std::string_view { return schema_; }
+        [[nodiscard]] auto schema_hash() const -> std::uint64_t { return header_.schema_hash; }
+        [[nodiscard]] auto chunk_rows() const -> std::uint32_t { return header_.chunk_rows; }
+        [[nodiscard]] auto chunks() const -> std::uint64_t { return (rows_ + header_.chunk_rows - 1) / header_.chunk_rows; }
+        [[nodiscard]] auto error() const -> const std::string& { return error_; }
+
+        [[nodiscard]] auto find(std::string_view name) const -> std::optional<std::size_t> {
+            for (std::size_t i = 0; i < signals_.size(); ++i) {
+                if (signals_[i].name == name) return i;
+            }
+            return std::nullopt;
+        }
+
+        // The rows of one signal that lie in one chunk, without copying
+        [[nodiscard]] auto column(std::size_t signal_index, std::uint64_t chunk) const -> std::span<const float> {
+            auto first = chunk * header_.chunk_rows;
+            if (signal_index >= signals_.size() || first >= rows_) return {};
+            const auto* data = reinterpret_cast<const float*>(base_ + header_.data_offset + chunk * chunk_bytes() +
+                                                              signal_index * header_.chunk_rows * sizeof(float));
+            return {data, static_cast<std::size_t>(std::min<std::uint64_t>(header_.chunk_rows, rows_ - first))};
+        }
+
+        // One sample; NaN for a signal or row the trace does not have
+        [[nodiscard]] auto value(std::size_t signal_index, std::uint64_t row) const -> float {
+            if (signal_index >= signals_.size() || row >= rows_) return std::numeric_limits<float>::quiet_NaN();
+            return column(signal_index, row / header_.chunk_rows)[row % header_.chunk_rows];
+        }
+
+        // A whole signal, copied out of its chunks
+        [[nodiscard]] auto read_column(std::size_t signal_index) const -> std::vector<float> {
+            std::vector<float> values;
+            values.reserve(rows_);
+            for (std::uint64_t chunk = 0; chunk < chunks(); ++chunk) {
+                auto part = column(signal_index, chunk);
+                values.insert(values.end(), part.begin(), part.end());
+            }
+            return values;
+        }
+
+    private:
+        const std::byte* base_ = nullptr;
+        std::size_t size_ = 0;
+        header header_{};
+        std::vector<signal> signals_;
+        std::string_view schema_;
+        std::uint64_t rows_ = 0;
+        std::string error_;
+
+        [[nodiscard]] auto chunk_bytes() const -> std::size_t {
+            return static_cast<std::size_t>(header_.chunk_rows) * header_.signal_count * sizeof(float);
+        }
+
+        auto fail(std::string message) -> bool {
+            error_ = std::move(message);
+            unmap();
+            return false;
+        }
+
+        void unmap() {
+            if (base_) ::munmap(const_cast<std::byte*>(base_), size_);
+            base_ = nullptr;
+            size_ = 0;
+            signals_.clear();
+            schema_ = {};
+            rows_ = 0;
+        }
+    };
+
+} // namespace oc::trace
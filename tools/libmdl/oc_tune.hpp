@@ -0,0 +1,336 @@
+//
+// Open Controls - Gradient-Free Parameter Tuning
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace oc::tune {
+
+    // A tuned config name and the range it may take
+    struct parameter {
+        std::string name;
+        double lo = 0.0;
+        double hi = 1.0;
+    };
+
+    enum class method { cmaes, nelder_mead };
+
+    struct tune_options {
+        method algorithm = method::cmaes;
+        std::size_t population = 0;     // CMA-ES candidates per generation; 0: 4 + 3 ln n, at least 8
+        std::size_t generations = 100;  // generations (CMA-ES) or iterations (Nelder-Mead)
+        double sigma = 0.3;             // initial step, as a fraction of each range
+        double tolerance = 1e-6;        // stop once steps shrink below this fraction of each range
+        std::uint64_t seed = 1;
+    };
+
+    struct result {
+        std::vector<double> best;       // parameter values
+        double cost = std::numeric_limits<double>::infinity();
+        double start_cost = std::numeric_limits<double>::infinity();
+        std::size_t evaluations = 0;
+        std::size_t generations = 0;
+        bool converged = false;
+    };
+
+    // Costs of a whole generation of points (parameter values), so that the caller can evaluate them
+    // side by side. A run that fails or diverges costs infinity.
+    using evaluator = std::function<std::vector<double>(const std::vector<std::vector<double>>& points)>;
+
+    // Called after each generation with its number and the best cost so far
+    using progress = std::function<void(std::size_t generation, double best, std::span<const double> values)>;
+
+    namespace detail {
+
+        // Eigenvalues and eigenvectors (columns of vectors) of a symmetric n x n matrix, by cyclic
+        // Jacobi rotations; n is the number of tuned parameters, so a handful
+        inline void eigen_symmetric(std::vector<double> a, std::size_t n, std::vector<double>& values,
+                                    std::vector<double>& vectors) {
+            vectors.assign(n * n, 0.0);
+            for (std::size_t i = 0; i < n; ++i) vectors[i * n + i] = 1.0;
+            for (int sweep = 0; sweep < 64; ++sweep) {
+                double off = 0.0;
+                for (std::size_t p = 0; p < n; ++p) {
+                    for (std::size_t q = p + 1; q < n; ++q) off += a[p * n + q] * a[p * n + q];
+                }
+                if (off < 1e-30) break;
+                for (std::size_t p = 0; p < n; ++p) {
+                    for (std::size_t q = p + 1; q < n; ++q) {
+                        if (std::abs(a[p * n + q]) < 1e-300) continue;
+                        double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * a[p * n + q]);
+                        double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                        double c = 1.0 / std::sqrt(t * t + 1.0);
+                        double s = t * c;
+                        for (std::size_t k = 0; k < n; ++k) {
+                            double akp = a[k * n + p], akq = a[k * n + q];
+                            a[k * n + p] = c * akp - s * akq;
+                            a[k * n + q] = s * akp + c * akq;
+                        }
+                        for (std::size_t k = 0; k < n; ++k) {
+                            double apk = a[p * n + k], aqk = a[q * n + k];
+                            a[p * n + k] = c * apk - s * aqk;
+                            a[q * n + k] = s * apk + c * aqk;
+                        }
+                        for (std::size_t k = 0; k < n; ++k) {
+                            double vkp = vectors[k * n + p], vkq = vectors[k * n + q];
+                            vectors[k * n + p] = c * vkp - s * vkq;
+                            vectors[k * n + q] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+            }
+            values.resize(n);
+            for (std::size_t i = 0; i < n; ++i) values[i] = a[i * n + i];
+        }
+
+        // Fold a normalized coordinate back into [0, 1], mirroring at the bounds
+        [[nodiscard]] inline auto reflect(double x) -> double {
+            if (!std::isfinite(x)) return 0.5;
+            x = std::fmod(std::abs(x), 2.0);
+            return x > 1.0 ? 2.0 - x : x;
+        }
+
+    } // namespace detail
+
+    // Minimize over the box of the parameters, from start (clamped into it). Both methods work in
+    // coordinates normalized to [0, 1] per parameter, so ranges of different scale are searched
+    // alike. CMA-ES samples a population per generation from an adapted Gaussian; Nelder-Mead moves
+    // a simplex and evaluates its reflection, expansion and both contractions together, so that each
+    // of its iterations is one parallel batch as well.
+    [[nodiscard]] inline auto minimize(std::span<const parameter> parameters, std::vector<double> start,
+                                       const evaluator& evaluate, const tune_options& options = {},
+                                       const progress& report = {}) -> result {
+        const auto n = parameters.size();
+        result out;
+        if (n == 0) return out;
+
+        auto to_values = [&](const std::vector<double>& x) {
+            std::vector<double> values(n);
+            for (std::size_t i = 0; i < n; ++i) values[i] = parameters[i].lo + x[i] * (parameters[i].hi - parameters[i].lo);
+            return values;
+        };
+        start.resize(n);
+        std::vector<double> mean(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            auto span = parameters[i].hi - parameters[i].lo;
+            mean[i] = span != 0.0 ? std::clamp((start[i] - parameters[i].lo) / span, 0.0, 1.0) : 0.0;
+        }
+
+        // Evaluate normalized points and keep the best one seen
+        auto run = [&](const std::vector<std::vector<double>>& xs) {
+            std::vector<std::vector<double>> points;
+            for (const auto& x : xs) points.push_back(to_values(x));
+            auto costs = evaluate(points);
+            costs.resize(xs.size(), std::numeric_limits<double>::infinity());
+            for (std::size_t i = 0; i < xs.size(); ++i) {
+                if (!std::isfinite(costs[i])) costs[i] = std::numeric_limits<double>::infinity();
+                if (costs[i] < out.cost || out.best.empty()) {
+                    out.cost = costs[i];
+                    out.best = points[i];
+                }
+            }
+            out.evaluations += xs.size();
+            return costs;
+        };
+        auto finish_generation = [&] {
+            ++out.generations;
+            if (report) report(out.generations, out.cost, out.best);
+        };
+
+        if (options.algorithm == method::nelder_mead) {
+            // Initial simplex: the start and one step of sigma along each axis, away from the near bound
+            std::vector<std::vector<double>> simplex{mean};
+            for (std::size_t i = 0; i < n; ++i) {
+                auto x = mean;
+                x[i] += x[i] + options.sigma <= 1.0 ? options.sigma : -options.sigma;
+                x[i] = std::clamp(x[i], 0.0, 1.0);
+                simplex.push_back(x);
+            }
+            auto costs = run(simplex);
+            out.start_cost = costs.front();
+
+            auto clamp = [](std::vector<double> x) {
+                for (auto& v : x) v = std::clamp(v, 0.0, 1.0);
+                return x;
+            };
+            for (std::size_t iteration = 0; iteration < options.generations; ++iteration) {
+                std::vector<std::size_t> order(n + 1);
+                std::iota(order.begin(), order.end(), 0);
+                std::ranges::sort(order, [&](auto a, auto b) { return costs[a] < costs[b]; });
+                auto best = order.front(), worst = order.back(), second = order[n - 1];
+
+                double size = 0.0;
+                for (std::size_t i = 0; i <= n; ++i) {
+                    for (std::size_t j = 0; j < n; ++j) size = std::max(size, std::abs(simplex[i][j] - simplex[best][j]));
+                }
+                if (size < options.tolerance) {
+                    out.converged = true;
+                    break;
+                }
+
+                std::vector<double> centroid(n, 0.0);
+                for (std::size_t i = 0; i <= n; ++i) {
+                    if (i == worst) continue;
+                    for (std::size_t j = 0; j < n; ++j) centroid[j] += simplex[i][j] / static_cast<double>(n);
+                }
+                auto along = [&](double t) {
+                    std::vector<double> x(n);
+                    for (std::size_t j = 0; j < n; ++j) x[j] = centroid[j] + t * (centroid[j] - simplex[worst][j]);
+                    return clamp(x);
+                };
+                // Reflection, expansion, outside and inside contraction in one batch
+                std::vector<std::vector<double>> trial{along(1.0), along(2.0), along(0.5), along(-0.5)};
+                auto f = run(trial);
+
+                std::optional<std::size_t> accept;
+                if (f[0] < costs[best]) accept = f[1] < f[0] ? 1 : 0;
+                else if (f[0] < costs[second]) accept = 0;
+                else if (f[0] < costs[worst]) { if (f[2] <= f[0]) accept = 2; }
+                else if (f[3] < costs[worst]) accept = 3;
+
+                if (accept) {
+                    simplex[worst] = trial[*accept];
+                    costs[worst] = f[*accept];
+                } else {
+                    // Shrink towards the best vertex
+                    std::vector<std::vector<double>> shrunk;
+                    std::vector<std::size_t> moved;
+                    for (std::size_t i = 0; i <= n; ++i) {
+                        if (i == best) continue;
+                        for (std::size_t j = 0; j < n; ++j) simplex[i][j] = simplex[best][j] + 0.5 * (simplex[i][j] - simplex[best][j]);
+                        shrunk.push_back(simplex[i]);
+                        moved.push_back(i);
+                    }
+                    auto g = run(shrunk);
+                    for (std::size_t i = 0; i < moved.size(); ++i) costs[moved[i]] = g[i];
+                }
+                finish_generation();
+            }
+            return out;
+        }
+
+        // CMA-ES with weighted recombination, rank-one and rank-mu covariance updates and cumulative
+        // step-size adaptation (Hansen's defaults). Samples outside the box are mirrored into it and
+        // the mirrored point is what the distribution learns from.
+        const auto dn = static_cast<double>(n);
+        auto lambda = options.population ? options.population
+                                         : std::max<std::size_t>(8, 4 + static_cast<std::size_t>(3.0 * std::log(dn)));
+        lambda = std::max<std::size_t>(lambda, 2);
+        auto mu = lambda / 2;
+        std::vector<double> weights(mu);
+        for (std::size_t i = 0; i < mu; ++i) weights[i] = std::log(static_cast<double>(mu) + 0.5) - std::log(static_cast<double>(i) + 1.0);
+        auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+        for (auto& w : weights) w /= sum;
+        double mueff = 1.0 / std::inner_product(weights.begin(), weights.end(), weights.begin(), 0.0);
+
+        double cc = (4.0 + mueff / dn) / (dn + 4.0 + 2.0 * mueff / dn);
+        double cs = (mueff + 2.0) / (dn + mueff + 5.0);
+        double c1 = 2.0 / ((dn + 1.3) * (dn + 1.3) + mueff);
+        double cmu = std::min(1.0 - c1, 2.0 * (mueff - 2.0 + 1.0 / mueff) / ((dn + 2.0) * (dn + 2.0) + mueff));
+        double damps = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff - 1.0) / (dn + 1.0)) - 1.0) + cs;
+        double chi = std::sqrt(dn) * (1.0 - 1.0 / (4.0 * dn) + 1.0 / (21.0 * dn * dn));
+
+        double sigma = options.sigma;
+        std::vector<double> c(n * n, 0.0), b(n * n, 0.0), d(n, 1.0), pc(n, 0.0), ps(n, 0.0);
+        for (std::size_t i = 0; i < n; ++i) c[i * n + i] = b[i * n + i] = 1.0;
+
+        std::mt19937_64 rng(options.seed);
+        std::normal_distribution<double> normal;
+        for (std::size_t generation = 0; generation < options.generations; ++generation) {
+            std::vector<std::vector<double>> xs(lambda, std::vector<double>(n));
+            for (auto& x : xs) {
+                std::vector<double> z(n);
+                for (auto& v : z) v = normal(rng);
+                for (std::size_t i = 0; i < n; ++i) {
+                    double y = 0.0;
+                    for (std::size_t j = 0; j < n; ++j) y += b[i * n + j] * d[j] * z[j];
+                    x[i] = detail::reflect(mean[i] + sigma * y);
+                }
+            }
+            // The first generation scores the start as well, without learning from it
+            if (generation == 0) xs.push_back(mean);
+            auto costs = run(xs);
+            if (generation == 0) {
+                out.start_cost = costs.back();
+                xs.pop_back();
+                costs.pop_back();
+            }
+
+            std::vector<std::size_t> order(lambda);
+            std::iota(order.begin(), order.end(), 0);
+            std::ranges::stable_sort(order, [&](auto a, auto b) { return costs[a] < costs[b]; });
+
+            auto old = mean;
+            std::ranges::fill(mean, 0.0);
+            for (std::size_t k = 0; k < mu; ++k) {
+                for (std::size_t i = 0; i < n; ++i) mean[i] += weights[k] * xs[order[k]][i];
+            }
+            std::vector<double> yw(n);
+            for (std::size_t i = 0; i < n; ++i) yw[i] = (mean[i] - old[i]) / sigma;
+
+            // C^-1/2 yw = B D^-1 B' yw
+            std::vector<double> bt(n, 0.0), whitened(n, 0.0);
+            for (std::size_t j = 0; j < n; ++j) {
+                for (std::size_t i = 0; i < n; ++i) bt[j] += b[i * n + j] * yw[i];
+                bt[j] /= d[j];
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) whitened[i] += b[i * n + j] * bt[j];
+            }
+            double ps_norm = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                ps[i] = (1.0 - cs) * ps[i] + std::sqrt(cs * (2.0 - cs) * mueff) * whitened[i];
+                ps_norm += ps[i] * ps[i];
+            }
+            ps_norm = std::sqrt(ps_norm);
+            double decay = 1.0 - std::pow(1.0 - cs, 2.0 * static_cast<double>(generation + 1));
+            bool hsig = ps_norm / std::sqrt(decay) / chi < 1.4 + 2.0 / (dn + 1.0);
+            for (std::size_t i = 0; i < n; ++i) pc[i] = (1.0 - cc) * pc[i] + (hsig ? std::sqrt(cc * (2.0 - cc) * mueff) : 0.0) * yw[i];
+
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t j = 0; j < n; ++j) {
+                    double rank_mu = 0.0;
+                    for (std::size_t k = 0; k < mu; ++k) {
+                        const auto& x = xs[order[k]];
+                        rank_mu += weights[k] * (x[i] - old[i]) * (x[j] - old[j]) / (sigma * sigma);
+                    }
+                    c[i * n + j] = (1.0 - c1 - cmu) * c[i * n + j] +
+                                   c1 * (pc[i] * pc[j] + (hsig ? 0.0 : cc * (2.0 - cc) * c[i * n + j])) + cmu * rank_mu;
+                }
+            }
+            sigma *= std::exp((cs / damps) * (ps_norm / chi - 1.0));
+            sigma = std::min(sigma, 1.0);
+
+            std::vector<double> eigenvalues;
+            detail::eigen_symmetric(c, n, eigenvalues, b);
+            for (std::size_t i = 0; i < n; ++i) d[i] = std::sqrt(std::max(eigenvalues[i], 1e-20));
+            finish_generation();
+
+            if (sigma * *std::ranges::max_element(d) < options.tolerance) {
+                out.converged = true;
+                break;
+            }
+        }
+        return out;
+    }
+
+} // namespace oc::tune
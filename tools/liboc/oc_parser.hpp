@@ -434,6 +434,15 @@ namespace oc::parser {
                 return var;
             }
 
+            // Optional array length, kept with the type ("float[8]")
+            if (current().text == "[") {
+                advance();
+                var.type += "[" + current().text + "]";
+                advance();
+                if (current().text == "]") advance();
+                else error("Expected ']' after array length");
+            }
+
             // Optional default value
             if (check(token_type::op_assign)) {
                 advance();
@@ -0,0 +1,282 @@
+//
+// Open Controls - MDL Co-Simulation
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_sim.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include "../libmdl/oc_trace.hpp"
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <print>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <controller.mdl> <controller> <plant.mdl> <plant> [options]", program);
+        std::println("");
+        std::println("Runs a controller subsystem in closed loop with a plant subsystem, in one");
+        std::println("process and one step loop. Controller outputs drive the plant inputs of the");
+        std::println("same name and plant outputs feed the controller inputs of the same name.");
+        std::println("");
+        std::println("Options:");
+        std::println("  --ratio <n>            Plant steps per controller step (default 1)");
+        std::println("  --connect <c>=<p>      Also connect controller port c with plant port p");
+        std::println("  --time <s>             Simulated time (default 1)");
+        std::println("  --steps <n>            Controller steps, instead of --time");
+        std::println("  --dt <s>               Controller step (default: dt from --cal, else 0.001)");
+        std::println("  --cal <cal.yaml>       Controller parameter values");
+        std::println("  --plant-cal <cal.yaml> Plant parameter values");
+        std::println("  --set <port>=<v>       Hold an unconnected inport, e.g. v_ref or plant/load");
+        std::println("  --input <in.csv|.oct>  Unconnected inport values per controller step");
+        std::println("  --probe <path>         Also trace a signal, e.g. controller/Sum or plant/Block:2");
+        std::println("  --decimate <k>         Write every k-th controller step");
+        std::println("  -o <trace.csv|.oct>    Trace of every outport of both sides (default cosim_trace.csv)");
+    }
+
+    [[nodiscard]] auto read_text(const std::string& path) -> std::optional<std::string> {
+        std::ifstream file(path);
+        if (!file) return std::nullopt;
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    [[nodiscard]] auto find_subsystem(const oc::mdl::model& model, const std::string& name) -> const oc::mdl::system* {
+        const auto* chosen = oc::tool::find_subsystem(model, name);
+        return chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 5) {
+        print_usage(argv[0]);
+        return argc == 2 && (std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help") ? 0 : 1;
+    }
+
+    std::vector<std::string> positional;
+    std::string controller_cal;
+    std::string plant_cal;
+    std::string input_file;
+    std::string output_file = "cosim_trace.csv";
+    std::vector<std::pair<std::string, float>> held;
+    std::vector<std::string> probes;
+    double duration = 1.0;
+    std::optional<long long> steps;
+    long long decimate = 1;
+    oc::sim::cosim_options options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        static const std::set<std::string_view> with_value = {
+            "--ratio", "--connect", "--time", "--steps", "--dt", "--cal", "--plant-cal", "--set", "--input", "--probe",
+            "--decimate", "-o"
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (with_value.contains(arg)) {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "--ratio") read = oc::tool::read_positive(arg, v, options.ratio);
+            else if (arg == "--time") read = oc::tool::read_number(arg, v, duration);
+            else if (arg == "--steps") read = oc::tool::read_number(arg, v, steps.emplace());
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, options.controller.dt.emplace());
+            else if (arg == "--cal") controller_cal = v;
+            else if (arg == "--plant-cal") plant_cal = v;
+            else if (arg == "--input") input_file = v;
+            else if (arg == "--probe") probes.push_back(v);
+            else if (arg == "--decimate") read = oc::tool::read_positive(arg, v, decimate);
+            else if (arg == "-o") output_file = v;
+            else {
+                auto eq = v.find('=');
+                if (eq == std::string::npos) {
+                    std::println(stderr, "Error: {} expects <name>=<value>", arg);
+                    return 1;
+                }
+                if (arg == "--set") {
+                    float level = 0.0f;
+                    read = oc::tool::read_number(arg, std::string_view(v).substr(eq + 1), level);
+                    held.emplace_back(v.substr(0, eq), level);
+                }
+                else options.connections.emplace_back(v.substr(0, eq), v.substr(eq + 1));
+            }
+            if (!read) return 1;
+        } else {
+            positional.emplace_back(arg);
+        }
+    }
+
+    if (positional.size() != 4) {
+        std::println(stderr, "Error: Expected a controller model and subsystem, then a plant model and subsystem");
+        return 1;
+    }
+
+    for (auto [file, into] : {std::pair(&controller_cal, &options.controller), std::pair(&plant_cal, &options.plant)}) {
+        if (file->empty()) continue;
+        auto text = read_text(*file);
+        if (!text) {
+            std::println(stderr, "Error: Could not read {}", *file);
+            return 1;
+        }
+        into->calibration = oc::codegen::parse_calibration(*text);
+    }
+
+    // The plant may come from the controller's own model file
+    oc::mdl::parser controller_parser;
+    oc::mdl::parser plant_parser;
+    if (!controller_parser.load(positional[0]) || (positional[2] != positional[0] && !plant_parser.load(positional[2]))) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& controller_model = controller_parser.get_model();
+    const auto& plant_model = positional[2] == positional[0] ? controller_model : plant_parser.get_model();
+    const auto* controller = find_subsystem(controller_model, positional[1]);
+    const auto* plant = find_subsystem(plant_model, positional[3]);
+    if (!controller || !plant) {
+        std::println(stderr, "Error: No subsystem matching '{}'", controller ? positional[3] : positional[1]);
+        return 1;
+    }
+
+    auto compile_start = std::chrono::steady_clock::now();
+    oc::sim::cosimulator sim(controller_model, *controller, plant_model, *plant, options);
+    auto compile_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - compile_start).count();
+    for (const auto& warning : sim.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    // "v_ref" finds controller/v_ref or plant/v_ref, whichever is unconnected
+    auto input_slot = [&](const std::string& name) -> std::optional<std::uint32_t> {
+        for (const auto& port : sim.inputs()) {
+            auto short_name = port.name.substr(port.name.find('/') + 1);
+            if (port.name == name || short_name == name || short_name == oc::codegen::sanitize_name(name)) return port.slot;
+        }
+        return std::nullopt;
+    };
+    for (const auto& [name, v] : held) {
+        auto slot = input_slot(name);
+        if (!slot) {
+            std::println(stderr, "Error: No unconnected inport '{}'", name);
+            return 1;
+        }
+        sim.set(*slot, v);
+    }
+
+    // Per-step inputs, from a CSV header row or the IN signals of a trace
+    std::vector<std::pair<std::uint32_t, std::vector<float>>> stimulus;
+    if (input_file.ends_with(".oct")) {
+        oc::trace::reader trace;
+        if (!trace.load(input_file)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+        for (std::size_t c = 0; c < trace.signals().size(); ++c) {
+            if (auto slot = input_slot(trace.signals()[c].name)) stimulus.emplace_back(*slot, trace.read_column(c));
+        }
+    } else if (!input_file.empty()) {
+        auto table = oc::tool::read_csv(input_file);
+        if (!table) {
+            std::println(stderr, "Error: Could not read {}", input_file);
+            return 1;
+        }
+        for (std::size_t c = 0; c < table->columns.size(); ++c) {
+            auto slot = input_slot(table->columns[c]);
+            if (!slot) continue;
+            std::vector<float> values;
+            for (const auto& row : table->rows) values.push_back(row[c]);
+            stimulus.emplace_back(*slot, std::move(values));
+        }
+    }
+
+    std::vector<oc::sim::cosimulator::port> traced = sim.outputs();
+    for (const auto& path : probes) {
+        auto slot = sim.find_signal(path);
+        if (!slot) {
+            std::println(stderr, "Error: No signal '{}'", path);
+            return 1;
+        }
+        traced.push_back({path, *slot});
+    }
+
+    bool binary = output_file.ends_with(".oct");
+    std::ofstream out;
+    oc::trace::writer trace;
+    std::vector<float> row(traced.size());
+    std::string text = "time";
+    if (binary) {
+        std::vector<oc::trace::signal> signals;
+        for (std::size_t i = 0; i < traced.size(); ++i) {
+            signals.push_back({traced[i].name, i < sim.outputs().size() ? oc::trace::group::output : oc::trace::group::probe});
+        }
+        if (!trace.open(output_file, std::move(signals), sim.dt() * static_cast<double>(decimate))) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+    } else {
+        out.open(output_file, std::ios::binary);
+        if (!out) {
+            std::println(stderr, "Error: Could not write {}", output_file);
+            return 1;
+        }
+        for (const auto& port : traced) text += "," + port.name;
+        text += "\n";
+    }
+
+    auto total = steps.value_or(static_cast<long long>(std::llround(duration / sim.dt())));
+    std::chrono::steady_clock::duration stepping{};
+    for (long long k = 0; k < total; ++k) {
+        for (const auto& [slot, values] : stimulus) {
+            if (!values.empty()) sim.set(slot, values[std::min<std::size_t>(static_cast<std::size_t>(k), values.size() - 1)]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        sim.step();
+        stepping += std::chrono::steady_clock::now() - start;
+
+        if ((k + 1) % decimate != 0) continue;
+        if (binary) {
+            for (std::size_t i = 0; i < traced.size(); ++i) row[i] = sim.signal(traced[i].slot);
+            trace.append(row);
+            continue;
+        }
+        oc::tool::append_float(text, static_cast<float>((k + 1) * sim.dt()));
+        for (const auto& port : traced) {
+            text += ',';
+            oc::tool::append_float(text, sim.signal(port.slot));
+        }
+        text += '\n';
+        if (text.size() > (1 << 20)) {
+            out << text;
+            text.clear();
+        }
+    }
+    if (binary) trace.close();
+    else out << text;
+
+    auto seconds = std::chrono::duration<double>(stepping).count();
+    auto plant_steps = total * static_cast<long long>(sim.ratio());
+    std::println("{} + {}: {} blocks, {} + {} instructions, {} connections by slot (compiled in {:.2f} ms)", positional[1],
+                 positional[3], sim.block_count(), sim.controller_instructions(), sim.plant_instructions(), sim.connections(),
+                 compile_time * 1e3);
+    std::println("{} controller steps of {} s, {} plant steps (ratio {}) in {:.3f} ms", total, sim.dt(), plant_steps, sim.ratio(),
+                 seconds * 1e3);
+    if (seconds > 0) {
+        std::println("{:.0f} controller steps/s, {:.0f} plant steps/s, {:.0f}x real time", static_cast<double>(total) / seconds,
+                     static_cast<double>(plant_steps) / seconds, static_cast<double>(total) * sim.dt() / seconds);
+    }
+    std::println("Trace: {}", output_file);
+    return 0;
+}
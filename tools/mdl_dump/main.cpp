@@ -43,6 +43,11 @@ void dump_system(const oc::mdl::model& model, const oc::mdl::system& sys, int de
                 if (auto t = blk->param("Threshold")) std::print(" [Threshold={}]", *t);
             } else if (type == "UnitDelay" || type == "DiscreteIntegrator") {
                 if (auto ic = blk->param("InitialCondition")) std::print(" [IC={}]", *ic);
+            } else if (type == "Delay") {
+                if (auto n = blk->param("DelayLength")) std::print(" [Length={}]", *n);
+            } else if (type == "DiscreteFilter" || type == "DiscreteTransferFcn") {
+                if (auto n = blk->param("Numerator")) std::print(" [Num={}]", *n);
+                if (auto d = blk->param("Denominator")) std::print(" [Den={}]", *d);
             } else if (type == "Product") {
                 if (auto i = blk->param("Inputs")) std::print(" [Inputs={}]", *i);
             }
@@ -0,0 +1,253 @@
+//
+// Open Controls - MDL Frequency Response
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_freq.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <print>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <input.mdl> <subsystem> [options]", program);
+        std::println("");
+        std::println("Frequency response of a subsystem from one inport to one outport or signal, as");
+        std::println("the code runs it at dt. A linear path is composed into H(z) from the block");
+        std::println("coefficients and evaluated directly; a nonlinear one is measured with simulated");
+        std::println("sine sweeps around the operating point, one frequency per thread.");
+        std::println("");
+        std::println("Options:");
+        std::println("  --in <inport>        Input (default: the first inport)");
+        std::println("  --out <port|path>    Outport, or a signal such as Sub/Block:2 (default: the first outport)");
+        std::println("  --from <hz>          Lowest frequency (default 0.1)");
+        std::println("  --to <hz>            Highest frequency (default: Nyquist, 0.5 / dt)");
+        std::println("  --points <n>         Logarithmically spaced frequencies (default 200)");
+        std::println("  --dt <s>             Step size (default: dt from --cal, else 0.001)");
+        std::println("  --cal <cal.yaml>     Parameter values, as for mdl_sim");
+        std::println("  --set <in>=<v>       Operating point of an inport for the simulated sweep");
+        std::println("  --simulate           Sweep even a linear path, e.g. to check H(z)");
+        std::println("  --amplitude <a>      Sweep amplitude around the operating point (default 0.01)");
+        std::println("  --periods <n>        Periods measured per frequency (default 10)");
+        std::println("  --settle <s>         Settling time before measuring, at least 20 periods (default 0)");
+        std::println("  --threads <n>        Sweep threads (default: all cores)");
+        std::println("  -o <bode.csv>        Output (default <subsystem>_bode.csv)");
+    }
+
+    [[nodiscard]] auto format_polynomial(const std::vector<double>& p) -> std::string {
+        std::ostringstream text;
+        text << std::setprecision(9) << '[';
+        for (std::size_t i = 0; i < p.size(); ++i) text << (i ? " " : "") << p[i];
+        text << ']';
+        return text.str();
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return argc == 2 && (std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help") ? 0 : 1;
+    }
+
+    std::string input_file;
+    std::string subsystem;
+    std::string calibration_file;
+    std::string output_file;
+    std::string in_name;
+    std::string out_name;
+    std::vector<std::pair<std::string, float>> held;
+    double from = 0.1;
+    std::optional<double> to;
+    std::size_t points = 200;
+    bool simulate = false;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    oc::sim::sim_options options;
+    oc::freq::sweep_options sweep;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        static const std::set<std::string_view> with_value = {
+            "--in", "--out", "--from", "--to", "--points", "--dt", "--cal", "--set", "--amplitude", "--periods", "--settle",
+            "--threads", "-o"
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--simulate") {
+            simulate = true;
+        } else if (with_value.contains(arg)) {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "--in") in_name = v;
+            else if (arg == "--out") out_name = v;
+            else if (arg == "--from") read = oc::tool::read_positive(arg, v, from);
+            else if (arg == "--to") read = oc::tool::read_positive(arg, v, to.emplace());
+            else if (arg == "--points") read = oc::tool::read_positive(arg, v, points);
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, options.dt.emplace());
+            else if (arg == "--cal") calibration_file = v;
+            else if (arg == "--amplitude") read = oc::tool::read_number(arg, v, sweep.amplitude);
+            else if (arg == "--periods") read = oc::tool::read_positive(arg, v, sweep.periods);
+            else if (arg == "--settle") read = oc::tool::read_number(arg, v, sweep.settle_time);
+            else if (arg == "--threads") read = oc::tool::read_positive(arg, v, threads);
+            else if (arg == "-o") output_file = v;
+            else {
+                auto eq = v.find('=');
+                if (eq == std::string::npos) {
+                    std::println(stderr, "Error: --set expects <inport>=<value>");
+                    return 1;
+                }
+                float level = 0.0f;
+                read = oc::tool::read_number(arg, std::string_view(v).substr(eq + 1), level);
+                held.emplace_back(v.substr(0, eq), level);
+            }
+            if (!read) return 1;
+        } else if (input_file.empty()) {
+            input_file = std::string(arg);
+        } else {
+            subsystem = std::string(arg);
+        }
+    }
+
+    if (input_file.empty() || subsystem.empty()) {
+        std::println(stderr, "Error: An input file and a subsystem are required");
+        return 1;
+    }
+
+    if (!calibration_file.empty()) {
+        std::ifstream file(calibration_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", calibration_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        options.calibration = oc::codegen::parse_calibration(text.str());
+    }
+
+    oc::mdl::parser parser;
+    if (!parser.load(input_file)) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& model = parser.get_model();
+    const auto* root = model.root_system();
+    if (!root) {
+        std::println(stderr, "Error: No root system found");
+        return 1;
+    }
+
+    const auto* chosen = oc::tool::find_subsystem(model, subsystem);
+    const auto* sys = chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    if (!sys) {
+        std::println(stderr, "Error: No subsystem matching '{}'", subsystem);
+        return 1;
+    }
+
+    oc::sim::simulator sim(model, *sys, options);
+    for (const auto& warning : sim.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    if (sim.inputs().empty() || sim.outputs().empty()) {
+        std::println(stderr, "Error: {} needs an inport and an outport", chosen->name);
+        return 1;
+    }
+    auto input = in_name.empty() ? std::optional<std::size_t>(0) : oc::tool::port_index(sim.inputs(), in_name);
+    if (!input) {
+        std::println(stderr, "Error: No inport '{}'", in_name);
+        return 1;
+    }
+    std::optional<std::uint32_t> output;
+    if (out_name.empty()) output = sim.output_slot(0);
+    else if (auto port = oc::tool::port_index(sim.outputs(), out_name)) output = sim.output_slot(*port);
+    else output = sim.find_signal(out_name);
+    if (!output) {
+        std::println(stderr, "Error: No outport or signal '{}'", out_name);
+        return 1;
+    }
+    auto path = sim.inputs()[*input] + " -> " + (out_name.empty() ? sim.outputs()[0] : out_name);
+
+    std::vector<float> operating(sim.inputs().size(), 0.0f);
+    for (const auto& [name, v] : held) {
+        auto index = oc::tool::port_index(sim.inputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        operating[*index] = v;
+    }
+
+    auto grid = oc::freq::log_grid(from, to.value_or(0.5 / sim.dt()), points);
+    std::vector<double> hz = grid;
+    std::vector<std::complex<double>> response(grid.size());
+
+    auto linear = sim.linear_path(*input, *output);
+    if (linear.nonlinear.empty() && !simulate) {
+        auto start = std::chrono::steady_clock::now();
+        auto tf = oc::freq::compose(linear);
+        auto composed = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < grid.size(); ++i) response[i] = oc::freq::evaluate(tf, sim.dt(), grid[i]);
+        auto evaluated = std::chrono::steady_clock::now();
+
+        std::println("{}: {} is linear with {} states, H(z) of order {}", chosen->name, path, linear.states, tf.order());
+        std::println("  num {}", format_polynomial(tf.num));
+        std::println("  den {}", format_polynomial(tf.den));
+        std::println("Composed in {:.1f} us, {} frequencies evaluated in {:.1f} us",
+                     std::chrono::duration<double, std::micro>(composed - start).count(), grid.size(),
+                     std::chrono::duration<double, std::micro>(evaluated - composed).count());
+    } else {
+        if (!linear.nonlinear.empty()) {
+            std::println("{}: {} is nonlinear through '{}', sweeping {} frequencies on {} threads", chosen->name, path,
+                         linear.nonlinear, grid.size(), std::min(threads, grid.size()));
+        } else {
+            std::println("{}: {} is linear with {} states, sweeping {} frequencies on {} threads", chosen->name, path,
+                         linear.states, grid.size(), std::min(threads, grid.size()));
+        }
+
+        // The lowest frequencies take longest and come first in the grid
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<std::size_t> next{0};
+        std::atomic<long long> steps{0};
+        std::vector<std::thread> workers;
+        for (std::size_t w = 0; w < std::min(threads, grid.size()); ++w) {
+            workers.emplace_back([&] {
+                oc::sim::simulator local(model, *sys, options);
+                for (auto job = next.fetch_add(1); job < grid.size(); job = next.fetch_add(1)) {
+                    auto m = oc::freq::measure(local, operating, *input, *output, grid[job], sweep);
+                    hz[job] = m.hz;
+                    response[job] = m.response;
+                    steps += m.steps;
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::println("Swept in {:.3f} s: {} simulated steps, {:.1f} M steps/s", seconds, steps.load(),
+                     static_cast<double>(steps.load()) / seconds * 1e-6);
+    }
+
+    if (output_file.empty()) output_file = oc::codegen::sanitize_name(chosen->name) + "_bode.csv";
+    std::ofstream out(output_file);
+    if (!out) {
+        std::println(stderr, "Error: Could not write {}", output_file);
+        return 1;
+    }
+    out << "frequency_hz,magnitude_db,phase_deg\n" << std::setprecision(9);
+    for (const auto& p : oc::freq::bode(hz, response)) out << p.hz << ',' << p.magnitude_db << ',' << p.phase_deg << '\n';
+    std::println("Bode data: {}", output_file);
+    return 0;
+}
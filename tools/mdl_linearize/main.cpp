@@ -0,0 +1,243 @@
+//
+// Open Controls - MDL Linearization
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_linearize.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <print>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <input.mdl> <subsystem> [options]", program);
+        std::println("");
+        std::println("Discrete-time A, B, C and D of one step of a subsystem around an operating");
+        std::println("point, by central differences: every state and inport is perturbed up and");
+        std::println("down in its own run, and the runs are stepped in batches on all cores.");
+        std::println("  x[k] = A x[k-1] + B u[k],  y[k] = C x[k-1] + D u[k]");
+        std::println("");
+        std::println("Options:");
+        std::println("  --out <port|path>   Outport, or a signal such as Sub/Block:2 (repeatable; default all outports)");
+        std::println("  --cal <cal.yaml>    Parameter values, as for mdl_sim");
+        std::println("  --dt <s>            Step size (default: dt from --cal, else 0.001)");
+        std::println("  --set <in>=<v>      Inport value at the operating point (default 0)");
+        std::println("  --time <s>          Simulate this long with the --set inputs to reach the operating point");
+        std::println("  --steps <n>         Steps to simulate, instead of --time");
+        std::println("  --delta <f>         Perturbation, relative to max(1, |value|) (default 0.01)");
+        std::println("  --full              Keep every state, not only those the inputs reach and the outputs see");
+        std::println("  --lanes <n>         Perturbed runs stepped together per batch (default 64)");
+        std::println("  --threads <n>       Worker threads (default: all cores)");
+        std::println("  -o <linear.yaml>    Output (default <subsystem>_linear.yaml)");
+    }
+
+    [[nodiscard]] auto quoted(const std::string& text) -> std::string {
+        std::string result = "\"";
+        for (char ch : text) {
+            if (ch == '"' || ch == '\\') result += '\\';
+            result += ch;
+        }
+        return result + '"';
+    }
+
+    [[nodiscard]] auto format_row(std::span<const double> values) -> std::string {
+        std::ostringstream text;
+        text << std::setprecision(9) << '[';
+        for (std::size_t i = 0; i < values.size(); ++i) text << (i ? ", " : "") << values[i];
+        text << ']';
+        return text.str();
+    }
+
+    [[nodiscard]] auto format_names(const std::vector<std::string>& names) -> std::string {
+        std::string text = "[";
+        for (std::size_t i = 0; i < names.size(); ++i) text += (i ? ", " : "") + quoted(names[i]);
+        return text + "]";
+    }
+
+    // A matrix as a list of rows; an empty one keeps its shape readable as []
+    void write_matrix(std::ostream& out, std::string_view name, const std::vector<double>& values, std::size_t rows, std::size_t cols) {
+        if (rows == 0 || cols == 0) {
+            out << name << ": []\n";
+            return;
+        }
+        out << name << ":\n";
+        for (std::size_t r = 0; r < rows; ++r) {
+            out << "  - " << format_row(std::span(values).subspan(r * cols, cols)) << '\n';
+        }
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return argc == 2 && (std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help") ? 0 : 1;
+    }
+
+    std::string input_file;
+    std::string subsystem;
+    std::string calibration_file;
+    std::string output_file;
+    std::vector<std::string> out_names;
+    std::vector<std::pair<std::string, float>> held;
+    std::optional<double> time;
+    std::optional<long long> steps;
+    oc::sim::sim_options options;
+    oc::lin::linearize_options linear;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        static const std::set<std::string_view> with_value = {
+            "--out", "--cal", "--dt", "--set", "--time", "--steps", "--delta", "--lanes", "--threads", "-o"
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--full") {
+            linear.minimal = false;
+        } else if (with_value.contains(arg)) {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "--out") out_names.push_back(v);
+            else if (arg == "--cal") calibration_file = v;
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, options.dt.emplace());
+            else if (arg == "--time") read = oc::tool::read_number(arg, v, time.emplace());
+            else if (arg == "--steps") read = oc::tool::read_number(arg, v, steps.emplace());
+            else if (arg == "--delta") read = oc::tool::read_positive(arg, v, linear.delta);
+            else if (arg == "--lanes") read = oc::tool::read_positive(arg, v, linear.lanes);
+            else if (arg == "--threads") read = oc::tool::read_positive(arg, v, linear.threads);
+            else if (arg == "-o") output_file = v;
+            else {
+                auto eq = v.find('=');
+                if (eq == std::string::npos) {
+                    std::println(stderr, "Error: --set expects <inport>=<value>");
+                    return 1;
+                }
+                float level = 0.0f;
+                read = oc::tool::read_number(arg, std::string_view(v).substr(eq + 1), level);
+                held.emplace_back(v.substr(0, eq), level);
+            }
+            if (!read) return 1;
+        } else if (input_file.empty()) {
+            input_file = std::string(arg);
+        } else {
+            subsystem = std::string(arg);
+        }
+    }
+
+    if (input_file.empty() || subsystem.empty()) {
+        std::println(stderr, "Error: An input file and a subsystem are required");
+        return 1;
+    }
+
+    if (!calibration_file.empty()) {
+        std::ifstream file(calibration_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", calibration_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        options.calibration = oc::codegen::parse_calibration(text.str());
+    }
+
+    oc::mdl::parser parser;
+    if (!parser.load(input_file)) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& model = parser.get_model();
+    const auto* root = model.root_system();
+    if (!root) {
+        std::println(stderr, "Error: No root system found");
+        return 1;
+    }
+
+    const auto* chosen = oc::tool::find_subsystem(model, subsystem);
+    const auto* sys = chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    if (!sys) {
+        std::println(stderr, "Error: No subsystem matching '{}'", subsystem);
+        return 1;
+    }
+
+    oc::sim::simulator sim(model, *sys, options);
+    for (const auto& warning : sim.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    std::vector<std::uint32_t> output_slots;
+    if (out_names.empty()) {
+        out_names = sim.outputs();
+        for (std::size_t i = 0; i < sim.outputs().size(); ++i) output_slots.push_back(sim.output_slot(i));
+    } else {
+        for (const auto& name : out_names) {
+            std::optional<std::uint32_t> slot;
+            if (auto port = oc::tool::port_index(sim.outputs(), name)) slot = sim.output_slot(*port);
+            else slot = sim.find_signal(name);
+            if (!slot) {
+                std::println(stderr, "Error: No outport or signal '{}'", name);
+                return 1;
+            }
+            output_slots.push_back(*slot);
+        }
+    }
+    for (const auto& [name, v] : held) {
+        auto index = oc::tool::port_index(sim.inputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        sim.set_input(*index, v);
+    }
+
+    auto settle = steps.value_or(time ? std::llround(*time / sim.dt()) : 0);
+    for (long long k = 0; k < settle; ++k) sim.step();
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = oc::lin::linearize(sim, output_slots, linear);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto n = result.states.size();
+    auto m = result.inputs.size();
+    auto p = output_slots.size();
+    std::println("{}: {} states ({} kept), {} inputs, {} outputs at t = {} s", chosen->name, result.all_states, n, m, p,
+                 static_cast<double>(settle) * sim.dt());
+    std::println("Linearized in {:.3f} ms: {} perturbed steps", seconds * 1e3, result.runs);
+
+    if (output_file.empty()) output_file = oc::codegen::sanitize_name(chosen->name) + "_linear.yaml";
+    std::ofstream out(output_file);
+    if (!out) {
+        std::println(stderr, "Error: Could not write {}", output_file);
+        return 1;
+    }
+    out << "# " << chosen->name << " linearized by mdl_linearize\n";
+    out << "# x[k] = A x[k-1] + B u[k], y[k] = C x[k-1] + D u[k]\n";
+    out << "dt: " << sim.dt() << '\n';
+    out << "time: " << static_cast<double>(settle) * sim.dt() << '\n';
+    out << "delta: " << linear.delta << '\n';
+    out << "states: " << format_names(result.states) << '\n';
+    out << "inputs: " << format_names(result.inputs) << '\n';
+    out << "outputs: " << format_names(out_names) << '\n';
+    out << "x: " << format_row(result.x) << '\n';
+    out << "u: " << format_row(result.u) << '\n';
+    out << "y: " << format_row(result.y) << '\n';
+    write_matrix(out, "A", result.a, n, n);
+    write_matrix(out, "B", result.b, n, m);
+    write_matrix(out, "C", result.c, p, n);
+    write_matrix(out, "D", result.d, p, m);
+    std::println("Linear model: {}", output_file);
+    return 0;
+}
@@ -0,0 +1,422 @@
+//
+// Open Controls - MDL Simulator
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_checkpoint.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include "../libmdl/oc_trace.hpp"
+#include "../mdl_to_yaml/yaml_writer.hpp"
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <print>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <input.mdl> <subsystem> [options]", program);
+        std::println("");
+        std::println("Runs a subsystem of the library without generating code and writes a trace");
+        std::println("of its outports, one CSV row per step.");
+        std::println("");
+        std::println("Options:");
+        std::println("  --time <s>        Simulated time (default 1)");
+        std::println("  --steps <n>       Number of steps, instead of --time");
+        std::println("  --dt <s>          Step size (default: dt from --cal, else 0.001)");
+        std::println("  --cal <cal.yaml>  Parameter values, as for mdl_to_cpp --specialize; other");
+        std::println("                    config names read 0 like the generated config struct");
+        std::println("  --set <in>=<v>    Hold an inport at a value");
+        std::println("  --input <in.csv>  Inport values per step, one column per inport name (or the");
+        std::println("                    IN signals of a .oct trace); the last row holds once it ends");
+        std::println("  --probe <path>    Also trace an internal signal, e.g. Block or Sub/Block:2");
+        std::println("  --decimate <k>    Write every k-th step");
+        std::println("  --tiered          Start interpreted and switch to native code once it has");
+        std::println("                    been compiled in the background");
+        std::println("  --native          Compile to native code before the first step");
+        std::println("  --cache-dir <dir> Compiled systems (default ~/.cache/open-controls)");
+        std::println("  --solver ode45    Integrate Integrator and TransferFcn blocks with a variable-step");
+        std::println("                    Dormand-Prince solver; CSV traces get a row per solver step");
+        std::println("  --rtol <r>        Relative tolerance of the solver (default 1e-4)");
+        std::println("  --atol <a>        Absolute tolerance of the solver (default 1e-6)");
+        std::println("  --max-step <s>    Largest solver step (default: dt with discrete blocks, else none)");
+        std::println("  --checkpoint <p>  Save the full state as <p>-<step>.ocp from a background thread");
+        std::println("  --checkpoint-every <s>  Simulated time between checkpoints (default 60)");
+        std::println("  --resume <f.ocp>  Continue a run from a checkpoint, with the same model, --cal and");
+        std::println("                    --input; the trace starts at the checkpoint");
+        std::println("  -o <trace.csv>    Trace file (default <subsystem>_trace.csv); a .oct name writes");
+        std::println("                    a binary trace of the inports, outports and probes");
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input_file;
+    std::string subsystem;
+    std::string calibration_file;
+    std::string input_csv;
+    std::string output_file;
+    std::vector<std::pair<std::string, float>> held;
+    std::vector<std::string> probes;
+    double duration = 1.0;
+    std::optional<long long> steps;
+    long long decimate = 1;
+    oc::sim::sim_options options;
+    oc::sim::native_options native;
+    bool tiered = false;
+    bool native_first = false;
+    std::string checkpoint_prefix;
+    std::string resume_file;
+    double checkpoint_every = 60.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::optional<std::string> {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return std::nullopt;
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--tiered") {
+            tiered = true;
+        } else if (arg == "--native") {
+            native_first = true;
+        } else if (arg == "--time" || arg == "--steps" || arg == "--dt" || arg == "--decimate" || arg == "--cal" ||
+                   arg == "--set" || arg == "--input" || arg == "--probe" || arg == "--cache-dir" || arg == "--solver" ||
+                   arg == "--rtol" || arg == "--atol" || arg == "--max-step" || arg == "--checkpoint" ||
+                   arg == "--checkpoint-every" || arg == "--resume" || arg == "-o") {
+            auto v = value();
+            if (!v) return 1;
+            bool read = true;
+            if (arg == "--time") read = oc::tool::read_number(arg, *v, duration);
+            else if (arg == "--steps") read = oc::tool::read_number(arg, *v, steps.emplace());
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, *v, options.dt.emplace());
+            else if (arg == "--decimate") read = oc::tool::read_positive(arg, *v, decimate);
+            else if (arg == "--cal") calibration_file = *v;
+            else if (arg == "--input") input_csv = *v;
+            else if (arg == "--probe") probes.push_back(*v);
+            else if (arg == "--cache-dir") native.cache_dir = *v;
+            else if (arg == "--rtol") read = oc::tool::read_number(arg, *v, options.rel_tol);
+            else if (arg == "--atol") read = oc::tool::read_number(arg, *v, options.abs_tol);
+            else if (arg == "--max-step") read = oc::tool::read_number(arg, *v, options.max_step);
+            else if (arg == "--checkpoint") checkpoint_prefix = *v;
+            else if (arg == "--checkpoint-every") read = oc::tool::read_positive(arg, *v, checkpoint_every);
+            else if (arg == "--resume") resume_file = *v;
+            else if (arg == "--solver") {
+                if (*v != "ode45" && *v != "fixed") {
+                    std::println(stderr, "Error: Unknown solver '{}' (fixed or ode45)", *v);
+                    return 1;
+                }
+                options.solver = *v == "ode45" ? oc::sim::solver_kind::ode45 : oc::sim::solver_kind::fixed;
+            }
+            else if (arg == "-o") output_file = *v;
+            else {
+                auto eq = v->find('=');
+                if (eq == std::string::npos) {
+                    std::println(stderr, "Error: --set expects <inport>=<value>");
+                    return 1;
+                }
+                float level = 0.0f;
+                read = oc::tool::read_number(arg, std::string_view(*v).substr(eq + 1), level);
+                held.emplace_back(v->substr(0, eq), level);
+            }
+            if (!read) return 1;
+        } else if (input_file.empty()) {
+            input_file = std::string(arg);
+        } else {
+            subsystem = std::string(arg);
+        }
+    }
+
+    if (input_file.empty() || subsystem.empty()) {
+        std::println(stderr, "Error: An input file and a subsystem are required");
+        return 1;
+    }
+
+    if (!calibration_file.empty()) {
+        std::ifstream file(calibration_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", calibration_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        options.calibration = oc::codegen::parse_calibration(text.str());
+        if (auto dt = options.calibration.find("dt"); !options.dt && dt != options.calibration.end() && !(dt->second > 0.0)) {
+            std::println(stderr, "Error: dt in {} has to be above 0", calibration_file);
+            return 1;
+        }
+    }
+
+    oc::mdl::parser parser;
+    if (!parser.load(input_file)) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& model = parser.get_model();
+    const auto* root = model.root_system();
+    if (!root) {
+        std::println(stderr, "Error: No root system found");
+        return 1;
+    }
+
+    const auto* chosen = oc::tool::find_subsystem(model, subsystem);
+    const auto* sys = chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    if (!sys) {
+        std::println(stderr, "Error: No subsystem matching '{}'", subsystem);
+        return 1;
+    }
+
+    auto compile_start = std::chrono::steady_clock::now();
+    oc::sim::simulator sim(model, *sys, options);
+    auto compile_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - compile_start).count();
+
+    for (const auto& warning : sim.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    // Inputs and state as saved; the input table below carries on from the saved cursor
+    std::uint64_t cursor = 0;
+    double resumed_at = 0.0;
+    if (!resume_file.empty()) {
+        std::string error;
+        auto saved = oc::checkpoint::read(resume_file, error);
+        if (!saved) {
+            std::println(stderr, "Error: {}", error);
+            return 1;
+        }
+        if (!sim.restore(saved->state)) {
+            std::println(stderr, "Error: {} was saved from a different system, calibration, dt or solver", resume_file);
+            return 1;
+        }
+        cursor = saved->cursor;
+        resumed_at = options.solver == oc::sim::solver_kind::ode45 ? sim.time() : static_cast<double>(sim.step_count()) * sim.dt();
+    }
+
+    auto input_index = [&](const std::string& name) { return oc::tool::port_index(sim.inputs(), name); };
+    for (const auto& [name, v] : held) {
+        auto index = input_index(name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        sim.set_input(*index, v);
+    }
+
+    oc::tool::table table;
+    std::vector<std::pair<std::size_t, std::size_t>> columns;  // {table column or trace signal, inport}
+    oc::trace::reader input_trace;
+    if (input_csv.ends_with(".oct")) {
+        if (!input_trace.load(input_csv)) {
+            std::println(stderr, "Error: {}", input_trace.error());
+            return 1;
+        }
+        for (std::size_t c = 0; c < input_trace.signals().size(); ++c) {
+            const auto& sig = input_trace.signals()[c];
+            if (sig.kind != oc::trace::group::input && sig.kind != oc::trace::group::probe) continue;
+            if (auto index = input_index(sig.name)) columns.emplace_back(c, *index);
+        }
+    } else if (!input_csv.empty()) {
+        auto read = oc::tool::read_csv(input_csv);
+        if (!read) {
+            std::println(stderr, "Error: Could not read {}", input_csv);
+            return 1;
+        }
+        table = std::move(*read);
+        for (std::size_t c = 0; c < table.columns.size(); ++c) {
+            if (auto index = input_index(table.columns[c])) columns.emplace_back(c, *index);
+        }
+    }
+
+    std::vector<std::pair<std::string, std::uint32_t>> traced;
+    for (const auto& path : probes) {
+        auto slot = sim.find_signal(path);
+        if (!slot) {
+            std::println(stderr, "Error: No signal '{}'", path);
+            return 1;
+        }
+        traced.emplace_back(path, *slot);
+    }
+
+    if (output_file.empty()) output_file = oc::codegen::sanitize_name(chosen->name) + "_trace.csv";
+    bool binary = output_file.ends_with(".oct");
+    std::ofstream out;
+    oc::trace::writer trace;
+    std::vector<float> row;
+    if (binary) {
+        // Columns keyed by the element's interface, which the trace carries along
+        oc::mdl::system named = *sys;
+        named.name = chosen->name;
+        oc::yaml::converter converter;
+        converter.set_model(&model);
+        auto schema = oc::yaml::writer{}.write(converter.convert(named));
+
+        std::vector<oc::trace::signal> signals;
+        for (const auto& name : sim.inputs()) signals.push_back({name, oc::trace::group::input});
+        for (const auto& name : sim.outputs()) signals.push_back({name, oc::trace::group::output});
+        for (const auto& [path, slot] : traced) signals.push_back({path, oc::trace::group::probe});
+        row.resize(signals.size());
+        if (!trace.open(output_file, std::move(signals), sim.dt() * static_cast<double>(decimate), schema)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+    } else {
+        out.open(output_file, std::ios::binary);
+        if (!out) {
+            std::println(stderr, "Error: Could not write {}", output_file);
+            return 1;
+        }
+    }
+
+    std::string text = "time";
+    for (const auto& name : sim.outputs()) text += "," + name;
+    for (const auto& [path, slot] : traced) text += "," + path;
+    text += "\n";
+
+    native.name = oc::codegen::sanitize_name(chosen->name);
+    bool variable = options.solver == oc::sim::solver_kind::ode45;
+    if (variable && (tiered || native_first)) {
+        std::println(stderr, "Error: --tiered and --native run the fixed-step stream; drop them with --solver ode45");
+        return 1;
+    }
+    if (tiered || native_first) sim.start_native(native);
+    if (native_first && !sim.wait_native()) {
+        std::println(stderr, "Error: Native build failed: {}", sim.native_status());
+        return 1;
+    }
+
+    auto total = steps.value_or(static_cast<long long>(std::llround(duration / sim.dt())));
+    long long rows = static_cast<long long>(cursor);
+    auto write_row = [&](double time) {
+        if (++rows % decimate != 0) return;
+        if (binary) {
+            std::size_t c = 0;
+            for (std::size_t i = 0; i < sim.inputs().size(); ++i) row[c++] = sim.input(i);
+            for (std::size_t i = 0; i < sim.outputs().size(); ++i) row[c++] = sim.output(i);
+            for (const auto& [path, slot] : traced) row[c++] = sim.signal(slot);
+            trace.append(row);
+            return;
+        }
+        oc::tool::append_float(text, static_cast<float>(time));
+        for (std::size_t i = 0; i < sim.outputs().size(); ++i) {
+            text += ',';
+            oc::tool::append_float(text, sim.output(i));
+        }
+        for (const auto& [path, slot] : traced) {
+            text += ',';
+            oc::tool::append_float(text, sim.signal(slot));
+        }
+        text += '\n';
+        if (text.size() > (1 << 20)) {
+            out << text;
+            text.clear();
+        }
+    };
+
+    // The solver runs through to the end unless inputs change every dt or a binary trace needs a
+    // uniform sample period; a CSV trace gets one row per solver step either way
+    bool solver_rows = variable && !binary;
+    long long intervals = variable && table.rows.empty() && input_trace.rows() == 0 && !binary ? 1 : total;
+    std::chrono::steady_clock::duration stepping{};
+    std::chrono::steady_clock::duration native_stepping{};
+
+    // Checkpoints fall on multiples of the interval in simulated time, resumed runs included
+    std::optional<oc::checkpoint::writer> checkpoints;
+    auto next_checkpoint = (std::floor(resumed_at / checkpoint_every + 1e-9) + 1.0) * checkpoint_every;
+    if (!checkpoint_prefix.empty()) checkpoints.emplace(checkpoint_prefix);
+    auto checkpoint = [&](double time, std::uint64_t position) {
+        if (!checkpoints || time < next_checkpoint - 1e-9 * sim.dt()) return;
+        checkpoints->take(sim, position, std::llround(time / sim.dt()));
+        while (next_checkpoint <= time + 1e-9 * sim.dt()) next_checkpoint += checkpoint_every;
+    };
+
+    for (auto k = static_cast<long long>(cursor); k < intervals; ++k) {
+        if (!table.rows.empty()) {
+            const auto& values = table.rows[std::min<std::size_t>(k, table.rows.size() - 1)];
+            for (auto [column, index] : columns) sim.set_input(index, values[column]);
+        } else if (input_trace.rows() > 0) {
+            auto at = std::min<std::uint64_t>(static_cast<std::uint64_t>(k), input_trace.rows() - 1);
+            for (auto [column, index] : columns) sim.set_input(index, input_trace.value(column, at));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (variable) {
+            auto until = static_cast<double>(k + 1 == intervals ? total : k + 1) * sim.dt();
+            while (sim.solver_step(until)) {
+                if (solver_rows) {
+                    stepping += std::chrono::steady_clock::now() - start;
+                    write_row(sim.time());
+                    checkpoint(sim.time(), static_cast<std::uint64_t>(k));
+                    start = std::chrono::steady_clock::now();
+                }
+            }
+            stepping += std::chrono::steady_clock::now() - start;
+            if (!solver_rows) write_row(sim.time());
+            checkpoint(sim.time(), static_cast<std::uint64_t>(k + 1));
+            continue;
+        }
+        sim.step();
+        (sim.native_since() >= 0 ? native_stepping : stepping) += std::chrono::steady_clock::now() - start;
+        write_row(static_cast<double>(k + 1) * sim.dt());
+        checkpoint(static_cast<double>(k + 1) * sim.dt(), static_cast<std::uint64_t>(k + 1));
+    }
+    if (binary) trace.close();
+    else out << text;
+    if (checkpoints) checkpoints->close();
+
+    sim.wait_native();
+
+    std::println("{}: {} blocks, {} instructions, {} signals (compiled in {:.2f} ms)", chosen->name, sim.block_count(),
+                 sim.instruction_count(), sim.signal_count(), compile_time * 1e3);
+    auto report = [&](std::string_view tier, long long count, std::chrono::steady_clock::duration time) {
+        if (count <= 0) return;
+        auto seconds = std::chrono::duration<double>(time).count();
+        auto per_step = seconds / static_cast<double>(count) * 1e9;
+        std::println("{} {}steps of {} s in {:.3f} ms: {:.1f} ns/step, {:.2f} ns/block", count, tier, sim.dt(), seconds * 1e3,
+                     per_step, sim.block_count() > 0 ? per_step / static_cast<double>(sim.block_count()) : 0.0);
+    };
+    if (!resume_file.empty()) std::println("Resumed from {} at t = {} s", resume_file, resumed_at);
+    if (checkpoints) {
+        if (!checkpoints->error().empty()) std::println(stderr, "Error: {}", checkpoints->error());
+        std::println("Checkpoints: {} written every {} s{}{}", checkpoints->written(), checkpoint_every,
+                     checkpoints->written() ? ", last " + checkpoints->last() : std::string(),
+                     checkpoints->dropped() ? ", " + std::to_string(checkpoints->dropped()) + " replaced before the disk caught up"
+                                            : std::string());
+    }
+    if (variable) {
+        const auto& stats = sim.stats();
+        auto seconds = std::chrono::duration<double>(stepping).count();
+        std::println("{} solver steps over {} s for {} continuous states in {:.3f} ms ({} fixed steps of {} s)", stats.steps,
+                     sim.time(), sim.continuous_states(), seconds * 1e3, total, sim.dt());
+        std::println("{} rejected, {} evaluations, {} zero crossings located", stats.rejected, stats.evaluations,
+                     stats.zero_crossings);
+        std::println("Trace: {}", output_file);
+        return 0;
+    }
+    auto first = static_cast<long long>(cursor);
+    auto switched = sim.native_since() >= 0 ? sim.native_since() : total;
+    report(tiered || native_first ? "interpreted " : "", switched - first, stepping);
+    report("native ", total - switched, native_stepping);
+    if (tiered || native_first) {
+        std::println("Native: {} in {:.1f} ms{}", sim.native_status(), sim.native_build_seconds() * 1e3,
+                     sim.native_since() >= 0 ? ", running from step " + std::to_string(sim.native_since()) : std::string());
+    }
+    std::println("Trace: {}", output_file);
+    return 0;
+}
@@ -0,0 +1,594 @@
+//
+// Open Controls - MDL Parameter Sweep
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_sim.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <random>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <input.mdl> <subsystem> --space <space.yaml> [options]", program);
+        std::println("");
+        std::println("Simulates a subsystem over every combination of the config values in the");
+        std::println("space file, on all cores, and writes one row of summary metrics per run.");
+        std::println("");
+        std::println("Space file, one config name per line:");
+        std::println("  kp: [0.5, 1, 2]            Values to sweep");
+        std::println("  ki: 0.1:0.1:0.5            lo:step:hi");
+        std::println("  tau: uniform(0.01, 0.02)   Drawn per Monte Carlo sample");
+        std::println("  gain: normal(1, 0.05)      Drawn per Monte Carlo sample");
+        std::println("");
+        std::println("Options:");
+        std::println("  --space <file>      Parameter space (required)");
+        std::println("  --cal <cal.yaml>    Values of the config names the space leaves fixed");
+        std::println("  --samples <n>       Monte Carlo samples per grid point (default 1)");
+        std::println("  --seeds <n>         Noise seeds per sample (default 1)");
+        std::println("  --seed <n>          Base seed (default 1)");
+        std::println("  --time <s>          Simulated time per run (default 1)");
+        std::println("  --steps <n>         Steps per run, instead of --time");
+        std::println("  --dt <s>            Step size (default: dt from --cal, else 0.001)");
+        std::println("  --set <in>=<v>      Hold an inport at a value (a step at t = 0)");
+        std::println("  --noise <in>=<sd>   Add Gaussian noise to an inport, per step and seed");
+        std::println("  --output <out>      Outport to score (repeatable; default all)");
+        std::println("  --target <out>=<v>  Value the outport should reach (default its final value)");
+        std::println("  --band <f>          Settling band as a fraction of the step (default 0.02)");
+        std::println("  --threads <n>       Worker threads (default: all cores)");
+        std::println("  --batch <n>         Runs stepped together per worker (default 8)");
+        std::println("  -o <results.csv>    Results file (default <subsystem>_sweep.csv)");
+    }
+
+    // One config name of the parameter space: a list of values, or a distribution to draw from
+    struct dimension {
+        enum class kind { grid, uniform, normal };
+        std::string name;
+        kind type = kind::grid;
+        std::vector<double> values;
+        double a = 0.0;
+        double b = 0.0;
+    };
+
+    [[nodiscard]] auto trim(std::string_view text) -> std::string_view {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+        return text;
+    }
+
+    [[nodiscard]] auto parse_numbers(std::string_view text) -> std::vector<double> {
+        std::vector<double> numbers;
+        std::string current;
+        for (char c : std::string(text) + ",") {
+            if (c == ',' || c == ' ' || c == '\t' || c == ';') {
+                if (!current.empty()) numbers.push_back(std::strtod(current.c_str(), nullptr));
+                current.clear();
+            } else {
+                current += c;
+            }
+        }
+        return numbers;
+    }
+
+    // "name: [a, b]", "name: lo:step:hi", "name: uniform(lo, hi)", "name: normal(mean, sd)" or "name: value"
+    [[nodiscard]] auto parse_space(const std::string& text) -> std::optional<std::vector<dimension>> {
+        std::vector<dimension> space;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);) {
+            if (auto hash = line.find('#'); hash != std::string::npos) line.erase(hash);
+            auto colon = line.find(':');
+            if (trim(line).empty()) continue;
+            if (colon == std::string::npos) {
+                std::println(stderr, "Error: Expected 'name: values' in '{}'", trim(line));
+                return std::nullopt;
+            }
+
+            dimension dim;
+            dim.name = std::string(trim(std::string_view(line).substr(0, colon)));
+            auto spec = trim(std::string_view(line).substr(colon + 1));
+            auto args = [&](std::string_view prefix) {
+                auto inner = spec.substr(prefix.size(), spec.size() - prefix.size() - 1);
+                return parse_numbers(inner);
+            };
+
+            if ((spec.starts_with("uniform(") || spec.starts_with("normal(")) && spec.ends_with(")")) {
+                bool uniform = spec.starts_with("uniform(");
+                auto numbers = args(uniform ? "uniform(" : "normal(");
+                if (numbers.size() != 2) {
+                    std::println(stderr, "Error: {} for '{}' takes two numbers", uniform ? "uniform" : "normal", dim.name);
+                    return std::nullopt;
+                }
+                dim.type = uniform ? dimension::kind::uniform : dimension::kind::normal;
+                dim.a = numbers[0];
+                dim.b = numbers[1];
+            } else if (spec.starts_with("[") && spec.ends_with("]")) {
+                dim.values = args("[");
+            } else if (std::ranges::count(spec, ':') == 2) {
+                auto numbers = parse_numbers(std::string(spec).replace(spec.find(':'), 1, ",").replace(spec.rfind(':'), 1, ","));
+                if (numbers.size() != 3 || numbers[1] == 0.0 || (numbers[2] - numbers[0]) / numbers[1] < 0) {
+                    std::println(stderr, "Error: Bad range '{}' for '{}'", spec, dim.name);
+                    return std::nullopt;
+                }
+                auto count = static_cast<std::size_t>(std::floor((numbers[2] - numbers[0]) / numbers[1] + 1e-9)) + 1;
+                for (std::size_t i = 0; i < count; ++i) dim.values.push_back(numbers[0] + static_cast<double>(i) * numbers[1]);
+            } else {
+                dim.values = parse_numbers(spec);
+            }
+
+            if (dim.type == dimension::kind::grid && dim.values.empty()) {
+                std::println(stderr, "Error: No values for '{}'", dim.name);
+                return std::nullopt;
+            }
+            space.push_back(std::move(dim));
+        }
+        return space;
+    }
+
+    // Batches split into one contiguous range per worker. A worker takes from the front of its
+    // own range and, once that is empty, steals from the range with the most batches left.
+    class job_ranges {
+    public:
+        job_ranges(std::size_t jobs, std::size_t workers) : ranges_(workers) {
+            for (std::size_t w = 0; w < workers; ++w) {
+                ranges_[w].next.store(jobs * w / workers, std::memory_order_relaxed);
+                ranges_[w].end = jobs * (w + 1) / workers;
+            }
+        }
+
+        auto take(std::size_t worker) -> std::optional<std::size_t> {
+            if (auto job = claim(ranges_[worker])) return job;
+            while (true) {
+                std::size_t victim = ranges_.size();
+                std::size_t most = 0;
+                for (std::size_t w = 0; w < ranges_.size(); ++w) {
+                    auto next = ranges_[w].next.load(std::memory_order_relaxed);
+                    if (next < ranges_[w].end && ranges_[w].end - next > most) {
+                        most = ranges_[w].end - next;
+                        victim = w;
+                    }
+                }
+                if (victim == ranges_.size()) return std::nullopt;
+                if (auto job = claim(ranges_[victim])) {
+                    steals_.fetch_add(1, std::memory_order_relaxed);
+                    return job;
+                }
+            }
+        }
+
+        [[nodiscard]] auto steals() const -> std::size_t { return steals_.load(); }
+
+    private:
+        struct range {
+            std::atomic<std::size_t> next{0};
+            std::size_t end = 0;
+        };
+
+        static auto claim(range& r) -> std::optional<std::size_t> {
+            auto job = r.next.fetch_add(1, std::memory_order_relaxed);
+            return job < r.end ? std::optional(job) : std::nullopt;
+        }
+
+        std::vector<range> ranges_;
+        std::atomic<std::size_t> steals_{0};
+    };
+
+    // Step response summary of one outport
+    struct metrics {
+        float overshoot = 0.0f;  // percent of the step beyond the target
+        float settling = 0.0f;   // time after which it stays within the band; NaN if it never does
+        float iae = 0.0f;        // integral of |target - y|
+        float final = 0.0f;
+    };
+
+    // Step response metrics of one outport, fed one step at a time. Against a --target every metric
+    // is accumulated as the run goes; the default goal is the final value, known only once the run
+    // ends, so without a target the outport's samples are kept until result().
+    class scorer {
+    public:
+        scorer(std::optional<double> target, double dt, double band) : target_(target), dt_(dt), band_(band) {}
+
+        void add(float y) {
+            if (target_) accumulate(*target_, y);
+            else samples_.push_back(y);
+        }
+
+        // Call once, after the last step
+        [[nodiscard]] auto result() -> metrics {
+            if (!target_) {
+                for (float y : samples_) accumulate(samples_.back(), y);
+            }
+            metrics result;
+            if (count_ == 0) return result;
+            double goal = target_.value_or(last_);
+            double step = goal - first_;
+            double peak = step >= 0 ? high_ - goal : goal - low_;
+            result.final = last_;
+            result.overshoot = step != 0.0 ? static_cast<float>(std::max(0.0, peak) / std::abs(step) * 100.0) : 0.0f;
+            result.iae = static_cast<float>(iae_);
+            if (!last_outside_) result.settling = 0.0f;
+            else if (*last_outside_ + 1 == count_) result.settling = std::numeric_limits<float>::quiet_NaN();
+            else result.settling = static_cast<float>(static_cast<double>(*last_outside_ + 2) * dt_);
+            return result;
+        }
+
+    private:
+        void accumulate(double goal, float y) {
+            if (count_ == 0) {
+                first_ = high_ = low_ = y;
+                double step = goal - y;
+                tolerance_ = band_ * (step != 0.0 ? std::abs(step) : std::max(std::abs(goal), 1e-12));
+            }
+            high_ = std::max(high_, y);
+            low_ = std::min(low_, y);
+            double error = std::abs(goal - y);
+            iae_ += error * dt_;
+            if (error > tolerance_) last_outside_ = count_;
+            last_ = y;
+            ++count_;
+        }
+
+        std::optional<double> target_;
+        double dt_;
+        double band_;
+        std::vector<float> samples_;
+        std::size_t count_ = 0;
+        float first_ = 0.0f, last_ = 0.0f, high_ = 0.0f, low_ = 0.0f;
+        double tolerance_ = 0.0;
+        double iae_ = 0.0;
+        std::optional<std::size_t> last_outside_;
+    };
+
+    // Shortest text that reads back as the same value
+    template <typename T>
+    void append_number(std::string& out, T value) {
+        char buffer[32];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+    // splitmix64, so that each run draws from its own stream whatever thread runs it
+    [[nodiscard]] auto mix(std::uint64_t a, std::uint64_t b) -> std::uint64_t {
+        std::uint64_t z = a * 0x9e3779b97f4a7c15ull + b + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    [[nodiscard]] auto split_assignment(const std::string& text, std::string_view flag)
+        -> std::optional<std::pair<std::string, double>> {
+        auto eq = text.find('=');
+        if (eq == std::string::npos) {
+            std::println(stderr, "Error: {} expects <name>=<value>", flag);
+            return std::nullopt;
+        }
+        double value = 0.0;
+        if (!oc::tool::read_number(flag, std::string_view(text).substr(eq + 1), value)) return std::nullopt;
+        return std::pair(text.substr(0, eq), value);
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input_file;
+    std::string subsystem;
+    std::string space_file;
+    std::string calibration_file;
+    std::string output_file;
+    std::vector<std::pair<std::string, double>> held;
+    std::vector<std::pair<std::string, double>> noise;
+    std::vector<std::string> scored;
+    std::map<std::string, double> targets;
+    double duration = 1.0;
+    double band = 0.02;
+    std::optional<long long> steps;
+    std::optional<double> dt;
+    std::size_t samples = 1;
+    std::size_t seeds = 1;
+    std::uint64_t seed = 1;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t batch_size = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        static const std::set<std::string_view> with_value = {
+            "--space", "--cal", "--samples", "--seeds", "--seed", "--time", "--steps", "--dt", "--set", "--noise",
+            "--output", "--target", "--band", "--threads", "--batch", "-o"
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (with_value.contains(arg)) {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "--space") space_file = v;
+            else if (arg == "--cal") calibration_file = v;
+            else if (arg == "--samples") read = oc::tool::read_positive(arg, v, samples);
+            else if (arg == "--seeds") read = oc::tool::read_positive(arg, v, seeds);
+            else if (arg == "--seed") read = oc::tool::read_number(arg, v, seed);
+            else if (arg == "--time") read = oc::tool::read_number(arg, v, duration);
+            else if (arg == "--steps") read = oc::tool::read_number(arg, v, steps.emplace());
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, dt.emplace());
+            else if (arg == "--output") scored.push_back(v);
+            else if (arg == "--band") read = oc::tool::read_number(arg, v, band);
+            else if (arg == "--threads") read = oc::tool::read_positive(arg, v, threads);
+            else if (arg == "--batch") read = oc::tool::read_positive(arg, v, batch_size);
+            else if (arg == "-o") output_file = v;
+            else {
+                auto assignment = split_assignment(v, arg);
+                if (!assignment) return 1;
+                if (arg == "--set") held.push_back(*assignment);
+                else if (arg == "--noise") noise.push_back(*assignment);
+                else targets[assignment->first] = assignment->second;
+            }
+            if (!read) return 1;
+        } else if (input_file.empty()) {
+            input_file = std::string(arg);
+        } else {
+            subsystem = std::string(arg);
+        }
+    }
+
+    if (input_file.empty() || subsystem.empty() || space_file.empty()) {
+        std::println(stderr, "Error: An input file, a subsystem and --space are required");
+        return 1;
+    }
+
+    auto read_text = [](const std::string& path) -> std::optional<std::string> {
+        std::ifstream file(path);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", path);
+            return std::nullopt;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    };
+
+    auto space_text = read_text(space_file);
+    if (!space_text) return 1;
+    auto space = parse_space(*space_text);
+    if (!space) return 1;
+
+    std::map<std::string, double> base;
+    if (!calibration_file.empty()) {
+        auto text = read_text(calibration_file);
+        if (!text) return 1;
+        base = oc::codegen::parse_calibration(*text);
+    }
+
+    oc::mdl::parser parser;
+    if (!parser.load(input_file)) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& model = parser.get_model();
+    const auto* root = model.root_system();
+    if (!root) {
+        std::println(stderr, "Error: No root system found");
+        return 1;
+    }
+
+    const auto* chosen = oc::tool::find_subsystem(model, subsystem);
+    const auto* sys = chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    if (!sys) {
+        std::println(stderr, "Error: No subsystem matching '{}'", subsystem);
+        return 1;
+    }
+
+    // Run index = ((grid point * samples) + sample) * seeds + noise seed
+    std::size_t grid_points = 1;
+    bool random = false;
+    for (const auto& dim : *space) {
+        if (dim.type == dimension::kind::grid) grid_points *= dim.values.size();
+        else random = true;
+    }
+    if (!random && samples > 1) {
+        std::println(stderr, "Warning: --samples has no effect without uniform() or normal() entries");
+        samples = 1;
+    }
+    std::size_t runs = grid_points * samples * seeds;
+
+    auto calibration = [&](std::size_t run) {
+        auto values = base;
+        auto point = run / (samples * seeds);
+        auto sample = run / seeds;
+        std::mt19937_64 rng(mix(seed, sample));
+        for (const auto& dim : *space) {
+            if (dim.type == dimension::kind::grid) {
+                values[dim.name] = dim.values[point % dim.values.size()];
+                point /= dim.values.size();
+            } else if (dim.type == dimension::kind::uniform) {
+                values[dim.name] = std::uniform_real_distribution<double>(dim.a, dim.b)(rng);
+            } else {
+                values[dim.name] = std::normal_distribution<double>(dim.a, dim.b)(rng);
+            }
+        }
+        return values;
+    };
+    auto options = [&](std::size_t run) { return oc::sim::sim_options{.calibration = calibration(run), .dt = dt}; };
+
+    // The first run names the ports and reports what the simulator cannot run
+    oc::sim::simulator probe(model, *sys, options(0));
+    for (const auto& warning : probe.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    std::vector<std::pair<std::size_t, float>> held_inputs;
+    std::vector<std::tuple<std::size_t, float, float>> noisy_inputs;  // {inport, sd, held level}
+    for (const auto& [name, v] : held) {
+        auto index = oc::tool::port_index(probe.inputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        held_inputs.emplace_back(*index, static_cast<float>(v));
+    }
+    for (const auto& [name, v] : noise) {
+        auto index = oc::tool::port_index(probe.inputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        auto held_level = std::ranges::find(held_inputs, *index, &std::pair<std::size_t, float>::first);
+        noisy_inputs.emplace_back(*index, static_cast<float>(v), held_level == held_inputs.end() ? 0.0f : held_level->second);
+    }
+    std::vector<std::size_t> scored_outputs;
+    if (scored.empty()) {
+        for (std::size_t i = 0; i < probe.outputs().size(); ++i) scored_outputs.push_back(i);
+    }
+    for (const auto& name : scored) {
+        auto index = oc::tool::port_index(probe.outputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No outport '{}'", name);
+            return 1;
+        }
+        scored_outputs.push_back(*index);
+    }
+    std::vector<std::optional<double>> output_targets(probe.outputs().size());
+    for (const auto& [name, v] : targets) {
+        auto index = oc::tool::port_index(probe.outputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No outport '{}'", name);
+            return 1;
+        }
+        output_targets[*index] = v;
+    }
+
+    if (output_file.empty()) output_file = oc::codegen::sanitize_name(chosen->name) + "_sweep.csv";
+    std::ofstream out(output_file, std::ios::binary);
+    if (!out) {
+        std::println(stderr, "Error: Could not write {}", output_file);
+        return 1;
+    }
+
+    std::string header = "run";
+    for (const auto& dim : *space) header += "," + dim.name;
+    header += ",seed";
+    for (auto index : scored_outputs) {
+        const auto& name = probe.outputs()[index];
+        header += "," + name + "_overshoot," + name + "_settling," + name + "_iae," + name + "_final";
+    }
+    out << header << "\n";
+
+    // Rows are written as batches finish; the running batch keeps its metrics, and the scored
+    // outports themselves only for those without a --target
+    std::mutex out_mutex;
+    std::atomic<long long> lane_steps{0};
+    auto jobs = (runs + batch_size - 1) / batch_size;
+    threads = std::min(threads, std::max<std::size_t>(jobs, 1));
+    job_ranges queue(jobs, threads);
+
+    auto run_batch = [&](std::size_t job) {
+        auto first = job * batch_size;
+        auto last = std::min(runs, first + batch_size);
+
+        std::vector<std::unique_ptr<oc::sim::simulator>> sims;
+        std::vector<std::size_t> run_of;
+        for (auto run = first; run < last; ++run) {
+            sims.push_back(std::make_unique<oc::sim::simulator>(model, *sys, options(run)));
+            run_of.push_back(run);
+        }
+
+        // Runs whose parameters change the instruction stream (a Delay length, say) form their own batch
+        std::vector<std::vector<std::size_t>> groups;
+        for (std::size_t i = 0; i < sims.size(); ++i) {
+            auto group = std::ranges::find_if(groups, [&](const auto& g) { return oc::sim::batch::compatible(*sims[g.front()], *sims[i]); });
+            if (group == groups.end()) groups.push_back({i});
+            else group->push_back(i);
+        }
+
+        std::string rows;
+        for (const auto& group : groups) {
+            std::vector<const oc::sim::simulator*> lanes;
+            for (auto i : group) lanes.push_back(sims[i].get());
+            oc::sim::batch sim(lanes);
+            auto total = static_cast<std::size_t>(steps.value_or(std::llround(duration / sim.dt())));
+
+            std::vector<std::mt19937_64> rngs;
+            for (auto i : group) rngs.emplace_back(mix(seed ^ 0x6e6f697365ull, run_of[i]));
+            for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+                for (auto [index, v] : held_inputs) sim.set_input(lane, index, v);
+            }
+
+            // scores[o][lane]
+            std::vector<std::vector<scorer>> scores(scored_outputs.size());
+            for (std::size_t o = 0; o < scored_outputs.size(); ++o) {
+                scores[o].assign(lanes.size(), scorer(output_targets[scored_outputs[o]], sim.dt(), band));
+            }
+            for (std::size_t k = 0; k < total; ++k) {
+                for (auto [index, sd, level] : noisy_inputs) {
+                    for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+                        sim.set_input(lane, index, level + std::normal_distribution<float>(0.0f, sd)(rngs[lane]));
+                    }
+                }
+                sim.step();
+                for (std::size_t o = 0; o < scored_outputs.size(); ++o) {
+                    for (std::size_t lane = 0; lane < lanes.size(); ++lane) scores[o][lane].add(sim.output(lane, scored_outputs[o]));
+                }
+            }
+            lane_steps.fetch_add(static_cast<long long>(total * lanes.size()), std::memory_order_relaxed);
+
+            for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+                auto run = run_of[group[lane]];
+                auto values = calibration(run);
+                rows += std::to_string(run);
+                for (const auto& dim : *space) {
+                    rows += ',';
+                    append_number(rows, values[dim.name]);
+                }
+                rows += "," + std::to_string(run % seeds);
+                for (std::size_t o = 0; o < scored_outputs.size(); ++o) {
+                    auto m = scores[o][lane].result();
+                    for (float v : {m.overshoot, m.settling, m.iae, m.final}) {
+                        rows += ',';
+                        append_number(rows, v);
+                    }
+                }
+                rows += '\n';
+            }
+        }
+
+        std::lock_guard lock(out_mutex);
+        out << rows;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            while (auto job = queue.take(w)) run_batch(*job);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::println("{}: {} runs ({} grid points x {} samples x {} seeds) in {:.3f} s on {} threads", chosen->name, runs,
+                 grid_points, samples, seeds, seconds, threads);
+    std::println("{} batches of up to {}, {} stolen; {:.1f} runs/s, {:.1f} ns per run step", jobs, batch_size, queue.steals(),
+                 seconds > 0 ? static_cast<double>(runs) / seconds : 0.0,
+                 lane_steps > 0 ? seconds * 1e9 * static_cast<double>(threads) / static_cast<double>(lane_steps.load()) : 0.0);
+    std::println("Results: {}", output_file);
+    return 0;
+}
@@ -11,9 +11,11 @@
 
 #include "../libmdl/oc_mdl.hpp"
 #include "../libmdl/oc_codegen.hpp"
+#include "../libmdl/oc_tool.hpp"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <numeric>
 #include <print>
 
 namespace fs = std::filesystem;
@@ -21,10 +23,43 @@ namespace fs = std::filesystem;
 namespace {
 
     void print_usage(std::string_view program) {
-        std::println("Usage: {} <input.mdl> [subsystem_filter]", program);
+        std::println("Usage: {} <input.mdl> [options] [subsystem_filter]", program);
         std::println("");
         std::println("Converts Simulink MDL subsystems to C++ code.");
         std::println("Output directory: <model_name>-cpp/");
+        std::println("");
+        std::println("Options:");
+        std::println("  --update-n   Also emit <elem>_update_n(in, out, n, ...) over a window of steps");
+        std::println("  --bench      Emit <elem>_bench.cpp comparing _update_n to a loop of _update");
+        std::println("  --typed      Propagate data types (OutDataTypeStr, bool for logic) instead of float");
+        std::println("  --specialize <cal.yaml>");
+        std::println("               Bind the calibrated parameters, fold them through the graph and");
+        std::println("               drop dead Switch branches; only unbound parameters stay in config");
+        std::println("  --state-space");
+        std::println("               Compile linear blocks into one x[k+1] = Ax + Bu, y = Cx + Du update;");
+        std::println("               coefficients must be literal or bound by --specialize (dt for");
+        std::println("               Integrator and TransferFcn)");
+        std::println("  --fuse       Fold single-use signals into their reader's expression (std::fma for");
+        std::println("               a product added to another term); fan-out and named lines stay locals");
+        std::println("  --schedule   Order blocks to minimize live signals, keep temporaries in a scratch");
+        std::println("               array reused by liveness, and report the peak live signals");
+        std::println("  --bank       Update first/second-order TransferFcns of an element as one loop per");
+        std::println("               order over state arrays; stage delay updates and commit them in one copy");
+        std::println("  --ranges <ranges.yaml>");
+        std::println("               Propagate inport and config ranges through the graph, drop saturations");
+        std::println("               that never engage and comparisons they decide, and report the signal");
+        std::println("               ranges with a fixed-point type for each");
+        std::println("  --pipeline <K>");
+        std::println("               Also emit <elem>_pipeline, which runs the update as up to K cost-balanced");
+        std::println("               stages on pinned threads, one step apart; outputs lag inputs by");
+        std::println("               stages - 1 steps. Reports the cost of each stage and the latency");
+        std::println("  --parallel <N>");
+        std::println("               Also emit <elem>_parallel, which runs groups of blocks sharing no signal or");
+        std::println("               state on up to N threads with one barrier per step, or _update when the");
+        std::println("               graph is too narrow. Reports the graph's width and the partition costs");
+        std::println("  --ad <name,...>");
+        std::println("               Also emit <elem>_ad, the update over dual numbers that carry derivatives");
+        std::println("               by the named config fields and inports (forward-mode AD)");
     }
 
     [[nodiscard]] auto to_lowercase(std::string_view str) -> std::string {
@@ -57,12 +92,65 @@ auto main(int argc, char* argv[]) -> int {
 
     std::string input_file;
     std::string filter;
+    oc::codegen::generator_options options;
+    bool bench = false;
+    std::string calibration_file;
+    std::string ranges_file;
 
     for (int i = 1; i < argc; ++i) {
         std::string_view arg = argv[i];
         if (arg == "-h" || arg == "--help") {
             print_usage(argv[0]);
             return 0;
+        } else if (arg == "--update-n") {
+            options.update_n = true;
+        } else if (arg == "--bench") {
+            options.update_n = true;
+            bench = true;
+        } else if (arg == "--typed") {
+            options.typed = true;
+        } else if (arg == "--schedule") {
+            options.schedule = true;
+        } else if (arg == "--bank") {
+            options.bank = true;
+        } else if (arg == "--fuse") {
+            options.fuse = true;
+        } else if (arg == "--state-space") {
+            options.state_space = true;
+        } else if (arg == "--specialize") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: --specialize requires a calibration file");
+                return 1;
+            }
+            calibration_file = argv[++i];
+        } else if (arg == "--ranges") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: --ranges requires a ranges file");
+                return 1;
+            }
+            ranges_file = argv[++i];
+            options.range_analysis = true;
+        } else if (arg == "--pipeline") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: --pipeline requires a stage count");
+                return 1;
+            }
+            if (!oc::tool::read_positive(arg, argv[++i], options.pipeline)) return 1;
+        } else if (arg == "--parallel") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: --parallel requires a thread count");
+                return 1;
+            }
+            if (!oc::tool::read_positive(arg, argv[++i], options.parallel)) return 1;
+        } else if (arg == "--ad") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: --ad requires a list of config fields or inports");
+                return 1;
+            }
+            std::istringstream names(argv[++i]);
+            for (std::string name; std::getline(names, name, ',');) {
+                if (!name.empty()) options.derivatives.push_back(name);
+            }
         } else if (input_file.empty()) {
             input_file = std::string(arg);
         } else {
@@ -75,6 +163,37 @@ auto main(int argc, char* argv[]) -> int {
         return 1;
     }
 
+    // Stages and partitions are cut from the plain block order; these modes move state updates out of it
+    bool threaded = options.pipeline > 0 || options.parallel > 0;
+    if (threaded && (options.state_space || options.bank || options.fuse)) {
+        std::println(stderr, "Error: --pipeline and --parallel cannot be combined with --state-space, --bank or --fuse");
+        return 1;
+    }
+
+    if (!calibration_file.empty()) {
+        std::ifstream file(calibration_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", calibration_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        options.calibration = oc::codegen::parse_calibration(text.str());
+        std::println("Calibration: {} value(s) from {}", options.calibration.size(), calibration_file);
+    }
+
+    if (!ranges_file.empty()) {
+        std::ifstream file(ranges_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", ranges_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        options.ranges = oc::codegen::parse_ranges(text.str());
+        std::println("Ranges: {} signal(s) from {}", options.ranges.size(), ranges_file);
+    }
+
     fs::path input_path(input_file);
     auto model_name = input_path.stem().string();
     auto output_dir = model_name + "-cpp";
@@ -105,6 +224,7 @@ auto main(int argc, char* argv[]) -> int {
 
     oc::codegen::generator codegen;
     codegen.set_model(&model);
+    codegen.set_options(options);
 
     int exported = 0;
 
@@ -130,13 +250,37 @@ auto main(int argc, char* argv[]) -> int {
         out << "//\n";
         out << "// Generated from: " << input_file << "\n";
         out << "// Subsystem: " << blk.name << "\n";
+        if (!calibration_file.empty()) {
+            out << "// Specialized for: " << calibration_file << "\n";
+        }
+        if (!ranges_file.empty()) {
+            out << "// Ranges from: " << ranges_file << "\n";
+        }
         out << "//\n";
         out << "// This file was auto-generated by mdl_to_cpp.\n";
         out << "// Manual edits may be overwritten.\n";
         out << "//\n\n";
         out << "#pragma once\n\n";
         out << "#include <algorithm>\n";
-        out << "#include <cmath>\n\n";
+        out << "#include <cmath>\n";
+        if (threaded) {
+            out << "#include <array>\n";
+            out << "#include <atomic>\n";
+        }
+        if (options.typed || threaded) {
+            out << "#include <cstdint>\n";
+        }
+        if (options.update_n || threaded) {
+            out << "#include <cstddef>\n";
+            out << "#include <span>\n";
+        }
+        if (threaded) {
+            out << "#include <thread>\n";
+            out << "#if defined(__linux__)\n";
+            out << "#include <pthread.h>\n";
+            out << "#endif\n";
+        }
+        out << "\n";
         out << cpp_content;
 
         auto filename = base_filename + ".hpp";
@@ -149,9 +293,80 @@ auto main(int argc, char* argv[]) -> int {
         } else {
             std::println(stderr, "  Error: Could not write {}", filepath.string());
         }
+
+        if (bench) {
+            auto bench_path = fs::path(output_dir) / (base_filename + "_bench.cpp");
+            if (std::ofstream file(bench_path); file) {
+                file << codegen.generate_benchmark(named_sys, library_name, filename);
+                std::println("  {} -> {}", blk.name, bench_path.filename().string());
+            } else {
+                std::println(stderr, "  Error: Could not write {}", bench_path.string());
+            }
+        }
     }
 
     std::println("\nGenerated {} C++ file(s) in {}/", exported, output_dir);
 
+    if (options.schedule) {
+        std::println("\nLive signals (original -> scheduled order), scratch slots:");
+        for (const auto& [name, stats] : codegen.schedule_report()) {
+            std::println("  {}: {} -> {}, {} slot(s)", name, stats.max_live_before, stats.max_live, stats.scratch_slots);
+        }
+    }
+
+    if (options.range_analysis) {
+        std::println("\nSaturations removed/narrowed, comparisons decided, and bounded signal ranges:");
+        for (const auto& [name, stats] : codegen.range_report()) {
+            std::println("  {}: {}/{}, {}", name, stats.clamps_removed, stats.clamps_narrowed, stats.comparisons_folded);
+            for (const auto& [signal, range] : stats.signals) {
+                if (!range.bounded()) continue;
+                std::println("    {:<32} [{:g}, {:g}]  {}", signal, range.lo, range.hi, oc::codegen::fixed_point_type(range));
+            }
+        }
+    }
+
+    if (options.pipeline > 0) {
+        std::println("\nPipeline stages (estimated cost of each), latency added:");
+        for (const auto& [name, stats] : codegen.pipeline_report()) {
+            std::string costs;
+            for (auto cost : stats.costs) costs += (costs.empty() ? "" : ", ") + std::to_string(cost);
+            auto total = std::accumulate(stats.costs.begin(), stats.costs.end(), 0);
+            auto dearest = stats.costs.empty() ? 0 : std::ranges::max(stats.costs);
+            std::println("  {}: {} of {} stage(s) [{}], {} step(s) of latency, {} signal(s) handed over, {:.2f}x",
+                         name, stats.costs.size(), stats.requested, costs, stats.latency(), stats.handed_over,
+                         dearest > 0 ? static_cast<double>(total) / dearest : 1.0);
+        }
+    }
+
+    if (options.parallel > 0) {
+        std::println("\nParallel width (work / longest chain), independent groups, cost of the serial head,");
+        std::println("each partition and the serial tail:");
+        for (const auto& [name, stats] : codegen.parallel_report()) {
+            std::string loads;
+            for (auto load : stats.loads) loads += (loads.empty() ? "" : ", ") + std::to_string(load);
+            if (!stats.serial.empty()) {
+                std::println("  {}: {:.2f} ({}/{}), {} group(s), serial: {}", name, stats.width(), stats.work, stats.span,
+                             stats.groups, stats.serial);
+                continue;
+            }
+            auto step = stats.head + std::ranges::max(stats.loads) + stats.tail;
+            std::println("  {}: {:.2f} ({}/{}), {} group(s), head {} + [{}] + tail {}, {:.2f}x", name, stats.width(), stats.work,
+                         stats.span, stats.groups, stats.head, loads, stats.tail, static_cast<double>(stats.work) / step);
+        }
+    }
+
+    if (!options.derivatives.empty()) {
+        std::println("\nDerivatives of the AD variant (index: field), and names not found:");
+        for (const auto& [name, stats] : codegen.derivative_report()) {
+            std::string seeded;
+            for (std::size_t i = 0; i < stats.seeded.size(); ++i) seeded += (i ? ", " : "") + std::to_string(i) + ": " + stats.seeded[i];
+            std::string missing;
+            for (const auto& field : stats.missing) missing += (missing.empty() ? "" : ", ") + field;
+            if (stats.seeded.empty()) std::println("  {}: none, no AD variant (not found: {})", name, missing);
+            else if (missing.empty()) std::println("  {}: {}", name, seeded);
+            else std::println("  {}: {} (not found: {})", name, seeded, missing);
+        }
+    }
+
     return 0;
 }
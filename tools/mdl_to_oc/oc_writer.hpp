@@ -72,6 +72,8 @@ namespace oc {
                     bool is_component_state = (comment == "component state");
                     if (is_component_state) {
                         out << "        " << name << " " << name << ";";
+                    } else if (auto it = parts.state_types.find(name); it != parts.state_types.end()) {
+                        out << "        " << state_declaration(it->second, name);
                     } else {
                         out << "        float " << name << " = 0.0;";
                     }
@@ -138,6 +140,8 @@ namespace oc {
                     bool is_component_state = (comment == "component state");
                     if (is_component_state) {
                         out << "        " << name << " " << name << ";";
+                    } else if (auto it = func.state_types.find(name); it != func.state_types.end()) {
+                        out << "        " << state_declaration(it->second, name);
                     } else {
                         out << "        float " << name << " = 0.0;";
                     }
@@ -162,6 +166,14 @@ namespace oc {
 
             out << "}\n\n";
         }
+
+        // State field with a type other than float: an array such as "float[8]" or an int
+        [[nodiscard]] static auto state_declaration(const std::string& type, const std::string& name) -> std::string {
+            if (auto open = type.find('['); open != std::string::npos) {
+                return type.substr(0, open) + " " + name + type.substr(open) + ";";
+            }
+            return type + " " + name + " = 0;";
+        }
     };
 
 } // namespace oc
@@ -298,6 +298,7 @@ namespace oc::yaml {
                 sig.name = name;
                 sig.description = comment;
                 sig.type = (comment == "component state") ? name + "_state" : "float";
+                if (auto it = func.state_types.find(name); it != func.state_types.end()) sig.type = it->second;
                 sig.default_value = (comment == "component state") ? "" : "0.0f";
                 fs.state.push_back(std::move(sig));
             }
@@ -0,0 +1,470 @@
+//
+// Open Controls - MDL Parameter Tuning
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_mdl.hpp"
+#include "../libmdl/oc_sim.hpp"
+#include "../libmdl/oc_tool.hpp"
+#include "../libmdl/oc_trace.hpp"
+#include "../libmdl/oc_tune.hpp"
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <print>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <input.mdl> <subsystem> --param <name>=<lo>:<hi> --track <out>=<ref> [options]", program);
+        std::println("");
+        std::println("Tunes config values of a subsystem to minimize a cost over a scenario, simulating");
+        std::println("each generation of candidates side by side on all cores, and writes the result as");
+        std::println("a calibration file.");
+        std::println("");
+        std::println("Options:");
+        std::println("  --param <n>=<lo>:<hi>  Config name to tune and its range (repeatable)");
+        std::println("  --cal <cal.yaml>       Values of the other config names, and the starting point");
+        std::println("  --input <in.csv>       Scenario: inport values per step, one column per inport name");
+        std::println("                         (or a .oct trace); the last row holds once it ends");
+        std::println("  --set <in>=<v>         Hold an inport at a value");
+        std::println("  --time <s>             Simulated time per run (default: the scenario, else 1)");
+        std::println("  --steps <n>            Steps per run, instead of --time");
+        std::println("  --dt <s>               Step size (default: dt from --cal, else 0.001)");
+        std::println("  --track <out>=<ref>    Score |ref - out| over the run; ref is a scenario column, an");
+        std::println("                         inport or a number (repeatable)");
+        std::println("  --effort <out>         Score out^2 over the run, e.g. a controller command (repeatable)");
+        std::println("  --w-track <w>          Weight of the tracking error (default 1)");
+        std::println("  --w-effort <w>         Weight of the control effort (default 1)");
+        std::println("  --w-overshoot <w>      Weight of the overshoot of tracked outports, in % (default 0)");
+        std::println("  --method <m>           cmaes (default) or nelder-mead");
+        std::println("  --population <n>       Candidates per CMA-ES generation (default 4 + 3 ln n, at least 8)");
+        std::println("  --generations <n>      Generations, or Nelder-Mead iterations (default 100)");
+        std::println("  --sigma <f>            Initial step as a fraction of each range (default 0.3)");
+        std::println("  --seed <n>             Seed of the CMA-ES samples (default 1)");
+        std::println("  --threads <n>          Worker threads (default: all cores)");
+        std::println("  --batch <n>            Candidates stepped together per worker (default 8)");
+        std::println("  -o <tuned.yaml>        Calibration file (default <subsystem>_tuned.yaml)");
+    }
+
+    [[nodiscard]] auto split_assignment(const std::string& text, std::string_view flag)
+        -> std::optional<std::pair<std::string, std::string>> {
+        auto eq = text.find('=');
+        if (eq == std::string::npos) {
+            std::println(stderr, "Error: {} expects <name>=<value>", flag);
+            return std::nullopt;
+        }
+        return std::pair(text.substr(0, eq), text.substr(eq + 1));
+    }
+
+    // Shortest text that reads back as the same value
+    void append_number(std::string& out, double value) {
+        char buffer[32];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    }
+
+    // A tracked outport and its reference, one value per step
+    struct tracked {
+        std::size_t output = 0;
+        std::vector<float> reference;
+    };
+
+    // Running cost terms of one lane; overshoot needs the first value and the extremes
+    struct accumulator {
+        double error = 0.0;
+        double effort = 0.0;
+        std::vector<float> first, high, low;
+        bool finite = true;
+    };
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input_file;
+    std::string subsystem;
+    std::string calibration_file;
+    std::string scenario_file;
+    std::string output_file;
+    std::vector<oc::tune::parameter> parameters;
+    std::vector<std::pair<std::string, double>> held;
+    std::vector<std::pair<std::string, std::string>> tracks;
+    std::vector<std::string> efforts;
+    double track_weight = 1.0;
+    double effort_weight = 1.0;
+    double overshoot_weight = 0.0;
+    std::optional<double> duration;
+    std::optional<long long> steps;
+    std::optional<double> dt;
+    oc::tune::tune_options tuning;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t batch_size = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        static const std::set<std::string_view> with_value = {
+            "--param", "--cal", "--input", "--set", "--time", "--steps", "--dt", "--track", "--effort", "--w-track",
+            "--w-effort", "--w-overshoot", "--method", "--population", "--generations", "--sigma", "--seed",
+            "--threads", "--batch", "-o"
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (with_value.contains(arg)) {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "--cal") calibration_file = v;
+            else if (arg == "--input") scenario_file = v;
+            else if (arg == "--time") read = oc::tool::read_number(arg, v, duration.emplace());
+            else if (arg == "--steps") read = oc::tool::read_number(arg, v, steps.emplace());
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, dt.emplace());
+            else if (arg == "--effort") efforts.push_back(v);
+            else if (arg == "--w-track") read = oc::tool::read_number(arg, v, track_weight);
+            else if (arg == "--w-effort") read = oc::tool::read_number(arg, v, effort_weight);
+            else if (arg == "--w-overshoot") read = oc::tool::read_number(arg, v, overshoot_weight);
+            else if (arg == "--population") read = oc::tool::read_number(arg, v, tuning.population);
+            else if (arg == "--generations") read = oc::tool::read_number(arg, v, tuning.generations);
+            else if (arg == "--sigma") read = oc::tool::read_positive(arg, v, tuning.sigma);
+            else if (arg == "--seed") read = oc::tool::read_number(arg, v, tuning.seed);
+            else if (arg == "--threads") read = oc::tool::read_positive(arg, v, threads);
+            else if (arg == "--batch") read = oc::tool::read_positive(arg, v, batch_size);
+            else if (arg == "-o") output_file = v;
+            else if (arg == "--method") {
+                if (v == "cmaes" || v == "cma-es") tuning.algorithm = oc::tune::method::cmaes;
+                else if (v == "nelder-mead" || v == "nm") tuning.algorithm = oc::tune::method::nelder_mead;
+                else {
+                    std::println(stderr, "Error: Unknown method '{}' (cmaes or nelder-mead)", v);
+                    return 1;
+                }
+            } else {
+                auto assignment = split_assignment(v, arg);
+                if (!assignment) return 1;
+                if (arg == "--set") {
+                    double level = 0.0;
+                    read = oc::tool::read_number(arg, assignment->second, level);
+                    held.emplace_back(assignment->first, level);
+                }
+                else if (arg == "--track") tracks.push_back(*assignment);
+                else {
+                    auto colon = assignment->second.find(':');
+                    if (colon == std::string::npos) {
+                        std::println(stderr, "Error: --param expects <name>=<lo>:<hi>");
+                        return 1;
+                    }
+                    oc::tune::parameter p{assignment->first, 0.0, 0.0};
+                    if (!oc::tool::read_number(arg, std::string_view(assignment->second).substr(0, colon), p.lo) ||
+                        !oc::tool::read_number(arg, std::string_view(assignment->second).substr(colon + 1), p.hi)) return 1;
+                    if (!(p.lo < p.hi)) {
+                        std::println(stderr, "Error: Empty range for '{}'", p.name);
+                        return 1;
+                    }
+                    parameters.push_back(p);
+                }
+            }
+            if (!read) return 1;
+        } else if (input_file.empty()) {
+            input_file = std::string(arg);
+        } else {
+            subsystem = std::string(arg);
+        }
+    }
+
+    if (input_file.empty() || subsystem.empty() || parameters.empty()) {
+        std::println(stderr, "Error: An input file, a subsystem and at least one --param are required");
+        return 1;
+    }
+    if (tracks.empty() && efforts.empty()) {
+        std::println(stderr, "Error: Nothing to minimize; give --track or --effort");
+        return 1;
+    }
+
+    std::map<std::string, double> base;
+    if (!calibration_file.empty()) {
+        std::ifstream file(calibration_file);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", calibration_file);
+            return 1;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        base = oc::codegen::parse_calibration(text.str());
+    }
+
+    oc::mdl::parser parser;
+    if (!parser.load(input_file)) {
+        std::println(stderr, "Error: Failed to parse MDL file");
+        return 1;
+    }
+    const auto& model = parser.get_model();
+    const auto* root = model.root_system();
+    if (!root) {
+        std::println(stderr, "Error: No root system found");
+        return 1;
+    }
+
+    const auto* chosen = oc::tool::find_subsystem(model, subsystem);
+    const auto* sys = chosen ? model.get_system(chosen->subsystem_ref) : nullptr;
+    if (!sys) {
+        std::println(stderr, "Error: No subsystem matching '{}'", subsystem);
+        return 1;
+    }
+
+    auto calibration = [&](std::span<const double> values) {
+        auto result = base;
+        for (std::size_t i = 0; i < parameters.size(); ++i) result[parameters[i].name] = values[i];
+        return result;
+    };
+    std::vector<double> start;
+    for (const auto& p : parameters) start.push_back(base.contains(p.name) ? base[p.name] : (p.lo + p.hi) / 2.0);
+
+    // The probe leaves the tuned names out, so that a name the subsystem never reads stands out as the
+    // one without a "has no value" warning
+    {
+        auto untuned = base;
+        for (const auto& p : parameters) untuned.erase(p.name);
+        oc::sim::simulator unset(model, *sys, {.calibration = untuned, .dt = dt});
+        for (const auto& p : parameters) {
+            auto read = std::ranges::any_of(unset.warnings(), [&](const auto& w) { return w.find("'" + p.name + "'") != std::string::npos; });
+            if (!read) std::println(stderr, "Warning: '{}' is not a config name of {}; tuning it has no effect", p.name, chosen->name);
+        }
+    }
+    oc::sim::simulator probe(model, *sys, {.calibration = calibration(start), .dt = dt});
+    for (const auto& warning : probe.warnings()) std::println(stderr, "Warning: {}", warning);
+
+    // The scenario as one column per trace signal; inports it names follow it, the others are held
+    std::vector<std::string> scenario_columns;
+    std::vector<std::vector<float>> scenario;  // [column][row]
+    if (scenario_file.ends_with(".oct")) {
+        oc::trace::reader trace;
+        if (!trace.load(scenario_file)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+        for (std::size_t c = 0; c < trace.signals().size(); ++c) {
+            scenario_columns.push_back(trace.signals()[c].name);
+            auto& column = scenario.emplace_back(trace.rows());
+            for (std::uint64_t r = 0; r < trace.rows(); ++r) column[r] = trace.value(c, r);
+        }
+    } else if (!scenario_file.empty()) {
+        auto table = oc::tool::read_csv(scenario_file);
+        if (!table) {
+            std::println(stderr, "Error: Could not read {}", scenario_file);
+            return 1;
+        }
+        scenario_columns = table->columns;
+        for (std::size_t c = 0; c < table->columns.size(); ++c) {
+            auto& column = scenario.emplace_back();
+            for (const auto& row : table->rows) column.push_back(row[c]);
+        }
+    }
+    std::size_t scenario_rows = scenario.empty() ? 0 : scenario.front().size();
+    auto total = static_cast<std::size_t>(steps.value_or(
+        duration ? std::llround(*duration / probe.dt()) : scenario_rows ? static_cast<long long>(scenario_rows) : std::llround(1.0 / probe.dt())));
+    if (total == 0) {
+        std::println(stderr, "Error: Nothing to simulate");
+        return 1;
+    }
+
+    // stimulus[i][k]: inport i at step k
+    std::vector<std::vector<float>> stimulus(probe.inputs().size(), std::vector<float>(total, 0.0f));
+    for (const auto& [name, v] : held) {
+        auto index = oc::tool::port_index(probe.inputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No inport '{}'", name);
+            return 1;
+        }
+        std::ranges::fill(stimulus[*index], static_cast<float>(v));
+    }
+    for (std::size_t c = 0; c < scenario_columns.size(); ++c) {
+        auto index = oc::tool::port_index(probe.inputs(), scenario_columns[c]);
+        if (!index || scenario_rows == 0) continue;
+        for (std::size_t k = 0; k < total; ++k) stimulus[*index][k] = scenario[c][std::min(k, scenario_rows - 1)];
+    }
+
+    std::vector<tracked> tracked_outputs;
+    for (const auto& [name, ref] : tracks) {
+        auto index = oc::tool::port_index(probe.outputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No outport '{}'", name);
+            return 1;
+        }
+        tracked t{*index, std::vector<float>(total)};
+        auto column = std::ranges::find(scenario_columns, ref);
+        if (column != scenario_columns.end() && scenario_rows > 0) {
+            const auto& values = scenario[static_cast<std::size_t>(column - scenario_columns.begin())];
+            for (std::size_t k = 0; k < total; ++k) t.reference[k] = values[std::min(k, scenario_rows - 1)];
+        } else if (auto inport = oc::tool::port_index(probe.inputs(), ref)) {
+            t.reference = stimulus[*inport];
+        } else {
+            char* end = nullptr;
+            auto value = std::strtod(ref.c_str(), &end);
+            if (ref.empty() || *end != '\0') {
+                std::println(stderr, "Error: Reference '{}' of '{}' is not a scenario column, an inport or a number", ref, name);
+                return 1;
+            }
+            std::ranges::fill(t.reference, static_cast<float>(value));
+        }
+        tracked_outputs.push_back(std::move(t));
+    }
+    std::vector<std::size_t> effort_outputs;
+    for (const auto& name : efforts) {
+        auto index = oc::tool::port_index(probe.outputs(), name);
+        if (!index) {
+            std::println(stderr, "Error: No outport '{}'", name);
+            return 1;
+        }
+        effort_outputs.push_back(*index);
+    }
+
+    // Cost of one run: weighted IAE of the tracked outports, integral of the squared efforts and the
+    // overshoot (%) of each tracked outport past its final reference, relative to the step towards it
+    auto finish = [&](const accumulator& acc) {
+        if (!acc.finite) return std::numeric_limits<double>::infinity();
+        double overshoot = 0.0;
+        for (std::size_t t = 0; t < tracked_outputs.size(); ++t) {
+            double goal = tracked_outputs[t].reference.back();
+            double step = goal - acc.first[t];
+            if (step == 0.0) continue;
+            double peak = step > 0 ? acc.high[t] - goal : goal - acc.low[t];
+            overshoot += std::max(0.0, peak) / std::abs(step) * 100.0;
+        }
+        return track_weight * acc.error + effort_weight * acc.effort + overshoot_weight * overshoot;
+    };
+
+    // One generation: its candidates split into batches of compatible simulators, taken by the workers
+    // in turn. Every candidate costs the same whatever batch or thread runs it.
+    std::atomic<long long> lane_steps{0};
+    auto evaluate = [&](const std::vector<std::vector<double>>& points) {
+        std::vector<double> costs(points.size(), std::numeric_limits<double>::infinity());
+        auto jobs = (points.size() + batch_size - 1) / batch_size;
+        std::atomic<std::size_t> next{0};
+
+        auto run_batch = [&](std::size_t job) {
+            auto first = job * batch_size;
+            auto last = std::min(points.size(), first + batch_size);
+            std::vector<std::unique_ptr<oc::sim::simulator>> sims;
+            for (auto c = first; c < last; ++c) {
+                sims.push_back(std::make_unique<oc::sim::simulator>(model, *sys, oc::sim::sim_options{.calibration = calibration(points[c]), .dt = dt}));
+            }
+
+            // Candidates whose values change the instruction stream (a Delay length, say) form their own batch
+            std::vector<std::vector<std::size_t>> groups;
+            for (std::size_t i = 0; i < sims.size(); ++i) {
+                auto group = std::ranges::find_if(groups, [&](const auto& g) { return oc::sim::batch::compatible(*sims[g.front()], *sims[i]); });
+                if (group == groups.end()) groups.push_back({i});
+                else group->push_back(i);
+            }
+
+            for (const auto& group : groups) {
+                std::vector<const oc::sim::simulator*> lanes;
+                for (auto i : group) lanes.push_back(sims[i].get());
+                oc::sim::batch sim(lanes);
+                auto step_dt = sim.dt();
+
+                std::vector<accumulator> acc(lanes.size());
+                for (auto& a : acc) {
+                    a.first.assign(tracked_outputs.size(), 0.0f);
+                    a.high.assign(tracked_outputs.size(), -std::numeric_limits<float>::infinity());
+                    a.low.assign(tracked_outputs.size(), std::numeric_limits<float>::infinity());
+                }
+                for (std::size_t k = 0; k < total; ++k) {
+                    for (std::size_t i = 0; i < stimulus.size(); ++i) {
+                        for (std::size_t lane = 0; lane < lanes.size(); ++lane) sim.set_input(lane, i, stimulus[i][k]);
+                    }
+                    sim.step();
+                    for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+                        auto& a = acc[lane];
+                        for (std::size_t t = 0; t < tracked_outputs.size(); ++t) {
+                            auto y = sim.output(lane, tracked_outputs[t].output);
+                            if (!std::isfinite(y)) a.finite = false;
+                            if (k == 0) a.first[t] = y;
+                            a.high[t] = std::max(a.high[t], y);
+                            a.low[t] = std::min(a.low[t], y);
+                            a.error += std::abs(static_cast<double>(tracked_outputs[t].reference[k]) - y) * step_dt;
+                        }
+                        for (auto o : effort_outputs) {
+                            double u = sim.output(lane, o);
+                            if (!std::isfinite(u)) a.finite = false;
+                            a.effort += u * u * step_dt;
+                        }
+                    }
+                }
+                lane_steps.fetch_add(static_cast<long long>(total * lanes.size()), std::memory_order_relaxed);
+                for (std::size_t lane = 0; lane < lanes.size(); ++lane) costs[first + group[lane]] = finish(acc[lane]);
+            }
+        };
+
+        auto workers_used = std::min(threads, std::max<std::size_t>(jobs, 1));
+        std::vector<std::thread> workers;
+        for (std::size_t w = 0; w < workers_used; ++w) {
+            workers.emplace_back([&] {
+                for (auto job = next.fetch_add(1); job < jobs; job = next.fetch_add(1)) run_batch(job);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        return costs;
+    };
+
+    auto describe = [&](std::span<const double> values) {
+        std::string text;
+        for (std::size_t i = 0; i < parameters.size(); ++i) {
+            text += (i ? ", " : "") + parameters[i].name + " = ";
+            append_number(text, values[i]);
+        }
+        return text;
+    };
+
+    auto start_time = std::chrono::steady_clock::now();
+    double reported = std::numeric_limits<double>::infinity();
+    auto report = [&](std::size_t generation, double best, std::span<const double> values) {
+        if (best >= reported) return;
+        reported = best;
+        std::println("Generation {}: cost {} ({})", generation, best, describe(values));
+    };
+    auto result = oc::tune::minimize(parameters, start, evaluate, tuning, report);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (output_file.empty()) output_file = oc::codegen::sanitize_name(chosen->name) + "_tuned.yaml";
+    std::ofstream out(output_file, std::ios::binary);
+    if (!out) {
+        std::println(stderr, "Error: Could not write {}", output_file);
+        return 1;
+    }
+    std::string text = "# " + chosen->name + " tuned by mdl_tune: cost ";
+    append_number(text, result.cost);
+    text += " (start ";
+    append_number(text, result.start_cost);
+    text += ")\n";
+    for (const auto& [name, value] : calibration(result.best)) {
+        text += name + ": ";
+        append_number(text, value);
+        text += '\n';
+    }
+    out << text;
+
+    std::println("{}: cost {} from {} after {} generations{} ({})", chosen->name, result.cost, result.start_cost,
+                 result.generations, result.converged ? ", converged" : "", describe(result.best));
+    std::println("{} evaluations of {} steps in {:.3f} s on {} threads; {:.1f} evaluations/s, {:.1f} ns per run step",
+                 result.evaluations, total, seconds, threads, seconds > 0 ? static_cast<double>(result.evaluations) / seconds : 0.0,
+                 lane_steps > 0 ? seconds * 1e9 * static_cast<double>(threads) / static_cast<double>(lane_steps.load()) : 0.0);
+    std::println("Calibration: {}", output_file);
+    return 0;
+}
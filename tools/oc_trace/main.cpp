@@ -0,0 +1,275 @@
+//
+// Open Controls - Trace Converter
+//
+// Copyright (C) 2026 Daher Alfawares
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+
+#include "../libmdl/oc_tool.hpp"
+#include "../libmdl/oc_trace.hpp"
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <print>
+#include <set>
+
+namespace {
+
+    void print_usage(std::string_view program) {
+        std::println("Usage: {} <command> <input> [options]", program);
+        std::println("");
+        std::println("Inspects and converts binary simulation traces (.oct).");
+        std::println("");
+        std::println("Commands:");
+        std::println("  info <trace.oct>              Signals, rows, sample period and schema");
+        std::println("  to-csv <trace.oct>            Write a CSV with a time column and one column per signal");
+        std::println("  from-csv <trace.csv>          Write a trace from a CSV with a header row");
+        std::println("");
+        std::println("Options:");
+        std::println("  -o <file>                     Output file (default: input with .csv or .oct)");
+        std::println("  --signals <a,b,...>           to-csv: only these signals");
+        std::println("  --schema <element.yaml>       from-csv: group columns as the interface's IN/OUT/STATE");
+        std::println("                                and embed the interface in the trace");
+        std::println("  --dt <s>                      from-csv: sample period (default: from a time column at (k+1)*dt)");
+        std::println("  --chunk-rows <n>              from-csv: rows per chunk (default 4096)");
+    }
+
+    [[nodiscard]] auto with_extension(const std::string& path, std::string_view extension) -> std::string {
+        auto dot = path.rfind('.');
+        auto slash = path.rfind('/');
+        auto stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? path.substr(0, dot) : path;
+        return stem + std::string(extension);
+    }
+
+    auto info(const std::string& input) -> int {
+        oc::trace::reader trace;
+        if (!trace.load(input)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+        std::println("{}: {} rows of {} signals, {} chunks of {} rows", input, trace.rows(), trace.signals().size(),
+                     trace.chunks(), trace.chunk_rows());
+        if (trace.dt() > 0) std::println("Sample period: {} s ({} s)", trace.dt(), static_cast<double>(trace.rows()) * trace.dt());
+        if (!trace.schema().empty()) {
+            auto name = std::string("(unnamed)");
+            if (auto at = trace.schema().find("    name: "); at != std::string_view::npos) {
+                auto start = at + 10;
+                name = std::string(trace.schema().substr(start, trace.schema().find('\n', start) - start));
+            }
+            std::println("Schema: {} ({:x})", name, trace.schema_hash());
+        }
+        for (const auto& sig : trace.signals()) std::println("  {:<6} {}", oc::trace::group_name(sig.kind), sig.name);
+        return 0;
+    }
+
+    auto to_csv(const std::string& input, std::string output, const std::string& selection) -> int {
+        oc::trace::reader trace;
+        if (!trace.load(input)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+
+        std::vector<std::size_t> columns;
+        if (selection.empty()) {
+            for (std::size_t i = 0; i < trace.signals().size(); ++i) columns.push_back(i);
+        }
+        for (const auto& name : oc::tool::split_csv(selection)) {
+            auto index = trace.find(name);
+            if (!index) {
+                std::println(stderr, "Error: No signal '{}' in {}", name, input);
+                return 1;
+            }
+            columns.push_back(*index);
+        }
+
+        if (output.empty()) output = with_extension(input, ".csv");
+        std::ofstream out(output, std::ios::binary);
+        if (!out) {
+            std::println(stderr, "Error: Could not write {}", output);
+            return 1;
+        }
+
+        std::string text = trace.dt() > 0 ? "time" : "row";
+        for (auto c : columns) text += "," + trace.signals()[c].name;
+        text += "\n";
+
+        std::vector<std::span<const float>> chunk(columns.size());
+        for (std::uint64_t k = 0; k < trace.chunks(); ++k) {
+            for (std::size_t i = 0; i < columns.size(); ++i) chunk[i] = trace.column(columns[i], k);
+            auto first = k * trace.chunk_rows();
+            auto rows = columns.empty() ? std::min<std::uint64_t>(trace.chunk_rows(), trace.rows() - first) : chunk[0].size();
+            for (std::size_t r = 0; r < rows; ++r) {
+                auto row = first + r;
+                if (trace.dt() > 0) oc::tool::append_float(text, static_cast<float>(static_cast<double>(row + 1) * trace.dt()));
+                else text += std::to_string(row);
+                for (const auto& column : chunk) {
+                    text += ',';
+                    oc::tool::append_float(text, column[r]);
+                }
+                text += '\n';
+            }
+            out << text;
+            text.clear();
+        }
+        std::println("Wrote {} rows of {} signals to {}", trace.rows(), columns.size(), output);
+        return 0;
+    }
+
+    auto from_csv(const std::string& input, std::string output, const std::string& schema_file, std::optional<double> dt,
+                  std::uint32_t chunk_rows) -> int {
+        std::ifstream file(input);
+        if (!file) {
+            std::println(stderr, "Error: Could not read {}", input);
+            return 1;
+        }
+
+        std::string schema;
+        if (!schema_file.empty()) {
+            std::ifstream in(schema_file);
+            if (!in) {
+                std::println(stderr, "Error: Could not read {}", schema_file);
+                return 1;
+            }
+            std::ostringstream text;
+            text << in.rdbuf();
+            schema = text.str();
+        }
+        auto interface = oc::trace::interface_signals(schema);
+
+        std::string line;
+        if (!std::getline(file, line)) {
+            std::println(stderr, "Error: {} is empty", input);
+            return 1;
+        }
+        auto names = oc::tool::split_csv(line);
+
+        // A time column is dropped when it is the trace's own time base, row k at (k + 1) * dt, and its
+        // step becomes the sample period; any other time column is kept as a signal
+        std::optional<std::size_t> time_column;
+        if (!names.empty() && (names[0] == "time" || names[0] == "t")) time_column = 0;
+
+        std::vector<std::vector<float>> rows;
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            std::vector<float> row;
+            for (const auto& field : oc::tool::split_csv(line)) row.push_back(std::strtof(field.c_str(), nullptr));
+            row.resize(names.size(), row.empty() ? 0.0f : row.back());
+            rows.push_back(std::move(row));
+        }
+
+        // Times written as floats drift by their rounding, so each is compared with a tolerance
+        auto on_grid = [&](double step) {
+            if (!(step > 0)) return false;
+            for (std::size_t r = 0; r < rows.size(); ++r) {
+                double expected = static_cast<double>(r + 1) * step;
+                if (std::abs(rows[r][0] - expected) > 1e-3 * step + 1e-6 * std::abs(expected)) return false;
+            }
+            return true;
+        };
+        bool keep_time = static_cast<bool>(time_column);
+        if (time_column && dt) {
+            keep_time = !on_grid(*dt);
+        } else if (time_column && !rows.empty()) {
+            // The step is fitted over the whole column
+            double step = static_cast<double>(rows.back()[0]) / static_cast<double>(rows.size());
+            if (on_grid(step)) {
+                std::ostringstream rounded;
+                rounded << std::setprecision(7) << step;
+                dt = std::stod(rounded.str());
+                keep_time = false;
+            }
+        }
+
+        std::vector<oc::trace::signal> signals;
+        std::vector<std::size_t> sources;
+        std::set<std::string> present;
+        for (std::size_t c = 0; c < names.size(); ++c) {
+            if (time_column == c && !keep_time) continue;
+            oc::trace::signal sig{names[c], oc::trace::group::probe};
+            for (const auto& entry : interface) {
+                if (entry.name == names[c]) sig.kind = entry.kind;
+            }
+            present.insert(names[c]);
+            signals.push_back(sig);
+            sources.push_back(c);
+        }
+        for (const auto& entry : interface) {
+            if (!present.contains(entry.name)) {
+                std::println(stderr, "Warning: {} signal '{}' of the schema has no column", oc::trace::group_name(entry.kind), entry.name);
+            }
+        }
+
+        if (output.empty()) output = with_extension(input, ".oct");
+        oc::trace::writer trace;
+        if (!trace.open(output, signals, dt.value_or(0.0), schema, chunk_rows)) {
+            std::println(stderr, "Error: {}", trace.error());
+            return 1;
+        }
+        std::vector<float> values(signals.size());
+        for (const auto& row : rows) {
+            for (std::size_t i = 0; i < sources.size(); ++i) values[i] = row[sources[i]];
+            trace.append(values);
+        }
+        trace.close();
+        std::println("Wrote {} rows of {} signals to {}", rows.size(), signals.size(), output);
+        if (dt) std::println("Sample period: {} s", *dt);
+        return 0;
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return argc == 2 && (std::string_view(argv[1]) == "-h" || std::string_view(argv[1]) == "--help") ? 0 : 1;
+    }
+
+    std::string command = argv[1];
+    std::string input;
+    std::string output;
+    std::string selection;
+    std::string schema_file;
+    std::optional<double> dt;
+    std::uint32_t chunk_rows = oc::trace::default_chunk_rows;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "-o" || arg == "--signals" || arg == "--schema" || arg == "--dt" || arg == "--chunk-rows") {
+            if (i + 1 >= argc) {
+                std::println(stderr, "Error: {} requires a value", arg);
+                return 1;
+            }
+            std::string v = argv[++i];
+            bool read = true;
+            if (arg == "-o") output = v;
+            else if (arg == "--signals") selection = v;
+            else if (arg == "--schema") schema_file = v;
+            else if (arg == "--dt") read = oc::tool::read_positive(arg, v, dt.emplace());
+            else read = oc::tool::read_positive(arg, v, chunk_rows);
+            if (!read) return 1;
+        } else {
+            input = std::string(arg);
+        }
+    }
+
+    if (input.empty()) {
+        std::println(stderr, "Error: No input file specified");
+        return 1;
+    }
+    if (command == "info") return info(input);
+    if (command == "to-csv") return to_csv(input, output, selection);
+    if (command == "from-csv") return from_csv(input, output, schema_file, dt, chunk_rows);
+
+    std::println(stderr, "Error: Unknown command '{}'", command);
+    print_usage(argv[0]);
+    return 1;
+}